@@ -497,6 +497,15 @@ static void CL_ForceFixedDlights( void ) {
 }
 
 
+static void CL_LoadWorldMap( const char *mapname ) {
+	int64_t start;
+
+	start = Sys_Microseconds();
+	re.LoadWorld( mapname );
+	Com_DPrintf( "%s: world %.1f ms\n", mapname, ( Sys_Microseconds() - start ) / 1000.0 );
+}
+
+
 /*
 ====================
 CL_CgameSystemCalls
@@ -638,7 +647,7 @@ static intptr_t CL_CgameSystemCalls( intptr_t *args ) {
 		S_StartBackgroundTrack( VMA(1), VMA(2) );
 		return 0;
 	case CG_R_LOADWORLDMAP:
-		re.LoadWorld( VMA(1) );
+		CL_LoadWorldMap( VMA(1) );
 		return 0;
 	case CG_R_REGISTERMODEL:
 		return re.RegisterModel( VMA(1) );
@@ -1267,7 +1276,7 @@ void CL_SetCGameTime( void ) {
 		// Advance TV frames while cl.serverTime is ahead of latest snapshot
 		while ( cl.serverTime - cl.snap.serverTime >= 0 ) {
 			CL_TV_ReadFrame();
-			if ( tvPlay.atEnd ) {
+			if ( tvPlay.atEnd || tvPlay.starved ) {
 				break;
 			}
 			CL_TV_BuildSnapshot();
@@ -998,6 +998,48 @@ static void CL_PlayDemo_f( void ) {
 }
 
 
+/*
+====================
+CL_TVLive_f
+
+tvlive <host[:port]>
+
+Watch a server's TV relay as it is being recorded.
+====================
+*/
+static void CL_TVLive_f( void ) {
+	const char *address;
+
+	if ( Cmd_Argc() != 2 ) {
+		Com_Printf( "tvlive <host[:port]>\n" );
+		return;
+	}
+
+	address = Cmd_Argv( 1 );
+
+	Cvar_Set( "sv_killserver", "2" );
+	CL_Disconnect( qtrue );
+
+	clc.demoplaying = qtrue;
+	Con_Close();
+
+	if ( !CL_TV_OpenStream( address ) ) {
+		Com_Printf( S_COLOR_YELLOW "couldn't open TV relay %s\n", address );
+		clc.demoplaying = qfalse;
+		return;
+	}
+
+	clc.lastPacketTime = cls.realtime;
+
+	Q_strncpyz( clc.demoName, "tvlive", sizeof( clc.demoName ) );
+	Q_strncpyz( cls.servername, address, sizeof( cls.servername ) );
+	cls.state = CA_CONNECTED;
+	clc.firstDemoFrameSkipped = qfalse;
+
+	CL_InitDownloads();
+}
+
+
 /*
 ==================
 CL_NextDemo
@@ -4198,6 +4240,7 @@ void CL_Init( void ) {
 	Cmd_SetCommandCompletionFunc( "record", CL_CompleteRecordName );
 	Cmd_AddCommand ("demo", CL_PlayDemo_f);
 	Cmd_SetCommandCompletionFunc( "demo", CL_CompleteDemoName );
+	Cmd_AddCommand ("tvlive", CL_TVLive_f);
 	Cmd_AddCommand ("cinematic", CL_PlayCinematic_f);
 	Cmd_AddCommand ("stoprecord", CL_StopRecord_f);
 	Cmd_AddCommand ("connect", CL_Connect_f);
@@ -4283,6 +4326,7 @@ void CL_Shutdown( const char *finalmsg, qboolean quit ) {
 	Cmd_RemoveCommand ("disconnect");
 	Cmd_RemoveCommand ("record");
 	Cmd_RemoveCommand ("demo");
+	Cmd_RemoveCommand ("tvlive");
 	Cmd_RemoveCommand ("cinematic");
 	Cmd_RemoveCommand ("stoprecord");
 	Cmd_RemoveCommand ("connect");
@@ -32,6 +32,7 @@ tvPlayback_t tvPlay;
 cvar_t *cl_tvViewpoint;
 cvar_t *cl_tvTime;
 cvar_t *cl_tvDuration;
+cvar_t *cl_tvAsync;
 
 static void CL_TV_View_f( void );
 static void CL_TV_ViewNext_f( void );
@@ -71,6 +72,115 @@ void CL_TV_Init( void ) {
 	cl_tvViewpoint = Cvar_Get( "cl_tvViewpoint", "0", CVAR_ROM );
 	cl_tvTime = Cvar_Get( "cl_tvTime", "0", CVAR_ROM );
 	cl_tvDuration = Cvar_Get( "cl_tvDuration", "0", CVAR_ROM );
+	cl_tvAsync = Cvar_Get( "cl_tvAsync", "1", CVAR_ARCHIVE_ND );
+	Cvar_CheckRange( cl_tvAsync, "0", "1", CV_INTEGER );
+	Cvar_SetDescription( cl_tvAsync, "Decode TV demo frames ahead of playback on a background thread." );
+}
+
+
+/*
+===============
+CL_TV_StreamFill
+
+Pull whatever the relay has sent and decompress it into streamBuf.
+Never blocks.
+===============
+*/
+static void CL_TV_StreamFill( void ) {
+	if ( tvPlay.streamPos > 0 ) {
+		tvPlay.streamSize -= tvPlay.streamPos;
+		memmove( tvPlay.streamBuf, tvPlay.streamBuf + tvPlay.streamPos, tvPlay.streamSize );
+		tvPlay.streamPos = 0;
+	}
+
+	while ( tvPlay.streamSize < TVD_STREAM_BUF_SIZE ) {
+		ZSTD_inBuffer in;
+		ZSTD_outBuffer out;
+		size_t ret;
+
+		if ( tvPlay.zstdInPos >= tvPlay.zstdInSize ) {
+			int bytesRead;
+
+			if ( tvPlay.streamClosed ) {
+				break;
+			}
+			bytesRead = NET_StreamRecv( tvPlay.stream, tvPlay.zstdInBuf, TVD_ZSTD_IN_BUF_SIZE );
+			if ( bytesRead < 0 ) {
+				tvPlay.streamClosed = qtrue;
+				break;
+			}
+			if ( bytesRead == 0 ) {
+				break;
+			}
+			tvPlay.zstdInSize = (size_t)bytesRead;
+			tvPlay.zstdInPos = 0;
+		}
+
+		in.src = tvPlay.zstdInBuf;
+		in.size = tvPlay.zstdInSize;
+		in.pos = tvPlay.zstdInPos;
+		out.dst = tvPlay.streamBuf;
+		out.size = TVD_STREAM_BUF_SIZE;
+		out.pos = (size_t)tvPlay.streamSize;
+
+		ret = ZSTD_decompressStream( tvPlay.dstream, &out, &in );
+		tvPlay.zstdInPos = in.pos;
+		tvPlay.streamSize = (int)out.pos;
+
+		if ( ZSTD_isError( ret ) ) {
+			Com_Printf( S_COLOR_YELLOW "TV: Relay stream corrupt: %s\n", ZSTD_getErrorName( ret ) );
+			tvPlay.streamClosed = qtrue;
+			tvPlay.zstdInSize = tvPlay.zstdInPos = 0;
+			break;
+		}
+	}
+}
+
+
+/*
+===============
+CL_TV_StreamFrameReady
+
+Returns qtrue when a complete frame has been received from the relay.
+===============
+*/
+static qboolean CL_TV_StreamFrameReady( void ) {
+	unsigned int frameSize;
+	int avail;
+
+	CL_TV_StreamFill();
+
+	avail = tvPlay.streamSize - tvPlay.streamPos;
+	if ( avail < 4 ) {
+		return qfalse;
+	}
+
+	Com_Memcpy( &frameSize, tvPlay.streamBuf + tvPlay.streamPos, 4 );
+	if ( frameSize > sizeof( tvPlay.msgBuf ) ) {
+		return qtrue; // let CL_TV_ReadFrame reject it
+	}
+
+	return ( avail - 4 >= (int)frameSize ) ? qtrue : qfalse;
+}
+
+
+/*
+===============
+CL_TV_StreamWaitFrame
+
+Block until a complete frame arrives, the relay closes, or timeout.
+Only used while opening the stream.
+===============
+*/
+static void CL_TV_StreamWaitFrame( void ) {
+	int start = Sys_Milliseconds();
+
+	while ( !CL_TV_StreamFrameReady() && !tvPlay.streamClosed ) {
+		if ( Sys_Milliseconds() - start > TVD_STREAM_TIMEOUT ) {
+			break;
+		}
+		NET_StreamWait( tvPlay.stream, 100 );
+	}
 }
 
 
@@ -86,6 +196,17 @@ static int CL_TV_DecompressRead( void *buf, int len ) {
 	byte *dst = (byte *)buf;
 	int total = 0;
 
+	// Live streams are decompressed ahead by CL_TV_StreamFill
+	if ( tvPlay.stream ) {
+		total = tvPlay.streamSize - tvPlay.streamPos;
+		if ( total > len ) {
+			total = len;
+		}
+		Com_Memcpy( dst, tvPlay.streamBuf + tvPlay.streamPos, total );
+		tvPlay.streamPos += total;
+		return total;
+	}
+
 	while ( total < len ) {
 		// Consume from decompressed output buffer first
 		if ( tvPlay.zstdOutPos < tvPlay.zstdOutSize ) {
@@ -102,30 +223,49 @@ static int CL_TV_DecompressRead( void *buf, int len ) {
 			break;
 		}
 
-		// Read more compressed data from file if input buffer exhausted
+		// Read more compressed data from file if input buffer exhausted,
+		// stopping short of the trailer
 		if ( tvPlay.zstdInPos >= tvPlay.zstdInSize ) {
-			int bytesRead = FS_Read( tvPlay.zstdInBuf, TVD_ZSTD_IN_BUF_SIZE, tvPlay.file );
+			long remaining = tvPlay.dataEndOffset - tvPlay.zstdReadOffset;
+			int bytesRead;
+
+			if ( remaining <= 0 ) {
+				tvPlay.zstdStreamEnded = qtrue;
+				break;
+			}
+
+			// mapped files hand the rest of the data to zstd in one go
+			if ( tvPlay.mapData ) {
+				tvPlay.zstdIn = tvPlay.mapData + tvPlay.zstdReadOffset;
+				tvPlay.zstdInSize = (size_t)remaining;
+				tvPlay.zstdInPos = 0;
+				tvPlay.zstdReadOffset = tvPlay.dataEndOffset;
+				continue;
+			}
+
+			bytesRead = FS_Read( tvPlay.zstdInBuf,
+				remaining < TVD_ZSTD_IN_BUF_SIZE ? (int)remaining : TVD_ZSTD_IN_BUF_SIZE, tvPlay.file );
 			if ( bytesRead <= 0 ) {
 				tvPlay.zstdStreamEnded = qtrue;
 				break;
 			}
+			tvPlay.zstdReadOffset += bytesRead;
+			tvPlay.zstdIn = tvPlay.zstdInBuf;
 			tvPlay.zstdInSize = (size_t)bytesRead;
 			tvPlay.zstdInPos = 0;
 		}
 
 		// Decompress
 		{
-			ZSTD_inBuffer in = { tvPlay.zstdInBuf, tvPlay.zstdInSize, tvPlay.zstdInPos };
+			ZSTD_inBuffer in = { tvPlay.zstdIn, tvPlay.zstdInSize, tvPlay.zstdInPos };
 			ZSTD_outBuffer out = { tvPlay.zstdOutBuf, TVD_ZSTD_OUT_BUF_SIZE, 0 };
 			size_t ret = ZSTD_decompressStream( tvPlay.dstream, &out, &in );
 			tvPlay.zstdInPos = in.pos;
 			tvPlay.zstdOutSize = out.pos;
 			tvPlay.zstdOutPos = 0;
 
-			if ( ret == 0 ) {
-				// Zstd frame complete
-				tvPlay.zstdStreamEnded = qtrue;
-			}
+			// ret == 0 only means a zstd frame is complete; keyframes start
+			// a new frame, so keep going until the data end offset
 			if ( ZSTD_isError( ret ) ) {
 				tvPlay.zstdStreamEnded = qtrue;
 			}
@@ -136,125 +276,205 @@ static int CL_TV_DecompressRead( void *buf, int len ) {
 }
 
 
+/*
+===============
+CL_TV_ParseTrailer
+
+Parse the k/v trailer, "TVDt" + repeated(key\0 + valueLen:2 + valueData) + \0,
+from memory. The trailing trailerSize:4 is not included.
+===============
+*/
+static qboolean CL_TV_ParseTrailer( const byte *data, int len ) {
+	const byte *p, *end;
+
+	if ( len < 5 || memcmp( data, "TVDt", 4 ) ) {
+		return qfalse;
+	}
+
+	p = data + 4;
+	end = data + len;
+
+	// Read k/v pairs until empty key (terminator)
+	while ( p < end && *p ) {
+		const char *key = (const char *)p;
+		unsigned short vlen;
+
+		p += strnlen( key, end - p ) + 1;
+		if ( end - p < 2 ) {
+			return qfalse;
+		}
+		Com_Memcpy( &vlen, p, 2 );
+		p += 2;
+		if ( end - p < vlen ) {
+			return qfalse;
+		}
+
+		// Keyframe seek table: serverTime:4 + offset:4 per entry
+		if ( !Q_stricmp( key, "kf" ) ) {
+			int count = vlen / 8;
+			int i;
+
+			if ( count > TVD_MAX_KEYFRAMES ) {
+				count = TVD_MAX_KEYFRAMES;
+			}
+			for ( i = 0; i < count; i++ ) {
+				Com_Memcpy( &tvPlay.keyframes[i].serverTime, p + i * 8, 4 );
+				Com_Memcpy( &tvPlay.keyframes[i].offset, p + i * 8 + 4, 4 );
+			}
+			tvPlay.keyframeCount = count;
+		} else if ( !Q_stricmp( key, "dur" ) && vlen == 4 ) {
+			Com_Memcpy( &tvPlay.totalDuration, p, 4 );
+		}
+
+		p += vlen;
+	}
+
+	return ( p < end );
+}
+
+
 /*
 ===============
 CL_TV_ReadTrailer
 
-Read k/v trailer from the end of the file.
-Format: "TVDt" + repeated(key\0 + valueLen:2 + valueData) + \0 + trailerSize:4
-Returns qtrue on success, qfalse on failure (sets totalDuration=0).
+Read the trailer from the end of the file, from the mapping if there
+is one, else with a single read. Returns qtrue on success, qfalse on
+failure (sets totalDuration=0). Also sets dataEndOffset, where the
+compressed frame data stops.
 ===============
 */
 static qboolean CL_TV_ReadTrailer( void ) {
 	long savedPos;
-	int trailerSize;
-	char magic[4];
 	long fileLen;
-	char key[64];
-	unsigned short vlen;
-	byte vbuf[256];
+	int trailerSize;
+	byte *buf;
+	qboolean ok;
 
 	tvPlay.totalDuration = 0;
+	tvPlay.keyframeCount = 0;
+
+	if ( tvPlay.mapData ) {
+		fileLen = tvPlay.mapSize;
+		tvPlay.dataEndOffset = fileLen;
+
+		// Minimum trailer: "TVDt"(4) + \0(1) + size(4) = 9
+		if ( fileLen < 9 ) {
+			return qfalse;
+		}
+
+		Com_Memcpy( &trailerSize, tvPlay.mapData + fileLen - 4, 4 );
+		if ( trailerSize < 9 || trailerSize > fileLen ||
+			!CL_TV_ParseTrailer( tvPlay.mapData + fileLen - trailerSize, trailerSize - 4 ) ) {
+			tvPlay.totalDuration = 0;
+			tvPlay.keyframeCount = 0;
+			return qfalse;
+		}
+
+		tvPlay.dataEndOffset = fileLen - trailerSize;
+		return qtrue;
+	}
 
 	savedPos = FS_FTell( tvPlay.file );
 
 	// Get file length by seeking to end
 	FS_Seek( tvPlay.file, 0, FS_SEEK_END );
 	fileLen = FS_FTell( tvPlay.file );
-
-	// Minimum trailer: "TVDt"(4) + \0(1) + size(4) = 9
-	if ( fileLen < 9 ) {
-		FS_Seek( tvPlay.file, savedPos, FS_SEEK_SET );
-		return qfalse;
+	tvPlay.dataEndOffset = fileLen;
+
+	// Read trailerSize from EOF-4, then the rest of the trailer
+	ok = qfalse;
+	if ( fileLen >= 9 ) {
+		FS_Seek( tvPlay.file, fileLen - 4, FS_SEEK_SET );
+		if ( FS_Read( &trailerSize, 4, tvPlay.file ) == 4 && trailerSize >= 9 && trailerSize <= fileLen ) {
+			buf = malloc( trailerSize - 4 );
+			if ( buf ) {
+				FS_Seek( tvPlay.file, fileLen - trailerSize, FS_SEEK_SET );
+				ok = ( FS_Read( buf, trailerSize - 4, tvPlay.file ) == trailerSize - 4 &&
+					CL_TV_ParseTrailer( buf, trailerSize - 4 ) );
+				free( buf );
+			}
+		}
 	}
 
-	// Read trailerSize from EOF-4
-	FS_Seek( tvPlay.file, fileLen - 4, FS_SEEK_SET );
-	if ( FS_Read( &trailerSize, 4, tvPlay.file ) != 4 || trailerSize < 9 || trailerSize > fileLen ) {
-		FS_Seek( tvPlay.file, savedPos, FS_SEEK_SET );
-		return qfalse;
+	if ( ok ) {
+		tvPlay.dataEndOffset = fileLen - trailerSize;
+	} else {
+		tvPlay.totalDuration = 0;
+		tvPlay.keyframeCount = 0;
 	}
 
-	// Seek to trailer start
-	FS_Seek( tvPlay.file, fileLen - trailerSize, FS_SEEK_SET );
+	// Restore file position
+	FS_Seek( tvPlay.file, savedPos, FS_SEEK_SET );
+	return ok;
+}
 
-	// Read and validate magic "TVDt"
-	if ( FS_Read( magic, 4, tvPlay.file ) != 4 ||
-		 magic[0] != 'T' || magic[1] != 'V' || magic[2] != 'D' || magic[3] != 't' ) {
-		FS_Seek( tvPlay.file, savedPos, FS_SEEK_SET );
-		return qfalse;
-	}
 
-	// Read k/v pairs until empty key (terminator)
-	while ( 1 ) {
-		int i;
+/*
+===============
+CL_TV_HeaderRead
 
-		// Read key (null-terminated)
-		for ( i = 0; i < (int)sizeof( key ) - 1; i++ ) {
-			if ( FS_Read( &key[i], 1, tvPlay.file ) != 1 ) {
-				FS_Seek( tvPlay.file, savedPos, FS_SEEK_SET );
-				return qfalse;
-			}
-			if ( key[i] == '\0' ) {
-				break;
-			}
-		}
-		key[sizeof( key ) - 1] = '\0';
+Read uncompressed header bytes from the file or the relay stream.
+Stream bytes past the header stay in zstdInBuf for the decompressor.
+===============
+*/
+static int CL_TV_HeaderRead( void *ctx, void *buf, int len ) {
+	byte *dst = (byte *)buf;
+	int total = 0;
 
-		// Empty key = terminator
-		if ( key[0] == '\0' ) {
-			break;
-		}
+	if ( !tvPlay.stream ) {
+		return FS_Read( buf, len, tvPlay.file );
+	}
 
-		// Read value length
-		if ( FS_Read( &vlen, 2, tvPlay.file ) != 2 ) {
-			FS_Seek( tvPlay.file, savedPos, FS_SEEK_SET );
-			return qfalse;
-		}
+	while ( total < len ) {
+		int bytesRead;
 
-		// Read value data
-		if ( vlen > sizeof( vbuf ) ) {
-			// Skip unknown large value
-			FS_Seek( tvPlay.file, vlen, FS_SEEK_CUR );
+		if ( tvPlay.zstdInPos < tvPlay.zstdInSize ) {
+			dst[total++] = tvPlay.zstdInBuf[tvPlay.zstdInPos++];
 			continue;
 		}
-		if ( vlen > 0 && FS_Read( vbuf, vlen, tvPlay.file ) != vlen ) {
-			FS_Seek( tvPlay.file, savedPos, FS_SEEK_SET );
-			return qfalse;
+
+		if ( !NET_StreamWait( tvPlay.stream, TVD_STREAM_TIMEOUT ) ) {
+			break;
 		}
 
-		// Match known keys
-		if ( !Q_stricmp( key, "dur" ) && vlen == 4 ) {
-			Com_Memcpy( &tvPlay.totalDuration, vbuf, 4 );
+		bytesRead = NET_StreamRecv( tvPlay.stream, tvPlay.zstdInBuf, TVD_ZSTD_IN_BUF_SIZE );
+		if ( bytesRead < 0 ) {
+			break;
 		}
+		tvPlay.zstdInSize = (size_t)bytesRead;
+		tvPlay.zstdInPos = 0;
 	}
 
-	// Restore file position
-	FS_Seek( tvPlay.file, savedPos, FS_SEEK_SET );
-	return qtrue;
+	return total;
 }
 
 
 /*
 ===============
-CL_TV_ReadString
-
-Read a null-terminated string from file, byte at a time.
+CL_TV_CloseSource
 ===============
 */
-static int CL_TV_ReadString( char *buf, int bufSize ) {
-	int i;
-	for ( i = 0; i < bufSize - 1; i++ ) {
-		if ( FS_Read( &buf[i], 1, tvPlay.file ) != 1 ) {
-			buf[i] = '\0';
-			return -1;
-		}
-		if ( buf[i] == '\0' ) {
-			return i;
-		}
+static void CL_TV_CloseSource( void ) {
+	if ( tvPlay.stream ) {
+		NET_StreamClose( tvPlay.stream );
+		tvPlay.stream = NULL;
+	}
+
+	if ( tvPlay.streamBuf ) {
+		free( tvPlay.streamBuf );
+		tvPlay.streamBuf = NULL;
+	}
+
+	if ( tvPlay.mapData ) {
+		FS_UnmapFile( tvPlay.mapData, tvPlay.mapSize );
+		tvPlay.mapData = NULL;
+		tvPlay.mapSize = 0;
+	}
+
+	if ( tvPlay.file ) {
+		FS_FCloseFile( tvPlay.file );
+		tvPlay.file = 0;
 	}
-	buf[bufSize - 1] = '\0';
-	return i;
 }
 
 
@@ -335,111 +555,459 @@ static void CL_TV_UpdateConfigstring( int index, const char *data, int dataLen )
 
 /*
 ===============
-CL_TV_Open
+CL_TV_ApplyKeyframeConfigstrings
+
+Replace cl.gameState with the full configstring set carried by a keyframe.
+Outside of seeking, synthesize "cs" commands for any configstring that
+differs from the state cgame already has. Returns the record after the
+last configstring.
+===============
+*/
+static const byte *CL_TV_ApplyKeyframeConfigstrings( const byte *p, int csCount ) {
+	gameState_t oldGs;
+	char csData[BIG_INFO_STRING];
+	const char *data;
+	int csIndex, csLen;
+	int i;
+
+	oldGs = cl.gameState;
+	Com_Memset( &cl.gameState, 0, sizeof( cl.gameState ) );
+	cl.gameState.dataCount = 1;
+
+	for ( i = 0; i < csCount; i++ ) {
+		p = TVD_FrameNextString( p, &csIndex, &data, &csLen );
+
+		if ( (unsigned)csIndex >= MAX_CONFIGSTRINGS || csLen == 0 ) {
+			continue;
+		}
+
+		Q_strncpyz( csData, data, sizeof( csData ) );
+
+		// Ensure \tv\1 is always present in CS_SERVERINFO
+		if ( csIndex == CS_SERVERINFO ) {
+			Info_SetValueForKey( csData, "tv", "1" );
+			csLen = (int)strlen( csData );
+		}
+
+		if ( csLen + 1 + cl.gameState.dataCount > MAX_GAMESTATE_CHARS ) {
+			Com_Error( ERR_DROP, "CL_TV_ApplyKeyframeConfigstrings: MAX_GAMESTATE_CHARS exceeded" );
+		}
+		cl.gameState.stringOffsets[csIndex] = cl.gameState.dataCount;
+		Com_Memcpy( cl.gameState.stringData + cl.gameState.dataCount, csData, csLen + 1 );
+		cl.gameState.dataCount += csLen + 1;
+	}
+
+	if ( tvPlay.seeking ) {
+		return p;
+	}
+
+	for ( i = 0; i < MAX_CONFIGSTRINGS; i++ ) {
+		const char *oldCs = oldGs.stringData + oldGs.stringOffsets[i];
+		const char *newCs = cl.gameState.stringData + cl.gameState.stringOffsets[i];
+
+		if ( strcmp( oldCs, newCs ) != 0 ) {
+			char csCmd[MAX_STRING_CHARS];
+			Com_sprintf( csCmd, sizeof( csCmd ), "cs %i \"%s\"", i, newCs );
+			CL_TV_WriteCommand( csCmd );
+		}
+	}
+
+	return p;
+}
+
+
+/*
+===============
+CL_TV_DecodeFrame
+
+Read the next frame from the source and parse it into f. Runs on the
+decoder thread when there is one, so it must not print or touch cl/clc;
+failures are reported through f->error and f->end.
+===============
+*/
+static void CL_TV_DecodeFrame( tvdFrame_t *f ) {
+	unsigned int frameSize;
+
+	// Read frame size (4 bytes from compressed stream)
+	if ( CL_TV_DecompressRead( &frameSize, 4 ) != 4 || frameSize == 0 ) {
+		f->end = qtrue;
+		f->error[0] = '\0';
+		return;
+	}
+
+	if ( frameSize > sizeof( tvPlay.msgBuf ) ) {
+		Com_sprintf( f->error, sizeof( f->error ), "Frame too large (%u)", frameSize );
+		f->end = qtrue;
+		return;
+	}
+
+	// Read the frame payload (raw bits for protocol 5, Huffman before) from the compressed stream
+	if ( CL_TV_DecompressRead( tvPlay.msgBuf, frameSize ) != (int)frameSize ) {
+		f->end = qtrue;
+		f->error[0] = '\0';
+		return;
+	}
+
+	TVD_ParseFrame( &tvPlay.decoder, tvPlay.msgBuf, frameSize, f );
+}
+
+
+/*
+===============
+CL_TV_ApplyFrame
+
+Apply a decoded frame to the playback state, cl.gameState and the
+command ring.
+===============
+*/
+static void CL_TV_ApplyFrame( const tvdFrame_t *f ) {
+	byte oldEntityBitmask[MAX_GENTITIES/8];
+	byte oldPlayerBitmask[MAX_CLIENTS/8];
+	const byte *p;
+	const char *data;
+	int index, len;
+	int i;
+
+	if ( f->end ) {
+		if ( f->error[0] ) {
+			Com_Printf( S_COLOR_YELLOW "TV: %s\n", f->error );
+		}
+		tvPlay.atEnd = qtrue;
+		return;
+	}
+
+	if ( f->flags & TVD_FRAME_KEYFRAME ) {
+		Com_Memset( tvPlay.entities, 0, sizeof( tvPlay.entities ) );
+		Com_Memset( tvPlay.entityBitmask, 0, sizeof( tvPlay.entityBitmask ) );
+		Com_Memset( tvPlay.players, 0, sizeof( tvPlay.players ) );
+		Com_Memset( tvPlay.playerBitmask, 0, sizeof( tvPlay.playerBitmask ) );
+	}
+
+	// --- Entity section ---
+	Com_Memcpy( oldEntityBitmask, tvPlay.entityBitmask, sizeof( oldEntityBitmask ) );
+	Com_Memcpy( tvPlay.entityBitmask, f->entityBitmask, sizeof( tvPlay.entityBitmask ) );
+
+	for ( i = 0; i < f->numEntities; i++ ) {
+		if ( f->entities[i].es.number == MAX_GENTITIES - 1 ) {
+			Com_Memset( &tvPlay.entities[f->entities[i].num], 0, sizeof( entityState_t ) );
+		} else {
+			tvPlay.entities[f->entities[i].num] = f->entities[i].es;
+		}
+	}
+
+	for ( i = 0; i < MAX_GENTITIES; i++ ) {
+		if ( ( oldEntityBitmask[i >> 3] & ( 1 << ( i & 7 ) ) ) &&
+			 !( tvPlay.entityBitmask[i >> 3] & ( 1 << ( i & 7 ) ) ) ) {
+			Com_Memset( &tvPlay.entities[i], 0, sizeof( entityState_t ) );
+		}
+	}
+
+	// --- Player section ---
+	Com_Memcpy( oldPlayerBitmask, tvPlay.playerBitmask, sizeof( oldPlayerBitmask ) );
+	Com_Memcpy( tvPlay.playerBitmask, f->playerBitmask, sizeof( tvPlay.playerBitmask ) );
+
+	for ( i = 0; i < f->numPlayers; i++ ) {
+		tvPlay.players[f->players[i].clientNum] = f->players[i].ps;
+	}
+
+	for ( i = 0; i < MAX_CLIENTS; i++ ) {
+		if ( ( oldPlayerBitmask[i >> 3] & ( 1 << ( i & 7 ) ) ) &&
+			 !( tvPlay.playerBitmask[i >> 3] & ( 1 << ( i & 7 ) ) ) ) {
+			Com_Memset( &tvPlay.players[i], 0, sizeof( playerState_t ) );
+		}
+	}
+
+	// Auto-switch viewpoint if current player disconnected or became spectator
+	// Skip during seek: early replay frames may not yet contain the followed player
+	if ( !tvPlay.seeking &&
+		 ( !( tvPlay.playerBitmask[tvPlay.viewpoint >> 3] & ( 1 << ( tvPlay.viewpoint & 7 ) ) ) ||
+		   CL_TV_GetPlayerTeam( tvPlay.viewpoint ) == TEAM_SPECTATOR ) ) {
+		int newVp = CL_TV_FindFirstActivePlayer();
+		if ( newVp >= 0 ) {
+			tvPlay.viewpoint = newVp;
+			clc.clientNum = newVp;
+			Cvar_SetIntegerValue( "cl_tvViewpoint", newVp );
+		}
+	}
+
+	// --- Configstring changes ---
+	p = f->strings;
+	if ( f->flags & TVD_FRAME_KEYFRAME ) {
+		p = CL_TV_ApplyKeyframeConfigstrings( p, f->csCount );
+	} else {
+		for ( i = 0; i < f->csCount; i++ ) {
+			p = TVD_FrameNextString( p, &index, &data, &len );
+
+			if ( (unsigned)index < MAX_CONFIGSTRINGS ) {
+				CL_TV_UpdateConfigstring( index, data, len );
+
+				// Synthesize "cs" command for cgame so it registers new models/sounds/etc.
+				// Skip during seek (tv_seek_sync handles bulk re-registration)
+				if ( !tvPlay.seeking ) {
+					char csCmd[MAX_STRING_CHARS];
+					Com_sprintf( csCmd, sizeof( csCmd ), "cs %i \"%s\"", index, data );
+					CL_TV_WriteCommand( csCmd );
+				}
+			}
+		}
+	}
+
+	// --- Server commands ---
+	for ( i = 0; i < f->cmdCount; i++ ) {
+		p = TVD_FrameNextString( p, &index, &data, &len );
+
+		// Queue if broadcast (255) or targeted at our viewpoint
+		// Skip during seek to avoid overflowing the 64-command buffer
+		if ( !tvPlay.seeking && ( index == 255 || index == tvPlay.viewpoint ) ) {
+			CL_TV_WriteCommand( data );
+		}
+	}
+
+	tvPlay.serverTime = f->serverTime;
+
+	// Track last server time for seek clamping
+	if ( f->serverTime > tvPlay.lastServerTime ) {
+		tvPlay.lastServerTime = f->serverTime;
+	}
+}
+
+
+/*
+===============
+CL_TV_DecoderThread
+
+Decode frames ahead of playback until the end of the data or shutdown.
+===============
+*/
+static void CL_TV_DecoderThread( void *arg ) {
+	tvdFrame_t *f;
+
+	while ( 1 ) {
+		Sys_SemaphoreWait( tvPlay.decodeSlotFree );
+		if ( tvPlay.decodeShutdown ) {
+			break;
+		}
+
+		f = &tvPlay.decodeSlots[tvPlay.decodeHead];
+		CL_TV_DecodeFrame( f );
+		tvPlay.decodeHead = ( tvPlay.decodeHead + 1 ) % TVD_DECODE_SLOTS;
+
+		Sys_SemaphorePost( tvPlay.decodeFrameReady );
+
+		if ( f->end ) {
+			break;
+		}
+	}
+}
+
+
+/*
+===============
+CL_TV_StartDecoder
+
+Start decoding file playback ahead on a background thread. Leaves
+decodeThread NULL (decoding on demand) for live streams, when
+cl_tvAsync is off, or when threads are unavailable.
+===============
+*/
+static void CL_TV_StartDecoder( void ) {
+	if ( tvPlay.stream || !cl_tvAsync->integer ) {
+		return;
+	}
+
+	tvPlay.decodeSlotFree = Sys_CreateSemaphore( TVD_DECODE_SLOTS );
+	tvPlay.decodeFrameReady = Sys_CreateSemaphore( 0 );
+	tvPlay.decodeShutdown = 0;
+	tvPlay.decodeHead = 0;
+	tvPlay.decodeTail = 0;
+	tvPlay.decodeDone = qfalse;
+
+	if ( tvPlay.decodeSlotFree && tvPlay.decodeFrameReady ) {
+		tvPlay.decodeThread = Sys_CreateThread( CL_TV_DecoderThread, NULL );
+	}
+
+	if ( !tvPlay.decodeThread ) {
+		Sys_DestroySemaphore( tvPlay.decodeSlotFree );
+		Sys_DestroySemaphore( tvPlay.decodeFrameReady );
+		tvPlay.decodeSlotFree = NULL;
+		tvPlay.decodeFrameReady = NULL;
+	}
+}
+
+
+/*
+===============
+CL_TV_StopDecoder
+
+Stop the decoder thread and discard frames decoded ahead. Must be
+called before touching the file or zstd state from the main thread.
+===============
+*/
+static void CL_TV_StopDecoder( void ) {
+	if ( !tvPlay.decodeThread ) {
+		return;
+	}
+
+	tvPlay.decodeShutdown = 1;
+	Sys_SemaphorePost( tvPlay.decodeSlotFree );
+	Sys_JoinThread( tvPlay.decodeThread );
+	tvPlay.decodeThread = NULL;
+
+	Sys_DestroySemaphore( tvPlay.decodeSlotFree );
+	Sys_DestroySemaphore( tvPlay.decodeFrameReady );
+	tvPlay.decodeSlotFree = NULL;
+	tvPlay.decodeFrameReady = NULL;
+}
+
+
+/*
+===============
+CL_TV_FreeFrames
+===============
+*/
+static void CL_TV_FreeFrames( void ) {
+	int i;
+
+	CL_TV_StopDecoder();
+
+	for ( i = 0; i < TVD_DECODE_SLOTS; i++ ) {
+		TVD_FreeFrame( &tvPlay.decodeSlots[i] );
+	}
+}
+
+
+/*
+===============
+CL_TV_ReadFrame
+
+Apply the next frame, taking it from the decoder thread when running,
+otherwise decoding it here.
+===============
+*/
+void CL_TV_ReadFrame( void ) {
+	tvdFrame_t *f;
+
+	if ( tvPlay.decodeThread ) {
+		if ( tvPlay.decodeDone ) {
+			tvPlay.atEnd = qtrue;
+			return;
+		}
+
+		Sys_SemaphoreWait( tvPlay.decodeFrameReady );
+		f = &tvPlay.decodeSlots[tvPlay.decodeTail];
+		CL_TV_ApplyFrame( f );
+		tvPlay.decodeTail = ( tvPlay.decodeTail + 1 ) % TVD_DECODE_SLOTS;
+
+		if ( f->end ) {
+			tvPlay.decodeDone = qtrue;
+		} else {
+			Sys_SemaphorePost( tvPlay.decodeSlotFree );
+		}
+		return;
+	}
+
+	// Live streams only read complete frames; wait for more data
+	// unless the relay is gone
+	if ( tvPlay.stream ) {
+		if ( !CL_TV_StreamFrameReady() ) {
+			if ( tvPlay.streamClosed ) {
+				tvPlay.atEnd = qtrue;
+			} else {
+				tvPlay.starved = qtrue;
+			}
+			return;
+		}
+		tvPlay.starved = qfalse;
+	}
+
+	f = &tvPlay.decodeSlots[0];
+	CL_TV_DecodeFrame( f );
+	CL_TV_ApplyFrame( f );
+}
+
+
+/*
+===============
+CL_TV_HeaderConfigstring
+
+Store a header configstring in cl.gameState.
+===============
+*/
+static qboolean CL_TV_HeaderConfigstring( void *ctx, int index, const char *s, int len ) {
+	if ( len + 1 + cl.gameState.dataCount > MAX_GAMESTATE_CHARS ) {
+		Com_Printf( S_COLOR_YELLOW "TV: MAX_GAMESTATE_CHARS exceeded loading configstrings\n" );
+		return qfalse;
+	}
+
+	cl.gameState.stringOffsets[index] = cl.gameState.dataCount;
+	Com_Memcpy( cl.gameState.stringData + cl.gameState.dataCount, s, len + 1 );
+	cl.gameState.dataCount += len + 1;
+
+	return qtrue;
+}
+
+
+/*
+===============
+CL_TV_LoadDictionary
+
+Load the zstd dictionary a recording was compressed with. Dictionaries
+are looked up by id as tvdict/<id>.dict, which may come from a pk3.
+Session resets while seeking keep it loaded.
 ===============
 */
-qboolean CL_TV_Open( const char *filename ) {
-	char magic[4];
-	int protocol;
-	char mapname[MAX_QPATH];
-	char timestamp[64];
-	char csData[BIG_INFO_STRING];
-	unsigned short csIdx, csLen;
-
-	Com_Memset( &tvPlay, 0, sizeof( tvPlay ) );
-
-	if ( FS_FOpenFileRead( filename, &tvPlay.file, qtrue ) == -1 ) {
+static qboolean CL_TV_LoadDictionary( unsigned int dictId ) {
+	char path[MAX_QPATH];
+	void *dict;
+	int len;
+
+	Com_sprintf( path, sizeof( path ), "tvdict/%08x.dict", dictId );
+	len = FS_ReadFile( path, &dict );
+	if ( !dict ) {
+		Com_Printf( S_COLOR_YELLOW "TV: Recording needs dictionary %s\n", path );
 		return qfalse;
 	}
 
-	// Read and validate magic
-	if ( FS_Read( magic, 4, tvPlay.file ) != 4 ||
-		 magic[0] != 'T' || magic[1] != 'V' || magic[2] != 'D' || magic[3] != '1' ) {
-		Com_Printf( S_COLOR_YELLOW "TV: Invalid magic\n" );
-		FS_FCloseFile( tvPlay.file );
+	if ( crc32_buffer( dict, len ) != dictId ) {
+		Com_Printf( S_COLOR_YELLOW "TV: Dictionary %s does not match its id\n", path );
+		FS_FreeFile( dict );
 		return qfalse;
 	}
 
-	// Protocol version
-	if ( FS_Read( &protocol, 4, tvPlay.file ) != 4 || protocol != 1 ) {
-		Com_Printf( S_COLOR_YELLOW "TV: Unsupported protocol %i\n", protocol );
-		FS_FCloseFile( tvPlay.file );
-		return qfalse;
-	}
+	ZSTD_DCtx_loadDictionary( tvPlay.dstream, dict, len );
+	FS_FreeFile( dict );
 
-	// sv_fps
-	if ( FS_Read( &tvPlay.svFps, 4, tvPlay.file ) != 4 ) {
-		FS_FCloseFile( tvPlay.file );
-		return qfalse;
-	}
+	return qtrue;
+}
 
-	// maxclients
-	if ( FS_Read( &tvPlay.maxclients, 4, tvPlay.file ) != 4 ) {
-		FS_FCloseFile( tvPlay.file );
-		return qfalse;
-	}
 
-	// Map name
-	if ( CL_TV_ReadString( mapname, sizeof( mapname ) ) < 0 ) {
-		FS_FCloseFile( tvPlay.file );
-		return qfalse;
-	}
+/*
+===============
+CL_TV_Start
 
-	// Timestamp
-	if ( CL_TV_ReadString( timestamp, sizeof( timestamp ) ) < 0 ) {
-		FS_FCloseFile( tvPlay.file );
-		return qfalse;
-	}
+Read the header from the opened file or stream and the first frames.
+Closes the source on failure.
+===============
+*/
+static qboolean CL_TV_Start( void ) {
+	tvdHeader_t header;
 
-	// Populate cl.gameState with configstrings
+	// Populate cl.gameState with the header configstrings
 	Com_Memset( &cl.gameState, 0, sizeof( cl.gameState ) );
 	cl.gameState.dataCount = 1;
 
-	while ( 1 ) {
-		if ( FS_Read( &csIdx, 2, tvPlay.file ) != 2 ) {
-			FS_FCloseFile( tvPlay.file );
-			return qfalse;
-		}
-
-		if ( csIdx == 0xFFFF ) {
-			break;  // terminator
-		}
-
-		if ( FS_Read( &csLen, 2, tvPlay.file ) != 2 ) {
-			FS_FCloseFile( tvPlay.file );
-			return qfalse;
-		}
-
-		if ( csLen >= sizeof( csData ) ) {
-			Com_Printf( S_COLOR_YELLOW "TV: Configstring %i too long (%i)\n", csIdx, csLen );
-			FS_FCloseFile( tvPlay.file );
-			return qfalse;
-		}
-
-		if ( csLen > 0 ) {
-			if ( FS_Read( csData, csLen, tvPlay.file ) != csLen ) {
-				FS_FCloseFile( tvPlay.file );
-				return qfalse;
-			}
-		}
-		csData[csLen] = '\0';
-
-		if ( (unsigned)csIdx >= MAX_CONFIGSTRINGS ) {
-			continue;
-		}
-
-		// Store in gameState
-		if ( csLen + 1 + cl.gameState.dataCount > MAX_GAMESTATE_CHARS ) {
-			Com_Printf( S_COLOR_YELLOW "TV: MAX_GAMESTATE_CHARS exceeded loading configstrings\n" );
-			FS_FCloseFile( tvPlay.file );
-			return qfalse;
+	if ( !TVD_ReadHeader( CL_TV_HeaderRead, CL_TV_HeaderConfigstring, NULL, &header ) ) {
+		if ( header.error[0] ) {
+			Com_Printf( S_COLOR_YELLOW "TV: %s\n", header.error );
 		}
-
-		cl.gameState.stringOffsets[csIdx] = cl.gameState.dataCount;
-		Com_Memcpy( cl.gameState.stringData + cl.gameState.dataCount, csData, csLen + 1 );
-		cl.gameState.dataCount += csLen + 1;
+		CL_TV_CloseSource();
+		return qfalse;
 	}
 
+	tvPlay.protocol = header.protocol;
+	tvPlay.svFps = header.svFps;
+	tvPlay.maxclients = header.maxclients;
+
 	// Inject \tv\1 into CS_SERVERINFO (CL_TV_UpdateConfigstring auto-injects for CS_SERVERINFO)
 	{
 		const char *si = cl.gameState.stringData + cl.gameState.stringOffsets[CS_SERVERINFO];
@@ -447,7 +1015,9 @@ qboolean CL_TV_Open( const char *filename ) {
 	}
 
 	// Read trailer for duration (before saving frame offset)
-	CL_TV_ReadTrailer();
+	if ( !tvPlay.stream ) {
+		CL_TV_ReadTrailer();
+	}
 
 	// Print header info
 	{
@@ -457,22 +1027,32 @@ qboolean CL_TV_Open( const char *filename ) {
 			int m = ( secs % 3600 ) / 60;
 			int s = secs % 60;
 			Com_Printf( "TV: %s recorded %s, %i fps, %i maxclients, %02i:%02i:%02i\n",
-				mapname, timestamp, tvPlay.svFps, tvPlay.maxclients, h, m, s );
+				header.mapname, header.timestamp, tvPlay.svFps, tvPlay.maxclients, h, m, s );
 		} else {
 			Com_Printf( "TV: %s recorded %s, %i fps, %i maxclients, unknown duration\n",
-				mapname, timestamp, tvPlay.svFps, tvPlay.maxclients );
+				header.mapname, header.timestamp, tvPlay.svFps, tvPlay.maxclients );
 		}
 	}
 
 	// Save initial gameState and first frame offset for seeking
 	tvPlay.initialGameState = cl.gameState;
-	tvPlay.firstFrameOffset = FS_FTell( tvPlay.file );
 
 	// Init zstd decompressor
 	tvPlay.dstream = ZSTD_createDStream();
 	ZSTD_initDStream( tvPlay.dstream );
-	tvPlay.zstdInSize = 0;
-	tvPlay.zstdInPos = 0;
+	if ( header.dictId && !CL_TV_LoadDictionary( header.dictId ) ) {
+		ZSTD_freeDStream( tvPlay.dstream );
+		tvPlay.dstream = NULL;
+		CL_TV_CloseSource();
+		return qfalse;
+	}
+	// stream sources keep the compressed bytes that arrived with the header
+	if ( !tvPlay.stream ) {
+		tvPlay.firstFrameOffset = FS_FTell( tvPlay.file );
+		tvPlay.zstdInSize = 0;
+		tvPlay.zstdInPos = 0;
+		tvPlay.zstdReadOffset = tvPlay.firstFrameOffset;
+	}
 	tvPlay.zstdOutSize = 0;
 	tvPlay.zstdOutPos = 0;
 	tvPlay.zstdStreamEnded = qfalse;
@@ -482,6 +1062,7 @@ qboolean CL_TV_Open( const char *filename ) {
 	Com_Memset( tvPlay.entityBitmask, 0, sizeof( tvPlay.entityBitmask ) );
 	Com_Memset( tvPlay.players, 0, sizeof( tvPlay.players ) );
 	Com_Memset( tvPlay.playerBitmask, 0, sizeof( tvPlay.playerBitmask ) );
+	TVD_ResetDecoder( &tvPlay.decoder, tvPlay.protocol );
 
 	// Initialize standard ring buffer state
 	cl.parseEntitiesNum = 0;
@@ -493,10 +1074,17 @@ qboolean CL_TV_Open( const char *filename ) {
 	clc.clientNum = 0;
 
 	// Read first frame
+	if ( tvPlay.stream ) {
+		CL_TV_StreamWaitFrame();
+	}
+	CL_TV_StartDecoder();
 	CL_TV_ReadFrame();
-	if ( tvPlay.atEnd ) {
-		Com_Printf( S_COLOR_YELLOW "TV: No frames in file\n" );
-		FS_FCloseFile( tvPlay.file );
+	if ( tvPlay.atEnd || tvPlay.starved ) {
+		Com_Printf( S_COLOR_YELLOW "TV: No frames in %s\n", tvPlay.stream ? "stream" : "file" );
+		CL_TV_FreeFrames();
+		ZSTD_freeDStream( tvPlay.dstream );
+		tvPlay.dstream = NULL;
+		CL_TV_CloseSource();
 		return qfalse;
 	}
 
@@ -514,6 +1102,9 @@ qboolean CL_TV_Open( const char *filename ) {
 	CL_TV_BuildSnapshot();
 
 	// Read second frame and build second snapshot
+	if ( tvPlay.stream ) {
+		CL_TV_StreamWaitFrame();
+	}
 	CL_TV_ReadFrame();
 	if ( tvPlay.atEnd ) {
 		// Only one frame - build duplicate snapshot with same data
@@ -545,221 +1136,104 @@ qboolean CL_TV_Open( const char *filename ) {
 
 /*
 ===============
-CL_TV_Close
+CL_TV_Open
 ===============
 */
-void CL_TV_Close( void ) {
-	if ( tvPlay.dstream ) {
-		ZSTD_freeDStream( tvPlay.dstream );
-		tvPlay.dstream = NULL;
-	}
+qboolean CL_TV_Open( const char *filename ) {
+	Com_Memset( &tvPlay, 0, sizeof( tvPlay ) );
 
-	if ( tvPlay.file ) {
-		FS_FCloseFile( tvPlay.file );
+	if ( FS_FOpenFileRead( filename, &tvPlay.file, qtrue ) == -1 ) {
+		return qfalse;
 	}
 
-	Cmd_RemoveCommand( "tv_view" );
-	Cmd_RemoveCommand( "tv_view_next" );
-	Cmd_RemoveCommand( "tv_view_prev" );
-	Cmd_RemoveCommand( "tv_seek" );
+	tvPlay.mapData = FS_MapFile( tvPlay.file, &tvPlay.mapSize );
 
-	Com_Memset( &tvPlay, 0, sizeof( tvPlay ) );
+	return CL_TV_Start();
 }
 
 
 /*
 ===============
-CL_TV_ReadFrame
+CL_TV_OpenStream
 
-Read one frame from the current file position.
+Connect to a server's TV relay (sv_tvRelayPort). The relay answers
+with an HTTP/1.0 response followed by a .tvd stream without trailer.
 ===============
 */
-void CL_TV_ReadFrame( void ) {
-	unsigned int frameSize;
-	msg_t msg;
-	int serverTime;
-	int num;
-	entityState_t tempEntity;
-	playerState_t tempPlayer;
-	byte oldEntityBitmask[MAX_GENTITIES/8];
-	byte oldPlayerBitmask[MAX_CLIENTS/8];
-	int csCount, cmdCount;
-	int i;
-	char csData[BIG_INFO_STRING];
+qboolean CL_TV_OpenStream( const char *address ) {
+	static const char request[] = "GET / HTTP/1.0\r\n\r\n";
+	char line[64];
+	int len, matched;
+	char c;
 
-	// Read frame size (4 bytes from compressed stream)
-	if ( CL_TV_DecompressRead( &frameSize, 4 ) != 4 || frameSize == 0 ) {
-		tvPlay.atEnd = qtrue;
-		return;
-	}
-
-	if ( frameSize > sizeof( tvPlay.msgBuf ) ) {
-		Com_Printf( S_COLOR_YELLOW "TV: Frame too large (%u)\n", frameSize );
-		tvPlay.atEnd = qtrue;
-		return;
-	}
-
-	// Read Huffman-encoded payload from compressed stream
-	if ( CL_TV_DecompressRead( tvPlay.msgBuf, frameSize ) != (int)frameSize ) {
-		tvPlay.atEnd = qtrue;
-		return;
-	}
-
-	// Set up message for reading
-	MSG_Init( &msg, tvPlay.msgBuf, sizeof( tvPlay.msgBuf ) );
-	msg.cursize = frameSize;
-	MSG_BeginReading( &msg );
-
-	// Server time
-	serverTime = MSG_ReadLong( &msg );
-
-	// --- Entity section ---
-
-	// Save old bitmask for cleanup
-	Com_Memcpy( oldEntityBitmask, tvPlay.entityBitmask, sizeof( oldEntityBitmask ) );
-
-	// Read new entity bitmask
-	MSG_ReadData( &msg, tvPlay.entityBitmask, MAX_GENTITIES / 8 );
-
-	// Read delta-encoded entities from the bitstream
-	while ( 1 ) {
-		num = MSG_ReadEntitynum( &msg );
-		if ( num == MAX_GENTITIES - 1 ) {
-			break;  // end marker
-		}
-
-		if ( num < 0 ) {
-			// MSG_ReadEntitynum returns -1 when the message buffer is
-			// exhausted.  This is normal at the end of a demo file where
-			// the final frame may be truncated.
-			tvPlay.atEnd = qtrue;
-			return;
-		}
+	Com_Memset( &tvPlay, 0, sizeof( tvPlay ) );
 
-		if ( num >= MAX_GENTITIES - 1 ) {
-			Com_Printf( S_COLOR_YELLOW "TV: Bad entity number %i\n", num );
-			tvPlay.atEnd = qtrue;
-			return;
-		}
+	Com_Printf( "TV: Connecting to relay %s...\n", address );
 
-		// Delta frame: read into temp, then copy back
-		MSG_ReadDeltaEntity( &msg, &tvPlay.entities[num], &tempEntity, num );
-		if ( tempEntity.number == MAX_GENTITIES - 1 ) {
-			// Entity removed
-			Com_Memset( &tvPlay.entities[num], 0, sizeof( entityState_t ) );
-		} else {
-			tvPlay.entities[num] = tempEntity;
-		}
+	tvPlay.stream = NET_StreamConnect( address, TVD_RELAY_PORT );
+	if ( !tvPlay.stream ) {
+		Com_Printf( S_COLOR_YELLOW "TV: Could not connect to %s\n", address );
+		return qfalse;
 	}
 
-	// Zero entities that left the bitmask to match the writer's baseline.
-	// The writer zeroes prevEntities for removed entities (sv_tv.c),
-	// so our running state must also be zeroed for correct delta decoding.
-	for ( i = 0; i < MAX_GENTITIES; i++ ) {
-		if ( ( oldEntityBitmask[i >> 3] & ( 1 << ( i & 7 ) ) ) &&
-			 !( tvPlay.entityBitmask[i >> 3] & ( 1 << ( i & 7 ) ) ) ) {
-			Com_Memset( &tvPlay.entities[i], 0, sizeof( entityState_t ) );
-		}
+	tvPlay.streamBuf = malloc( TVD_STREAM_BUF_SIZE );
+	if ( !tvPlay.streamBuf ) {
+		CL_TV_CloseSource();
+		return qfalse;
 	}
 
-	// --- Player section ---
-	Com_Memcpy( oldPlayerBitmask, tvPlay.playerBitmask, sizeof( oldPlayerBitmask ) );
-	MSG_ReadData( &msg, tvPlay.playerBitmask, MAX_CLIENTS / 8 );
-
-	for ( i = 0; i < MAX_CLIENTS; i++ ) {
-		int clientNum;
+	NET_StreamSend( tvPlay.stream, request, sizeof( request ) - 1 );
 
-		if ( !( tvPlay.playerBitmask[i >> 3] & ( 1 << ( i & 7 ) ) ) ) {
-			continue;
+	// Check the status line and skip the rest of the response header
+	len = 0;
+	matched = 0;
+	line[0] = '\0';
+	while ( matched < 4 ) {
+		if ( CL_TV_HeaderRead( NULL, &c, 1 ) != 1 ) {
+			Com_Printf( S_COLOR_YELLOW "TV: No response from relay\n" );
+			CL_TV_CloseSource();
+			return qfalse;
 		}
-
-		clientNum = MSG_ReadByte( &msg );
-		if ( clientNum < 0 || clientNum >= MAX_CLIENTS ) {
-			Com_Printf( S_COLOR_YELLOW "TV: Bad player clientNum %i\n", clientNum );
-			tvPlay.atEnd = qtrue;
-			return;
+		if ( len < (int)sizeof( line ) - 1 && !matched && !strchr( line, '\n' ) ) {
+			line[len++] = c;
+			line[len] = '\0';
 		}
-
-		MSG_ReadDeltaPlayerstate( &msg, &tvPlay.players[clientNum], &tempPlayer );
-		tvPlay.players[clientNum] = tempPlayer;
+		matched = ( c == "\r\n\r\n"[matched] ) ? matched + 1 : ( c == '\r' ? 1 : 0 );
 	}
 
-	// Zero players that left the bitmask to match the writer's baseline.
-	// The writer zeroes prevPlayers for removed players (sv_tv.c),
-	// so our running state must also be zeroed for correct delta decoding.
-	for ( i = 0; i < MAX_CLIENTS; i++ ) {
-		if ( ( oldPlayerBitmask[i >> 3] & ( 1 << ( i & 7 ) ) ) &&
-			 !( tvPlay.playerBitmask[i >> 3] & ( 1 << ( i & 7 ) ) ) ) {
-			Com_Memset( &tvPlay.players[i], 0, sizeof( playerState_t ) );
-		}
+	if ( Q_strncmp( line, "HTTP/1.", 7 ) || !strstr( line, " 200" ) ) {
+		Com_Printf( S_COLOR_YELLOW "TV: Relay refused the connection\n" );
+		CL_TV_CloseSource();
+		return qfalse;
 	}
 
-	// Auto-switch viewpoint if current player disconnected or became spectator
-	// Skip during seek: early replay frames may not yet contain the followed player
-	if ( !tvPlay.seeking &&
-		 ( !( tvPlay.playerBitmask[tvPlay.viewpoint >> 3] & ( 1 << ( tvPlay.viewpoint & 7 ) ) ) ||
-		   CL_TV_GetPlayerTeam( tvPlay.viewpoint ) == TEAM_SPECTATOR ) ) {
-		int newVp = CL_TV_FindFirstActivePlayer();
-		if ( newVp >= 0 ) {
-			tvPlay.viewpoint = newVp;
-			clc.clientNum = newVp;
-			Cvar_SetIntegerValue( "cl_tvViewpoint", newVp );
-		}
-	}
+	Com_Printf( "TV: Waiting for keyframe...\n" );
 
-	// --- Configstring changes ---
-	csCount = MSG_ReadShort( &msg );
-	for ( i = 0; i < csCount; i++ ) {
-		int csIndex = MSG_ReadShort( &msg );
-		int csLen = MSG_ReadShort( &msg );
+	return CL_TV_Start();
+}
 
-		if ( csLen > 0 && csLen < (int)sizeof( csData ) ) {
-			MSG_ReadData( &msg, csData, csLen );
-			csData[csLen] = '\0';
-		} else {
-			csData[0] = '\0';
-		}
 
-		if ( (unsigned)csIndex < MAX_CONFIGSTRINGS ) {
-			CL_TV_UpdateConfigstring( csIndex, csData, csLen );
+/*
+===============
+CL_TV_Close
+===============
+*/
+void CL_TV_Close( void ) {
+	CL_TV_FreeFrames();
 
-			// Synthesize "cs" command for cgame so it registers new models/sounds/etc.
-			// Skip during seek (tv_seek_sync handles bulk re-registration)
-			if ( !tvPlay.seeking ) {
-				char csCmd[MAX_STRING_CHARS];
-				Com_sprintf( csCmd, sizeof( csCmd ), "cs %i \"%s\"", csIndex, csData );
-				CL_TV_WriteCommand( csCmd );
-			}
-		}
+	if ( tvPlay.dstream ) {
+		ZSTD_freeDStream( tvPlay.dstream );
+		tvPlay.dstream = NULL;
 	}
 
-	// --- Server commands ---
-	cmdCount = MSG_ReadShort( &msg );
-	for ( i = 0; i < cmdCount; i++ ) {
-		int target = MSG_ReadByte( &msg );
-		int cmdLen = MSG_ReadShort( &msg );
-
-		if ( cmdLen > 0 && cmdLen < (int)sizeof( csData ) ) {
-			MSG_ReadData( &msg, csData, cmdLen );
-			csData[cmdLen] = '\0';
-		} else {
-			csData[0] = '\0';
-			cmdLen = 0;
-		}
-
-		// Queue if broadcast (255) or targeted at our viewpoint
-		// Skip during seek to avoid overflowing the 64-command buffer
-		if ( !tvPlay.seeking && ( target == 255 || target == tvPlay.viewpoint ) ) {
-			CL_TV_WriteCommand( csData );
-		}
-	}
+	CL_TV_CloseSource();
 
-	tvPlay.serverTime = serverTime;
+	Cmd_RemoveCommand( "tv_view" );
+	Cmd_RemoveCommand( "tv_view_next" );
+	Cmd_RemoveCommand( "tv_view_prev" );
+	Cmd_RemoveCommand( "tv_seek" );
 
-	// Track last server time for seek clamping
-	if ( serverTime > tvPlay.lastServerTime ) {
-		tvPlay.lastServerTime = serverTime;
-	}
+	Com_Memset( &tvPlay, 0, sizeof( tvPlay ) );
 }
 
 
@@ -969,6 +1443,83 @@ void CL_TV_BuildSnapshot( void ) {
 }
 
 
+/*
+===============
+CL_TV_FindKeyframe
+
+Return the index of the last keyframe at or before targetTime, or -1.
+===============
+*/
+static int CL_TV_FindKeyframe( int targetTime ) {
+	int lo, hi;
+
+	lo = 0;
+	hi = tvPlay.keyframeCount - 1;
+	while ( lo <= hi ) {
+		int mid = ( lo + hi ) / 2;
+		if ( tvPlay.keyframes[mid].serverTime <= targetTime ) {
+			lo = mid + 1;
+		} else {
+			hi = mid - 1;
+		}
+	}
+
+	return hi;
+}
+
+
+/*
+===============
+CL_TV_Rewind
+
+Reposition the stream at the start of a zstd frame and reset all
+running state. The first frame read after this must be either the
+first frame of the file or a keyframe.
+===============
+*/
+static void CL_TV_Rewind( long offset ) {
+	int j;
+
+	CL_TV_StopDecoder();
+
+	// Restore initial gameState (configstrings are delta-encoded from header)
+	cl.gameState = tvPlay.initialGameState;
+
+	// Seek to the frame and reset all running state
+	if ( !tvPlay.mapData ) {
+		FS_Seek( tvPlay.file, offset, FS_SEEK_SET );
+	}
+	Com_Memset( tvPlay.entities, 0, sizeof( tvPlay.entities ) );
+	Com_Memset( tvPlay.entityBitmask, 0, sizeof( tvPlay.entityBitmask ) );
+	Com_Memset( tvPlay.players, 0, sizeof( tvPlay.players ) );
+	Com_Memset( tvPlay.playerBitmask, 0, sizeof( tvPlay.playerBitmask ) );
+	TVD_ResetDecoder( &tvPlay.decoder, tvPlay.protocol );
+	tvPlay.serverTime = 0;
+	tvPlay.atEnd = qfalse;
+
+	// Reset entity cursor (snapshot ring keeps incrementing to avoid
+	// cgame's latestSnapshotNum going backward)
+	cl.parseEntitiesNum = 0;
+	clc.lastExecutedServerCommand = clc.serverCommandSequence;
+
+	// Invalidate all snapshot ring buffer entries
+	for ( j = 0; j < PACKET_BACKUP; j++ ) {
+		cl.snapshots[j].valid = qfalse;
+	}
+
+	// Reset zstd decompressor session (without freeing context)
+	ZSTD_DCtx_reset( tvPlay.dstream, ZSTD_reset_session_only );
+	tvPlay.zstdInSize = 0;
+	tvPlay.zstdInPos = 0;
+	tvPlay.zstdReadOffset = offset;
+	tvPlay.zstdOutSize = 0;
+	tvPlay.zstdOutPos = 0;
+	tvPlay.zstdStreamEnded = qfalse;
+
+	CL_TV_StartDecoder();
+}
+
+
 /*
 ===============
 CL_TV_Seek
@@ -976,8 +1527,9 @@ CL_TV_Seek
 */
 void CL_TV_Seek( int targetTime ) {
 	int prevMsgNum;
+	int kf;
 
-	if ( !tvPlay.active ) {
+	if ( !tvPlay.active || tvPlay.stream ) {
 		return;
 	}
 
@@ -989,9 +1541,13 @@ void CL_TV_Seek( int targetTime ) {
 		targetTime = tvPlay.firstServerTime + tvPlay.totalDuration;
 	}
 
-	if ( targetTime >= tvPlay.serverTime && !tvPlay.atEnd ) {
-		// Forward seek: continue streaming from current position
-		// Entity/player delta state and configstrings are already correct
+	kf = CL_TV_FindKeyframe( targetTime );
+
+	if ( targetTime >= tvPlay.serverTime && !tvPlay.atEnd &&
+		 ( kf < 0 || tvPlay.keyframes[kf].serverTime <= tvPlay.serverTime ) ) {
+		// Forward seek with no keyframe in between: continue streaming
+		// from current position. Entity/player delta state and
+		// configstrings are already correct
 		tvPlay.seeking = qtrue;
 
 		while ( tvPlay.serverTime < targetTime && !tvPlay.atEnd ) {
@@ -1000,44 +1556,17 @@ void CL_TV_Seek( int targetTime ) {
 
 		tvPlay.seeking = qfalse;
 	} else {
-		int j;
-
-		// Backward seek: full reset required
-
-		// Restore initial gameState (configstrings are delta-encoded from header)
-		cl.gameState = tvPlay.initialGameState;
-
-		// Seek to the first frame and reset all running state
-		FS_Seek( tvPlay.file, tvPlay.firstFrameOffset, FS_SEEK_SET );
-		Com_Memset( tvPlay.entities, 0, sizeof( tvPlay.entities ) );
-		Com_Memset( tvPlay.entityBitmask, 0, sizeof( tvPlay.entityBitmask ) );
-		Com_Memset( tvPlay.players, 0, sizeof( tvPlay.players ) );
-		Com_Memset( tvPlay.playerBitmask, 0, sizeof( tvPlay.playerBitmask ) );
-		tvPlay.serverTime = 0;
-		tvPlay.atEnd = qfalse;
-
-		// Reset entity cursor (snapshot ring keeps incrementing to avoid
-		// cgame's latestSnapshotNum going backward)
-		cl.parseEntitiesNum = 0;
-		clc.lastExecutedServerCommand = clc.serverCommandSequence;
-
-		// Invalidate all snapshot ring buffer entries
-		for ( j = 0; j < PACKET_BACKUP; j++ ) {
-			cl.snapshots[j].valid = qfalse;
+		// Jump to the nearest keyframe, or replay from the first frame
+		// if there is none (protocol 1 or target before the first keyframe)
+		if ( kf >= 0 ) {
+			CL_TV_Rewind( (long)tvPlay.keyframes[kf].offset );
+		} else {
+			CL_TV_Rewind( tvPlay.firstFrameOffset );
 		}
 
-		// Reset zstd decompressor session (without freeing context)
-		ZSTD_DCtx_reset( tvPlay.dstream, ZSTD_reset_session_only );
-		tvPlay.zstdInSize = 0;
-		tvPlay.zstdInPos = 0;
-		tvPlay.zstdOutSize = 0;
-		tvPlay.zstdOutPos = 0;
-		tvPlay.zstdStreamEnded = qfalse;
-
 		// Skip command queueing during seek to avoid buffer overflow
 		tvPlay.seeking = qtrue;
 
-		// Read ALL frames from the beginning to ensure configstrings are correct
 		while ( tvPlay.serverTime < targetTime && !tvPlay.atEnd ) {
 			CL_TV_ReadFrame();
 		}
@@ -1225,6 +1754,11 @@ static void CL_TV_Seek_f( void ) {
 		return;
 	}
 
+	if ( tvPlay.stream ) {
+		Com_Printf( "Can't seek in a live TV stream.\n" );
+		return;
+	}
+
 	if ( Cmd_Argc() != 2 ) {
 		Com_Printf( "tv_seek <seconds>\n" );
 		return;
@@ -147,16 +147,36 @@ extern	clientActive_t		cl;
 
 // TV playback state
 #include "zstd.h"
+#include "../qcommon/tvd.h"
 
 #define MAX_TV_MSGLEN		(256*1024)
 #define TVD_ZSTD_IN_BUF_SIZE   (128*1024)
 #define TVD_ZSTD_OUT_BUF_SIZE  (256*1024)
+#define TVD_MAX_KEYFRAMES		4096
+#define TVD_STREAM_BUF_SIZE		(2*1024*1024)	// decompressed live stream data not yet read
+#define TVD_STREAM_TIMEOUT		10000			// msec to wait for header and first frames
+#define TVD_RELAY_PORT			27970			// default sv_tvRelayPort for tvlive
+#define TVD_DECODE_SLOTS		16				// frames decoded ahead by the playback thread
+
+typedef struct {
+	int				serverTime;
+	unsigned int	offset;			// file offset of the zstd frame starting with this keyframe
+} tvdKeyframe_t;
 
 typedef struct {
 	qboolean		active;
 	fileHandle_t	file;
 
+	// Live relay source (tvlive), used instead of file
+	netstream_t		*stream;
+	byte			*streamBuf;			// decompressed bytes, TVD_STREAM_BUF_SIZE
+	int				streamSize;
+	int				streamPos;
+	qboolean		streamClosed;
+	qboolean		starved;			// no complete frame received yet
+
 	// Header
+	int				protocol;
 	int				svFps;
 	int				maxclients;
 
@@ -177,6 +197,19 @@ typedef struct {
 	// Read buffer
 	byte			msgBuf[MAX_TV_MSGLEN];
 
+	// Decoder delta state, ahead of the running state when threaded
+	tvdDecoder_t	decoder;
+
+	// Background decoder for file playback (cl_tvAsync)
+	void			*decodeThread;
+	void			*decodeSlotFree;
+	void			*decodeFrameReady;
+	volatile int	decodeShutdown;
+	int				decodeHead;			// next slot the decoder fills
+	int				decodeTail;			// next slot CL_TV_ReadFrame applies
+	qboolean		decodeDone;			// end frame applied, decoder exited
+	tvdFrame_t		decodeSlots[TVD_DECODE_SLOTS];
+
 	// Duration info
 	int				totalDuration;		// from header, in msec
 	int				firstServerTime;
@@ -192,11 +225,24 @@ typedef struct {
 	long			firstFrameOffset;
 	gameState_t		initialGameState;
 
+	// Keyframe seek table from the trailer (protocol 2+)
+	tvdKeyframe_t	keyframes[TVD_MAX_KEYFRAMES];
+	int				keyframeCount;
+
+	// End of compressed frame data (start of trailer, or file length)
+	long			dataEndOffset;
+
+	// Local files outside pk3s are mapped and fed to zstd in place
+	const byte		*mapData;
+	int				mapSize;
+
 	// Zstd streaming decompression
 	ZSTD_DStream	*dstream;
 	byte			zstdInBuf[TVD_ZSTD_IN_BUF_SIZE];
+	const byte		*zstdIn;			// zstdInBuf or a window of mapData
 	size_t			zstdInSize;
 	size_t			zstdInPos;
+	long			zstdReadOffset;		// file offset of the next compressed read
 	byte			zstdOutBuf[TVD_ZSTD_OUT_BUF_SIZE];
 	size_t			zstdOutSize;
 	size_t			zstdOutPos;
@@ -685,9 +731,11 @@ void	CL_LoadJPG( const char *filename, unsigned char **pic, int *width, int *hei
 extern cvar_t *cl_tvViewpoint;
 extern cvar_t *cl_tvTime;
 extern cvar_t *cl_tvDuration;
+extern cvar_t *cl_tvAsync;
 
 void CL_TV_Init( void );
 qboolean CL_TV_Open( const char *filename );
+qboolean CL_TV_OpenStream( const char *address );
 void CL_TV_Close( void );
 void CL_TV_ReadFrame( void );
 void CL_TV_BuildSnapshot( void );
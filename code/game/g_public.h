@@ -50,6 +50,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #define SVF_SELF_PORTAL2		0x00020000  // merge a second pvs at entity->r.s.origin2 into snapshots
 
+#define MAX_TRACE_BATCH			256			// most traces in one G_TRACEBATCH
+
 //===============================================================
 
 
@@ -398,6 +400,9 @@ typedef enum {
 
 	// engine extensions
 	G_CVAR_SETDESCRIPTION,
+	G_TRACEBATCH,	// ( trace_t *results, const vec3_t *starts, const vec3_t *ends, int count, const vec3_t mins, const vec3_t maxs, int passEntityNum, int contentmask, int capsule );
+	// count G_TRACEs with the same mins, maxs, passEntityNum and contentmask,
+	// up to MAX_TRACE_BATCH; the number is found with trap_GetValue( "trap_TraceBatch_Trinity" )
 	G_TRAP_GETVALUE = COM_TRAP_GETVALUE
 
 } gameImport_t;
@@ -22,6 +22,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 // cmodel.c -- model loading
 
 #include "cm_local.h"
+#include "cm_patch.h"
 
 #ifdef BSPC
 
@@ -62,11 +63,43 @@ static byte *cmod_base;
 cvar_t		*cm_noAreas;
 cvar_t		*cm_noCurves;
 cvar_t		*cm_playerCurveClip;
+static cvar_t	*cm_patchCache;
+static cvar_t	*cm_loadThreads;
 #endif
 
+// the checksum of the whole .bsp is taken on another thread while the
+// lumps are loaded, CM_FinishChecksum waits for it
+typedef struct {
+	const void	*buf;
+	int			length;
+	int			checksum;
+	int			usec;
+	void		*thread;
+	qboolean	pending;
+} cmChecksumJob_t;
+
+static cmChecksumJob_t	checksumJob;
+
+// patches without a cache are generated in batches, patch n by work n
+// modulo numWork, each with a patchWork_t of its own
+typedef struct {
+	int				width;
+	int				height;
+	const vec3_t	*points;
+	patchCollide_t	*pc;		// malloced result
+} cmPatchJob_t;
+
+typedef struct {
+	cmPatchJob_t	*jobs;
+	int				numJobs;
+	patchWork_t		**work;
+	int				numWork;
+} cmPatchBatch_t;
+
 static cmodel_t box_model;
 static cplane_t *box_planes;
 static cbrush_t *box_brush;
+static cbrushSidePair_t box_sidePairs[3];
 
 
 
@@ -225,6 +258,30 @@ static void CM_BoundBrush( cbrush_t *b ) {
 }
 
 
+/*
+=================
+CM_SetBrushSidePairs
+
+Copy the side planes to brush->sidePairs, after they change.
+An odd last side is paired with itself.
+=================
+*/
+void CM_SetBrushSidePairs( cbrush_t *brush ) {
+	const cplane_t *plane;
+	cbrushSidePair_t *pair;
+	int i, j;
+
+	for ( i = 0; i < ( ( brush->numsides + 1 ) & ~1 ); i++ ) {
+		plane = brush->sides[ i < brush->numsides ? i : i - 1 ].plane;
+		pair = &brush->sidePairs[ i >> 1 ];
+		for ( j = 0; j < 3; j++ ) {
+			pair->normal[j][i & 1] = plane->normal[j];
+		}
+		pair->dist[i & 1] = plane->dist;
+	}
+}
+
+
 /*
 =================
 CMod_LoadBrushes
@@ -234,7 +291,9 @@ CMod_LoadBrushes
 static void CMod_LoadBrushes( const lump_t *l ) {
 	dbrush_t	*in;
 	cbrush_t	*out;
+	cbrushSidePair_t	*pairs;
 	int			i, count;
+	int			numSides, numPairs;
 
 	in = (void *)(cmod_base + l->fileofs);
 	if ( l->filelen % sizeof(*in) )
@@ -245,11 +304,23 @@ static void CMod_LoadBrushes( const lump_t *l ) {
 	cm.brushes = Hunk_Alloc( ( BOX_BRUSHES + count ) * sizeof( *cm.brushes ), h_high );
 	cm.numBrushes = count;
 
+	numPairs = 0;
+	for ( i = 0; i < count; i++ ) {
+		numSides = LittleLong( in[i].numSides );
+		if ( numSides < 0 || numSides > cm.numBrushSides ) {
+			Com_Error( ERR_DROP, "%s: bad numSides: %i", __func__, numSides );
+		}
+		numPairs += ( numSides + 1 ) / 2;
+	}
+	pairs = Hunk_Alloc( numPairs * sizeof( *pairs ), h_high );
+
 	out = cm.brushes;
 
 	for ( i = 0; i < count; i++, out++, in++ ) {
 		out->sides = cm.brushsides + LittleLong( in->firstSide );
 		out->numsides = LittleLong( in->numSides );
+		out->sidePairs = pairs;
+		pairs += ( out->numsides + 1 ) / 2;
 
 		out->shaderNum = LittleLong( in->shaderNum );
 		if ( out->shaderNum < 0 || out->shaderNum >= cm.numShaders ) {
@@ -258,6 +329,7 @@ static void CMod_LoadBrushes( const lump_t *l ) {
 		out->contents = cm.shaders[out->shaderNum].contentFlags;
 
 		CM_BoundBrush( out );
+		CM_SetBrushSidePairs( out );
 	}
 
 }
@@ -503,22 +575,383 @@ static void CMod_LoadVisibility( const lump_t *l ) {
 //==================================================================
 
 
+/*
+=================
+CM_ChecksumJob
+=================
+*/
+static void CM_ChecksumJob( void *arg ) {
+	cmChecksumJob_t *job = arg;
+	int64_t start;
+
+	start = Sys_Microseconds();
+	job->checksum = LittleLong( Com_BlockChecksum( job->buf, job->length ) );
+	job->usec = (int)( Sys_Microseconds() - start );
+}
+
+
+/*
+=================
+CM_FinishChecksum
+
+Sets cm.checksum once the checksum job is done. Also called before the
+map is cleared, so an error while loading can't leave the job running
+over a freed file.
+=================
+*/
+static void CM_FinishChecksum( void ) {
+	if ( checksumJob.pending ) {
+		Com_FinishJob( checksumJob.thread );
+		checksumJob.pending = qfalse;
+		cm.checksum = checksumJob.checksum;
+	}
+}
+
+
+#ifndef BSPC
+
+// The generated patch collision of a map is saved to maps/<name>.pcc
+// and used instead of generating it again as long as the checksum of
+// the .bsp matches. The file is in native byte order and struct layout,
+// a different ident or sizes make it be ignored and written again.
+
+#define	PATCH_CACHE_IDENT	(('C'<<24)+('C'<<16)+('P'<<8)+'P')	// "PPCC"
+#define	PATCH_CACHE_VERSION	1
+
+typedef struct {
+	int		ident;
+	int		version;
+	int		planeSize;		// sizeof( patchPlane_t )
+	int		facetSize;		// sizeof( facet_t )
+	int		checksum;		// of the whole .bsp
+	int		numSurfaces;
+	int		numPatches;
+	int		numPlanes;		// over all patches
+	int		numFacets;
+} patchCacheHeader_t;
+
+typedef struct {
+	int		surfaceNum;
+	vec3_t	bounds[2];
+	int		numPlanes;
+	int		numFacets;
+} patchCacheItem_t;
+
+
+/*
+=================
+CM_PatchCacheName
+=================
+*/
+static void CM_PatchCacheName( const char *mapname, char *name, int size ) {
+	COM_StripExtension( mapname, name, size );
+	Q_strcat( name, size, ".pcc" );
+}
+
+
+/*
+=================
+CM_ValidatePatchPlanes
+
+The plane signbits index the trace offsets, so they have to match the
+normal rather than be taken from the file.
+=================
+*/
+static qboolean CM_ValidatePatchPlanes( const patchPlane_t *plane, int numPlanes ) {
+	int i;
+
+	for ( i = 0; i < numPlanes; i++, plane++ ) {
+		if ( !Q_isfinite( plane->plane[0] ) || !Q_isfinite( plane->plane[1] )
+			|| !Q_isfinite( plane->plane[2] ) || !Q_isfinite( plane->plane[3] ) ) {
+			return qfalse;
+		}
+		if ( plane->signbits != CM_SignbitsForNormal( plane->plane ) ) {
+			return qfalse;
+		}
+	}
+
+	return qtrue;
+}
+
+
+/*
+=================
+CM_ValidatePatchFacets
+
+A cache file is not trusted to index inside the planes.
+=================
+*/
+static qboolean CM_ValidatePatchFacets( const facet_t *facet, int numFacets, int numPlanes ) {
+	int i, j;
+
+	for ( i = 0; i < numFacets; i++, facet++ ) {
+		if ( (unsigned)facet->surfacePlane >= numPlanes ) {
+			return qfalse;
+		}
+		if ( (unsigned)facet->numBorders > ARRAY_LEN( facet->borderPlanes ) ) {
+			return qfalse;
+		}
+		for ( j = 0; j < facet->numBorders; j++ ) {
+			if ( (unsigned)facet->borderPlanes[j] >= numPlanes ) {
+				return qfalse;
+			}
+		}
+	}
+
+	return qtrue;
+}
+
+
+/*
+=================
+CM_LoadPatchCache
+
+Returns the collision of the numPatches patch surfaces in surface
+order, or NULL if there is no cache file for this version of the map.
+Only the file written to the home path is used, never one from a pk3.
+=================
+*/
+static patchCollide_t *CM_LoadPatchCache( const char *mapname, const dsurface_t *surfs, int numPatches ) {
+	char name[ MAX_QPATH ];
+	const patchCacheHeader_t *header;
+	const patchCacheItem_t *items, *item;
+	const patchPlane_t *planes;
+	const facet_t *facets;
+	patchCollide_t *patches, *pc;
+	patchPlane_t *outPlanes;
+	facet_t *outFacets;
+	void *buf;
+	int length, i;
+	int surfaceNum, numPlanes, numFacets;
+
+	CM_PatchCacheName( mapname, name, sizeof( name ) );
+
+	length = FS_HomeReadFile( name, &buf );
+	if ( !buf ) {
+		return NULL;
+	}
+
+	CM_FinishChecksum();
+
+	header = buf;
+	if ( length < sizeof( *header ) || header->ident != PATCH_CACHE_IDENT || header->version != PATCH_CACHE_VERSION
+		|| header->planeSize != sizeof( patchPlane_t ) || header->facetSize != sizeof( facet_t )
+		|| header->checksum != cm.checksum || header->numSurfaces != cm.numSurfaces || header->numPatches != numPatches
+		|| (unsigned)header->numPlanes > numPatches * MAX_PATCH_PLANES || (unsigned)header->numFacets > numPatches * MAX_FACETS
+		|| length != sizeof( *header ) + numPatches * sizeof( *items )
+			+ header->numPlanes * sizeof( *planes ) + header->numFacets * sizeof( *facets ) ) {
+		Com_DPrintf( "%s is outdated\n", name );
+		FS_FreeFile( buf );
+		return NULL;
+	}
+
+	items = (const patchCacheItem_t *)( header + 1 );
+	planes = (const patchPlane_t *)( items + numPatches );
+	facets = (const facet_t *)( planes + header->numPlanes );
+
+	// check everything before allocating
+	surfaceNum = -1;
+	numPlanes = numFacets = 0;
+	for ( i = 0, item = items; i < numPatches; i++, item++ ) {
+		if ( item->surfaceNum <= surfaceNum || item->surfaceNum >= cm.numSurfaces
+			|| LittleLong( surfs[ item->surfaceNum ].surfaceType ) != MST_PATCH
+			|| (unsigned)item->numPlanes > MAX_PATCH_PLANES || (unsigned)item->numFacets > MAX_FACETS
+			|| numPlanes + item->numPlanes > header->numPlanes || numFacets + item->numFacets > header->numFacets
+			|| !CM_ValidatePatchPlanes( planes + numPlanes, item->numPlanes )
+			|| !CM_ValidatePatchFacets( facets + numFacets, item->numFacets, item->numPlanes ) ) {
+			Com_Printf( S_COLOR_YELLOW "WARNING: %s is corrupt\n", name );
+			FS_FreeFile( buf );
+			return NULL;
+		}
+		surfaceNum = item->surfaceNum;
+		numPlanes += item->numPlanes;
+		numFacets += item->numFacets;
+	}
+
+	patches = Hunk_Alloc( numPatches * sizeof( *patches ), h_high );
+	outPlanes = Hunk_Alloc( numPlanes * sizeof( *outPlanes ), h_high );
+	outFacets = Hunk_Alloc( numFacets * sizeof( *outFacets ), h_high );
+	Com_Memcpy( outPlanes, planes, numPlanes * sizeof( *outPlanes ) );
+	Com_Memcpy( outFacets, facets, numFacets * sizeof( *outFacets ) );
+
+	for ( i = 0, item = items, pc = patches; i < numPatches; i++, item++, pc++ ) {
+		VectorCopy( item->bounds[0], pc->bounds[0] );
+		VectorCopy( item->bounds[1], pc->bounds[1] );
+		pc->numPlanes = item->numPlanes;
+		pc->planes = outPlanes;
+		pc->numFacets = item->numFacets;
+		pc->facets = outFacets;
+		outPlanes += item->numPlanes;
+		outFacets += item->numFacets;
+	}
+
+	FS_FreeFile( buf );
+
+	return patches;
+}
+
+
+/*
+=================
+CM_WritePatchCache
+=================
+*/
+static void CM_WritePatchCache( const char *mapname ) {
+	char name[ MAX_QPATH ];
+	patchCacheHeader_t header;
+	patchCacheItem_t item;
+	const patchCollide_t *pc;
+	fileHandle_t f;
+	int i;
+
+	CM_FinishChecksum();
+
+	Com_Memset( &header, 0, sizeof( header ) );
+	header.ident = PATCH_CACHE_IDENT;
+	header.version = PATCH_CACHE_VERSION;
+	header.planeSize = sizeof( patchPlane_t );
+	header.facetSize = sizeof( facet_t );
+	header.checksum = cm.checksum;
+	header.numSurfaces = cm.numSurfaces;
+	for ( i = 0; i < cm.numSurfaces; i++ ) {
+		if ( cm.surfaces[i] ) {
+			header.numPatches++;
+			header.numPlanes += cm.surfaces[i]->pc->numPlanes;
+			header.numFacets += cm.surfaces[i]->pc->numFacets;
+		}
+	}
+
+	CM_PatchCacheName( mapname, name, sizeof( name ) );
+
+	f = FS_FOpenFileWrite( name );
+	if ( f == FS_INVALID_HANDLE ) {
+		Com_DPrintf( "couldn't write %s\n", name );
+		return;
+	}
+
+	FS_Write( &header, sizeof( header ), f );
+
+	for ( i = 0; i < cm.numSurfaces; i++ ) {
+		if ( !cm.surfaces[i] ) {
+			continue;
+		}
+		pc = cm.surfaces[i]->pc;
+		Com_Memset( &item, 0, sizeof( item ) );
+		item.surfaceNum = i;
+		VectorCopy( pc->bounds[0], item.bounds[0] );
+		VectorCopy( pc->bounds[1], item.bounds[1] );
+		item.numPlanes = pc->numPlanes;
+		item.numFacets = pc->numFacets;
+		FS_Write( &item, sizeof( item ), f );
+	}
+
+	for ( i = 0; i < cm.numSurfaces; i++ ) {
+		if ( cm.surfaces[i] ) {
+			pc = cm.surfaces[i]->pc;
+			FS_Write( pc->planes, pc->numPlanes * sizeof( pc->planes[0] ), f );
+		}
+	}
+
+	for ( i = 0; i < cm.numSurfaces; i++ ) {
+		if ( cm.surfaces[i] ) {
+			pc = cm.surfaces[i]->pc;
+			FS_Write( pc->facets, pc->numFacets * sizeof( pc->facets[0] ), f );
+		}
+	}
+
+	FS_FCloseFile( f );
+}
+
+#endif // !BSPC
+
+
+/*
+=================
+CM_PatchBatchJob
+
+Generates every numWork'th patch, stopping at the first error.
+=================
+*/
+static void CM_PatchBatchJob( void *arg, int index ) {
+	cmPatchBatch_t *batch = arg;
+	cmPatchJob_t *job;
+	int i;
+
+	for ( i = index; i < batch->numJobs; i += batch->numWork ) {
+		job = &batch->jobs[ i ];
+		job->pc = CM_GeneratePatchWork( batch->work[ index ], job->width, job->height, job->points );
+		if ( !job->pc ) {
+			break;
+		}
+	}
+}
+
+
+/*
+=================
+CM_FreePatchBatch
+=================
+*/
+static void CM_FreePatchBatch( cmPatchBatch_t *batch ) {
+	int i;
+
+	if ( batch->jobs ) {
+		for ( i = 0; i < batch->numJobs; i++ ) {
+			free( batch->jobs[ i ].pc );
+		}
+	}
+	if ( batch->work ) {
+		for ( i = 0; i < batch->numWork; i++ ) {
+			free( batch->work[ i ] );
+		}
+	}
+	free( batch->work );
+	free( batch->jobs );
+}
+
+
+/*
+=================
+CM_ValidPatchPoint
+
+NaN or far out points make the patch workers fail or subdivide
+without end.
+=================
+*/
+static qboolean CM_ValidPatchPoint( const vec3_t p ) {
+	int i;
+
+	for ( i = 0; i < 3; i++ ) {
+		if ( !Q_isfinite( p[i] ) || p[i] < MIN_WORLD_COORD || p[i] > MAX_WORLD_COORD ) {
+			return qfalse;
+		}
+	}
+
+	return qtrue;
+}
+
+
 /*
 =================
 CMod_LoadPatches
 =================
 */
 #define	MAX_PATCH_VERTS		1024
-static void CMod_LoadPatches( const lump_t *surfs, const lump_t *verts ) {
+static void CMod_LoadPatches( const lump_t *surfs, const lump_t *verts, const char *name ) {
 	drawVert_t	*dv, *dv_p;
 	dsurface_t	*in;
 	int			count;
 	int			i, j;
 	int			c;
 	cPatch_t	*patch;
-	vec3_t		points[MAX_PATCH_VERTS];
-	int			width, height;
+	vec3_t		*points;
+	int			numPoints;
 	int			shaderNum;
+	patchCollide_t	*cached = NULL;
+	cmPatchBatch_t	batch;
+	cmPatchJob_t	*job;
+	int			numPatches = 0;
+	char		error[ MAX_STRING_CHARS ];
 
 	in = (void *)(cmod_base + surfs->fileofs);
 	if (surfs->filelen % sizeof(*in))
@@ -531,8 +964,96 @@ static void CMod_LoadPatches( const lump_t *surfs, const lump_t *verts ) {
 	if (verts->filelen % sizeof(*dv))
 		Com_Error( ERR_DROP, "%s: funny lump size", __func__ );
 
+	numPoints = 0;
+	for ( i = 0 ; i < count ; i++ ) {
+		if ( LittleLong( in[i].surfaceType ) != MST_PATCH ) {
+			continue;
+		}
+		c = LittleLong( in[i].patchWidth ) * LittleLong( in[i].patchHeight );
+		if ( c > MAX_PATCH_VERTS ) {
+			Com_Error( ERR_DROP, "%s: MAX_PATCH_VERTS", __func__ );
+		}
+		numPatches++;
+		if ( c > 0 ) {
+			numPoints += c;		// bad sizes are left for CM_GeneratePatchWork to reject
+		}
+	}
+
+	if ( !numPatches ) {
+		return;
+	}
+
+#ifndef BSPC
+	if ( cm_patchCache->integer ) {
+		cached = CM_LoadPatchCache( name, in, numPatches );
+	}
+#endif
+
+	Com_Memset( &batch, 0, sizeof( batch ) );
+
+	if ( !cached ) {
+		// load the full drawverts of all patches
+		batch.numJobs = numPatches;
+		batch.jobs = calloc( 1, numPatches * sizeof( *batch.jobs ) + numPoints * sizeof( *points ) );
+		batch.numWork = 1;
+#ifndef BSPC
+		batch.numWork = MIN( cm_loadThreads->integer + 1, numPatches );
+#endif
+		batch.work = calloc( batch.numWork, sizeof( *batch.work ) );
+		for ( i = 0; batch.work && i < batch.numWork; i++ ) {
+			batch.work[ i ] = calloc( 1, sizeof( *batch.work[ i ] ) );
+			if ( !batch.work[ i ] ) {
+				break;
+			}
+		}
+		if ( !batch.jobs || !batch.work || i < batch.numWork ) {
+			CM_FreePatchBatch( &batch );
+			Com_Error( ERR_DROP, "%s: out of memory", __func__ );
+		}
+
+		points = (vec3_t *)( batch.jobs + numPatches );
+		job = batch.jobs;
+		for ( i = 0 ; i < count ; i++ ) {
+			if ( LittleLong( in[i].surfaceType ) != MST_PATCH ) {
+				continue;
+			}
+			job->width = LittleLong( in[i].patchWidth );
+			job->height = LittleLong( in[i].patchHeight );
+			job->points = points;
+			c = job->width * job->height;
+			dv_p = dv + LittleLong( in[i].firstVert );
+			for ( j = 0 ; j < c ; j++, dv_p++ ) {
+				points[j][0] = LittleFloat( dv_p->xyz[0] );
+				points[j][1] = LittleFloat( dv_p->xyz[1] );
+				points[j][2] = LittleFloat( dv_p->xyz[2] );
+				// the workers can't drop the map for this themselves
+				if ( !CM_ValidPatchPoint( points[j] ) ) {
+					CM_FreePatchBatch( &batch );
+					Com_Error( ERR_DROP, "%s: bad vertex in patch surface %i", __func__, i );
+				}
+			}
+			if ( c > 0 ) {
+				points += c;
+			}
+			job++;
+		}
+
+		// create the internal facet structures
+		Com_RunJobs( CM_PatchBatchJob, &batch, batch.numWork, batch.numWork - 1 );
+
+		for ( i = 0; i < batch.numWork; i++ ) {
+			if ( batch.work[ i ]->error[0] ) {
+				Q_strncpyz( error, batch.work[ i ]->error, sizeof( error ) );
+				CM_FreePatchBatch( &batch );
+				Com_Error( ERR_DROP, "%s", error );
+			}
+			CM_FinishPatchWork( batch.work[ i ] );
+		}
+	}
+
 	// scan through all the surfaces, but only load patches,
 	// not planar faces
+	job = batch.jobs;
 	for ( i = 0 ; i < count ; i++, in++ ) {
 		if ( LittleLong( in->surfaceType ) != MST_PATCH ) {
 			continue;		// ignore other surfaces
@@ -541,28 +1062,26 @@ static void CMod_LoadPatches( const lump_t *surfs, const lump_t *verts ) {
 
 		cm.surfaces[ i ] = patch = Hunk_Alloc( sizeof( *patch ), h_high );
 
-		// load the full drawverts onto the stack
-		width = LittleLong( in->patchWidth );
-		height = LittleLong( in->patchHeight );
-		c = width * height;
-		if ( c > MAX_PATCH_VERTS ) {
-			Com_Error( ERR_DROP, "%s: MAX_PATCH_VERTS", __func__ );
-		}
-
-		dv_p = dv + LittleLong( in->firstVert );
-		for ( j = 0 ; j < c ; j++, dv_p++ ) {
-			points[j][0] = LittleFloat( dv_p->xyz[0] );
-			points[j][1] = LittleFloat( dv_p->xyz[1] );
-			points[j][2] = LittleFloat( dv_p->xyz[2] );
-		}
-
 		shaderNum = LittleLong( in->shaderNum );
 		patch->contents = cm.shaders[shaderNum].contentFlags;
 		patch->surfaceFlags = cm.shaders[shaderNum].surfaceFlags;
 
-		// create the internal facet structure
-		patch->pc = CM_GeneratePatchCollide( width, height, points );
+		if ( cached ) {
+			patch->pc = cached++;
+		} else {
+			patch->pc = CM_FinishPatchCollide( job->pc );
+			job->pc = NULL;
+			job++;
+		}
 	}
+
+	CM_FreePatchBatch( &batch );
+
+#ifndef BSPC
+	if ( cm_patchCache->integer && !cached ) {
+		CM_WritePatchCache( name );
+	}
+#endif
 }
 
 //==================================================================
@@ -606,6 +1125,8 @@ void CM_LoadMap( const char *name, qboolean clientload, int *checksum ) {
 	int				i;
 	dheader_t		header;
 	int				length;
+	int64_t			start, t;
+	int				readTime, lumpsTime, patchesTime, checksumWait;
 
 	if ( !name || !name[0] ) {
 		Com_Error( ERR_DROP, "%s: NULL name", __func__ );
@@ -618,6 +1139,11 @@ void CM_LoadMap( const char *name, qboolean clientload, int *checksum ) {
 	Cvar_SetDescription( cm_noCurves, "Do not collide against curves." );
 	cm_playerCurveClip = Cvar_Get( "cm_playerCurveClip", "1", CVAR_ARCHIVE_ND | CVAR_CHEAT );
 	Cvar_SetDescription( cm_playerCurveClip, "Collide player against curves." );
+	cm_patchCache = Cvar_Get( "cm_patchCache", "1", CVAR_ARCHIVE_ND );
+	Cvar_SetDescription( cm_patchCache, "Save the generated curve collision of maps to maps/<name>.pcc and load it from there while the map is unchanged." );
+	cm_loadThreads = Cvar_Get( "cm_loadThreads", "3", CVAR_ARCHIVE_ND );
+	Cvar_CheckRange( cm_loadThreads, "0", "16", CV_INTEGER );
+	Cvar_SetDescription( cm_loadThreads, "Extra threads that take the map checksum and generate curve collision while a map loads. 0 = load on the main thread only." );
 #endif
 
 	Com_DPrintf( "%s( '%s', %i )\n", __func__, name, clientload );
@@ -641,6 +1167,8 @@ void CM_LoadMap( const char *name, qboolean clientload, int *checksum ) {
 	}
 #endif
 
+	start = Sys_Microseconds();
+
 	//
 	// load the file
 	//
@@ -657,7 +1185,21 @@ void CM_LoadMap( const char *name, qboolean clientload, int *checksum ) {
 		Com_Error( ERR_DROP, "%s: %s has truncated header", __func__, name );
 	}
 
-	*checksum = cm.checksum = LittleLong( Com_BlockChecksum( buf, length ) );
+	t = Sys_Microseconds();
+	readTime = (int)( t - start );
+
+	checksumJob.buf = buf;
+	checksumJob.length = length;
+	checksumJob.pending = qtrue;
+#ifndef BSPC
+	if ( cm_loadThreads->integer ) {
+		checksumJob.thread = Com_StartJob( CM_ChecksumJob, &checksumJob );
+	} else
+#endif
+	{
+		checksumJob.thread = NULL;
+		CM_ChecksumJob( &checksumJob );
+	}
 
 	header = *(dheader_t *)buf;
 	for ( i = 0; i < sizeof( dheader_t ) / sizeof( int32_t ); i++ ) {
@@ -690,10 +1232,21 @@ void CM_LoadMap( const char *name, qboolean clientload, int *checksum ) {
 	CMod_LoadNodes (&header.lumps[LUMP_NODES]);
 	CMod_LoadEntityString (&header.lumps[LUMP_ENTITIES]);
 	CMod_LoadVisibility( &header.lumps[LUMP_VISIBILITY] );
-	CMod_LoadPatches( &header.lumps[LUMP_SURFACES], &header.lumps[LUMP_DRAWVERTS] );
+
+	lumpsTime = (int)( Sys_Microseconds() - t );
+	t = Sys_Microseconds();
+
+	CMod_LoadPatches( &header.lumps[LUMP_SURFACES], &header.lumps[LUMP_DRAWVERTS], name );
+
+	patchesTime = (int)( Sys_Microseconds() - t );
 
 	CMod_CheckLeafBrushes();
 
+	t = Sys_Microseconds();
+	CM_FinishChecksum();
+	*checksum = cm.checksum;
+	checksumWait = (int)( Sys_Microseconds() - t );
+
 	// we are NOT freeing the file, because it is cached for the ref
 	FS_FreeFile( buf );
 
@@ -705,6 +1258,10 @@ void CM_LoadMap( const char *name, qboolean clientload, int *checksum ) {
 	if ( !clientload ) {
 		Q_strncpyz( cm.name, name, sizeof( cm.name ) );
 	}
+
+	Com_DPrintf( "%s: %.1f ms, read %.1f, lumps %.1f, patches %.1f, checksum %.1f (%.1f waited)\n",
+		name, ( Sys_Microseconds() - start ) * 0.001, readTime * 0.001, lumpsTime * 0.001,
+		patchesTime * 0.001, checksumJob.usec * 0.001, checksumWait * 0.001 );
 }
 
 
@@ -714,6 +1271,7 @@ CM_ClearMap
 ==================
 */
 void CM_ClearMap( void ) {
+	CM_FinishChecksum();
 	Com_Memset( &cm, 0, sizeof( cm ) );
 	CM_ClearLevelPatches();
 }
@@ -810,6 +1368,7 @@ static void CM_InitBoxHull( void )
 	box_brush = &cm.brushes[cm.numBrushes];
 	box_brush->numsides = 6;
 	box_brush->sides = cm.brushsides + cm.numBrushSides;
+	box_brush->sidePairs = box_sidePairs;
 	box_brush->contents = CONTENTS_BODY;
 
 	box_model.leaf.numLeafBrushes = 1;
@@ -841,6 +1400,8 @@ static void CM_InitBoxHull( void )
 
 		SetPlaneSignbits( p );
 	}
+
+	CM_SetBrushSidePairs( box_brush );
 }
 
 
@@ -875,6 +1436,14 @@ clipHandle_t CM_TempBoxModel( const vec3_t mins, const vec3_t maxs, int capsule
 	box_planes[10].dist = mins[2];
 	box_planes[11].dist = -mins[2];
 
+	// the planes of sides 0 to 5
+	box_sidePairs[0].dist[0] = maxs[0];
+	box_sidePairs[0].dist[1] = -mins[0];
+	box_sidePairs[1].dist[0] = maxs[1];
+	box_sidePairs[1].dist[1] = -mins[1];
+	box_sidePairs[2].dist[0] = maxs[2];
+	box_sidePairs[2].dist[1] = -mins[2];
+
 	VectorCopy( mins, box_brush->bounds[0] );
 	VectorCopy( maxs, box_brush->bounds[1] );
 
@@ -100,12 +100,19 @@ typedef struct {
 	int			shaderNum;
 } cbrushside_t;
 
+// the planes of two brush sides, laid out for CM_TraceThroughBrush
+typedef struct {
+	float		normal[3][2];	// [axis][side]
+	float		dist[2];
+} cbrushSidePair_t;
+
 typedef struct {
 	int			shaderNum;		// the shader that determined the contents
 	int			contents;
 	vec3_t		bounds[2];
 	int			numsides;
 	cbrushside_t	*sides;
+	cbrushSidePair_t	*sidePairs;	// ( numsides + 1 ) / 2, copied from sides
 	int			checkcount;		// to avoid repeated testings
 } cbrush_t;
 
@@ -224,6 +231,7 @@ typedef struct leafList_s {
 
 
 int CM_BoxBrushes( const vec3_t mins, const vec3_t maxs, cbrush_t **list, int listsize );
+void CM_SetBrushSidePairs( cbrush_t *brush );
 
 void CM_StoreLeafs( leafList_t *ll, int nodenum );
 void CM_StoreBrushes( leafList_t *ll, int nodenum );
@@ -236,7 +244,7 @@ qboolean CM_BoundsIntersectPoint( const vec3_t mins, const vec3_t maxs, const ve
 
 // cm_patch.c
 
-struct patchCollide_s	*CM_GeneratePatchCollide( int width, int height, vec3_t *points );
+struct patchCollide_s	*CM_GeneratePatchCollide( int width, int height, const vec3_t *points );
 void CM_TraceThroughPatchCollide( traceWork_t *tw, const struct patchCollide_s *pc );
 qboolean CM_PositionTestInPatchCollide( traceWork_t *tw, const struct patchCollide_s *pc );
 void CM_ClearLevelPatches( void );
@@ -103,7 +103,7 @@ void CM_ClearLevelPatches( void ) {
 CM_SignbitsForNormal
 =================
 */
-static int CM_SignbitsForNormal( const vec3_t normal ) {
+int CM_SignbitsForNormal( const vec3_t normal ) {
 	int	bits, j;
 
 	bits = 0;
@@ -419,12 +419,6 @@ PATCH COLLIDE GENERATION
 ================================================================================
 */
 
-static	int				numPlanes;
-static	patchPlane_t	planes[MAX_PATCH_PLANES];
-
-static	int				numFacets;
-static	facet_t			facets[MAX_FACETS];
-
 #define	NORMAL_EPSILON	0.0001
 #define	DIST_EPSILON	0.02
 
@@ -494,27 +488,29 @@ static void CM_SnapVector( vec3_t normal ) {
 CM_FindPlane2
 ==================
 */
-static int CM_FindPlane2( const float plane[4], int *flipped ) {
+static int CM_FindPlane2( patchWork_t *pw, const float plane[4], int *flipped ) {
 	int i;
 
 	// see if the points are close enough to an existing plane
-	for ( i = 0 ; i < numPlanes ; i++ ) {
-		if (CM_PlaneEqual(&planes[i], plane, flipped)) return i;
+	for ( i = 0 ; i < pw->numPlanes ; i++ ) {
+		if (CM_PlaneEqual(&pw->planes[i], plane, flipped)) return i;
 	}
 
 	// add a new plane
-	if ( numPlanes == MAX_PATCH_PLANES ) {
-		Com_Error( ERR_DROP, "MAX_PATCH_PLANES" );
+	if ( pw->numPlanes == MAX_PATCH_PLANES ) {
+		Q_strncpyz( pw->error, "MAX_PATCH_PLANES", sizeof( pw->error ) );
+		*flipped = qfalse;
+		return 0;
 	}
 
-	Vector4Copy( plane, planes[numPlanes].plane );
-	planes[numPlanes].signbits = CM_SignbitsForNormal( plane );
+	Vector4Copy( plane, pw->planes[pw->numPlanes].plane );
+	pw->planes[pw->numPlanes].signbits = CM_SignbitsForNormal( plane );
 
-	numPlanes++;
+	pw->numPlanes++;
 
 	*flipped = qfalse;
 
-	return numPlanes-1;
+	return pw->numPlanes-1;
 }
 
 
@@ -523,7 +519,7 @@ static int CM_FindPlane2( const float plane[4], int *flipped ) {
 CM_FindPlane
 ==================
 */
-static int CM_FindPlane( const float *p1, const float *p2, const float *p3 ) {
+static int CM_FindPlane( patchWork_t *pw, const float *p1, const float *p2, const float *p3 ) {
 	float	plane[4];
 	int		i;
 	float	d;
@@ -533,22 +529,22 @@ static int CM_FindPlane( const float *p1, const float *p2, const float *p3 ) {
 	}
 
 	// see if the points are close enough to an existing plane
-	for ( i = 0 ; i < numPlanes ; i++ ) {
-		if ( DotProduct( plane, planes[i].plane ) < 0 ) {
-			continue;	// allow backwards planes?
+	for ( i = 0 ; i < pw->numPlanes ; i++ ) {
+		if ( DotProduct( plane, pw->planes[i].plane ) < 0 ) {
+			continue;	// allow backwards pw->planes?
 		}
 
-		d = DotProduct( p1, planes[i].plane ) - planes[i].plane[3];
+		d = DotProduct( p1, pw->planes[i].plane ) - pw->planes[i].plane[3];
 		if ( d < -PLANE_TRI_EPSILON || d > PLANE_TRI_EPSILON ) {
 			continue;
 		}
 
-		d = DotProduct( p2, planes[i].plane ) - planes[i].plane[3];
+		d = DotProduct( p2, pw->planes[i].plane ) - pw->planes[i].plane[3];
 		if ( d < -PLANE_TRI_EPSILON || d > PLANE_TRI_EPSILON ) {
 			continue;
 		}
 
-		d = DotProduct( p3, planes[i].plane ) - planes[i].plane[3];
+		d = DotProduct( p3, pw->planes[i].plane ) - pw->planes[i].plane[3];
 		if ( d < -PLANE_TRI_EPSILON || d > PLANE_TRI_EPSILON ) {
 			continue;
 		}
@@ -558,16 +554,17 @@ static int CM_FindPlane( const float *p1, const float *p2, const float *p3 ) {
 	}
 
 	// add a new plane
-	if ( numPlanes == MAX_PATCH_PLANES ) {
-		Com_Error( ERR_DROP, "MAX_PATCH_PLANES" );
+	if ( pw->numPlanes == MAX_PATCH_PLANES ) {
+		Q_strncpyz( pw->error, "MAX_PATCH_PLANES", sizeof( pw->error ) );
+		return 0;
 	}
 
-	Vector4Copy( plane, planes[numPlanes].plane );
-	planes[numPlanes].signbits = CM_SignbitsForNormal( plane );
+	Vector4Copy( plane, pw->planes[pw->numPlanes].plane );
+	pw->planes[pw->numPlanes].signbits = CM_SignbitsForNormal( plane );
 
-	numPlanes++;
+	pw->numPlanes++;
 
-	return numPlanes-1;
+	return pw->numPlanes-1;
 }
 
 
@@ -576,14 +573,14 @@ static int CM_FindPlane( const float *p1, const float *p2, const float *p3 ) {
 CM_PointOnPlaneSide
 ==================
 */
-static int CM_PointOnPlaneSide( const float *p, int planeNum ) {
+static int CM_PointOnPlaneSide( const patchWork_t *pw, const float *p, int planeNum ) {
 	const float *plane;
 	double	d;
 
 	if ( planeNum == -1 ) {
 		return SIDE_ON;
 	}
-	plane = planes[ planeNum ].plane;
+	plane = pw->planes[ planeNum ].plane;
 
 	d = DotProductDPf( p, plane ) - plane[3];
 
@@ -617,7 +614,7 @@ static int	CM_GridPlane( int gridPlanes[MAX_GRID_SIZE][MAX_GRID_SIZE][2], int i,
 	}
 
 	// should never happen
-	Com_Printf( "WARNING: CM_GridPlane unresolvable\n" );
+	Com_JobPrintf( "WARNING: CM_GridPlane unresolvable\n" );
 	return -1;
 }
 
@@ -627,7 +624,8 @@ static int	CM_GridPlane( int gridPlanes[MAX_GRID_SIZE][MAX_GRID_SIZE][2], int i,
 CM_EdgePlaneNum
 ==================
 */
-static int CM_EdgePlaneNum( const cGrid_t *grid, int gridPlanes[MAX_GRID_SIZE][MAX_GRID_SIZE][2], int i, int j, int k ) {
+static int CM_EdgePlaneNum( patchWork_t *pw, int i, int j, int k ) {
+	const cGrid_t *grid = &pw->grid;
 	const float *p1, *p2;
 	vec3_t		up;
 	int			p;
@@ -636,66 +634,66 @@ static int CM_EdgePlaneNum( const cGrid_t *grid, int gridPlanes[MAX_GRID_SIZE][M
 	case 0:	// top border
 		p1 = grid->points[i][j];
 		p2 = grid->points[i+1][j];
-		p = CM_GridPlane( gridPlanes, i, j, 0 );
+		p = CM_GridPlane( pw->gridPlanes, i, j, 0 );
 		if ( p == -1 ) {
 			return -1;
 		}
-		VectorMA( p1, 4, planes[ p ].plane, up );
-		return CM_FindPlane( p1, p2, up );
+		VectorMA( p1, 4, pw->planes[ p ].plane, up );
+		return CM_FindPlane( pw, p1, p2, up );
 
 	case 2:	// bottom border
 		p1 = grid->points[i][j+1];
 		p2 = grid->points[i+1][j+1];
-		p = CM_GridPlane( gridPlanes, i, j, 1 );
+		p = CM_GridPlane( pw->gridPlanes, i, j, 1 );
 		if ( p == -1 ) {
 			return -1;
 		}
-		VectorMA( p1, 4, planes[ p ].plane, up );
-		return CM_FindPlane( p2, p1, up );
+		VectorMA( p1, 4, pw->planes[ p ].plane, up );
+		return CM_FindPlane( pw, p2, p1, up );
 
 	case 3: // left border
 		p1 = grid->points[i][j];
 		p2 = grid->points[i][j+1];
-		p = CM_GridPlane( gridPlanes, i, j, 1 );
+		p = CM_GridPlane( pw->gridPlanes, i, j, 1 );
 		if ( p == -1 ) {
 			return -1;
 		}
-		VectorMA( p1, 4, planes[ p ].plane, up );
-		return CM_FindPlane( p2, p1, up );
+		VectorMA( p1, 4, pw->planes[ p ].plane, up );
+		return CM_FindPlane( pw, p2, p1, up );
 
 	case 1:	// right border
 		p1 = grid->points[i+1][j];
 		p2 = grid->points[i+1][j+1];
-		p = CM_GridPlane( gridPlanes, i, j, 0 );
+		p = CM_GridPlane( pw->gridPlanes, i, j, 0 );
 		if ( p == -1 ) {
 			return -1;
 		}
-		VectorMA( p1, 4, planes[ p ].plane, up );
-		return CM_FindPlane( p1, p2, up );
+		VectorMA( p1, 4, pw->planes[ p ].plane, up );
+		return CM_FindPlane( pw, p1, p2, up );
 
 	case 4:	// diagonal out of triangle 0
 		p1 = grid->points[i+1][j+1];
 		p2 = grid->points[i][j];
-		p = CM_GridPlane( gridPlanes, i, j, 0 );
+		p = CM_GridPlane( pw->gridPlanes, i, j, 0 );
 		if ( p == -1 ) {
 			return -1;
 		}
-		VectorMA( p1, 4, planes[ p ].plane, up );
-		return CM_FindPlane( p1, p2, up );
+		VectorMA( p1, 4, pw->planes[ p ].plane, up );
+		return CM_FindPlane( pw, p1, p2, up );
 
 	case 5:	// diagonal out of triangle 1
 		p1 = grid->points[i][j];
 		p2 = grid->points[i+1][j+1];
-		p = CM_GridPlane( gridPlanes, i, j, 1 );
+		p = CM_GridPlane( pw->gridPlanes, i, j, 1 );
 		if ( p == -1 ) {
 			return -1;
 		}
-		VectorMA( p1, 4, planes[ p ].plane, up );
-		return CM_FindPlane( p1, p2, up );
+		VectorMA( p1, 4, pw->planes[ p ].plane, up );
+		return CM_FindPlane( pw, p1, p2, up );
 
 	}
 
-	Com_Error( ERR_DROP, "CM_EdgePlaneNum: bad k" );
+	Q_strncpyz( pw->error, "CM_EdgePlaneNum: bad k", sizeof( pw->error ) );
 	return -1;
 }
 
@@ -705,8 +703,8 @@ static int CM_EdgePlaneNum( const cGrid_t *grid, int gridPlanes[MAX_GRID_SIZE][M
 CM_SetBorderInward
 ===================
 */
-static void CM_SetBorderInward( facet_t *facet, const cGrid_t *grid, int gridPlanes[MAX_GRID_SIZE][MAX_GRID_SIZE][2],
-						  int i, int j, int which ) {
+static void CM_SetBorderInward( patchWork_t *pw, facet_t *facet, int i, int j, int which ) {
+	const cGrid_t *grid = &pw->grid;
 	int		k, l;
 	const float *points[4];
 	int		numPoints;
@@ -732,9 +730,8 @@ static void CM_SetBorderInward( facet_t *facet, const cGrid_t *grid, int gridPla
 		numPoints = 3;
 		break;
 	default:
-		Com_Error( ERR_FATAL, "CM_SetBorderInward: bad parameter" );
-		numPoints = 0;
-		break;
+		Q_strncpyz( pw->error, "CM_SetBorderInward: bad parameter", sizeof( pw->error ) );
+		return;
 	}
 
 	for ( k = 0 ; k < facet->numBorders ; k++ ) {
@@ -746,7 +743,7 @@ static void CM_SetBorderInward( facet_t *facet, const cGrid_t *grid, int gridPla
 		for ( l = 0 ; l < numPoints ; l++ ) {
 			int		side;
 
-			side = CM_PointOnPlaneSide( points[l], facet->borderPlanes[k] );
+			side = CM_PointOnPlaneSide( pw, points[l], facet->borderPlanes[k] );
 			if ( side == SIDE_FRONT ) {
 				front++;
 			} else if ( side == SIDE_BACK ) {
@@ -763,14 +760,14 @@ static void CM_SetBorderInward( facet_t *facet, const cGrid_t *grid, int gridPla
 			facet->borderPlanes[k] = -1;
 		} else {
 			// bisecting side border
-			Com_DPrintf( "WARNING: CM_SetBorderInward: mixed plane sides\n" );
+			Com_JobDPrintf( "WARNING: CM_SetBorderInward: mixed plane sides\n" );
 			facet->borderInward[k] = qfalse;
-			if ( !debugBlock ) {
-				debugBlock = qtrue;
-				VectorCopy( grid->points[i][j], debugBlockPoints[0] );
-				VectorCopy( grid->points[i+1][j], debugBlockPoints[1] );
-				VectorCopy( grid->points[i+1][j+1], debugBlockPoints[2] );
-				VectorCopy( grid->points[i][j+1], debugBlockPoints[3] );
+			if ( !pw->debugBlock ) {
+				pw->debugBlock = qtrue;
+				VectorCopy( grid->points[i][j], pw->debugBlockPoints[0] );
+				VectorCopy( grid->points[i+1][j], pw->debugBlockPoints[1] );
+				VectorCopy( grid->points[i+1][j+1], pw->debugBlockPoints[2] );
+				VectorCopy( grid->points[i][j+1], pw->debugBlockPoints[3] );
 			}
 		}
 	}
@@ -784,7 +781,7 @@ CM_ValidateFacet
 If the facet isn't bounded by its borders, we screwed up.
 ==================
 */
-static qboolean CM_ValidateFacet( const facet_t *facet ) {
+static qboolean CM_ValidateFacet( patchWork_t *pw, const facet_t *facet ) {
 	float		plane[4];
 	int			j;
 	winding_t	*w;
@@ -794,19 +791,27 @@ static qboolean CM_ValidateFacet( const facet_t *facet ) {
 		return qfalse;
 	}
 
-	Vector4Copy( planes[ facet->surfacePlane ].plane, plane );
+	Vector4Copy( pw->planes[ facet->surfacePlane ].plane, plane );
 	w = BaseWindingForPlane( plane,  plane[3] );
+	if ( !w ) {
+		Q_strncpyz( pw->error, "CM_ValidateFacet: bad facet winding", sizeof( pw->error ) );
+		return qfalse;
+	}
 	for ( j = 0 ; j < facet->numBorders && w ; j++ ) {
 		if ( facet->borderPlanes[j] == -1 ) {
 			FreeWinding( w );
 			return qfalse;
 		}
-		Vector4Copy( planes[ facet->borderPlanes[j] ].plane, plane );
+		Vector4Copy( pw->planes[ facet->borderPlanes[j] ].plane, plane );
 		if ( !facet->borderInward[j] ) {
 			VectorSubtract( vec3_origin, plane, plane );
 			plane[3] = -plane[3];
 		}
-		ChopWindingInPlace( &w, plane, plane[3], 0.1f );
+		if ( !ChopWindingInPlace( &w, plane, plane[3], 0.1f ) ) {
+			FreeWinding( w );
+			Q_strncpyz( pw->error, "CM_ValidateFacet: bad facet winding", sizeof( pw->error ) );
+			return qfalse;
+		}
 	}
 
 	if ( !w ) {
@@ -837,7 +842,7 @@ static qboolean CM_ValidateFacet( const facet_t *facet ) {
 CM_AddFacetBevels
 ==================
 */
-static void CM_AddFacetBevels( facet_t *facet ) {
+static void CM_AddFacetBevels( patchWork_t *pw, facet_t *facet ) {
 
 	int i, j, k, l;
 	int axis, dir, order, flipped;
@@ -846,19 +851,27 @@ static void CM_AddFacetBevels( facet_t *facet ) {
 	vec3_t mins, maxs, vec, vec2;
 	double d, d1[3], d2[3];
 
-	Vector4Copy( planes[ facet->surfacePlane ].plane, plane );
+	Vector4Copy( pw->planes[ facet->surfacePlane ].plane, plane );
 
 	w = BaseWindingForPlane( plane,  plane[3] );
+	if ( !w ) {
+		Q_strncpyz( pw->error, "CM_AddFacetBevels: bad facet winding", sizeof( pw->error ) );
+		return;
+	}
 	for ( j = 0 ; j < facet->numBorders && w ; j++ ) {
 		if (facet->borderPlanes[j] == facet->surfacePlane) continue;
-		Vector4Copy( planes[ facet->borderPlanes[j] ].plane, plane );
+		Vector4Copy( pw->planes[ facet->borderPlanes[j] ].plane, plane );
 
 		if ( !facet->borderInward[j] ) {
 			VectorSubtract( vec3_origin, plane, plane );
 			plane[3] = -plane[3];
 		}
 
-		ChopWindingInPlace( &w, plane, plane[3], 0.1f );
+		if ( !ChopWindingInPlace( &w, plane, plane[3], 0.1f ) ) {
+			FreeWinding( w );
+			Q_strncpyz( pw->error, "CM_AddFacetBevels: bad facet winding", sizeof( pw->error ) );
+			return;
+		}
 	}
 	if ( !w ) {
 		return;
@@ -866,7 +879,7 @@ static void CM_AddFacetBevels( facet_t *facet ) {
 
 	WindingBounds(w, mins, maxs);
 
-	// add the axial planes
+	// add the axial pw->planes
 	order = 0;
 	for ( axis = 0 ; axis < 3 ; axis++ )
 	{
@@ -881,21 +894,21 @@ static void CM_AddFacetBevels( facet_t *facet ) {
 				plane[3] = -mins[axis];
 			}
 			//if it's the surface plane
-			if (CM_PlaneEqual(&planes[facet->surfacePlane], plane, &flipped)) {
+			if (CM_PlaneEqual(&pw->planes[facet->surfacePlane], plane, &flipped)) {
 				continue;
 			}
 			// see if the plane is already present
 			for ( i = 0 ; i < facet->numBorders ; i++ ) {
-				if (CM_PlaneEqual(&planes[facet->borderPlanes[i]], plane, &flipped))
+				if (CM_PlaneEqual(&pw->planes[facet->borderPlanes[i]], plane, &flipped))
 					break;
 			}
 
 			if ( i == facet->numBorders ) {
 				if ( facet->numBorders >= 4 + 6 + 16 ) {
-					Com_Printf( "ERROR: too many bevels\n" );
+					Com_JobPrintf( "ERROR: too many bevels\n" );
 					continue;
 				}
-				facet->borderPlanes[facet->numBorders] = CM_FindPlane2(plane, &flipped);
+				facet->borderPlanes[facet->numBorders] = CM_FindPlane2( pw, plane, &flipped );
 				facet->borderNoAdjust[facet->numBorders] = 0;
 				facet->borderInward[facet->numBorders] = flipped;
 				facet->numBorders++;
@@ -947,41 +960,51 @@ static void CM_AddFacetBevels( facet_t *facet ) {
 					continue;
 
 				//if it's the surface plane
-				if (CM_PlaneEqual(&planes[facet->surfacePlane], plane, &flipped)) {
+				if (CM_PlaneEqual(&pw->planes[facet->surfacePlane], plane, &flipped)) {
 					continue;
 				}
 				// see if the plane is already present
 				for ( i = 0 ; i < facet->numBorders ; i++ ) {
-					if (CM_PlaneEqual(&planes[facet->borderPlanes[i]], plane, &flipped)) {
+					if (CM_PlaneEqual(&pw->planes[facet->borderPlanes[i]], plane, &flipped)) {
 							break;
 					}
 				}
 
 				if ( i == facet->numBorders ) {
 					if ( facet->numBorders >= 4 + 6 + 16 ) {
-						Com_Printf( "ERROR: too many bevels\n" );
+						Com_JobPrintf( "ERROR: too many bevels\n" );
 						continue;
 					}
-					facet->borderPlanes[facet->numBorders] = CM_FindPlane2(plane, &flipped);
+					facet->borderPlanes[facet->numBorders] = CM_FindPlane2( pw, plane, &flipped );
 
 					for ( k = 0 ; k < facet->numBorders ; k++ ) {
 						if (facet->borderPlanes[facet->numBorders] ==
-							facet->borderPlanes[k]) Com_Printf("WARNING: bevel plane already used\n");
+							facet->borderPlanes[k]) Com_JobPrintf("WARNING: bevel plane already used\n");
 					}
 
 					facet->borderNoAdjust[facet->numBorders] = 0;
 					facet->borderInward[facet->numBorders] = flipped;
 					//
 					w2 = CopyWinding(w);
-					Vector4Copy(planes[facet->borderPlanes[facet->numBorders]].plane, newplane);
+					if ( !w2 ) {
+						FreeWinding( w );
+						Q_strncpyz( pw->error, "CM_AddFacetBevels: out of memory", sizeof( pw->error ) );
+						return;
+					}
+					Vector4Copy(pw->planes[facet->borderPlanes[facet->numBorders]].plane, newplane);
 					if (!facet->borderInward[facet->numBorders])
 					{
 						VectorNegate(newplane, newplane);
 						newplane[3] = -newplane[3];
 					} //end if
-					ChopWindingInPlace( &w2, newplane, newplane[3], 0.1f );
+					if ( !ChopWindingInPlace( &w2, newplane, newplane[3], 0.1f ) ) {
+						FreeWinding( w2 );
+						FreeWinding( w );
+						Q_strncpyz( pw->error, "CM_AddFacetBevels: bad facet winding", sizeof( pw->error ) );
+						return;
+					}
 					if (!w2) {
-						Com_DPrintf("WARNING: CM_AddFacetBevels... invalid bevel\n");
+						Com_JobDPrintf("WARNING: CM_AddFacetBevels... invalid bevel\n");
 						continue;
 					}
 					else {
@@ -1000,7 +1023,7 @@ static void CM_AddFacetBevels( facet_t *facet ) {
 #ifndef BSPC
 	//add opposite plane
 	if ( facet->numBorders >= 4 + 6 + 16 ) {
-		Com_Printf( "ERROR: too many bevels\n" );
+		Com_JobPrintf( "ERROR: too many bevels\n" );
 		return;
 	}
 	facet->borderPlanes[facet->numBorders] = facet->surfacePlane;
@@ -1023,29 +1046,30 @@ typedef enum {
 CM_PatchCollideFromGrid
 ==================
 */
-static void CM_PatchCollideFromGrid( const cGrid_t *grid, patchCollide_t *pf ) {
+static void CM_PatchCollideFromGrid( patchWork_t *pw ) {
+	const cGrid_t	*grid = &pw->grid;
+	int				(*gridPlanes)[MAX_GRID_SIZE][2] = pw->gridPlanes;
 	int				i, j;
 	const float		*p1, *p2, *p3;
-	int				gridPlanes[MAX_GRID_SIZE][MAX_GRID_SIZE][2];
 	facet_t			*facet;
 	int				borders[4];
 	qboolean		noAdjust[4];
 
-	numPlanes = 0;
-	numFacets = 0;
+	pw->numPlanes = 0;
+	pw->numFacets = 0;
 
-	// find the planes for each triangle of the grid
+	// find the pw->planes for each triangle of the grid
 	for ( i = 0 ; i < grid->width - 1 ; i++ ) {
 		for ( j = 0 ; j < grid->height - 1 ; j++ ) {
 			p1 = grid->points[i][j];
 			p2 = grid->points[i+1][j];
 			p3 = grid->points[i+1][j+1];
-			gridPlanes[i][j][0] = CM_FindPlane( p1, p2, p3 );
+			gridPlanes[i][j][0] = CM_FindPlane( pw, p1, p2, p3 );
 
 			p1 = grid->points[i+1][j+1];
 			p2 = grid->points[i][j+1];
 			p3 = grid->points[i][j];
-			gridPlanes[i][j][1] = CM_FindPlane( p1, p2, p3 );
+			gridPlanes[i][j][1] = CM_FindPlane( pw, p1, p2, p3 );
 		}
 	}
 
@@ -1061,7 +1085,7 @@ static void CM_PatchCollideFromGrid( const cGrid_t *grid, patchCollide_t *pf ) {
 			}
 			noAdjust[EN_TOP] = ( borders[EN_TOP] == gridPlanes[i][j][0] );
 			if ( borders[EN_TOP] == -1 || noAdjust[EN_TOP] ) {
-				borders[EN_TOP] = CM_EdgePlaneNum( grid, gridPlanes, i, j, 0 );
+				borders[EN_TOP] = CM_EdgePlaneNum( pw, i, j, 0 );
 			}
 
 			borders[EN_BOTTOM] = -1;
@@ -1072,7 +1096,7 @@ static void CM_PatchCollideFromGrid( const cGrid_t *grid, patchCollide_t *pf ) {
 			}
 			noAdjust[EN_BOTTOM] = ( borders[EN_BOTTOM] == gridPlanes[i][j][1] );
 			if ( borders[EN_BOTTOM] == -1 || noAdjust[EN_BOTTOM] ) {
-				borders[EN_BOTTOM] = CM_EdgePlaneNum( grid, gridPlanes, i, j, 2 );
+				borders[EN_BOTTOM] = CM_EdgePlaneNum( pw, i, j, 2 );
 			}
 
 			borders[EN_LEFT] = -1;
@@ -1083,7 +1107,7 @@ static void CM_PatchCollideFromGrid( const cGrid_t *grid, patchCollide_t *pf ) {
 			}
 			noAdjust[EN_LEFT] = ( borders[EN_LEFT] == gridPlanes[i][j][1] );
 			if ( borders[EN_LEFT] == -1 || noAdjust[EN_LEFT] ) {
-				borders[EN_LEFT] = CM_EdgePlaneNum( grid, gridPlanes, i, j, 3 );
+				borders[EN_LEFT] = CM_EdgePlaneNum( pw, i, j, 3 );
 			}
 
 			borders[EN_RIGHT] = -1;
@@ -1094,13 +1118,14 @@ static void CM_PatchCollideFromGrid( const cGrid_t *grid, patchCollide_t *pf ) {
 			}
 			noAdjust[EN_RIGHT] = ( borders[EN_RIGHT] == gridPlanes[i][j][0] );
 			if ( borders[EN_RIGHT] == -1 || noAdjust[EN_RIGHT] ) {
-				borders[EN_RIGHT] = CM_EdgePlaneNum( grid, gridPlanes, i, j, 1 );
+				borders[EN_RIGHT] = CM_EdgePlaneNum( pw, i, j, 1 );
 			}
 
-			if ( numFacets == MAX_FACETS ) {
-				Com_Error( ERR_DROP, "MAX_FACETS" );
+			if ( pw->numFacets == MAX_FACETS ) {
+				Q_strncpyz( pw->error, "MAX_FACETS", sizeof( pw->error ) );
+				return;
 			}
-			facet = &facets[numFacets];
+			facet = &pw->facets[pw->numFacets];
 			Com_Memset( facet, 0, sizeof( *facet ) );
 
 			if ( gridPlanes[i][j][0] == gridPlanes[i][j][1] ) {
@@ -1117,10 +1142,10 @@ static void CM_PatchCollideFromGrid( const cGrid_t *grid, patchCollide_t *pf ) {
 				facet->borderNoAdjust[2] = noAdjust[EN_BOTTOM];
 				facet->borderPlanes[3] = borders[EN_LEFT];
 				facet->borderNoAdjust[3] = noAdjust[EN_LEFT];
-				CM_SetBorderInward( facet, grid, gridPlanes, i, j, -1 );
-				if ( CM_ValidateFacet( facet ) ) {
-					CM_AddFacetBevels( facet );
-					numFacets++;
+				CM_SetBorderInward( pw, facet, i, j, -1 );
+				if ( CM_ValidateFacet( pw, facet ) ) {
+					CM_AddFacetBevels( pw, facet );
+					pw->numFacets++;
 				}
 			} else {
 				// two separate triangles
@@ -1134,19 +1159,20 @@ static void CM_PatchCollideFromGrid( const cGrid_t *grid, patchCollide_t *pf ) {
 				if ( facet->borderPlanes[2] == -1 ) {
 					facet->borderPlanes[2] = borders[EN_BOTTOM];
 					if ( facet->borderPlanes[2] == -1 ) {
-						facet->borderPlanes[2] = CM_EdgePlaneNum( grid, gridPlanes, i, j, 4 );
+						facet->borderPlanes[2] = CM_EdgePlaneNum( pw, i, j, 4 );
 					}
 				}
- 				CM_SetBorderInward( facet, grid, gridPlanes, i, j, 0 );
-				if ( CM_ValidateFacet( facet ) ) {
-					CM_AddFacetBevels( facet );
-					numFacets++;
+ 				CM_SetBorderInward( pw, facet, i, j, 0 );
+				if ( CM_ValidateFacet( pw, facet ) ) {
+					CM_AddFacetBevels( pw, facet );
+					pw->numFacets++;
 				}
 
-				if ( numFacets == MAX_FACETS ) {
-					Com_Error( ERR_DROP, "MAX_FACETS" );
+				if ( pw->numFacets == MAX_FACETS ) {
+					Q_strncpyz( pw->error, "MAX_FACETS", sizeof( pw->error ) );
+					return;
 				}
-				facet = &facets[numFacets];
+				facet = &pw->facets[pw->numFacets];
 				Com_Memset( facet, 0, sizeof( *facet ) );
 
 				facet->surfacePlane = gridPlanes[i][j][1];
@@ -1159,106 +1185,191 @@ static void CM_PatchCollideFromGrid( const cGrid_t *grid, patchCollide_t *pf ) {
 				if ( facet->borderPlanes[2] == -1 ) {
 					facet->borderPlanes[2] = borders[EN_TOP];
 					if ( facet->borderPlanes[2] == -1 ) {
-						facet->borderPlanes[2] = CM_EdgePlaneNum( grid, gridPlanes, i, j, 5 );
+						facet->borderPlanes[2] = CM_EdgePlaneNum( pw, i, j, 5 );
 					}
 				}
-				CM_SetBorderInward( facet, grid, gridPlanes, i, j, 1 );
-				if ( CM_ValidateFacet( facet ) ) {
-					CM_AddFacetBevels( facet );
-					numFacets++;
+				CM_SetBorderInward( pw, facet, i, j, 1 );
+				if ( CM_ValidateFacet( pw, facet ) ) {
+					CM_AddFacetBevels( pw, facet );
+					pw->numFacets++;
 				}
 			}
 		}
 	}
 
-	// copy the results out
-	pf->numPlanes = numPlanes;
-	pf->numFacets = numFacets;
-	pf->facets = Hunk_Alloc( numFacets * sizeof( *pf->facets ), h_high );
-	Com_Memcpy( pf->facets, facets, numFacets * sizeof( *pf->facets ) );
-	pf->planes = Hunk_Alloc( numPlanes * sizeof( *pf->planes ), h_high );
-	Com_Memcpy( pf->planes, planes, numPlanes * sizeof( *pf->planes ) );
 }
 
 
 /*
 ===================
-CM_GeneratePatchCollide
+CM_GeneratePatchWork
 
-Creates an internal structure that will be used to perform
-collision detection with a patch mesh.
+The part of CM_GeneratePatchCollide that can run on any thread, with
+its own patchWork_t. Returns the collision in one malloc, with the
+planes and facets following the patchCollide_t, or NULL and the
+reason in pw->error.
 
 Points are packed as concatenated rows.
 ===================
 */
-struct patchCollide_s *CM_GeneratePatchCollide( int width, int height, vec3_t *points ) {
+patchCollide_t *CM_GeneratePatchWork( patchWork_t *pw, int width, int height, const vec3_t *points ) {
+	cGrid_t			*grid = &pw->grid;
 	patchCollide_t	*pf;
-	cGrid_t			grid;
+	vec3_t			bounds[2];
 	int				i, j;
 
+	pw->error[0] = '\0';
+
 	if ( width <= 2 || height <= 2 || !points ) {
-		Com_Error( ERR_DROP, "CM_GeneratePatchFacets: bad parameters: (%i, %i, %p)",
-			width, height, (void *)points );
+		Com_sprintf( pw->error, sizeof( pw->error ), "CM_GeneratePatchWork: bad parameters: (%i, %i, %p)",
+			width, height, (const void *)points );
+		return NULL;
 	}
 
 	if ( !(width & 1) || !(height & 1) ) {
-		Com_Error( ERR_DROP, "CM_GeneratePatchFacets: even sizes are invalid for quadratic meshes" );
+		Q_strncpyz( pw->error, "CM_GeneratePatchWork: even sizes are invalid for quadratic meshes", sizeof( pw->error ) );
+		return NULL;
 	}
 
 	if ( width > MAX_GRID_SIZE || height > MAX_GRID_SIZE ) {
-		Com_Error( ERR_DROP, "CM_GeneratePatchFacets: source is > MAX_GRID_SIZE" );
+		Q_strncpyz( pw->error, "CM_GeneratePatchWork: source is > MAX_GRID_SIZE", sizeof( pw->error ) );
+		return NULL;
 	}
 
 	// build a grid
-	grid.width = width;
-	grid.height = height;
-	grid.wrapWidth = qfalse;
-	grid.wrapHeight = qfalse;
+	grid->width = width;
+	grid->height = height;
+	grid->wrapWidth = qfalse;
+	grid->wrapHeight = qfalse;
 	for ( i = 0 ; i < width ; i++ ) {
 		for ( j = 0 ; j < height ; j++ ) {
-			VectorCopy( points[j*width + i], grid.points[i][j] );
+			VectorCopy( points[j*width + i], grid->points[i][j] );
 		}
 	}
 
 	// subdivide the grid
-	CM_SetGridWrapWidth( &grid );
-	CM_SubdivideGridColumns( &grid );
-	CM_RemoveDegenerateColumns( &grid );
+	CM_SetGridWrapWidth( grid );
+	CM_SubdivideGridColumns( grid );
+	CM_RemoveDegenerateColumns( grid );
 
-	CM_TransposeGrid( &grid );
+	CM_TransposeGrid( grid );
 
-	CM_SetGridWrapWidth( &grid );
-	CM_SubdivideGridColumns( &grid );
-	CM_RemoveDegenerateColumns( &grid );
+	CM_SetGridWrapWidth( grid );
+	CM_SubdivideGridColumns( grid );
+	CM_RemoveDegenerateColumns( grid );
 
 	// we now have a grid of points exactly on the curve
 	// the approximate surface defined by these points will be
 	// collided against
-	pf = Hunk_Alloc( sizeof( *pf ), h_high );
-	ClearBounds( pf->bounds[0], pf->bounds[1] );
-	for ( i = 0 ; i < grid.width ; i++ ) {
-		for ( j = 0 ; j < grid.height ; j++ ) {
-			AddPointToBounds( grid.points[i][j], pf->bounds[0], pf->bounds[1] );
+	ClearBounds( bounds[0], bounds[1] );
+	for ( i = 0 ; i < grid->width ; i++ ) {
+		for ( j = 0 ; j < grid->height ; j++ ) {
+			AddPointToBounds( grid->points[i][j], bounds[0], bounds[1] );
 		}
 	}
 
-	c_totalPatchBlocks += ( grid.width - 1 ) * ( grid.height - 1 );
+	pw->numBlocks += ( grid->width - 1 ) * ( grid->height - 1 );
 
 	// generate a bsp tree for the surface
-	CM_PatchCollideFromGrid( &grid, pf );
+	CM_PatchCollideFromGrid( pw );
+	if ( pw->error[0] ) {
+		return NULL;
+	}
+
+	// copy the results out
+	pf = malloc( sizeof( *pf ) + pw->numPlanes * sizeof( pf->planes[0] ) + pw->numFacets * sizeof( pf->facets[0] ) );
+	if ( !pf ) {
+		Q_strncpyz( pw->error, "CM_GeneratePatchWork: out of memory", sizeof( pw->error ) );
+		return NULL;
+	}
 
 	// expand by one unit for epsilon purposes
-	pf->bounds[0][0] -= 1;
-	pf->bounds[0][1] -= 1;
-	pf->bounds[0][2] -= 1;
+	pf->bounds[0][0] = bounds[0][0] - 1;
+	pf->bounds[0][1] = bounds[0][1] - 1;
+	pf->bounds[0][2] = bounds[0][2] - 1;
+
+	pf->bounds[1][0] = bounds[1][0] + 1;
+	pf->bounds[1][1] = bounds[1][1] + 1;
+	pf->bounds[1][2] = bounds[1][2] + 1;
 
-	pf->bounds[1][0] += 1;
-	pf->bounds[1][1] += 1;
-	pf->bounds[1][2] += 1;
+	pf->numPlanes = pw->numPlanes;
+	pf->planes = (patchPlane_t *)( pf + 1 );
+	Com_Memcpy( pf->planes, pw->planes, pw->numPlanes * sizeof( pf->planes[0] ) );
+	pf->numFacets = pw->numFacets;
+	pf->facets = (facet_t *)( pf->planes + pw->numPlanes );
+	Com_Memcpy( pf->facets, pw->facets, pw->numFacets * sizeof( pf->facets[0] ) );
 
 	return pf;
 }
 
+
+/*
+===================
+CM_FinishPatchWork
+
+Main thread only, once the patches generated with pw are finished.
+===================
+*/
+void CM_FinishPatchWork( const patchWork_t *pw ) {
+	c_totalPatchBlocks += pw->numBlocks;
+
+	if ( pw->debugBlock && !debugBlock ) {
+		debugBlock = qtrue;
+		Com_Memcpy( debugBlockPoints, pw->debugBlockPoints, sizeof( debugBlockPoints ) );
+	}
+}
+
+
+/*
+===================
+CM_FinishPatchCollide
+
+Main thread only, moves a CM_GeneratePatchWork result to the hunk.
+===================
+*/
+patchCollide_t *CM_FinishPatchCollide( patchCollide_t *work ) {
+	patchCollide_t *pf;
+
+	pf = Hunk_Alloc( sizeof( *pf ), h_high );
+	*pf = *work;
+	pf->facets = Hunk_Alloc( pf->numFacets * sizeof( *pf->facets ), h_high );
+	Com_Memcpy( pf->facets, work->facets, pf->numFacets * sizeof( *pf->facets ) );
+	pf->planes = Hunk_Alloc( pf->numPlanes * sizeof( *pf->planes ), h_high );
+	Com_Memcpy( pf->planes, work->planes, pf->numPlanes * sizeof( *pf->planes ) );
+
+	free( work );
+
+	return pf;
+}
+
+
+/*
+===================
+CM_GeneratePatchCollide
+
+Creates an internal structure that will be used to perform
+collision detection with a patch mesh.
+
+Points are packed as concatenated rows.
+===================
+*/
+struct patchCollide_s *CM_GeneratePatchCollide( int width, int height, const vec3_t *points ) {
+	static patchWork_t	work;
+	patchCollide_t		*pf;
+
+	work.numBlocks = 0;
+	work.debugBlock = qfalse;
+
+	pf = CM_GeneratePatchWork( &work, width, height, points );
+	if ( !pf ) {
+		Com_Error( ERR_DROP, "%s", work.error );
+	}
+
+	CM_FinishPatchWork( &work );
+
+	return CM_FinishPatchCollide( pf );
+}
+
 /*
 ================================================================================
 
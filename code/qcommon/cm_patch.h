@@ -95,9 +95,31 @@ typedef struct {
 	vec3_t	points[MAX_GRID_SIZE][MAX_GRID_SIZE];	// [width][height]
 } cGrid_t;
 
+// everything the collision of a patch is generated in, so
+// several threads can generate patches with one each
+typedef struct {
+	cGrid_t			grid;
+	int				gridPlanes[MAX_GRID_SIZE][MAX_GRID_SIZE][2];
+
+	int				numPlanes;
+	patchPlane_t	planes[MAX_PATCH_PLANES];
+	int				numFacets;
+	facet_t			facets[MAX_FACETS];
+
+	char			error[128];		// for the main thread to Com_Error with
+	int				numBlocks;
+	qboolean		debugBlock;
+	vec3_t			debugBlockPoints[4];
+} patchWork_t;
+
 #define	SUBDIVIDE_DISTANCE	16	//4	// never more than this units away from curve
 #define	PLANE_TRI_EPSILON	0.1
 #define	WRAP_POINT_EPSILON	0.1
 
 
-struct patchCollide_s	*CM_GeneratePatchCollide( int width, int height, vec3_t *points );
+struct patchCollide_s	*CM_GeneratePatchCollide( int width, int height, const vec3_t *points );
+
+patchCollide_t	*CM_GeneratePatchWork( patchWork_t *pw, int width, int height, const vec3_t *points );
+void			CM_FinishPatchWork( const patchWork_t *pw );
+patchCollide_t	*CM_FinishPatchCollide( patchCollide_t *work );
+int				CM_SignbitsForNormal( const vec3_t normal );
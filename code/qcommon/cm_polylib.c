@@ -26,13 +26,6 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "cm_local.h"
 
 
-// counters are only bumped when running single threaded,
-// because they are an awful coherence problem
-static int c_active_windings;
-static int c_peak_windings;
-static int c_winding_allocs;
-static int c_winding_points;
-
 #if 0
 static void pw(winding_t *w)
 {
@@ -46,6 +39,11 @@ static void pw(winding_t *w)
 /*
 =============
 AllocWinding
+
+Returns NULL when out of memory. Patch collision is generated on
+several threads, where neither the zone nor Com_Error may be used,
+so BaseWindingForPlane, CopyWinding and ChopWindingInPlace report
+their failures to the caller instead.
 =============
 */
 static winding_t *AllocWinding( int points )
@@ -53,14 +51,11 @@ static winding_t *AllocWinding( int points )
 	winding_t	*w;
 	size_t		s;
 
-	c_winding_allocs++;
-	c_winding_points += points;
-	c_active_windings++;
-	if ( c_active_windings > c_peak_windings )
-		c_peak_windings = c_active_windings;
-
 	s = sizeof( *w ) - sizeof( w->p ) + sizeof( w->p[0] ) * points;
-	w = Z_Malloc( s );
+	w = malloc( s );
+	if ( !w ) {
+		return NULL;
+	}
 	Com_Memset( w, 0, s );
 	return w;
 }
@@ -72,8 +67,7 @@ void FreeWinding (winding_t *w)
 		Com_Error (ERR_FATAL, "FreeWinding: freed a freed winding");
 	*(unsigned *)w = 0xdeaddead;
 
-	c_active_windings--;
-	Z_Free (w);
+	free (w);
 }
 
 /*
@@ -202,6 +196,8 @@ void	WindingCenter (winding_t *w, vec3_t center)
 /*
 =================
 BaseWindingForPlane
+
+Returns NULL for a normal without a major axis (NaN) or when out of memory
 =================
 */
 winding_t *BaseWindingForPlane (vec3_t normal, vec_t dist)
@@ -226,7 +222,7 @@ winding_t *BaseWindingForPlane (vec3_t normal, vec_t dist)
 	}
 
 	if ( x < 0 )
-		Com_Error( ERR_DROP, "BaseWindingForPlane: no axis found" );
+		return NULL;
 		
 	VectorCopy (vec3_origin, vup);
 	switch (x)
@@ -253,6 +249,8 @@ winding_t *BaseWindingForPlane (vec3_t normal, vec_t dist)
 
 // project a really big	axis aligned box onto the plane
 	w = AllocWinding (4);
+	if ( !w )
+		return NULL;
 	
 	VectorSubtract (org, vright, w->p[0]);
 	VectorAdd (w->p[0], vup, w->p[0]);
@@ -283,6 +281,8 @@ winding_t *CopyWinding( const winding_t *w )
 	winding_t	*c;
 
 	c = AllocWinding( w->numpoints );
+	if ( !c )
+		return NULL;
 	size = sizeof( *w ) - sizeof( w->p ) + sizeof( w->p[0] )* w->numpoints;
 	Com_Memcpy( c, w, size );
 	return c;
@@ -299,6 +299,8 @@ winding_t	*ReverseWinding (winding_t *w)
 	winding_t	*c;
 
 	c = AllocWinding (w->numpoints);
+	if ( !c )
+		return NULL;
 	for (i=0 ; i<w->numpoints ; i++)
 	{
 		VectorCopy (w->p[w->numpoints-1-i], c->p[i]);
@@ -365,8 +367,18 @@ static void ClipWindingEpsilon( winding_t *in, vec3_t normal, vec_t dist, vec_t
 	maxpts = in->numpoints+4;	// can't use counts[0]+2 because
 								// of fp grouping errors
 
-	*front = f = AllocWinding (maxpts);
-	*back = b = AllocWinding (maxpts);
+	f = AllocWinding (maxpts);
+	b = AllocWinding (maxpts);
+	if ( !f || !b )
+	{
+		if ( f )
+			FreeWinding (f);
+		if ( b )
+			FreeWinding (b);
+		return;
+	}
+	*front = f;
+	*back = b;
 		
 	for (i=0 ; i<in->numpoints ; i++)
 	{
@@ -427,9 +439,12 @@ static void ClipWindingEpsilon( winding_t *in, vec3_t normal, vec_t dist, vec_t
 /*
 =============
 ChopWindingInPlace
+
+Returns qfalse when out of memory or the result has too many points,
+*inout is left as it was then.
 =============
 */
-void ChopWindingInPlace( winding_t **inout, const vec3_t normal, vec_t dist, vec_t epsilon )
+qboolean ChopWindingInPlace( winding_t **inout, const vec3_t normal, vec_t dist, vec_t epsilon )
 {
 	winding_t	*in;
 	vec_t	dists[MAX_POINTS_ON_WINDING+4];
@@ -471,15 +486,17 @@ void ChopWindingInPlace( winding_t **inout, const vec3_t normal, vec_t dist, vec
 	{
 		FreeWinding (in);
 		*inout = NULL;
-		return;
+		return qtrue;
 	}
 	if (!counts[1])
-		return;		// inout stays the same
+		return qtrue;		// inout stays the same
 
 	maxpts = in->numpoints+4;	// can't use counts[0]+2 because
 								// of fp grouping errors
 
 	f = AllocWinding (maxpts);
+	if ( !f )
+		return qfalse;
 		
 	for (i=0 ; i<in->numpoints ; i++)
 	{
@@ -523,13 +540,15 @@ void ChopWindingInPlace( winding_t **inout, const vec3_t normal, vec_t dist, vec
 		f->numpoints++;
 	}
 	
-	if (f->numpoints > maxpts)
-		Com_Error (ERR_DROP, "ClipWinding: points exceeded estimate");
-	if (f->numpoints > MAX_POINTS_ON_WINDING)
-		Com_Error (ERR_DROP, "ClipWinding: MAX_POINTS_ON_WINDING");
+	if ( f->numpoints > maxpts || f->numpoints > MAX_POINTS_ON_WINDING )
+	{
+		FreeWinding (f);
+		return qfalse;
+	}
 
 	FreeWinding (in);
 	*inout = f;
+	return qtrue;
 }
 
 
@@ -747,7 +766,10 @@ void	AddWindingToConvexHull( winding_t *w, winding_t **hull, vec3_t normal ) {
 
 	FreeWinding( *hull );
 	w = AllocWinding( numHullPoints );
-	w->numpoints = numHullPoints;
 	*hull = w;
+	if ( !w ) {
+		return;
+	}
+	w->numpoints = numHullPoints;
 	Com_Memcpy( w->p, hullPoints, numHullPoints * sizeof(vec3_t) );
 }
@@ -58,5 +58,5 @@ void	WindingBounds( const winding_t *w, vec3_t mins, vec3_t maxs );
 
 void	AddWindingToConvexHull( winding_t *w, winding_t **hull, vec3_t normal );
 
-void	ChopWindingInPlace( winding_t **w, const vec3_t normal, vec_t dist, vec_t epsilon );
-// frees the original if clipped
+qboolean ChopWindingInPlace( winding_t **w, const vec3_t normal, vec_t dist, vec_t epsilon );
+// frees the original if clipped, qfalse if out of memory or too many points
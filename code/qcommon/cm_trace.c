@@ -21,6 +21,10 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 #include "cm_local.h"
 
+#if idx64
+#include <emmintrin.h>
+#endif
+
 // always use bbox vs. bbox collision and never capsule vs. bbox or vice versa
 //#define ALWAYS_BBOX_VS_BBOX
 // always use capsule vs. capsule collision and never capsule vs. bbox or vice versa
@@ -469,6 +473,56 @@ static void CM_TraceThroughPatch( traceWork_t *tw, const cPatch_t *patch ) {
 }
 
 
+/*
+================
+CM_SidePairDistances
+
+Distances of the trace start and end from two brush side planes, with
+the planes pushed out by the trace box the way tw->offsets[signbits]
+does. Taking the lower of the two corner products on each axis picks
+the same corner as the sign bits.
+================
+*/
+static ID_INLINE void CM_SidePairDistances( const traceWork_t *tw, const cbrushSidePair_t *pair, double *d1, double *d2 ) {
+#if idx64
+	__m128d nx, ny, nz, dist, offset;
+
+	nx = _mm_cvtps_pd( _mm_castsi128_ps( _mm_loadl_epi64( (const __m128i *)pair->normal[0] ) ) );
+	ny = _mm_cvtps_pd( _mm_castsi128_ps( _mm_loadl_epi64( (const __m128i *)pair->normal[1] ) ) );
+	nz = _mm_cvtps_pd( _mm_castsi128_ps( _mm_loadl_epi64( (const __m128i *)pair->normal[2] ) ) );
+	dist = _mm_cvtps_pd( _mm_castsi128_ps( _mm_loadl_epi64( (const __m128i *)pair->dist ) ) );
+
+	offset = _mm_min_pd( _mm_mul_pd( nx, _mm_set1_pd( tw->size[0][0] ) ), _mm_mul_pd( nx, _mm_set1_pd( tw->size[1][0] ) ) );
+	offset = _mm_add_pd( offset, _mm_min_pd( _mm_mul_pd( ny, _mm_set1_pd( tw->size[0][1] ) ), _mm_mul_pd( ny, _mm_set1_pd( tw->size[1][1] ) ) ) );
+	offset = _mm_add_pd( offset, _mm_min_pd( _mm_mul_pd( nz, _mm_set1_pd( tw->size[0][2] ) ), _mm_mul_pd( nz, _mm_set1_pd( tw->size[1][2] ) ) ) );
+	dist = _mm_sub_pd( dist, offset );
+
+	_mm_storeu_pd( d1, _mm_sub_pd( _mm_add_pd( _mm_add_pd(
+		_mm_mul_pd( nx, _mm_set1_pd( tw->start[0] ) ),
+		_mm_mul_pd( ny, _mm_set1_pd( tw->start[1] ) ) ),
+		_mm_mul_pd( nz, _mm_set1_pd( tw->start[2] ) ) ), dist ) );
+	_mm_storeu_pd( d2, _mm_sub_pd( _mm_add_pd( _mm_add_pd(
+		_mm_mul_pd( nx, _mm_set1_pd( tw->end[0] ) ),
+		_mm_mul_pd( ny, _mm_set1_pd( tw->end[1] ) ) ),
+		_mm_mul_pd( nz, _mm_set1_pd( tw->end[2] ) ) ), dist ) );
+#else
+	double normal[3], dist;
+	int i, j;
+
+	for ( i = 0; i < 2; i++ ) {
+		for ( j = 0; j < 3; j++ ) {
+			normal[j] = pair->normal[j][i];
+		}
+		dist = pair->dist[i] - ( normal[0] * tw->size[ normal[0] < 0 ][0]
+			+ normal[1] * tw->size[ normal[1] < 0 ][1]
+			+ normal[2] * tw->size[ normal[2] < 0 ][2] );
+		d1[i] = normal[0] * tw->start[0] + normal[1] * tw->start[1] + normal[2] * tw->start[2] - dist;
+		d2[i] = normal[0] * tw->end[0] + normal[1] * tw->end[1] + normal[2] * tw->end[2] - dist;
+	}
+#endif
+}
+
+
 /*
 ================
 CM_TraceThroughBrush
@@ -486,6 +540,7 @@ static void CM_TraceThroughBrush( traceWork_t *tw, const cbrush_t *brush ) {
 	double		t;
 	vec3_t		startp;
 	vec3_t		endp;
+	double		pairD1[2], pairD2[2];
 
 	enterFrac = -1.0;
 	leaveFrac = 1.0;
@@ -576,14 +631,14 @@ static void CM_TraceThroughBrush( traceWork_t *tw, const cbrush_t *brush ) {
 		// and the earliest time the trace crosses a plane towards the exterior
 		//
 		for (i = 0; i < brush->numsides; i++) {
-			side = brush->sides + i;
-			plane = side->plane;
-
-			// adjust the plane distance appropriately for mins/maxs
-			dist = plane->dist - DotProductDP( tw->offsets[ plane->signbits ], plane->normal );
+			// adjust the plane distances appropriately for mins/maxs,
+			// two sides at a time
+			if ( !( i & 1 ) ) {
+				CM_SidePairDistances( tw, &brush->sidePairs[ i >> 1 ], pairD1, pairD2 );
+			}
 
-			d1 = DotProductDP( tw->start, plane->normal ) - dist;
-			d2 = DotProductDP( tw->end, plane->normal ) - dist;
+			d1 = pairD1[ i & 1 ];
+			d2 = pairD2[ i & 1 ];
 
 			if (d2 > 0) {
 				getout = qtrue;	// endpoint is not in solid
@@ -610,8 +665,8 @@ static void CM_TraceThroughBrush( traceWork_t *tw, const cbrush_t *brush ) {
 				}
 				if (f > enterFrac) {
 					enterFrac = f;
-					clipplane = plane;
-					leadside = side;
+					leadside = brush->sides + i;
+					clipplane = leadside->plane;
 				}
 			} else {	// leave
 				f = (d1+SURFACE_CLIP_EPSILON) / (d1-d2);
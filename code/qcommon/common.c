@@ -78,6 +78,8 @@ cvar_t	*com_maxfpsUnfocused;
 cvar_t	*com_yieldCPU;
 cvar_t	*com_timedemo;
 #endif
+static cvar_t *com_preciseTick;
+static cvar_t *com_preciseTickSpin;
 #ifdef USE_AFFINITY_MASK
 cvar_t	*com_affinityMask;
 #endif
@@ -210,11 +212,13 @@ void FORMAT_PRINTF(1, 2) QDECL Com_Printf( const char *fmt, ... ) {
 		// TTimo: only open the qconsole.log if the filesystem is in an initialized state
 		//   also, avoid recursing in the qconsole.log opening (i.e. if fs_debug is on)
 		if ( logfile == FS_INVALID_HANDLE && FS_Initialized() && !opening_qconsole ) {
-			const char *logName = "qconsole.log";
+			char logName[MAX_QPATH];
 			int mode;
 
 			opening_qconsole = qtrue;
 
+			Q_strncpyz( logName, FS_InstancePath( "qconsole.log" ), sizeof( logName ) );
+
 			mode = com_logfile->integer - 1;
 
 			if ( mode & 2 )
@@ -252,6 +256,22 @@ void FORMAT_PRINTF(1, 2) QDECL Com_Printf( const char *fmt, ... ) {
 }
 
 
+/*
+================
+Com_ReopenLogFile
+
+Closes qconsole.log so the next print opens it again, e.g. under
+the instance directory of a forked server
+================
+*/
+void Com_ReopenLogFile( void ) {
+	if ( logfile != FS_INVALID_HANDLE ) {
+		FS_FCloseFile( logfile );
+		logfile = FS_INVALID_HANDLE;
+	}
+}
+
+
 /*
 ================
 Com_DPrintf
@@ -3883,6 +3903,13 @@ void Com_Init( char *commandLine ) {
 	Cvar_SetDescription( com_yieldCPU, "Attempt to sleep specified amount of time between rendered frames when game is active, this will greatly reduce CPU load. Use 0 only if you're experiencing some lag." );
 #endif
 
+	com_preciseTick = Cvar_Get( "com_preciseTick", "0", CVAR_ARCHIVE_ND );
+	Cvar_CheckRange( com_preciseTick, "0", "1", CV_INTEGER );
+	Cvar_SetDescription( com_preciseTick, "Dedicated servers sleep to the exact millisecond the next server frame is due instead of polling for it, for evenly spaced snapshots at high sv_fps. svperf shows the tick start jitter." );
+	com_preciseTickSpin = Cvar_Get( "com_preciseTickSpin", "0", CVAR_ARCHIVE_ND );
+	Cvar_CheckRange( com_preciseTickSpin, "0", "2000", CV_INTEGER );
+	Cvar_SetDescription( com_preciseTickSpin, "Microseconds com_preciseTick busy waits before a server frame instead of sleeping, trading CPU time for less wakeup latency." );
+
 #ifdef USE_AFFINITY_MASK
 	com_affinityMask = Cvar_Get( "com_affinityMask", "", CVAR_ARCHIVE_ND );
 	Cvar_SetDescription( com_affinityMask, "Bind game process to bitmask-specified CPU core(s), special characters:\n A or a - all default cores\n P or p - performance cores\n E or e - efficiency cores\n 0x<value> - use hexadecimal notation\n + or - can be used to add or exclude particular cores" );
@@ -4204,6 +4231,35 @@ static int Com_TimeVal( int minMsec )
 	return timeVal;
 }
 
+/*
+=================
+Com_WaitPreciseTick
+
+com_preciseTick wait of dedicated servers. Packets are handled as
+usual until the last couple of milliseconds, then the frame thread
+sleeps to the moment the server frame is due and picks up what
+arrived meanwhile, instead of polling at millisecond granularity.
+=================
+*/
+static void Com_WaitPreciseTick( int minMsec )
+{
+	int timeVal;
+	int timeValSV;
+
+	while ( ( timeVal = Com_TimeVal( minMsec ) ) > 2 ) {
+		timeValSV = SV_SendQueuedPackets();
+		if ( timeValSV < timeVal - 2 )
+			timeVal = timeValSV + 2;
+		NET_Sleep( ( timeVal - 2 ) * 1000 );
+	}
+
+	if ( timeVal > 0 ) {
+		Sys_SleepUntil( com_frameTime + minMsec, com_preciseTickSpin->integer );
+		NET_Sleep( 0 );
+	}
+}
+
+
 /*
 =================
 Com_FrameInit
@@ -4310,7 +4366,9 @@ void Com_Frame( qboolean noDelay ) {
 	}
 
 	// waiting for incoming packets
-	if ( noDelay == qfalse )
+	if ( noDelay == qfalse && com_dedicated->integer && com_sv_running->integer && com_preciseTick->integer )
+		Com_WaitPreciseTick( minMsec );
+	else if ( noDelay == qfalse )
 	do {
 		if ( com_sv_running->integer ) {
 			timeValSV = SV_SendQueuedPackets();
@@ -347,10 +347,13 @@ typedef struct {
 	handleOwner_t	owner;
 	int			pakIndex;
 	pack_t		*pak;
+	const char	*writeMode;		// "wb" or "ab" when opened for writing
 } fileHandleData_t;
 
 static fileHandleData_t	fsh[MAX_FILE_HANDLES];
 
+static char		fs_instanceDir[MAX_QPATH];	// forked server instance, see FS_SetInstanceDir
+
 // TTimo - https://zerowing.idsoftware.com/bugzilla/show_bug.cgi?id=540
 // whether we did a reorder on the current search path when joining the server
 qboolean fs_reordered;
@@ -868,6 +871,7 @@ FS_InitHandle
 static void FS_InitHandle( fileHandleData_t *fd ) {
 	fd->pak = NULL;
 	fd->pakIndex = -1;
+	fd->writeMode = NULL;
 	fs_lastPakIndex = -1;
 }
 
@@ -1264,6 +1268,7 @@ fileHandle_t FS_FOpenFileWrite( const char *filename ) {
 	Q_strncpyz( fd->name, filename, sizeof( fd->name ) );
 	fd->handleSync = qfalse;
 	fd->zipFile = qfalse;
+	fd->writeMode = "wb";
 
 	return f;
 }
@@ -1318,6 +1323,7 @@ fileHandle_t FS_FOpenFileAppend( const char *filename ) {
 	Q_strncpyz( fd->name, filename, sizeof( fd->name ) );
 	fd->handleSync = qfalse;
 	fd->zipFile = qfalse;
+	fd->writeMode = "ab";
 
 	return f;
 }
@@ -2202,6 +2208,58 @@ int FS_ReadFile( const char *qpath, void **buffer ) {
 }
 
 
+/*
+============
+FS_HomeReadFile
+
+Reads a file the game wrote itself with FS_FOpenFileWrite, skipping pk3s
+and every other search path
+============
+*/
+int FS_HomeReadFile( const char *qpath, void **buffer ) {
+	const char		*ospath;
+	FILE			*h;
+	byte			*buf;
+	int				len;
+
+	if ( !fs_searchpaths ) {
+		Com_Error( ERR_FATAL, "Filesystem call made without initialization" );
+	}
+
+	*buffer = NULL;
+
+	if ( qpath == NULL || qpath[0] == '\0' || FS_CheckDirTraversal( qpath ) ) {
+		return -1;
+	}
+
+	ospath = FS_BuildOSPath( fs_homepath->string, fs_gamedir, qpath );
+
+	h = Sys_FOpen( ospath, "rb" );
+	if ( h == NULL ) {
+		return -1;
+	}
+
+	len = FS_FileLength( h );
+
+	buf = Hunk_AllocateTempMemory( len + 1 );
+	if ( fread( buf, 1, len, h ) != (size_t)len ) {
+		Hunk_FreeTempMemory( buf );
+		fclose( h );
+		return -1;
+	}
+	fclose( h );
+
+	fs_loadCount++;
+	fs_loadStack++;
+
+	// guarantee that it will have a trailing 0 for string operations
+	buf[ len ] = '\0';
+	*buffer = buf;
+
+	return len;
+}
+
+
 /*
 =============
 FS_FreeFile
@@ -5584,6 +5642,30 @@ int FS_FTell( fileHandle_t f ) {
 }
 
 
+/*
+=================
+FS_MapFile
+
+Map a file opened for reading into memory. Files inside pk3s can't
+be mapped, NULL is returned and the caller keeps using FS_Read.
+=================
+*/
+const void *FS_MapFile( fileHandle_t f, int *length ) {
+	*length = 0;
+
+	if ( f <= 0 || f >= MAX_FILE_HANDLES || fsh[f].zipFile || !fsh[f].handleFiles.file.o ) {
+		return NULL;
+	}
+
+	return Sys_MapFile( fsh[f].handleFiles.file.o, length );
+}
+
+
+void FS_UnmapFile( const void *base, int length ) {
+	Sys_UnmapFile( base, length );
+}
+
+
 void FS_Flush( fileHandle_t f ) 
 {
 	fflush( fsh[f].handleFiles.file.o );
@@ -5616,6 +5698,60 @@ void FS_FilenameCompletion( const char *dir, const char *ext, qboolean stripExt,
 }
 
 
+/*
+===========
+FS_InstancePath
+
+Where a forked server instance writes its logs: qpath for the first
+instance, instanceN/qpath for the others.
+===========
+*/
+const char *FS_InstancePath( const char *qpath ) {
+	if ( !fs_instanceDir[0] ) {
+		return qpath;
+	}
+	return va( "%s/%s", fs_instanceDir, qpath );
+}
+
+
+/*
+===========
+FS_SetInstanceDir
+
+Called in a forked server instance. Files the game writes from now on
+go under dir, and those it already has open for writing are reopened
+there instead of sharing the first instance's file position.
+===========
+*/
+void FS_SetInstanceDir( const char *dir ) {
+	fileHandleData_t *fd;
+	const char *ospath;
+	int i;
+
+	Q_strncpyz( fs_instanceDir, dir, sizeof( fs_instanceDir ) );
+
+	for ( i = 1; i < MAX_FILE_HANDLES; i++ ) {
+		fd = &fsh[ i ];
+		if ( fd->owner != H_QAGAME || !fd->writeMode || !fd->handleFiles.file.o ) {
+			continue;
+		}
+
+		// everything buffered was flushed before the fork, so this
+		// only drops this instance's descriptor
+		fclose( fd->handleFiles.file.o );
+
+		ospath = FS_BuildOSPath( fs_homepath->string, fs_gamedir, FS_InstancePath( fd->name ) );
+		fd->handleFiles.file.o = Sys_FOpen( ospath, fd->writeMode );
+		if ( fd->handleFiles.file.o == NULL && !FS_CreatePath( ospath ) ) {
+			fd->handleFiles.file.o = Sys_FOpen( ospath, fd->writeMode );
+		}
+		if ( fd->handleFiles.file.o == NULL ) {
+			Com_Printf( S_COLOR_YELLOW "WARNING: couldn't reopen %s\n", ospath );
+		}
+	}
+}
+
+
 /*
 	Secure VM functions
 */
@@ -5623,6 +5759,10 @@ void FS_FilenameCompletion( const char *dir, const char *ext, qboolean stripExt,
 int FS_VM_OpenFile( const char *qpath, fileHandle_t *f, fsMode_t mode, handleOwner_t owner ) {
 	int r;
 
+	if ( mode != FS_READ && owner == H_QAGAME && qpath ) {
+		qpath = FS_InstancePath( qpath );
+	}
+
 	r = FS_FOpenFileByMode( qpath, f, mode );
 
 	if ( f && *f != FS_INVALID_HANDLE )
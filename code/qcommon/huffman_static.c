@@ -209,3 +209,80 @@ int HuffmanGetSymbol( unsigned int* symbol, const byte* buffer, int bitIndex )
 
 	return (int)(entry >> 8);
 }
+
+
+/*
+HuffmanPutBits
+
+MSG_WriteBits for huffman bitstreams: the low bits & 7 bits as they are,
+then a code for each byte. The output is assembled in one word and stored
+a byte at a time, matching HuffmanPutBit and HuffmanPutSymbol bit for bit.
+*/
+int HuffmanPutBits( byte* fout, int32_t bitIndex, uint32_t value, int bits )
+{
+	byte *p = fout + ( bitIndex >> 3 );
+	const int offset = bitIndex & 7;
+	const int nbits = bits & 7;
+	uint64_t word;
+	int count, i;
+
+	// at most 7 + 4 * 11 bits
+	word = value & ( ( 1u << nbits ) - 1 );
+	count = nbits;
+	value >>= nbits;
+
+	for ( i = nbits; i < bits; i += 8 )
+	{
+		const uint16_t result = HuffmanEncoderTable[ value & 0xFF ];
+		word |= (uint64_t)( ( result >> 4 ) & 0x7FF ) << count;
+		count += result & 15;
+		value >>= 8;
+	}
+
+	// a byte already started is or-ed into, the following ones are overwritten
+	word <<= offset;
+	if ( offset )
+		word |= p[0];
+
+	for ( i = offset + count; i > 0; i -= 8 )
+	{
+		*p++ = (byte)word;
+		word >>= 8;
+	}
+
+	return count;
+}
+
+
+/*
+HuffmanGetBits
+
+MSG_ReadBits for huffman bitstreams, reading the whole value from one
+8 byte window at bitIndex >> 3, which the caller has to keep inside the buffer.
+*/
+int HuffmanGetBits( unsigned int* value, const byte* buffer, int bitIndex, int bits )
+{
+	const int nbits = bits & 7;
+	uint64_t window;
+	uint32_t v;
+	int count, i;
+
+	memcpy( &window, buffer + ( bitIndex >> 3 ), sizeof( window ) );
+	window >>= bitIndex & 7;
+
+	v = (uint32_t)window & ( ( 1u << nbits ) - 1 );
+	window >>= nbits;
+	count = nbits;
+
+	for ( i = nbits; i < bits; i += 8 )
+	{
+		const uint16_t entry = HuffmanDecoderTable[ window & 0x7FF ];
+		v |= (uint32_t)( entry & 0xFF ) << i;
+		window >>= entry >> 8;
+		count += entry >> 8;
+	}
+
+	*value = v;
+
+	return count;
+}
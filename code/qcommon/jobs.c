@@ -0,0 +1,206 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// jobs.c -- running independent pieces of work on other threads
+//
+// Meant for loading, where threads are started for a batch of work and
+// joined when it is done. Job functions must not call Com_Error, the
+// zone or the hunk, anything like that is left for the calling thread
+// once the jobs are finished, and print with Com_JobPrintf. Without
+// threads the jobs simply run on the calling thread.
+
+#include "q_shared.h"
+#include "qcommon.h"
+
+#define MAX_JOB_THREADS		16
+
+typedef struct {
+	jobFunc_t	func;
+	void		*arg;
+	int			count;
+	int			next;			// next index to run
+	void		*lock;
+} jobBatch_t;
+
+static void *jobPrintLock;		// while Com_RunJobs runs on several threads
+
+
+/*
+=================
+Com_JobPrintf
+
+Com_Printf for job functions, one thread at a time.
+=================
+*/
+void QDECL Com_JobPrintf( const char *fmt, ... ) {
+	char msg[ MAXPRINTMSG ];
+	va_list argptr;
+
+	va_start( argptr, fmt );
+	Q_vsnprintf( msg, sizeof( msg ), fmt, argptr );
+	va_end( argptr );
+
+	if ( jobPrintLock ) {
+		Sys_LockMutex( jobPrintLock );
+		Com_Printf( "%s", msg );
+		Sys_UnlockMutex( jobPrintLock );
+	} else {
+		Com_Printf( "%s", msg );
+	}
+}
+
+
+/*
+=================
+Com_JobDPrintf
+=================
+*/
+void QDECL Com_JobDPrintf( const char *fmt, ... ) {
+	char msg[ MAXPRINTMSG ];
+	va_list argptr;
+
+	va_start( argptr, fmt );
+	Q_vsnprintf( msg, sizeof( msg ), fmt, argptr );
+	va_end( argptr );
+
+	if ( jobPrintLock ) {
+		Sys_LockMutex( jobPrintLock );
+		Com_DPrintf( "%s", msg );
+		Sys_UnlockMutex( jobPrintLock );
+	} else {
+		Com_DPrintf( "%s", msg );
+	}
+}
+
+
+/*
+=================
+Com_StartJob
+
+Runs func( arg ) alongside the calling thread until Com_FinishJob.
+=================
+*/
+void *Com_StartJob( sysThreadFunc_t func, void *arg ) {
+	void *thread;
+
+	thread = Sys_CreateThread( func, arg );
+	if ( !thread ) {
+		func( arg );
+	}
+
+	return thread;
+}
+
+
+/*
+=================
+Com_FinishJob
+=================
+*/
+void Com_FinishJob( void *job ) {
+	Sys_JoinThread( job );
+}
+
+
+/*
+=================
+Com_RunBatch
+=================
+*/
+static void Com_RunBatch( void *arg ) {
+	jobBatch_t *batch = arg;
+	int index;
+
+	for ( ;; ) {
+		Sys_LockMutex( batch->lock );
+		index = batch->next++;
+		Sys_UnlockMutex( batch->lock );
+
+		if ( index >= batch->count ) {
+			break;
+		}
+
+		batch->func( batch->arg, index );
+	}
+}
+
+
+/*
+=================
+Com_RunJobs
+
+Runs func( arg, 0 .. count-1 ) on the calling thread and up to
+numThreads others, returning when all of them are done. Returns the
+number of threads that took part.
+=================
+*/
+int Com_RunJobs( jobFunc_t func, void *arg, int count, int numThreads ) {
+	void *threads[ MAX_JOB_THREADS ];
+	jobBatch_t batch;
+	int i, started;
+
+	if ( numThreads > MAX_JOB_THREADS ) {
+		numThreads = MAX_JOB_THREADS;
+	}
+	if ( numThreads > count - 1 ) {
+		numThreads = count - 1;
+	}
+
+	batch.lock = NULL;
+	if ( numThreads > 0 ) {
+		batch.lock = Sys_CreateMutex();
+		jobPrintLock = Sys_CreateMutex();
+	}
+
+	if ( !batch.lock || !jobPrintLock ) {
+		Sys_DestroyMutex( batch.lock );
+		Sys_DestroyMutex( jobPrintLock );
+		jobPrintLock = NULL;
+		for ( i = 0; i < count; i++ ) {
+			func( arg, i );
+		}
+		return 1;
+	}
+
+	batch.func = func;
+	batch.arg = arg;
+	batch.count = count;
+	batch.next = 0;
+
+	for ( started = 0; started < numThreads; started++ ) {
+		threads[ started ] = Sys_CreateThread( Com_RunBatch, &batch );
+		if ( !threads[ started ] ) {
+			break;
+		}
+	}
+
+	Com_RunBatch( &batch );
+
+	for ( i = 0; i < started; i++ ) {
+		Sys_JoinThread( threads[ i ] );
+	}
+
+	Sys_DestroyMutex( batch.lock );
+	Sys_DestroyMutex( jobPrintLock );
+	jobPrintLock = NULL;
+
+	return started + 1;
+}
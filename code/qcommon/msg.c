@@ -58,6 +58,20 @@ void MSG_Clear( msg_t *buf ) {
 
 void MSG_Bitstream( msg_t *buf ) {
 	buf->oob = qfalse;
+	buf->raw = qfalse;
+}
+
+
+/*
+Like MSG_Bitstream, but values are packed into the buffer as is,
+LSB first, leaving entropy coding to whatever compresses the data
+afterwards. Values of 8 bits or more start on a byte boundary so
+repeated values give repeated bytes. Must be set again after
+MSG_BeginReading.
+*/
+void MSG_Rawstream( msg_t *buf ) {
+	buf->oob = qfalse;
+	buf->raw = qtrue;
 }
 
 
@@ -65,6 +79,7 @@ void MSG_BeginReading( msg_t *msg ) {
 	msg->readcount = 0;
 	msg->bit = 0;
 	msg->oob = qfalse;
+	msg->raw = qfalse;
 }
 
 
@@ -72,6 +87,7 @@ void MSG_BeginReadingOOB( msg_t *msg ) {
 	msg->readcount = 0;
 	msg->bit = 0;
 	msg->oob = qtrue;
+	msg->raw = qfalse;
 }
 
 
@@ -93,10 +109,47 @@ bit functions
 =============================================================================
 */
 
+/*
+=================
+MSG_PutRawBits / MSG_GetRawBits
+
+Plain LSB-first bit packing for raw streams, a byte at a time.
+Bits past the write position are cleared like HuffmanPutBit does.
+=================
+*/
+static void MSG_PutRawBits( byte *data, int bit, unsigned int value, int bits ) {
+	while ( bits > 0 ) {
+		const int ofs = bit & 7;
+		const int n = ( 8 - ofs < bits ) ? 8 - ofs : bits;
+
+		data[bit >> 3] = ( data[bit >> 3] & ( ( 1 << ofs ) - 1 ) ) | ( ( value & ( ( 1 << n ) - 1 ) ) << ofs );
+		value >>= n;
+		bit += n;
+		bits -= n;
+	}
+}
+
+
+static unsigned int MSG_GetRawBits( const byte *data, int bit, int bits ) {
+	unsigned int value = 0;
+	int shift = 0;
+
+	while ( bits > 0 ) {
+		const int ofs = bit & 7;
+		const int n = ( 8 - ofs < bits ) ? 8 - ofs : bits;
+
+		value |= (unsigned int)( ( data[bit >> 3] >> ofs ) & ( ( 1 << n ) - 1 ) ) << shift;
+		shift += n;
+		bit += n;
+		bits -= n;
+	}
+
+	return value;
+}
+
+
 // negative bit values include signs
 void MSG_WriteBits( msg_t *msg, int value, int bits ) {
-	int	i;
-
 	if ( bits == 0 || bits < -31 || bits > 32 ) {
 		Com_Error( ERR_DROP, "MSG_WriteBits: bad bits %i", bits );
 	}
@@ -125,24 +178,20 @@ void MSG_WriteBits( msg_t *msg, int value, int bits ) {
 		} else {
 			Com_Error(ERR_DROP, "can't write %d bits", bits);
 		}
-	} else {
-		value &= (0xffffffff>>(32-bits));
-		if ( bits & 7 ) {
-			int nbits;
-			nbits = bits&7;
-			for ( i = 0; i < nbits ; i++ ) {
-				HuffmanPutBit( msg->data, msg->bit, (value & 1) );
-				msg->bit++;
-				value = (value>>1);
-			}
-			bits = bits - nbits;
+	} else if ( msg->raw ) {
+		if ( bits >= 8 ) {
+			msg->bit = ( msg->bit + 7 ) & ~7;
 		}
-		if ( bits ) {
-			for( i = 0 ; i < bits ; i += 8 ) {
-				msg->bit += HuffmanPutSymbol( msg->data, msg->bit, (value & 0xFF) );
-				value = (value>>8);
-			}
+		if ( msg->bit + bits > msg->maxbits ) {
+			msg->overflowed = qtrue;
+			return;
 		}
+		MSG_PutRawBits( msg->data, msg->bit, (unsigned int)value, bits );
+		msg->bit += bits;
+		msg->cursize = ( msg->bit + 7 ) >> 3;
+	} else {
+		value &= (0xffffffff>>(32-bits));
+		msg->bit += HuffmanPutBits( msg->data, msg->bit, value, bits );
 		msg->cursize = (msg->bit>>3)+1;
 	}
 
@@ -152,6 +201,55 @@ void MSG_WriteBits( msg_t *msg, int value, int bits ) {
 }
 
 
+/*
+=================
+MSG_WriteBitstring
+
+Append bits written by MSG_WriteBits to another huffman bitstream
+message, starting at bit 0 of data. The encoding of a value does not
+depend on the bit position it is written at, so callers can cache
+encoded output and splice it into other messages.
+=================
+*/
+void MSG_WriteBitstring( msg_t *msg, const byte *data, int bits ) {
+	byte *dst;
+	int ofs, last, i, n;
+
+	if ( msg->oob || msg->raw ) {
+		Com_Error( ERR_DROP, "MSG_WriteBitstring: not a huffman bitstream" );
+	}
+
+	if ( msg->overflowed != qfalse || bits <= 0 )
+		return;
+
+	if ( msg->bit + bits > msg->maxbits ) {
+		msg->overflowed = qtrue;
+		return;
+	}
+
+	// bits past the end of data and past msg->bit are zero,
+	// as HuffmanPutBit clears each byte it starts
+	dst = msg->data + ( msg->bit >> 3 );
+	ofs = msg->bit & 7;
+	n = ( bits + 7 ) >> 3;
+
+	if ( ofs == 0 ) {
+		Com_Memcpy( dst, data, n );
+	} else {
+		last = ( ( msg->bit + bits - 1 ) >> 3 ) - ( msg->bit >> 3 );
+		for ( i = 0; i < n; i++ ) {
+			dst[i] |= data[i] << ofs;
+			if ( i < last ) {
+				dst[i+1] = data[i] >> ( 8 - ofs );
+			}
+		}
+	}
+
+	msg->bit += bits;
+	msg->cursize = (msg->bit>>3)+1;
+}
+
+
 static int MSG_ReadBits( msg_t *msg, int bits ) {
 	int		value;
 	qboolean	sgn;
@@ -194,23 +292,52 @@ static int MSG_ReadBits( msg_t *msg, int bits ) {
 		}
 		else
 			Com_Error( ERR_DROP, "can't read %d bits", bits );
+	} else if ( msg->raw ) {
+		if ( bits >= 8 ) {
+			msg->bit = ( msg->bit + 7 ) & ~7;
+		}
+		if ( msg->bit + bits > msg->maxbits ) {
+			msg->bit = msg->maxbits;
+			msg->readcount = msg->cursize + 1;
+			return 0;
+		}
+		value = (int)MSG_GetRawBits( buffer, msg->bit, bits );
+		msg->bit += bits;
+		msg->readcount = ( msg->bit + 7 ) >> 3;
 	} else {
 		const int nbits = bits & 7;
 		int bitIndex = msg->bit; // dereference optimization
-		if ( nbits )
-		{		
-			for ( i = 0; i < nbits; i++ ) {
-				value |= HuffmanGetBit( buffer, bitIndex ) << i;
-				bitIndex++;
+		if ( ( bitIndex >> 3 ) + 8 <= msg->maxsize )
+		{
+			if ( bits < 8 ) {
+				// no symbols, just the two bytes the bits can span
+				const byte *p = buffer + ( bitIndex >> 3 );
+				value = ( ( p[0] | ( p[1] << 8 ) ) >> ( bitIndex & 7 ) ) & ( ( 1 << bits ) - 1 );
+				bitIndex += bits;
+			} else {
+				// whole value from one 8 byte window
+				bitIndex += HuffmanGetBits( &sym, buffer, bitIndex, bits );
+				value = (int)sym;
 			}
 			bits -= nbits;
 		}
-		if ( bits )
+		else
 		{
-			for ( i = 0; i < bits; i += 8 )
+			if ( nbits )
 			{
-				bitIndex += HuffmanGetSymbol( &sym, buffer, bitIndex );
-				value |= ( sym << (i+nbits) );
+				for ( i = 0; i < nbits; i++ ) {
+					value |= HuffmanGetBit( buffer, bitIndex ) << i;
+					bitIndex++;
+				}
+				bits -= nbits;
+			}
+			if ( bits )
+			{
+				for ( i = 0; i < bits; i += 8 )
+				{
+					bitIndex += HuffmanGetSymbol( &sym, buffer, bitIndex );
+					value |= ( sym << (i+nbits) );
+				}
 			}
 		}
 		msg->bit = bitIndex;
@@ -517,7 +644,7 @@ int MSG_HashKey(const char *string, int maxlen) {
 
 #ifndef DEDICATED
 extern cvar_t *cl_shownet;
-#define	LOG(x) if( cl_shownet && cl_shownet->integer == 4 ) { Com_Printf("%s ", x ); };
+#define	LOG(x) if( shownet && shownet->integer == 4 ) { Com_Printf("%s ", x ); };
 #else
 #define	LOG(x)
 #endif
@@ -859,10 +986,11 @@ is how the from state is identified.
 
 If the delta removes the entity, entityState_t->number will be set to MAX_GENTITIES-1
 
-Can go from either a baseline or a previous packet_entity
+Can go from either a baseline or a previous packet_entity.
+Returns qfalse on an invalid field count, prints with shownet if set.
 ==================
 */
-void MSG_ReadDeltaEntity( msg_t *msg, const entityState_t *from, entityState_t *to, int number ) {
+static qboolean MSG_ParseDeltaEntity( msg_t *msg, const entityState_t *from, entityState_t *to, int number, const cvar_t *shownet ) {
 	int			i, lc;
 	int			numFields;
 	const netField_t *field;
@@ -872,10 +1000,6 @@ void MSG_ReadDeltaEntity( msg_t *msg, const entityState_t *from, entityState_t *
 	int			trunc;
 	int			startBit, endBit;
 
-	if ( number < 0 || number >= MAX_GENTITIES ) {
-		Com_Error( ERR_DROP, "Bad delta entity number: %i", number );
-	}
-
 	if ( msg->bit == 0 ) {
 		startBit = msg->readcount * 8 - GENTITYNUM_BITS;
 	} else {
@@ -887,25 +1011,25 @@ void MSG_ReadDeltaEntity( msg_t *msg, const entityState_t *from, entityState_t *
 		Com_Memset( to, 0, sizeof( *to ) );	
 		to->number = MAX_GENTITIES - 1;
 #ifndef DEDICATED
-		if ( cl_shownet && ( cl_shownet->integer >= 2 || cl_shownet->integer == -1 ) ) {
+		if ( shownet && ( shownet->integer >= 2 || shownet->integer == -1 ) ) {
 			Com_Printf( "%3i: #%-3i remove\n", msg->readcount, number );
 		}
 #endif
-		return;
+		return qtrue;
 	}
 
 	// check for no delta
 	if ( MSG_ReadBits( msg, 1 ) == 0 ) {
 		*to = *from;
 		to->number = number;
-		return;
+		return qtrue;
 	}
 
 	numFields = ARRAY_LEN( entityStateFields );
 	lc = MSG_ReadByte(msg);
 
 	if ( lc > numFields || lc < 0 ) {
-		Com_Error( ERR_DROP, "invalid entityState field count" );
+		return qfalse;
 	}
 
 	to->number = number;
@@ -913,7 +1037,7 @@ void MSG_ReadDeltaEntity( msg_t *msg, const entityState_t *from, entityState_t *
 #ifndef DEDICATED
 	// shownet 2/3 will interleave with other printed info, -1 will
 	// just print the delta records
-	if ( cl_shownet && ( cl_shownet->integer >= 2 || cl_shownet->integer == -1 ) ) {
+	if ( shownet && ( shownet->integer >= 2 || shownet->integer == -1 ) ) {
 		print = 1;
 		Com_Printf( "%3i: #%-3i ", msg->readcount, to->number );
 	} else {
@@ -982,6 +1106,43 @@ void MSG_ReadDeltaEntity( msg_t *msg, const entityState_t *from, entityState_t *
 		}
 		Com_Printf( " (%i bits)\n", endBit - startBit  );
 	}
+
+	return qtrue;
+}
+
+
+/*
+==================
+MSG_ReadDeltaEntity
+==================
+*/
+void MSG_ReadDeltaEntity( msg_t *msg, const entityState_t *from, entityState_t *to, int number ) {
+	if ( number < 0 || number >= MAX_GENTITIES ) {
+		Com_Error( ERR_DROP, "Bad delta entity number: %i", number );
+	}
+#ifndef DEDICATED
+	if ( !MSG_ParseDeltaEntity( msg, from, to, number, cl_shownet ) ) {
+#else
+	if ( !MSG_ParseDeltaEntity( msg, from, to, number, NULL ) ) {
+#endif
+		Com_Error( ERR_DROP, "invalid entityState field count" );
+	}
+}
+
+
+/*
+==================
+MSG_ReadDeltaEntityQuiet
+
+For other threads: never prints or calls Com_Error,
+returns qfalse if the delta is invalid instead.
+==================
+*/
+qboolean MSG_ReadDeltaEntityQuiet( msg_t *msg, const entityState_t *from, entityState_t *to, int number ) {
+	if ( number < 0 || number >= MAX_GENTITIES ) {
+		return qfalse;
+	}
+	return MSG_ParseDeltaEntity( msg, from, to, number, NULL );
 }
 
 
@@ -1199,10 +1360,12 @@ void MSG_WriteDeltaPlayerstate( msg_t *msg, const playerState_t *from, const pla
 
 /*
 ===================
-MSG_ReadDeltaPlayerstate
+MSG_ParseDeltaPlayerstate
+
+Returns qfalse on an invalid field count, prints with shownet if set.
 ===================
 */
-void MSG_ReadDeltaPlayerstate( msg_t *msg, const playerState_t *from, playerState_t *to ) {
+static qboolean MSG_ParseDeltaPlayerstate( msg_t *msg, const playerState_t *from, playerState_t *to, const cvar_t *shownet ) {
 	int			i, lc;
 	int			bits;
 	const netField_t *field;
@@ -1229,7 +1392,7 @@ void MSG_ReadDeltaPlayerstate( msg_t *msg, const playerState_t *from, playerStat
 #ifndef DEDICATED	
 	// shownet 2/3 will interleave with other printed info, -2 will
 	// just print the delta records
-	if ( cl_shownet && ( cl_shownet->integer >= 2 || cl_shownet->integer == -2 ) ) {
+	if ( shownet && ( shownet->integer >= 2 || shownet->integer == -2 ) ) {
 		print = 1;
 		Com_Printf( "%3i: playerstate ", msg->readcount );
 	} else {
@@ -1243,7 +1406,7 @@ void MSG_ReadDeltaPlayerstate( msg_t *msg, const playerState_t *from, playerStat
 	lc = MSG_ReadByte(msg);
 
 	if ( lc > numFields || lc < 0 ) {
-		Com_Error( ERR_DROP, "invalid playerState field count" );
+		return qfalse;
 	}
 
 	for ( i = 0, field = playerStateFields ; i < lc ; i++, field++ ) {
@@ -1344,6 +1507,36 @@ void MSG_ReadDeltaPlayerstate( msg_t *msg, const playerState_t *from, playerStat
 		}
 		Com_Printf( " (%i bits)\n", endBit - startBit  );
 	}
+
+	return qtrue;
+}
+
+
+/*
+===================
+MSG_ReadDeltaPlayerstate
+===================
+*/
+void MSG_ReadDeltaPlayerstate( msg_t *msg, const playerState_t *from, playerState_t *to ) {
+#ifndef DEDICATED
+	if ( !MSG_ParseDeltaPlayerstate( msg, from, to, cl_shownet ) ) {
+#else
+	if ( !MSG_ParseDeltaPlayerstate( msg, from, to, NULL ) ) {
+#endif
+		Com_Error( ERR_DROP, "invalid playerState field count" );
+	}
+}
+
+
+/*
+===================
+MSG_ReadDeltaPlayerstateQuiet
+
+For other threads, like MSG_ReadDeltaEntityQuiet
+===================
+*/
+qboolean MSG_ReadDeltaPlayerstateQuiet( msg_t *msg, const playerState_t *from, playerState_t *to ) {
+	return MSG_ParseDeltaPlayerstate( msg, from, to, NULL );
 }
 
 //===========================================================================
@@ -20,6 +20,10 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 ===========================================================================
 */
 
+#ifdef __linux__
+#define _GNU_SOURCE	// recvmmsg, sendmmsg
+#endif
+
 #include "../qcommon/q_shared.h"
 #include "../qcommon/qcommon.h"
 
@@ -79,6 +83,7 @@ static qboolean	winsockInitialized = qfalse;
 #	include <errno.h>
 #	include <netdb.h>
 #	include <netinet/in.h>
+#	include <netinet/tcp.h>
 #	include <arpa/inet.h>
 #	include <net/if.h>
 #	include <sys/ioctl.h>
@@ -93,6 +98,11 @@ static qboolean	winsockInitialized = qfalse;
 #		include <sys/filio.h>
 #	endif
 
+#	ifdef __linux__
+#		include <sys/epoll.h>
+#		define USE_NET_BATCH
+#	endif
+
 typedef int SOCKET;
 #	define INVALID_SOCKET		-1
 #	define SOCKET_ERROR			-1
@@ -214,6 +224,47 @@ static nip_localaddr_t localIP[MAX_IPS];
 static int numIP;
 
 static void	NET_Restart_f( void );
+static void	NET_Stats_f( void );
+
+// datagrams and syscalls, for packets per syscall
+static struct {
+	uint64_t	recvPackets;
+	uint64_t	recvCalls;
+	uint64_t	sendPackets;
+	uint64_t	sendCalls;
+} netStats;
+
+#ifdef USE_NET_BATCH
+// Linux moves up to NET_BATCH_SIZE datagrams per recvmmsg/sendmmsg call.
+// Outgoing packets are only queued between NET_BeginPacketBatch and
+// NET_EndPacketBatch, anything else is sent immediately.
+#define NET_BATCH_SIZE		32
+#define NET_SEND_POOL_SIZE	(64*1024)
+
+typedef struct {
+	struct mmsghdr	hdr[NET_BATCH_SIZE];
+	struct iovec	iov[NET_BATCH_SIZE];
+	sockaddr_t		addr[NET_BATCH_SIZE];
+	byte			data[NET_BATCH_SIZE][MAX_MSGLEN_BUF];
+} netRecvBatch_t;
+
+typedef struct {
+	qboolean		active;
+	int				count;
+	int				poolUsed;
+	SOCKET			sock[NET_BATCH_SIZE];
+	qboolean		broadcast[NET_BATCH_SIZE];
+	struct mmsghdr	hdr[NET_BATCH_SIZE];
+	struct iovec	iov[NET_BATCH_SIZE];
+	sockaddr_t		addr[NET_BATCH_SIZE];
+	byte			pool[NET_SEND_POOL_SIZE];
+} netSendBatch_t;
+
+static netRecvBatch_t	recvBatch;
+static netSendBatch_t	sendBatch;
+
+static int epoll_fd = -1;
+#endif
 
 //=============================================================================
 
@@ -638,126 +689,239 @@ qboolean NET_IsLocalAddress( const netadr_t *adr )
 
 /*
 ==================
-NET_GetPacket
+NET_AcceptPacket
 
-Receive one packet
+Set up net_from and net_message for a datagram of len bytes that was
+received from sock into net_message->data
 ==================
 */
-static qboolean NET_GetPacket( netadr_t *net_from, msg_t *net_message, const fd_set *fdr )
+static qboolean NET_AcceptPacket( SOCKET sock, sockaddr_t *from, socklen_t fromlen, int len, netadr_t *net_from, msg_t *net_message )
+{
+	if ( sock == ip_socket ) {
+		memset( &from->v4.sin_zero, 0, sizeof( from->v4.sin_zero ) );
+	}
+
+	if ( sock == ip_socket && usingSocks && memcmp( from, &socksRelayAddr, fromlen ) == 0 ) {
+		if ( len < 10 || net_message->data[0] != 0 || net_message->data[1] != 0 || net_message->data[2] != 0 || net_message->data[3] != 1 ) {
+			return qfalse;
+		}
+		net_from->type = NA_IP;
+		net_from->ipv._4[0] = net_message->data[4];
+		net_from->ipv._4[1] = net_message->data[5];
+		net_from->ipv._4[2] = net_message->data[6];
+		net_from->ipv._4[3] = net_message->data[7];
+		net_from->port = *(uint16_t *)&net_message->data[8];
+		net_message->readcount = 10;
+	}
+	else {
+		net_from->type = NA_BAD;
+		SockadrToNetadr( from, net_from );
+		net_message->readcount = 0;
+	}
+
+	if ( len >= net_message->maxsize ) {
+		Com_Printf( "Oversize packet from %s\n", NET_AdrToString( net_from ) );
+		return qfalse;
+	}
+
+	net_message->cursize = len;
+	return qtrue;
+}
+
+
+#ifndef USE_NET_BATCH
+/*
+==================
+NET_RecvFrom
+
+Receive one packet from sock, returns qfalse if nothing was read
+==================
+*/
+static qboolean NET_RecvFrom( SOCKET sock, netadr_t *net_from, msg_t *net_message, qboolean *accepted )
 {
-	int 	ret;
 	sockaddr_t	from;
 	socklen_t	fromlen;
-	int		err;
+	int			ret;
+	int			err;
+
+	fromlen = sizeof( from );
+	ret = recvfrom( sock, (void *)net_message->data, net_message->maxsize, 0, (struct sockaddr *) &from, &fromlen );
+	netStats.recvCalls++;
 
-	if(ip_socket != INVALID_SOCKET && FD_ISSET(ip_socket, fdr))
+	if ( ret == SOCKET_ERROR )
 	{
-		fromlen = sizeof(from);
-		ret = recvfrom( ip_socket, (void *)net_message->data, net_message->maxsize, 0, (struct sockaddr *) &from, &fromlen );
+		err = socketError;
 
-		if (ret == SOCKET_ERROR)
-		{
-			err = socketError;
+		if( err != EAGAIN && err != ECONNRESET )
+			Com_Printf( "NET_GetPacket: %s\n", NET_ErrorString() );
 
-			if( err != EAGAIN && err != ECONNRESET )
-				Com_Printf( "NET_GetPacket: %s\n", NET_ErrorString() );
-		}
-		else
-		{
-			memset( &from.v4.sin_zero, 0, sizeof( from.v4.sin_zero ) );
+		return qfalse;
+	}
 
-			if ( usingSocks && memcmp( &from, &socksRelayAddr, fromlen ) == 0 ) {
-				if ( ret < 10 || net_message->data[0] != 0 || net_message->data[1] != 0 || net_message->data[2] != 0 || net_message->data[3] != 1 ) {
-					return qfalse;
-				}
-				net_from->type = NA_IP;
-				net_from->ipv._4[0] = net_message->data[4];
-				net_from->ipv._4[1] = net_message->data[5];
-				net_from->ipv._4[2] = net_message->data[6];
-				net_from->ipv._4[3] = net_message->data[7];
-				net_from->port = *(uint16_t *)&net_message->data[8];
-				net_message->readcount = 10;
-			}
-			else {
-				net_from->type = NA_BAD;
-				SockadrToNetadr( &from, net_from );
-				net_message->readcount = 0;
-			}
+	netStats.recvPackets++;
+	*accepted = NET_AcceptPacket( sock, &from, fromlen, ret, net_from, net_message );
+	return qtrue;
+}
 
-			if( ret >= net_message->maxsize ) {
-				Com_Printf( "Oversize packet from %s\n", NET_AdrToString( net_from ) );
-				return qfalse;
-			}
 
-			net_message->cursize = ret;
-			return qtrue;
-		}
+/*
+==================
+NET_GetPacket
+
+Receive one packet
+==================
+*/
+static qboolean NET_GetPacket( netadr_t *net_from, msg_t *net_message, const fd_set *fdr )
+{
+	qboolean accepted;
+
+	if ( ip_socket != INVALID_SOCKET && FD_ISSET( ip_socket, fdr ) ) {
+		if ( NET_RecvFrom( ip_socket, net_from, net_message, &accepted ) )
+			return accepted;
 	}
 
 #ifdef USE_IPV6
-	if(ip6_socket != INVALID_SOCKET && FD_ISSET(ip6_socket, fdr))
-	{
-		fromlen = sizeof(from);
-		ret = recvfrom(ip6_socket, (void *)net_message->data, net_message->maxsize, 0, (struct sockaddr *) &from, &fromlen);
+	if ( ip6_socket != INVALID_SOCKET && FD_ISSET( ip6_socket, fdr ) ) {
+		if ( NET_RecvFrom( ip6_socket, net_from, net_message, &accepted ) )
+			return accepted;
+	}
 
-		if (ret == SOCKET_ERROR)
-		{
-			err = socketError;
+	if ( multicast6_socket != INVALID_SOCKET && multicast6_socket != ip6_socket && FD_ISSET( multicast6_socket, fdr ) ) {
+		if ( NET_RecvFrom( multicast6_socket, net_from, net_message, &accepted ) )
+			return accepted;
+	}
+#endif // USE_IPV6
 
-			if( err != EAGAIN && err != ECONNRESET )
-				Com_Printf( "NET_GetPacket: %s\n", NET_ErrorString() );
+	return qfalse;
+}
+#endif // !USE_NET_BATCH
+
+//=============================================================================
+
+
+#ifdef USE_NET_BATCH
+/*
+==================
+NET_FlushSendBatch
+
+Send queued packets with one sendmmsg call per run of packets
+for the same socket
+==================
+*/
+static void NET_FlushSendBatch( void )
+{
+	qboolean active;
+	int i, n, ret, err;
+
+	// anything printed from here goes out directly
+	active = sendBatch.active;
+	sendBatch.active = qfalse;
+
+	for ( i = 0; i < sendBatch.count; i += n ) {
+		for ( n = 1; i + n < sendBatch.count && sendBatch.sock[i + n] == sendBatch.sock[i]; n++ )
+			;
+
+		ret = sendmmsg( sendBatch.sock[i], sendBatch.hdr + i, n, 0 );
+		netStats.sendCalls++;
+
+		if ( ret > 0 ) {
+			netStats.sendPackets += ret;
+			n = ret;
+			continue;
 		}
-		else
-		{
-			net_from->type = NA_BAD;
-			SockadrToNetadr( &from, net_from );
-			net_message->readcount = 0;
 
-			if(ret >= net_message->maxsize)
-			{
-				Com_Printf( "Oversize packet from %s\n", NET_AdrToString( net_from ) );
-				return qfalse;
-			}
-			
-			net_message->cursize = ret;
-			return qtrue;
+		// the first packet failed, report it like sendto() would and skip it
+		err = socketError;
+		n = 1;
+
+		if ( err == EAGAIN || ( err == EADDRNOTAVAIL && sendBatch.broadcast[i] ) ) {
+			continue;
 		}
+
+		Com_Printf( "Sys_SendPacket: %s\n", NET_ErrorString() );
 	}
 
-	if(multicast6_socket != INVALID_SOCKET && multicast6_socket != ip6_socket && FD_ISSET(multicast6_socket, fdr))
-	{
-		fromlen = sizeof(from);
-		ret = recvfrom(multicast6_socket, (void *)net_message->data, net_message->maxsize, 0, (struct sockaddr *) &from, &fromlen);
+	sendBatch.count = 0;
+	sendBatch.poolUsed = 0;
+	sendBatch.active = active;
+}
 
-		if (ret == SOCKET_ERROR)
-		{
-			err = socketError;
 
-			if( err != EAGAIN && err != ECONNRESET )
-				Com_Printf( "NET_GetPacket: %s\n", NET_ErrorString() );
-		}
-		else
-		{
-			net_from->type = NA_BAD;
-			SockadrToNetadr( &from, net_from );
-			net_message->readcount = 0;
+/*
+==================
+NET_QueueSend
 
-			if(ret >= net_message->maxsize)
-			{
-				Com_Printf( "Oversize packet from %s\n", NET_AdrToString( net_from ) );
-				return qfalse;
-			}
+Returns qfalse if the packet has to be sent directly
+==================
+*/
+static qboolean NET_QueueSend( SOCKET sock, const sockaddr_t *addr, socklen_t addrlen, int length, const void *data, qboolean broadcast )
+{
+	struct msghdr *hdr;
+	int n;
 
-			net_message->cursize = ret;
-			return qtrue;
-		}
+	if ( length > sizeof( sendBatch.pool ) ) {
+		NET_FlushSendBatch();
+		return qfalse;
 	}
-#endif // USE_IPV6
 
-	return qfalse;
+	if ( sendBatch.count == NET_BATCH_SIZE || sendBatch.poolUsed + length > sizeof( sendBatch.pool ) ) {
+		NET_FlushSendBatch();
+	}
+
+	n = sendBatch.count++;
+
+	Com_Memcpy( sendBatch.pool + sendBatch.poolUsed, data, length );
+	sendBatch.iov[n].iov_base = sendBatch.pool + sendBatch.poolUsed;
+	sendBatch.iov[n].iov_len = length;
+	sendBatch.poolUsed += length;
+
+	sendBatch.addr[n] = *addr;
+	sendBatch.sock[n] = sock;
+	sendBatch.broadcast[n] = broadcast;
+
+	hdr = &sendBatch.hdr[n].msg_hdr;
+	Com_Memset( hdr, 0, sizeof( *hdr ) );
+	hdr->msg_name = &sendBatch.addr[n];
+	hdr->msg_namelen = addrlen;
+	hdr->msg_iov = &sendBatch.iov[n];
+	hdr->msg_iovlen = 1;
+
+	return qtrue;
 }
+#endif // USE_NET_BATCH
 
-//=============================================================================
+
+/*
+==================
+NET_BeginPacketBatch
+
+Packets sent until NET_EndPacketBatch may be queued and sent
+together, in order
+==================
+*/
+void NET_BeginPacketBatch( void )
+{
+#ifdef USE_NET_BATCH
+	sendBatch.active = qtrue;
+#endif
+}
+
+
+/*
+==================
+NET_EndPacketBatch
+==================
+*/
+void NET_EndPacketBatch( void )
+{
+#ifdef USE_NET_BATCH
+	sendBatch.active = qfalse;
+
+	if ( sendBatch.count ) {
+		NET_FlushSendBatch();
+	}
+#endif
+}
 
 
 /*
@@ -798,6 +962,13 @@ void Sys_SendPacket( int length, const void *data, const netadr_t *to ) {
 
 	NetadrToSockadr( to, &addr );
 
+#ifdef USE_NET_BATCH
+	// keep packet order if this one can't be queued
+	if ( sendBatch.active && sendBatch.count && usingSocks && to->type == NA_IP ) {
+		NET_FlushSendBatch();
+	}
+#endif
+
 	if ( usingSocks && to->type == NA_IP ) {
 		socks5_udp_request_t cmd;
 
@@ -813,6 +984,20 @@ void Sys_SendPacket( int length, const void *data, const netadr_t *to ) {
 		}
 	}
 	else {
+#ifdef USE_NET_BATCH
+		if ( sendBatch.active ) {
+			if ( addr.ss.ss_family == AF_INET ) {
+				if ( NET_QueueSend( ip_socket, &addr, sizeof(struct sockaddr_in), length, data, to->type == NA_BROADCAST ) )
+					return;
+			}
+#ifdef USE_IPV6
+			else if ( addr.ss.ss_family == AF_INET6 ) {
+				if ( NET_QueueSend( ip6_socket, &addr, sizeof(struct sockaddr_in6), length, data, qfalse ) )
+					return;
+			}
+#endif
+		}
+#endif
 		if ( addr.ss.ss_family == AF_INET )
 			ret = sendto( ip_socket, data, length, 0, (struct sockaddr *) &addr, sizeof(struct sockaddr_in) );
 #ifdef USE_IPV6
@@ -821,6 +1006,8 @@ void Sys_SendPacket( int length, const void *data, const netadr_t *to ) {
 #endif
 	}
 
+	netStats.sendCalls++;
+
 	if( ret == SOCKET_ERROR ) {
 		int err = socketError;
 
@@ -835,7 +1022,10 @@ void Sys_SendPacket( int length, const void *data, const netadr_t *to ) {
 		}
 
 		Com_Printf( "Sys_SendPacket: %s\n", NET_ErrorString() );
+		return;
 	}
+
+	netStats.sendPackets++;
 }
 
 
@@ -1682,6 +1872,55 @@ static qboolean NET_GetCvars( void ) {
 }
 
 
+#ifdef USE_NET_BATCH
+/*
+====================
+NET_EpollAdd
+====================
+*/
+static void NET_EpollAdd( SOCKET sock )
+{
+	struct epoll_event ev;
+
+	if ( sock == INVALID_SOCKET )
+		return;
+
+	Com_Memset( &ev, 0, sizeof( ev ) );
+	ev.events = EPOLLIN;
+	ev.data.fd = sock;
+
+	if ( epoll_ctl( epoll_fd, EPOLL_CTL_ADD, sock, &ev ) == -1 ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: epoll_ctl() failed: %s\n", NET_ErrorString() );
+		close( epoll_fd );
+		epoll_fd = -1;
+	}
+}
+
+
+/*
+====================
+NET_EpollOpen
+
+Falls back to select() in NET_Sleep if this fails
+====================
+*/
+static void NET_EpollOpen( void )
+{
+	epoll_fd = epoll_create1( EPOLL_CLOEXEC );
+	if ( epoll_fd == -1 ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: epoll_create1() failed: %s\n", NET_ErrorString() );
+		return;
+	}
+
+	NET_EpollAdd( ip_socket );
+#ifdef USE_IPV6
+	if ( epoll_fd != -1 )
+		NET_EpollAdd( ip6_socket );
+#endif
+}
+#endif
+
+
 /*
 ====================
 NET_Config
@@ -1727,6 +1966,13 @@ static void NET_Config( qboolean enableNetworking ) {
 	}
 
 	if( stop ) {
+#ifdef USE_NET_BATCH
+		NET_EndPacketBatch();
+		if ( epoll_fd != -1 ) {
+			close( epoll_fd );
+			epoll_fd = -1;
+		}
+#endif
 		if ( ip_socket != INVALID_SOCKET ) {
 			closesocket( ip_socket );
 			ip_socket = INVALID_SOCKET;
@@ -1759,6 +2005,9 @@ static void NET_Config( qboolean enableNetworking ) {
 			NET_OpenIP();
 #ifdef USE_IPV6
 			NET_SetMulticast6();
+#endif
+#ifdef USE_NET_BATCH
+			NET_EpollOpen();
 #endif
 		}
 	}
@@ -1787,6 +2036,7 @@ void NET_Init( void ) {
 	NET_Config( qtrue );
 	
 	Cmd_AddCommand( "net_restart", NET_Restart_f );
+	Cmd_AddCommand( "net_stats", NET_Stats_f );
 }
 
 
@@ -1809,6 +2059,84 @@ void NET_Shutdown( void ) {
 }
 
 
+/*
+====================
+NET_DispatchPacket
+====================
+*/
+static void NET_DispatchPacket( const netadr_t *from, msg_t *netmsg )
+{
+	if ( net_dropsim->value > 0.0f && net_dropsim->value <= 100.0f )
+	{
+		// com_dropsim->value percent of incoming packets get dropped.
+		if ( rand() < (int) (((double) RAND_MAX) / 100.0 * (double) net_dropsim->value) )
+			return; // drop this packet
+	}
+
+#ifdef DEDICATED
+	Com_RunAndTimeServerPacket( from, netmsg );
+#else
+	if ( com_sv_running->integer || com_dedicated->integer )
+		Com_RunAndTimeServerPacket( from, netmsg );
+	else
+		CL_PacketEvent( from, netmsg );
+#endif
+}
+
+
+#ifdef USE_NET_BATCH
+/*
+====================
+NET_ReceiveBatch
+
+Read everything that is pending on sock, NET_BATCH_SIZE datagrams per syscall
+====================
+*/
+static void NET_ReceiveBatch( SOCKET sock )
+{
+	struct msghdr *hdr;
+	netadr_t from;
+	msg_t netmsg;
+	int i, n, err;
+
+	do {
+		for ( i = 0; i < NET_BATCH_SIZE; i++ ) {
+			recvBatch.iov[i].iov_base = recvBatch.data[i];
+			recvBatch.iov[i].iov_len = MAX_MSGLEN;
+			hdr = &recvBatch.hdr[i].msg_hdr;
+			Com_Memset( hdr, 0, sizeof( *hdr ) );
+			hdr->msg_name = &recvBatch.addr[i];
+			hdr->msg_namelen = sizeof( recvBatch.addr[i] );
+			hdr->msg_iov = &recvBatch.iov[i];
+			hdr->msg_iovlen = 1;
+		}
+
+		n = recvmmsg( sock, recvBatch.hdr, NET_BATCH_SIZE, MSG_DONTWAIT, NULL );
+		netStats.recvCalls++;
+
+		if ( n == SOCKET_ERROR ) {
+			err = socketError;
+			if ( err != EAGAIN && err != ECONNRESET )
+				Com_Printf( "NET_GetPacket: %s\n", NET_ErrorString() );
+			return;
+		}
+
+		netStats.recvPackets += n;
+
+		for ( i = 0; i < n; i++ ) {
+			MSG_Init( &netmsg, recvBatch.data[i], MAX_MSGLEN );
+			hdr = &recvBatch.hdr[i].msg_hdr;
+			if ( NET_AcceptPacket( sock, &recvBatch.addr[i], hdr->msg_namelen, recvBatch.hdr[i].msg_len, &from, &netmsg ) ) {
+				NET_DispatchPacket( &from, &netmsg );
+			}
+		}
+	} while ( n == NET_BATCH_SIZE );
+}
+
+
+#endif // USE_NET_BATCH
+
+
 /*
 ====================
 NET_Event
@@ -1818,35 +2146,28 @@ Called from NET_Sleep which uses select() to determine which sockets have seen a
 */
 static void NET_Event( const fd_set *fdr )
 {
+#ifdef USE_NET_BATCH
+	if ( ip_socket != INVALID_SOCKET && FD_ISSET( ip_socket, fdr ) )
+		NET_ReceiveBatch( ip_socket );
+#ifdef USE_IPV6
+	if ( ip6_socket != INVALID_SOCKET && FD_ISSET( ip6_socket, fdr ) )
+		NET_ReceiveBatch( ip6_socket );
+#endif
+#else
 	byte bufData[ MAX_MSGLEN_BUF ];
 	netadr_t from;
 	msg_t netmsg;
-	
+
 	while( 1 )
 	{
 		MSG_Init( &netmsg, bufData, MAX_MSGLEN );
 
 		if ( NET_GetPacket( &from, &netmsg, fdr ) )
-		{
-			if ( net_dropsim->value > 0.0f && net_dropsim->value <= 100.0f )
-			{
-				// com_dropsim->value percent of incoming packets get dropped.
-				if ( rand() < (int) (((double) RAND_MAX) / 100.0 * (double) net_dropsim->value) )
-					continue; // drop this packet
-			}
-
-#ifdef DEDICATED
-			Com_RunAndTimeServerPacket( &from, &netmsg );
-#else
-			if ( com_sv_running->integer || com_dedicated->integer )
-				Com_RunAndTimeServerPacket( &from, &netmsg );
-			else
-				CL_PacketEvent( &from, &netmsg );
-#endif
-		}
+			NET_DispatchPacket( &from, &netmsg );
 		else
 			break;
 	}
+#endif
 }
 
 
@@ -1865,6 +2186,13 @@ qboolean NET_Sleep( int timeout )
 	fd_set fdr;
 	int retval;
 	SOCKET highestfd = INVALID_SOCKET;
+#ifdef USE_NET_BATCH
+	struct epoll_event events[2];
+	int i;
+
+	// in case an error dropped out of a batch
+	NET_EndPacketBatch();
+#endif
 
 	if ( timeout < 0 )
 		timeout = 0;
@@ -1903,6 +2231,27 @@ qboolean NET_Sleep( int timeout )
 #endif
 	}
 
+#ifdef USE_NET_BATCH
+	if ( epoll_fd != -1 )
+	{
+		// epoll has millisecond resolution, round up so that waits
+		// under half a millisecond don't turn into busy polling
+		retval = epoll_wait( epoll_fd, events, ARRAY_LEN( events ), ( timeout + 999 ) / 1000 );
+
+		if ( retval > 0 ) {
+			for ( i = 0; i < retval; i++ )
+				NET_ReceiveBatch( events[i].data.fd );
+			return qfalse;
+		}
+
+		if ( retval == -1 && errno != EINTR )
+			Com_Printf( S_COLOR_YELLOW "Warning: epoll_wait() syscall failed: %s\n",
+				NET_ErrorString() );
+
+		return qtrue;
+	}
+#endif
+
 	tv.tv_sec = timeout / 1000000;
 	tv.tv_usec = timeout - tv.tv_sec * 1000000;
 
@@ -1925,6 +2274,246 @@ qboolean NET_Sleep( int timeout )
 }
 
 
+/*
+=============================================================================
+
+TCP STREAMS
+
+Small non-blocking stream wrapper for the TV relay. These functions
+don't print, so they can be used from the TV writer thread.
+
+=============================================================================
+*/
+
+#ifdef MSG_NOSIGNAL
+#define STREAM_SEND_FLAGS	MSG_NOSIGNAL
+#else
+#define STREAM_SEND_FLAGS	0
+#endif
+
+struct netstream_s {
+	SOCKET	sock;
+};
+
+
+/*
+====================
+NET_StreamNew
+====================
+*/
+static netstream_t *NET_StreamNew( SOCKET sock ) {
+	netstream_t *stream;
+	ioctlarg_t _true = 1;
+#ifdef SO_NOSIGPIPE
+	int one = 1;
+
+	setsockopt( sock, SOL_SOCKET, SO_NOSIGPIPE, (char *)&one, sizeof( one ) );
+#endif
+
+	if ( ioctlsocket( sock, FIONBIO, &_true ) == SOCKET_ERROR ) {
+		closesocket( sock );
+		return NULL;
+	}
+
+	stream = malloc( sizeof( *stream ) );
+	if ( !stream ) {
+		closesocket( sock );
+		return NULL;
+	}
+
+	stream->sock = sock;
+	return stream;
+}
+
+
+/*
+====================
+NET_StreamListen
+
+Open a listening socket on all IPv4 interfaces.
+====================
+*/
+netstream_t *NET_StreamListen( int port ) {
+	struct sockaddr_in address;
+	SOCKET sock;
+	int one = 1;
+
+	if ( ( sock = socket( AF_INET, SOCK_STREAM, IPPROTO_TCP ) ) == INVALID_SOCKET ) {
+		return NULL;
+	}
+
+	setsockopt( sock, SOL_SOCKET, SO_REUSEADDR, (char *)&one, sizeof( one ) );
+
+	Com_Memset( &address, 0, sizeof( address ) );
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = INADDR_ANY;
+	address.sin_port = htons( (unsigned short)port );
+
+	if ( bind( sock, (void *)&address, sizeof( address ) ) == SOCKET_ERROR ||
+		 listen( sock, 16 ) == SOCKET_ERROR ) {
+		closesocket( sock );
+		return NULL;
+	}
+
+	return NET_StreamNew( sock );
+}
+
+
+/*
+====================
+NET_StreamAccept
+
+Returns NULL if no connection is pending.
+====================
+*/
+netstream_t *NET_StreamAccept( netstream_t *listener, netadr_t *from ) {
+	sockaddr_t address;
+	socklen_t len = sizeof( address );
+	SOCKET sock;
+	int one = 1;
+
+	sock = accept( listener->sock, (struct sockaddr *)&address, &len );
+	if ( sock == INVALID_SOCKET ) {
+		return NULL;
+	}
+
+	setsockopt( sock, IPPROTO_TCP, TCP_NODELAY, (char *)&one, sizeof( one ) );
+
+	if ( from ) {
+		Com_Memset( from, 0, sizeof( *from ) );
+		SockadrToNetadr( &address, from );
+	}
+
+	return NET_StreamNew( sock );
+}
+
+
+/*
+====================
+NET_StreamConnect
+
+Blocking connect, the returned stream is non-blocking.
+====================
+*/
+netstream_t *NET_StreamConnect( const char *address, int defaultPort ) {
+	netadr_t adr;
+	sockaddr_t sadr;
+	SOCKET sock;
+	int ret;
+
+	Com_Memset( &adr, 0, sizeof( adr ) );
+	ret = NET_StringToAdr( address, &adr, NA_UNSPEC );
+	if ( ret == 0 || ( adr.type != NA_IP
+#ifdef USE_IPV6
+		&& adr.type != NA_IP6
+#endif
+		) ) {
+		return NULL;
+	}
+	if ( ret == 2 ) {
+		adr.port = BigShort( (short)defaultPort );
+	}
+
+	Com_Memset( &sadr, 0, sizeof( sadr ) );
+	NetadrToSockadr( &adr, &sadr );
+
+	if ( ( sock = socket( sadr.ss.ss_family, SOCK_STREAM, IPPROTO_TCP ) ) == INVALID_SOCKET ) {
+		return NULL;
+	}
+
+	if ( connect( sock, (struct sockaddr *)&sadr,
+		sadr.ss.ss_family == AF_INET ? sizeof( sadr.v4 ) : sizeof( sadr.v6 ) ) == SOCKET_ERROR ) {
+		closesocket( sock );
+		return NULL;
+	}
+
+	return NET_StreamNew( sock );
+}
+
+
+/*
+====================
+NET_StreamSend
+====================
+*/
+int NET_StreamSend( netstream_t *stream, const void *data, int len ) {
+	int ret;
+
+	ret = send( stream->sock, data, len, STREAM_SEND_FLAGS );
+	if ( ret == SOCKET_ERROR ) {
+		return ( socketError == EAGAIN ) ? 0 : -1;
+	}
+
+	return ret;
+}
+
+
+/*
+====================
+NET_StreamRecv
+====================
+*/
+int NET_StreamRecv( netstream_t *stream, void *data, int len ) {
+	int ret;
+
+	ret = recv( stream->sock, data, len, 0 );
+	if ( ret == SOCKET_ERROR ) {
+		return ( socketError == EAGAIN ) ? 0 : -1;
+	}
+
+	if ( ret == 0 ) {
+		return -1; // orderly shutdown
+	}
+
+	return ret;
+}
+
+
+/*
+====================
+NET_StreamWait
+====================
+*/
+qboolean NET_StreamWait( netstream_t *stream, int msec ) {
+	struct timeval tv;
+	fd_set fdr;
+
+	FD_ZERO( &fdr );
+	FD_SET( stream->sock, &fdr );
+
+	tv.tv_sec = msec / 1000;
+	tv.tv_usec = ( msec % 1000 ) * 1000;
+
+	return select( stream->sock + 1, &fdr, NULL, NULL, &tv ) > 0 ? qtrue : qfalse;
+}
+
+
+/*
+====================
+NET_StreamClose
+====================
+*/
+void NET_StreamClose( netstream_t *stream ) {
+	if ( stream ) {
+		closesocket( stream->sock );
+		free( stream );
+	}
+}
+
+
+/*
+====================
+NET_Restart
+
+Reopen the sockets if any of the net cvars changed
+====================
+*/
+void NET_Restart( void )
+{
+	NET_Config( qtrue );
+}
+
+
 /*
 ====================
 NET_Restart_f
@@ -1932,5 +2521,31 @@ NET_Restart_f
 */
 static void NET_Restart_f( void )
 {
-	NET_Config( qtrue );
+	NET_Restart();
+}
+
+
+/*
+====================
+NET_Stats_f
+====================
+*/
+static void NET_Stats_f( void )
+{
+	if ( !Q_stricmp( Cmd_Argv( 1 ), "reset" ) ) {
+		Com_Memset( &netStats, 0, sizeof( netStats ) );
+		return;
+	}
+
+	Com_Printf( "recv: %llu packets in %llu syscalls, %.2f per call\n",
+		(unsigned long long)netStats.recvPackets, (unsigned long long)netStats.recvCalls,
+		netStats.recvCalls ? (double)netStats.recvPackets / netStats.recvCalls : 0.0 );
+	Com_Printf( "send: %llu packets in %llu syscalls, %.2f per call\n",
+		(unsigned long long)netStats.sendPackets, (unsigned long long)netStats.sendCalls,
+		netStats.sendCalls ? (double)netStats.sendPackets / netStats.sendCalls : 0.0 );
+#ifdef USE_NET_BATCH
+	Com_Printf( "batching: recvmmsg/sendmmsg, %s\n", epoll_fd != -1 ? "epoll" : "select" );
+#else
+	Com_Printf( "batching: off\n" );
+#endif
 }
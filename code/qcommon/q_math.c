@@ -1092,7 +1092,7 @@ int Q_isnan( float x )
 Q_isfinite
 ================
 */
-static int Q_isfinite( float f )
+int Q_isfinite( float f )
 {
 	floatint_t fi;
 	fi.f = f;
@@ -709,6 +709,7 @@ void MatrixMultiply(float in1[3][3], float in2[3][3], float out[3][3]);
 void AngleVectors( const vec3_t angles, vec3_t forward, vec3_t right, vec3_t up);
 void PerpendicularVector( vec3_t dst, const vec3_t src );
 int Q_isnan( float x );
+int Q_isfinite( float f );
 float Q_atof( const char *str );
 
 #ifndef MAX
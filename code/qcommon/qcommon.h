@@ -62,6 +62,7 @@ typedef struct {
 	qboolean	allowoverflow;	// if false, do a Com_Error
 	qboolean	overflowed;		// set to true if the buffer size failed (with allowoverflow set)
 	qboolean	oob;			// raw out-of-band operation, no static huffman encoding/decoding
+	qboolean	raw;			// plain bit packing, no static huffman encoding/decoding
 	byte	*data;
 	int		maxsize;
 	int		maxbits;			// maxsize in bits, for overflow checks
@@ -74,7 +75,9 @@ void MSG_Init( msg_t *buf, byte *data, int length );
 void MSG_InitOOB( msg_t *buf, byte *data, int length );
 void MSG_Clear( msg_t *buf );
 void MSG_WriteData( msg_t *buf, const void *data, int length );
+void MSG_WriteBitstring( msg_t *msg, const byte *data, int bits );
 void MSG_Bitstream( msg_t *buf );
+void MSG_Rawstream( msg_t *buf );
 
 // TTimo
 // copy a msg_t in case we need to store it as is for a bit
@@ -118,9 +121,11 @@ void MSG_ReadDeltaUsercmdKey( msg_t *msg, int key, const usercmd_t *from, usercm
 
 void MSG_WriteDeltaEntity( msg_t *msg, const entityState_t *from, const entityState_t *to, qboolean force );
 void MSG_ReadDeltaEntity( msg_t *msg, const entityState_t *from, entityState_t *to, int number );
+qboolean MSG_ReadDeltaEntityQuiet( msg_t *msg, const entityState_t *from, entityState_t *to, int number );
 
 void MSG_WriteDeltaPlayerstate( msg_t *msg, const playerState_t *from, const playerState_t *to );
 void MSG_ReadDeltaPlayerstate( msg_t *msg, const playerState_t *from, playerState_t *to );
+qboolean MSG_ReadDeltaPlayerstateQuiet( msg_t *msg, const playerState_t *from, playerState_t *to );
 
 void MSG_ReportChangeVectors_f( void );
 
@@ -216,6 +221,20 @@ void		NET_JoinMulticast6( void );
 void		NET_LeaveMulticast6( void );
 #endif
 qboolean	NET_Sleep( int timeout );
+void		NET_Restart( void );
+void		NET_BeginPacketBatch( void );
+void		NET_EndPacketBatch( void );
+
+// non-blocking TCP streams, used by the TV relay
+typedef struct netstream_s netstream_t;
+
+netstream_t	*NET_StreamListen( int port );
+netstream_t	*NET_StreamAccept( netstream_t *listener, netadr_t *from );
+netstream_t	*NET_StreamConnect( const char *address, int defaultPort );
+int			NET_StreamSend( netstream_t *stream, const void *data, int len );	// bytes sent, -1 on error
+int			NET_StreamRecv( netstream_t *stream, void *data, int len );	// bytes read, 0 if none pending, -1 on error or close
+qboolean	NET_StreamWait( netstream_t *stream, int msec );	// qtrue when readable
+void		NET_StreamClose( netstream_t *stream );
 
 #define	MAX_PACKETLEN	1400	// max size of a network packet
 
@@ -790,6 +809,10 @@ int		FS_ReadFile( const char *qpath, void **buffer );
 // the buffer should be considered read-only, because it may be cached
 // for other uses.
 
+int		FS_HomeReadFile( const char *qpath, void **buffer );
+// like FS_ReadFile, but only from the current gamedir under fs_homepath,
+// never from pk3s or the other search paths
+
 void	FS_ForceFlush( fileHandle_t f );
 // forces flush on files we're writing to.
 
@@ -805,6 +828,11 @@ int		FS_filelength( fileHandle_t f );
 int		FS_FTell( fileHandle_t f );
 // where are we?
 
+const void *FS_MapFile( fileHandle_t f, int *length );
+// maps a file opened for reading, NULL for pack files or if mapping fails
+
+void	FS_UnmapFile( const void *base, int length );
+
 void	FS_Flush( fileHandle_t f );
 
 void 	QDECL FS_Printf( fileHandle_t f, const char *fmt, ... ) __attribute__ ((format (printf, 2, 3)));
@@ -866,6 +894,10 @@ const char *FS_GetBaseGameDir( void );
 
 const char *FS_GetHomePath( void );
 
+// forked server instances write their logs under instanceN/
+const char *FS_InstancePath( const char *qpath );
+void FS_SetInstanceDir( const char *dir );
+
 qboolean FS_StripExt( char *filename, const char *ext );
 qboolean FS_AllowedExtension( const char *fileName, qboolean allowPk3s, const char **ext );
 
@@ -1130,6 +1162,7 @@ unsigned int Com_TouchMemory( void );
 void Com_Init( char *commandLine );
 void Com_FrameInit( void );
 void Com_Frame( qboolean noDelay );
+void Com_ReopenLogFile( void );
 
 /*
 ==============================================================
@@ -1268,6 +1301,8 @@ void	Sys_Init( void );
 void	Sys_QueEvent( int evTime, sysEventType_t evType, int value, int value2, int ptrLength, void *ptr );
 void	Sys_SendKeyEvents( void );
 void	Sys_Sleep( int msec );
+void	Sys_SleepUntil( int msec, int spinUsec );
+int		Sys_ForkInstances( int count );
 char	*Sys_ConsoleInput( void );
 
 void	NORETURN FORMAT_PRINTF(1, 2) QDECL Sys_Error( const char *error, ... );
@@ -1292,6 +1327,33 @@ int64_t	Sys_Microseconds( void );
 
 void	Sys_SnapVector( float *vector );
 
+// threads for background work; Sys_CreateThread returns NULL when threads
+// are not available (e.g. emscripten without pthreads) and callers must
+// fall back to doing the work on the main thread
+typedef void (*sysThreadFunc_t)( void *arg );
+
+void	*Sys_CreateThread( sysThreadFunc_t func, void *arg );
+void	Sys_JoinThread( void *thread );
+
+void	*Sys_CreateMutex( void );
+void	Sys_DestroyMutex( void *mutex );
+void	Sys_LockMutex( void *mutex );
+void	Sys_UnlockMutex( void *mutex );
+
+void	*Sys_CreateSemaphore( int count );
+void	Sys_DestroySemaphore( void *sem );
+void	Sys_SemaphoreWait( void *sem );
+void	Sys_SemaphorePost( void *sem );
+
+// jobs.c, load time work spread over threads
+typedef void (*jobFunc_t)( void *arg, int index );
+
+void	*Com_StartJob( sysThreadFunc_t func, void *arg );
+void	Com_FinishJob( void *job );
+int		Com_RunJobs( jobFunc_t func, void *arg, int count, int numThreads );
+void	QDECL Com_JobPrintf( const char *fmt, ... ) __attribute__ ((format (printf, 1, 2)));
+void	QDECL Com_JobDPrintf( const char *fmt, ... ) __attribute__ ((format (printf, 1, 2)));
+
 qboolean Sys_RandomBytes( byte *string, int len );
 
 // the system console is shown when a dedicated server is running
@@ -1326,6 +1388,9 @@ void Sys_FreeFileList( char **list );
 
 qboolean Sys_GetFileStats( const char *filename, fileOffset_t *size, fileTime_t *mtime, fileTime_t *ctime );
 
+const void *Sys_MapFile( FILE *f, int *length );
+void Sys_UnmapFile( const void *base, int length );
+
 void Sys_BeginProfiling( void );
 void Sys_EndProfiling( void );
 
@@ -1347,6 +1412,8 @@ void HuffmanPutBit( byte* fout, int32_t bitIndex, int bit );
 int HuffmanPutSymbol( byte* fout, uint32_t offset, int symbol );
 int HuffmanGetBit( const byte* buffer, int bitIndex );
 int HuffmanGetSymbol( unsigned int* symbol, const byte* buffer, int bitIndex );
+int HuffmanPutBits( byte* fout, int32_t bitIndex, uint32_t value, int bits );
+int HuffmanGetBits( unsigned int* value, const byte* buffer, int bitIndex, int bits );
 
 #define	SV_ENCODE_START		4
 #define	SV_DECODE_START		12
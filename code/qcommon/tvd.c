@@ -0,0 +1,605 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// tvd.c -- .tvd header and frame parsing
+//
+// Nothing here prints or touches client/server state, so it can run on a
+// worker thread and be linked into standalone tools with msg.c.
+
+#include "q_shared.h"
+#include "qcommon.h"
+#include "tvd.h"
+
+
+/*
+===============
+TVD_ReadString
+
+Read a null-terminated header string, byte at a time.
+Overlong strings are truncated and the rest is skipped.
+===============
+*/
+static qboolean TVD_ReadString( tvdReadFunc_t readFunc, void *ctx, char *buf, int bufSize ) {
+	int i;
+	char c;
+
+	for ( i = 0; ; i++ ) {
+		if ( readFunc( ctx, &c, 1 ) != 1 ) {
+			buf[i < bufSize ? i : bufSize - 1] = '\0';
+			return qfalse;
+		}
+		if ( i < bufSize - 1 ) {
+			buf[i] = c;
+		}
+		if ( c == '\0' ) {
+			break;
+		}
+	}
+
+	buf[i < bufSize ? i : bufSize - 1] = '\0';
+	return qtrue;
+}
+
+
+/*
+===============
+TVD_ReadHeader
+
+Read the uncompressed header: magic, protocol, sv_fps, maxclients,
+dictionary id, map name, timestamp and the initial configstrings, which
+are passed to csFunc. On failure header->error is set (possibly empty for a short read).
+===============
+*/
+qboolean TVD_ReadHeader( tvdReadFunc_t readFunc, tvdConfigstringFunc_t csFunc, void *ctx, tvdHeader_t *header ) {
+	char magic[4];
+	char csData[BIG_INFO_STRING];
+	unsigned short csIdx, csLen;
+
+	Com_Memset( header, 0, sizeof( *header ) );
+
+	// Read and validate magic
+	if ( readFunc( ctx, magic, 4 ) != 4 ||
+		 magic[0] != 'T' || magic[1] != 'V' || magic[2] != 'D' || magic[3] != '1' ) {
+		Q_strncpyz( header->error, "Invalid magic", sizeof( header->error ) );
+		return qfalse;
+	}
+
+	// Protocol version
+	if ( readFunc( ctx, &header->protocol, 4 ) != 4 ||
+		 header->protocol < 1 || header->protocol > TVD_PROTOCOL_VERSION ) {
+		Com_sprintf( header->error, sizeof( header->error ), "Unsupported protocol %i", header->protocol );
+		return qfalse;
+	}
+
+	if ( readFunc( ctx, &header->svFps, 4 ) != 4 ||
+		 readFunc( ctx, &header->maxclients, 4 ) != 4 ||
+		 ( header->protocol >= 4 && readFunc( ctx, &header->dictId, 4 ) != 4 ) ||
+		 !TVD_ReadString( readFunc, ctx, header->mapname, sizeof( header->mapname ) ) ||
+		 !TVD_ReadString( readFunc, ctx, header->timestamp, sizeof( header->timestamp ) ) ) {
+		return qfalse;
+	}
+
+	// Configstrings, terminated by 0xFFFF
+	while ( 1 ) {
+		if ( readFunc( ctx, &csIdx, 2 ) != 2 ) {
+			return qfalse;
+		}
+
+		if ( csIdx == 0xFFFF ) {
+			break;
+		}
+
+		if ( readFunc( ctx, &csLen, 2 ) != 2 ) {
+			return qfalse;
+		}
+
+		if ( csLen >= sizeof( csData ) ) {
+			Com_sprintf( header->error, sizeof( header->error ), "Configstring %i too long (%i)", csIdx, csLen );
+			return qfalse;
+		}
+
+		if ( csLen > 0 && readFunc( ctx, csData, csLen ) != csLen ) {
+			return qfalse;
+		}
+		csData[csLen] = '\0';
+
+		if ( csIdx >= MAX_CONFIGSTRINGS ) {
+			continue;
+		}
+
+		if ( csFunc && !csFunc( ctx, csIdx, csData, csLen ) ) {
+			Com_sprintf( header->error, sizeof( header->error ), "Configstring %i rejected", csIdx );
+			return qfalse;
+		}
+	}
+
+	return qtrue;
+}
+
+
+/*
+===============
+TVD_ResetDecoder
+===============
+*/
+void TVD_ResetDecoder( tvdDecoder_t *dec, int protocol ) {
+	Com_Memset( dec, 0, sizeof( *dec ) );
+	dec->protocol = protocol;
+}
+
+
+/*
+===============
+TVD_ReadMaskRuns
+
+Apply protocol 3 run-length encoded presence changes to a mask:
+alternating runs of unchanged and toggled bits, starting unchanged.
+===============
+*/
+static qboolean TVD_ReadMaskRuns( msg_t *msg, byte *mask, int count ) {
+	int pos, run, i;
+	qboolean toggled;
+
+	pos = 0;
+	toggled = qfalse;
+	while ( pos < count ) {
+		run = MSG_ReadShort( msg );
+		if ( run < 0 || run > count - pos || ( run == 0 && ( pos > 0 || toggled ) ) ) {
+			return qfalse;
+		}
+		if ( toggled ) {
+			for ( i = pos; i < pos + run; i++ ) {
+				mask[i >> 3] ^= ( 1 << ( i & 7 ) );
+			}
+		}
+		pos += run;
+		toggled = !toggled;
+	}
+
+	return qtrue;
+}
+
+
+/*
+===============
+TVD_FrameAddString
+
+Append a configstring or command record to a parsed frame:
+index:2, len:2, data, '\0'.
+===============
+*/
+qboolean TVD_FrameAddString( tvdFrame_t *f, int index, const char *data, int len ) {
+	short s;
+	int need;
+
+	need = f->stringsSize + 4 + len + 1;
+	if ( need > f->maxStrings ) {
+		int newMax = f->maxStrings ? f->maxStrings : 4096;
+		byte *buf;
+
+		while ( newMax < need ) {
+			newMax *= 2;
+		}
+		buf = realloc( f->strings, newMax );
+		if ( !buf ) {
+			return qfalse;
+		}
+		f->strings = buf;
+		f->maxStrings = newMax;
+	}
+
+	s = (short)index;
+	Com_Memcpy( f->strings + f->stringsSize, &s, 2 );
+	s = (short)len;
+	Com_Memcpy( f->strings + f->stringsSize + 2, &s, 2 );
+	Com_Memcpy( f->strings + f->stringsSize + 4, data, len );
+	f->strings[f->stringsSize + 4 + len] = '\0';
+	f->stringsSize = need;
+
+	return qtrue;
+}
+
+
+/*
+===============
+TVD_FrameNextString
+
+Walk the string records of a parsed frame.
+===============
+*/
+const byte *TVD_FrameNextString( const byte *p, int *index, const char **data, int *len ) {
+	short s;
+
+	Com_Memcpy( &s, p, 2 );
+	*index = s;
+	Com_Memcpy( &s, p + 2, 2 );
+	*len = s;
+	*data = (const char *)p + 4;
+
+	return p + 4 + *len + 1;
+}
+
+
+/*
+===============
+TVD_FreeFrame
+===============
+*/
+void TVD_FreeFrame( tvdFrame_t *f ) {
+	free( f->entities );
+	free( f->strings );
+	f->entities = NULL;
+	f->strings = NULL;
+	f->maxEntities = 0;
+	f->maxStrings = 0;
+}
+
+
+/*
+===============
+TVD_ParseFrame
+
+Parse one frame payload into f, advancing the decoder's delta state.
+The payload is raw bit packed (MSG_Rawstream) for protocol 5 and static
+Huffman for protocol 4 and older. Failures are reported through f->error
+and f->end.
+===============
+*/
+void TVD_ParseFrame( tvdDecoder_t *dec, byte *data, int size, tvdFrame_t *f ) {
+	msg_t msg;
+	int num;
+	entityState_t *oldEntity;
+	byte oldEntityBitmask[MAX_GENTITIES/8];
+	byte oldPlayerBitmask[MAX_CLIENTS/8];
+	int i;
+	char csData[BIG_INFO_STRING];
+
+	f->end = qfalse;
+	f->error[0] = '\0';
+	f->numEntities = 0;
+	f->numPlayers = 0;
+	f->csCount = 0;
+	f->cmdCount = 0;
+	f->stringsSize = 0;
+
+	// Set up message for reading
+	MSG_Init( &msg, data, size );
+	msg.cursize = size;
+	MSG_BeginReading( &msg );
+
+	// Protocol 5+ frames are plain bit packed, zstd does the entropy coding
+	if ( dec->protocol >= 5 ) {
+		MSG_Rawstream( &msg );
+	}
+
+	// Server time
+	f->serverTime = MSG_ReadLong( &msg );
+
+	// Frame flags (protocol 2+)
+	f->flags = ( dec->protocol >= 2 ) ? MSG_ReadByte( &msg ) : 0;
+
+	// Keyframes are delta-encoded from zeroed baselines
+	if ( f->flags & TVD_FRAME_KEYFRAME ) {
+		Com_Memset( dec->entities, 0, sizeof( dec->entities ) );
+		Com_Memset( dec->entityBitmask, 0, sizeof( dec->entityBitmask ) );
+		Com_Memset( dec->players, 0, sizeof( dec->players ) );
+		Com_Memset( dec->playerBitmask, 0, sizeof( dec->playerBitmask ) );
+	}
+
+	// --- Entity section ---
+
+	// Save old bitmask for cleanup
+	Com_Memcpy( oldEntityBitmask, dec->entityBitmask, sizeof( oldEntityBitmask ) );
+
+	// Read new entity bitmask
+	if ( dec->protocol >= 3 ) {
+		if ( !TVD_ReadMaskRuns( &msg, dec->entityBitmask, MAX_GENTITIES ) ) {
+			Q_strncpyz( f->error, "Bad entity mask", sizeof( f->error ) );
+			f->end = qtrue;
+			return;
+		}
+	} else {
+		MSG_ReadData( &msg, dec->entityBitmask, MAX_GENTITIES / 8 );
+	}
+	Com_Memcpy( f->entityBitmask, dec->entityBitmask, sizeof( f->entityBitmask ) );
+
+	// Read delta-encoded entities from the bitstream
+	while ( 1 ) {
+		num = MSG_ReadEntitynum( &msg );
+		if ( num == MAX_GENTITIES - 1 ) {
+			break;  // end marker
+		}
+
+		if ( num < 0 ) {
+			// MSG_ReadEntitynum returns -1 when the message buffer is
+			// exhausted.  This is normal at the end of a demo file where
+			// the final frame may be truncated.
+			f->end = qtrue;
+			return;
+		}
+
+		if ( num >= MAX_GENTITIES - 1 ) {
+			Com_sprintf( f->error, sizeof( f->error ), "Bad entity number %i", num );
+			f->end = qtrue;
+			return;
+		}
+
+		if ( f->numEntities == f->maxEntities ) {
+			tvdEntityDelta_t *buf = realloc( f->entities,
+				( f->maxEntities + 256 ) * sizeof( *f->entities ) );
+			if ( !buf ) {
+				Q_strncpyz( f->error, "Out of memory", sizeof( f->error ) );
+				f->end = qtrue;
+				return;
+			}
+			f->entities = buf;
+			f->maxEntities += 256;
+		}
+
+		// Delta frame: read into the frame, then copy back
+		oldEntity = &dec->entities[num];
+		if ( !MSG_ReadDeltaEntityQuiet( &msg, oldEntity, &f->entities[f->numEntities].es, num ) ) {
+			Com_sprintf( f->error, sizeof( f->error ), "Bad delta for entity %i", num );
+			f->end = qtrue;
+			return;
+		}
+		f->entities[f->numEntities].num = num;
+		if ( f->entities[f->numEntities].es.number == MAX_GENTITIES - 1 ) {
+			// Entity removed
+			Com_Memset( oldEntity, 0, sizeof( entityState_t ) );
+		} else {
+			*oldEntity = f->entities[f->numEntities].es;
+		}
+		f->numEntities++;
+	}
+
+	// Zero entities that left the bitmask to match the writer's baseline.
+	// The writer zeroes prevEntities for removed entities (sv_tv.c),
+	// so our running state must also be zeroed for correct delta decoding.
+	for ( i = 0; i < MAX_GENTITIES; i++ ) {
+		if ( ( oldEntityBitmask[i >> 3] & ( 1 << ( i & 7 ) ) ) &&
+			 !( dec->entityBitmask[i >> 3] & ( 1 << ( i & 7 ) ) ) ) {
+			Com_Memset( &dec->entities[i], 0, sizeof( entityState_t ) );
+		}
+	}
+
+	// --- Player section ---
+	Com_Memcpy( oldPlayerBitmask, dec->playerBitmask, sizeof( oldPlayerBitmask ) );
+	if ( dec->protocol >= 3 ) {
+		if ( !TVD_ReadMaskRuns( &msg, dec->playerBitmask, MAX_CLIENTS ) ) {
+			Q_strncpyz( f->error, "Bad player mask", sizeof( f->error ) );
+			f->end = qtrue;
+			return;
+		}
+	} else {
+		MSG_ReadData( &msg, dec->playerBitmask, MAX_CLIENTS / 8 );
+	}
+	Com_Memcpy( f->playerBitmask, dec->playerBitmask, sizeof( f->playerBitmask ) );
+
+	// Protocol 3 lists only changed players and ends with 255,
+	// older ones have one entry per player in the bitmask
+	for ( i = 0; i < MAX_CLIENTS || dec->protocol >= 3; i++ ) {
+		int clientNum;
+
+		if ( dec->protocol < 3 && !( dec->playerBitmask[i >> 3] & ( 1 << ( i & 7 ) ) ) ) {
+			continue;
+		}
+
+		clientNum = MSG_ReadByte( &msg );
+		if ( dec->protocol >= 3 && clientNum == 255 ) {
+			break;
+		}
+		if ( clientNum < 0 || clientNum >= MAX_CLIENTS || i >= MAX_CLIENTS ||
+			 !( dec->playerBitmask[clientNum >> 3] & ( 1 << ( clientNum & 7 ) ) ) ) {
+			Com_sprintf( f->error, sizeof( f->error ), "Bad player clientNum %i", clientNum );
+			f->end = qtrue;
+			return;
+		}
+
+		if ( !MSG_ReadDeltaPlayerstateQuiet( &msg, &dec->players[clientNum], &f->players[f->numPlayers].ps ) ) {
+			Com_sprintf( f->error, sizeof( f->error ), "Bad delta for player %i", clientNum );
+			f->end = qtrue;
+			return;
+		}
+		f->players[f->numPlayers].clientNum = clientNum;
+		dec->players[clientNum] = f->players[f->numPlayers].ps;
+		f->numPlayers++;
+	}
+
+	// Zero players that left the bitmask, as for entities
+	for ( i = 0; i < MAX_CLIENTS; i++ ) {
+		if ( ( oldPlayerBitmask[i >> 3] & ( 1 << ( i & 7 ) ) ) &&
+			 !( dec->playerBitmask[i >> 3] & ( 1 << ( i & 7 ) ) ) ) {
+			Com_Memset( &dec->players[i], 0, sizeof( playerState_t ) );
+		}
+	}
+
+	// --- Configstring changes ---
+	f->csCount = MSG_ReadShort( &msg );
+	for ( i = 0; i < f->csCount; i++ ) {
+		int csIndex = MSG_ReadShort( &msg );
+		int csLen = MSG_ReadShort( &msg );
+
+		if ( csLen > 0 && csLen < (int)sizeof( csData ) ) {
+			MSG_ReadData( &msg, csData, csLen );
+		} else {
+			csLen = 0;
+		}
+
+		if ( !TVD_FrameAddString( f, csIndex, csData, csLen ) ) {
+			Q_strncpyz( f->error, "Out of memory", sizeof( f->error ) );
+			f->end = qtrue;
+			return;
+		}
+	}
+
+	// --- Server commands ---
+	f->cmdCount = MSG_ReadShort( &msg );
+	for ( i = 0; i < f->cmdCount; i++ ) {
+		int target = MSG_ReadByte( &msg );
+		int cmdLen = MSG_ReadShort( &msg );
+
+		if ( cmdLen > 0 && cmdLen < (int)sizeof( csData ) ) {
+			MSG_ReadData( &msg, csData, cmdLen );
+		} else {
+			cmdLen = 0;
+		}
+
+		if ( !TVD_FrameAddString( f, target, csData, cmdLen ) ) {
+			Q_strncpyz( f->error, "Out of memory", sizeof( f->error ) );
+			f->end = qtrue;
+			return;
+		}
+	}
+}
+
+
+/*
+=============================================================================
+
+FRAME WRITING
+
+=============================================================================
+*/
+
+/*
+===============
+TVD_ResetEncoder
+===============
+*/
+void TVD_ResetEncoder( tvdEncoder_t *enc ) {
+	Com_Memset( enc, 0, sizeof( *enc ) );
+}
+
+
+/*
+===============
+TVD_WriteMaskRuns
+
+Inverse of TVD_ReadMaskRuns, as written by the server.
+===============
+*/
+static void TVD_WriteMaskRuns( msg_t *msg, const byte *mask, const byte *prevMask, int count ) {
+	int i, run;
+	int toggled, bit;
+
+	run = 0;
+	toggled = 0;
+	for ( i = 0; i < count; i++ ) {
+		bit = ( ( mask[i >> 3] ^ prevMask[i >> 3] ) >> ( i & 7 ) ) & 1;
+		if ( bit != toggled ) {
+			MSG_WriteShort( msg, run );
+			run = 0;
+			toggled = bit;
+		}
+		run++;
+	}
+	MSG_WriteShort( msg, run );
+}
+
+
+/*
+===============
+TVD_WriteFrame
+
+Write the running state of a decoder as one TVD_PROTOCOL_VERSION frame,
+delta encoded against enc, with f's serverTime, configstrings and
+commands. Keyframes delta from zeroed baselines; the caller must then
+supply every non-empty configstring in f. msg must be set up with
+MSG_Rawstream. Returns qfalse on overflow.
+===============
+*/
+qboolean TVD_WriteFrame( tvdEncoder_t *enc, msg_t *msg, const tvdDecoder_t *state, const tvdFrame_t *f, qboolean keyframe ) {
+	const byte *p;
+	const char *data;
+	int index, len;
+	int i;
+
+	if ( keyframe ) {
+		TVD_ResetEncoder( enc );
+	}
+
+	MSG_WriteLong( msg, f->serverTime );
+	MSG_WriteByte( msg, keyframe ? TVD_FRAME_KEYFRAME : 0 );
+
+	// Entities
+	TVD_WriteMaskRuns( msg, state->entityBitmask, enc->entityBitmask, MAX_GENTITIES );
+	for ( i = 0; i < MAX_GENTITIES; i++ ) {
+		if ( !( state->entityBitmask[i >> 3] & ( 1 << ( i & 7 ) ) ) ) {
+			if ( enc->entityBitmask[i >> 3] & ( 1 << ( i & 7 ) ) ) {
+				Com_Memset( &enc->entities[i], 0, sizeof( entityState_t ) );
+			}
+			continue;
+		}
+
+		if ( !memcmp( &enc->entities[i], &state->entities[i], sizeof( entityState_t ) ) ) {
+			continue;
+		}
+
+		MSG_WriteDeltaEntity( msg, &enc->entities[i], &state->entities[i], qfalse );
+		enc->entities[i] = state->entities[i];
+	}
+	Com_Memcpy( enc->entityBitmask, state->entityBitmask, sizeof( enc->entityBitmask ) );
+	MSG_WriteBits( msg, MAX_GENTITIES - 1, GENTITYNUM_BITS );
+
+	// Players
+	TVD_WriteMaskRuns( msg, state->playerBitmask, enc->playerBitmask, MAX_CLIENTS );
+	for ( i = 0; i < MAX_CLIENTS; i++ ) {
+		if ( !( state->playerBitmask[i >> 3] & ( 1 << ( i & 7 ) ) ) ) {
+			if ( enc->playerBitmask[i >> 3] & ( 1 << ( i & 7 ) ) ) {
+				Com_Memset( &enc->players[i], 0, sizeof( playerState_t ) );
+			}
+			continue;
+		}
+
+		if ( !memcmp( &enc->players[i], &state->players[i], sizeof( playerState_t ) ) ) {
+			continue;
+		}
+
+		MSG_WriteByte( msg, i );
+		MSG_WriteDeltaPlayerstate( msg, &enc->players[i], (playerState_t *)&state->players[i] );
+		enc->players[i] = state->players[i];
+	}
+	Com_Memcpy( enc->playerBitmask, state->playerBitmask, sizeof( enc->playerBitmask ) );
+	MSG_WriteByte( msg, 255 );
+
+	// Configstrings, then commands
+	p = f->strings;
+	MSG_WriteShort( msg, f->csCount );
+	for ( i = 0; i < f->csCount; i++ ) {
+		p = TVD_FrameNextString( p, &index, &data, &len );
+		MSG_WriteShort( msg, index );
+		MSG_WriteShort( msg, len );
+		if ( len > 0 ) {
+			MSG_WriteData( msg, data, len );
+		}
+	}
+
+	MSG_WriteShort( msg, f->cmdCount );
+	for ( i = 0; i < f->cmdCount; i++ ) {
+		p = TVD_FrameNextString( p, &index, &data, &len );
+		MSG_WriteByte( msg, index );
+		MSG_WriteShort( msg, len );
+		MSG_WriteData( msg, data, len );
+	}
+
+	return !msg->overflowed;
+}
@@ -0,0 +1,114 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// tvd.h -- .tvd demo reader shared by client playback and offline tools
+
+#ifndef TVD_H
+#define TVD_H
+
+#define TVD_PROTOCOL_VERSION	5	// written by the server, highest understood:
+									// 1 = single zstd frame, 2 = keyframes + seek table,
+									// 3 = run-length presence masks + changed players only,
+									// 4 = dictionary id in the header,
+									// 5 = raw bit packing instead of static huffman
+#define TVD_FRAME_KEYFRAME		1	// frame flag: full state, baselines reset
+#define TVD_MAX_FRAME_SIZE		(256*1024)
+
+// Uncompressed header fields
+typedef struct {
+	int				protocol;
+	int				svFps;
+	int				maxclients;
+	unsigned int	dictId;			// crc32 of the zstd dictionary, 0 = none (protocol 4+)
+	char			mapname[MAX_QPATH];
+	char			timestamp[64];
+	char			error[64];		// set when TVD_ReadHeader fails
+} tvdHeader_t;
+
+// Delta decoding state, advanced by every parsed frame
+typedef struct {
+	int				protocol;
+	entityState_t	entities[MAX_GENTITIES];
+	byte			entityBitmask[MAX_GENTITIES/8];
+	playerState_t	players[MAX_CLIENTS];
+	byte			playerBitmask[MAX_CLIENTS/8];
+} tvdDecoder_t;
+
+// Delta encoding state for writing frames, used by offline tools
+typedef struct {
+	entityState_t	entities[MAX_GENTITIES];
+	byte			entityBitmask[MAX_GENTITIES/8];
+	playerState_t	players[MAX_CLIENTS];
+	byte			playerBitmask[MAX_CLIENTS/8];
+} tvdEncoder_t;
+
+typedef struct {
+	int				num;
+	entityState_t	es;				// es.number == MAX_GENTITIES-1 for a delta remove
+} tvdEntityDelta_t;
+
+typedef struct {
+	int				clientNum;
+	playerState_t	ps;
+} tvdPlayerDelta_t;
+
+// One frame parsed from the stream, ready to be applied to the running state
+typedef struct {
+	qboolean		end;			// no frame, end of data or error
+	char			error[64];
+
+	int				serverTime;
+	int				flags;
+	byte			entityBitmask[MAX_GENTITIES/8];
+	byte			playerBitmask[MAX_CLIENTS/8];
+
+	tvdEntityDelta_t *entities;		// grown as needed
+	int				numEntities;
+	int				maxEntities;
+	tvdPlayerDelta_t players[MAX_CLIENTS];
+	int				numPlayers;
+
+	// configstrings followed by commands, index:2 len:2 data \0
+	int				csCount;
+	int				cmdCount;
+	byte			*strings;
+	int				stringsSize;
+	int				maxStrings;
+} tvdFrame_t;
+
+// Header source; returns bytes read, short on end of data
+typedef int (*tvdReadFunc_t)( void *ctx, void *buf, int len );
+
+// Called for every configstring in the header, qfalse aborts the read
+typedef qboolean (*tvdConfigstringFunc_t)( void *ctx, int index, const char *s, int len );
+
+qboolean	TVD_ReadHeader( tvdReadFunc_t readFunc, tvdConfigstringFunc_t csFunc, void *ctx, tvdHeader_t *header );
+
+void		TVD_ResetDecoder( tvdDecoder_t *dec, int protocol );
+void		TVD_ParseFrame( tvdDecoder_t *dec, byte *data, int size, tvdFrame_t *f );
+qboolean	TVD_FrameAddString( tvdFrame_t *f, int index, const char *data, int len );
+const byte	*TVD_FrameNextString( const byte *p, int *index, const char **data, int *len );
+void		TVD_FreeFrame( tvdFrame_t *f );
+
+void		TVD_ResetEncoder( tvdEncoder_t *enc );
+qboolean	TVD_WriteFrame( tvdEncoder_t *enc, msg_t *msg, const tvdDecoder_t *state, const tvdFrame_t *f, qboolean keyframe );
+
+#endif // TVD_H
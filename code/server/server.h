@@ -37,13 +37,13 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 typedef struct svEntity_s {
 	struct worldSector_s *worldSector;
 	struct svEntity_s *nextEntityInWorldSector;
+	int			areaLeaf;			// area tree node with sv_areaTree, 0 when not in it
 
 	entityState_t	baseline;		// for delta compression of initial sighting
 	int			numClusters;		// if -1, use headnode instead
 	int			clusternums[MAX_ENT_CLUSTERS];
 	int			lastCluster;		// if all the clusters don't fit in clusternums
 	int			areanum, areanum2;
-	int			snapshotCounter;	// used to prevent double adding from portal views
 } svEntity_t;
 
 typedef enum {
@@ -56,6 +56,8 @@ typedef enum {
 // so leave more room for slow-snaps clients etc.
 #define NUM_SNAPSHOT_FRAMES (PACKET_BACKUP*4)
 
+#define MAX_SNAPSHOT_THREADS 16
+
 typedef struct snapshotFrame_s {
 	entityState_t *ents[ MAX_GENTITIES ];
 	int	frameNum;
@@ -71,7 +73,6 @@ typedef struct {
 	int				serverId;			// changes each server start
 	int				restartedServerId;	// changes each map restart
 	int				checksumFeed;		// the feed key that we use to compute the pure checksum strings
-	int				snapshotCounter;	// incremented for each snapshot built
 	int				timeResidual;		// <= 1000 / sv_frame->value
 	char			*configstrings[MAX_CONFIGSTRINGS];
 	svEntity_t		svEntities[MAX_GENTITIES];
@@ -156,11 +157,20 @@ typedef enum {
 	GSA_ACKED		// gamestate acknowledged, no retansmissions needed
 } gameStateAck_t;
 
+// A server command is stored once and referenced by every reliable command
+// ring and TV frame it goes to. References are only taken and released on
+// the main thread, snapshot workers just read the text.
+typedef struct svCommand_s {
+	int				refCount;
+	int				len;
+	char			text[1];	// variable sized
+} svCommand_t;
+
 typedef struct client_s {
 	clientState_t	state;
 	char			userinfo[MAX_INFO_STRING];		// name, etc
 
-	char			reliableCommands[MAX_RELIABLE_COMMANDS][MAX_STRING_CHARS];
+	svCommand_t		*reliableCommands[MAX_RELIABLE_COMMANDS];	// NULL if never used, see SV_ReliableCommand()
 	int				reliableSequence;		// last added reliable message, not necessarily sent or acknowledged yet
 	int				reliableAcknowledge;	// last acknowledged reliable message
 	int				messageAcknowledge;
@@ -305,6 +315,11 @@ extern	cvar_t	*sv_hostname;
 extern	cvar_t	*sv_master[MAX_MASTER_SERVERS];
 extern	cvar_t	*sv_reconnectlimit;
 extern	cvar_t	*sv_padPackets;
+extern	cvar_t	*sv_snapshotThreads;
+extern	cvar_t	*sv_traceCache;
+extern	cvar_t	*sv_areaTree;
+extern	cvar_t	*sv_instances;
+extern	cvar_t	*sv_instance;
 extern	cvar_t	*sv_killserver;
 extern	cvar_t	*sv_mapname;
 extern	cvar_t	*sv_mapChecksum;
@@ -334,13 +349,58 @@ extern	int serverBansCount;
 #define MAX_TV_CMDS        256
 #define MAX_TV_CMDBUF      (64*1024)
 #define ZSTD_OUT_BUF_SIZE  (128*1024)
+#define MAX_TV_KEYFRAMES   4096     // seek table entries, 8 bytes each in the trailer
+#define TV_RELAY_KEYFRAME_RESERVE   512 // seek table entries relay-forced keyframes leave to periodic ones
+#define TV_KEYFRAME_UNLISTED    -2      // keyframe without a seek table entry
+#define TV_QUEUE_SLOTS     8        // frames buffered for the background writer
+#define MAX_TV_RELAY_VIEWERS    256
+#define TV_RELAY_PENDING_SIZE   (512*1024)  // per-viewer unsent bytes before it is dropped
+#define TV_RELAY_HEADER_SIZE    1024
+#define TV_DICT_DEFAULT_SIZE    (112*1024)  // tvtraindict output size
+#define TV_DICT_MAX_SIZE        (1024*1024)
+#define TV_LEVEL_MIN            -7      // adaptive compression level bounds
+#define TV_LEVEL_MAX            9
+#define TV_LEVEL_WINDOW         32      // frames measured per compression level decision
+
+// the protocol version and frame flags are in qcommon/tvd.h
 
 typedef struct {
     int         target;     // client index or -1 for broadcast
-    int         offset;     // offset into cmdBuf
-    int         len;
+    svCommand_t *cmd;       // referenced until the frame is written
 } tvCmd_t;
 
+typedef struct {
+    int         serverTime;
+    unsigned int offset;    // file offset of the zstd frame starting with this keyframe
+} tvKeyframe_t;
+
+typedef struct {
+    netstream_t *stream;
+    qboolean    live;       // header sent, receiving frames
+    byte        *pending;   // bytes the socket has not accepted yet
+    int         pendingLen;
+} tvRelayViewer_t;
+
+typedef struct {
+    byte        *data;      // MAX_TV_MSGLEN bytes
+    int         len;
+    int         keyframe;   // index into keyframes[], TV_KEYFRAME_UNLISTED or -1
+} tvQueuedFrame_t;
+
+// What tvstatus shows of the writer's state, copied under queueLock
+// after every frame the writer finishes
+typedef struct {
+    int64_t         rawBytes;
+    unsigned int    fileOffset;
+    int             compressLevel;
+    int             pendingLevel;
+    int             lastFrameUsec;
+    int             levelChanges;
+    int             relayViewerCount;
+    int             relayPeakViewers;
+    int             relayDropped;
+} tvWriterStatus_t;
+
 typedef struct {
     qboolean    recording;
     qboolean    autoPending;    // waiting for first human client before auto-start
@@ -352,6 +412,11 @@ typedef struct {
     int         firstServerTime;
     int         lastServerTime;
 
+    // Keyframe seek table, written to the trailer
+    tvKeyframe_t keyframes[MAX_TV_KEYFRAMES];
+    int         keyframeCount;
+    int         lastKeyframeTime;
+
     // Previous-frame baselines for delta encoding
     entityState_t   prevEntities[MAX_GENTITIES];
     byte            prevEntityBitmask[MAX_GENTITIES/8]; // 128 bytes
@@ -361,8 +426,7 @@ typedef struct {
     // Per-frame server command capture
     tvCmd_t     cmds[MAX_TV_CMDS];
     int         cmdCount;
-    char        cmdBuf[MAX_TV_CMDBUF];
-    int         cmdBufUsed;
+    int         cmdBytes;       // bounded by MAX_TV_CMDBUF per frame
 
     // Per-frame configstring change tracking
     qboolean    csChanged[MAX_CONFIGSTRINGS];
@@ -379,7 +443,51 @@ typedef struct {
 
     // Zstd streaming compression
     ZSTD_CStream    *cstream;
+    unsigned int    dictId;     // crc32 of the sv_tvDict dictionary, 0 = none
+
+    // Adaptive compression level (sv_tvCompressBudget). Writer-owned,
+    // tvstatus reads them from status
+    int             compressLevel;      // level of the current zstd frame
+    int             pendingLevel;       // level for the next zstd frame
+    int             frameBudgetUsec;    // allowed compression time per frame, 0 = fixed level
+    int64_t         windowUsec;         // compression time in the current window
+    int             windowFrames;
+    int             lastFrameUsec;      // average of the last full window
+    int             levelChanges;
+    int64_t         compressUsec;       // whole recording
+    int64_t         rawBytes;           // uncompressed frame data
     byte            zstdOutBuf[ZSTD_OUT_BUF_SIZE];
+
+    // Background writer (sv_tvAsync): the frame thread serializes into
+    // queue slots, the writer thread compresses and writes them in order
+    void            *writerThread;
+    void            *queueLock;     // protects queueDepth, writerShutdown and relayWantKeyframe
+    void            *slotFree;      // semaphore, counts free slots
+    void            *frameQueued;   // semaphore, counts queued frames (+1 for shutdown)
+    tvQueuedFrame_t queue[TV_QUEUE_SLOTS];
+    int             queueHead;      // next slot to write, writer thread only
+    int             queueTail;      // next slot to fill, frame thread only
+    int             queueDepth;
+    qboolean        writerShutdown;
+
+    // Writer back-pressure stats
+    int             queueMaxDepth;
+    int             queueStalls;    // frames that had to wait for a free slot
+    int64_t         queueStallUsec;
+
+    tvWriterStatus_t status;        // under queueLock with a writer
+
+    // Live relay (sv_tvRelayPort). Only touched from SV_TV_EmitFrame and
+    // file writes, so it belongs to the writer thread while one is running
+    netstream_t     *relayListener;
+    tvRelayViewer_t relayViewers[MAX_TV_RELAY_VIEWERS];
+    int             relayMaxViewers;
+    int             relayViewerCount;
+    int             relayPeakViewers;
+    int             relayDropped;       // viewers dropped for falling behind
+    byte            relayHeader[TV_RELAY_HEADER_SIZE];
+    int             relayHeaderLen;
+    qboolean        relayWantKeyframe;  // a viewer is waiting, under queueLock with a writer
 } tvState_t;
 
 extern tvState_t tv;
@@ -388,6 +496,13 @@ extern cvar_t *sv_tvAutoMinPlayers;
 extern cvar_t *sv_tvAutoMinPlayersSecs;
 extern cvar_t *sv_tvpath;
 extern cvar_t *sv_tvDownload;
+extern cvar_t *sv_tvKeyframeInterval;
+extern cvar_t *sv_tvAsync;
+extern cvar_t *sv_tvRelayPort;
+extern cvar_t *sv_tvRelayMaxViewers;
+extern cvar_t *sv_tvDict;
+extern cvar_t *sv_tvCompressLevel;
+extern cvar_t *sv_tvCompressBudget;
 
 //===========================================================
 
@@ -402,6 +517,12 @@ void SVC_RateDropAddress( const netadr_t *from, int burst, int period );
 
 void QDECL SV_SendServerCommand( client_t *cl, const char *fmt, ...) __attribute__ ((format (printf, 2, 3)));
 
+svCommand_t *SV_NewCommand( const char *text, int len );
+void SV_ReleaseCommand( svCommand_t *cmd );
+void SV_AddSharedCommand( client_t *client, svCommand_t *cmd );
+void SV_ClearReliableCommands( client_t *client );
+const char *SV_ReliableCommand( const client_t *client, int sequence );
+
 void SV_AddOperatorCommands( void );
 void SV_RemoveOperatorCommands( void );
 
@@ -466,6 +587,7 @@ void SV_SendClientSnapshot( client_t *client );
 
 void SV_InitSnapshotStorage( void );
 void SV_IssueNewSnapshot( void );
+void SV_ShutdownSnapshotThreads( void );
 
 int SV_RemainingGameState( void );
 
@@ -524,6 +646,7 @@ clipHandle_t SV_ClipHandleForEntity( const sharedEntity_t *ent );
 
 
 void SV_SectorList_f( void );
+void SV_TraceCache_f( void );
 
 
 int SV_AreaEntities( const vec3_t mins, const vec3_t maxs, int *entityList, int maxcount );
@@ -551,6 +674,11 @@ void SV_Trace( trace_t *results, const vec3_t start, const vec3_t mins, const ve
 // passEntityNum is explicitly excluded from clipping checks (normally ENTITYNUM_NONE)
 
 
+void SV_TraceBatch( trace_t *results, const vec3_t *starts, const vec3_t *ends, int count, const vec3_t mins, const vec3_t maxs, int passEntityNum, int contentmask, qboolean capsule );
+// count SV_Traces from starts[i] to ends[i] sharing everything else,
+// with the same results
+
+
 void SV_ClipToEntity( trace_t *trace, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int entityNum, int contentmask, qboolean capsule );
 // clip to a specific entity
 
@@ -570,14 +698,40 @@ const char *SV_RunFilters( const char *userinfo, const netadr_t *addr );
 void SV_AddFilter_f( void );
 void SV_AddFilterCmd_f( void );
 
+//
+// sv_perf.c
+//
+typedef enum {
+	SVP_FRAME,			// SV_Frame once it runs, all of the below and more
+	SVP_GAME,			// GAME_RUN_FRAME
+	SVP_TV,				// SV_TV_WriteFrame
+	SVP_BOTS,			// SV_BotFrame
+	SVP_TIMEOUTS,		// SV_CheckTimeouts
+	SVP_SNAPSHOT,		// building client snapshots, summed over the clients
+	SVP_ENCODE,			// writing the snapshot messages, summed over the clients
+	SVP_SEND,			// transmitting them
+	SVP_JITTER,			// how far game frame starts are from evenly spaced
+	SVP_NUM_SECTIONS
+} svPerfSection_t;
+
+extern cvar_t *sv_perfDump;
+
+void SV_PerfInit( void );
+void SV_PerfAdd( svPerfSection_t section, int64_t usec );
+void SV_PerfTick( int msec );
+void SV_PerfEndFrame( void );
+void SV_Perf_f( void );
+
 //
 // sv_tv.c
 //
 void SV_TV_Init( void );
 void SV_TV_StartRecord_f( void );
 void SV_TV_StopRecord_f( void );
+void SV_TV_TrainDict_f( void );
+void SV_TV_Status_f( void );
 void SV_TV_WriteFrame( void );
 void SV_TV_StopRecord( qboolean discard );
 void SV_TV_ConfigstringChanged( int index );
-void SV_TV_CaptureServerCommand( int target, const char *cmd );
+void SV_TV_CaptureServerCommand( int target, svCommand_t *cmd );
 void SV_TV_AutoStart( void );
@@ -594,7 +594,7 @@ int SV_BotGetConsoleMessage( int client, char *buf, int size )
 {
 	if ( (unsigned) client < sv.maxclients ) {
 		client_t* cl;
-		int index;
+		const char *cmd;
 
 		cl = &svs.clients[client];
 		cl->lastPacketTime = svs.time;
@@ -604,13 +604,13 @@ int SV_BotGetConsoleMessage( int client, char *buf, int size )
 		}
 
 		cl->reliableAcknowledge++;
-		index = cl->reliableAcknowledge & ( MAX_RELIABLE_COMMANDS - 1 );
+		cmd = SV_ReliableCommand( cl, cl->reliableAcknowledge );
 
-		if ( !cl->reliableCommands[index][0] ) {
+		if ( !cmd[0] ) {
 			return qfalse;
 		}
 
-		Q_strncpyz( buf, cl->reliableCommands[index], size );
+		Q_strncpyz( buf, cmd, size );
 		return qtrue;
 	} else {
 		return qfalse;
@@ -1560,6 +1560,7 @@ void SV_AddOperatorCommands( void ) {
 	Cmd_AddCommand ("dumpuser", SV_DumpUser_f);
 	Cmd_AddCommand ("map_restart", SV_MapRestart_f);
 	Cmd_AddCommand ("sectorlist", SV_SectorList_f);
+	Cmd_AddCommand( "tracecache", SV_TraceCache_f );
 	Cmd_AddCommand ("map", SV_Map_f);
 	Cmd_SetCommandCompletionFunc( "map", SV_CompleteMapName );
 #ifndef PRE_RELEASE_DEMO
@@ -1584,6 +1585,9 @@ void SV_AddOperatorCommands( void ) {
 	Cmd_AddCommand( "filtercmd", SV_AddFilterCmd_f );
 	Cmd_AddCommand( "tvrecord", SV_TV_StartRecord_f );
 	Cmd_AddCommand( "tvstop", SV_TV_StopRecord_f );
+	Cmd_AddCommand( "tvtraindict", SV_TV_TrainDict_f );
+	Cmd_AddCommand( "tvstatus", SV_TV_Status_f );
+	Cmd_AddCommand( "svperf", SV_Perf_f );
 }
 
 
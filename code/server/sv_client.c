@@ -387,24 +387,42 @@ static void SV_SaveSequences( void ) {
 
 
 static void SV_InjectLocation( const char *tld, const char *country ) {
-	const char *cmd;
-	char *str;
-	int i, n;
+	char text[MAX_STRING_CHARS];
+	svCommand_t *cmd, *original, *patched;
+	const char *str;
+	int i, n, index;
+
+	original = patched = NULL;
 	for ( i = 0; i < sv.maxclients; i++ ) {
 		if ( seqs[i] != svs.clients[i].reliableSequence ) {
 			for ( n = seqs[i]; n != svs.clients[i].reliableSequence + 1; n++ ) {
-				cmd = svs.clients[i].reliableCommands[n & (MAX_RELIABLE_COMMANDS-1)];
-				str = strstr( cmd, "connected\n\"" );
-				if ( str && str[11] == '\0' && str < cmd + 512 ) {
+				index = n & (MAX_RELIABLE_COMMANDS-1);
+				cmd = svs.clients[i].reliableCommands[index];
+				if ( !cmd )
+					continue;
+				// a broadcast is shared by the rings, give them all the same patched copy
+				if ( cmd != original ) {
+					str = strstr( cmd->text, "connected\n\"" );
+					if ( !str || str[11] != '\0' || str >= cmd->text + 512 )
+						continue;
+					Com_Memcpy( text, cmd->text, str - cmd->text );
 					if ( *tld == '\0' )
-						sprintf( str, S_COLOR_WHITE "connected (%s)\n\"", country );
+						sprintf( text + ( str - cmd->text ), S_COLOR_WHITE "connected (%s)\n\"", country );
 					else
-						sprintf( str, S_COLOR_WHITE "connected (" S_COLOR_RED "%s" S_COLOR_WHITE ", %s)\n\"", tld, country );
-					break;
+						sprintf( text + ( str - cmd->text ), S_COLOR_WHITE "connected (" S_COLOR_RED "%s" S_COLOR_WHITE ", %s)\n\"", tld, country );
+					SV_ReleaseCommand( patched );
+					original = cmd;
+					patched = SV_NewCommand( text, (int)strlen( text ) );
 				}
+				patched->refCount++;
+				svs.clients[i].reliableCommands[index] = patched;
+				SV_ReleaseCommand( cmd );
+				break;
 			}
 		}
 	}
+
+	SV_ReleaseCommand( patched );
 }
 
 
@@ -752,6 +770,7 @@ gotnewcl:
 	// accept the new client
 	// this is the only place a client_t is ever initialized
 	// we got a newcl, so reset the reliableSequence and reliableAcknowledge
+	SV_ClearReliableCommands( newcl );
 	Com_Memset( newcl, 0, sizeof( *newcl ) );
 	clientNum = newcl - svs.clients;
 #if 0 // skip this until CS_PRIMED
@@ -2168,7 +2187,7 @@ static void SV_UserMove( client_t *cl, msg_t *msg, qboolean delta ) {
 	// also use the message acknowledge
 	key ^= cl->messageAcknowledge;
 	// also use the last acknowledged server command in the key
-	key ^= MSG_HashKey(cl->reliableCommands[ cl->reliableAcknowledge & (MAX_RELIABLE_COMMANDS-1) ], 32);
+	key ^= MSG_HashKey(SV_ReliableCommand( cl, cl->reliableAcknowledge ), 32);
 
 	oldcmd = &nullcmd;
 	for ( i = 0 ; i < cmdCount ; i++ ) {
@@ -353,10 +353,36 @@ static qboolean SV_GetValue( char* value, int valueSize, const char* key )
 		return qtrue;
 	}
 
+	if ( !Q_stricmp( key, "trap_TraceBatch_Trinity" ) )
+	{
+		Com_sprintf( value, valueSize, "%i", G_TRACEBATCH );
+		return qtrue;
+	}
+
 	return qfalse;
 }
 
 
+/*
+====================
+SV_BotLibLoadMap
+
+The area files come in through botlib, timed like the collision map.
+====================
+*/
+static int SV_BotLibLoadMap( const char *mapname )
+{
+	int64_t start;
+	int ret;
+
+	start = Sys_Microseconds();
+	ret = botlib_export->BotLibLoadMap( mapname );
+	Com_DPrintf( "%s: aas %.1f ms\n", mapname, ( Sys_Microseconds() - start ) / 1000.0 );
+
+	return ret;
+}
+
+
 /*
 ====================
 SV_GameSystemCalls
@@ -551,7 +577,7 @@ static intptr_t SV_GameSystemCalls( intptr_t *args ) {
 	case BOTLIB_START_FRAME:
 		return botlib_export->BotLibStartFrame( VMF(1) );
 	case BOTLIB_LOAD_MAP:
-		return botlib_export->BotLibLoadMap( VMA(1) );
+		return SV_BotLibLoadMap( VMA(1) );
 	case BOTLIB_UPDATENTITY:
 		return botlib_export->BotLibUpdateEntity( args[1], VMA(2) );
 	case BOTLIB_TEST:
@@ -960,6 +986,15 @@ static intptr_t SV_GameSystemCalls( intptr_t *args ) {
 		Cvar_SetDescription2( (const char*)VMA(1), (const char*)VMA(2) );
 		return 0;
 
+	case G_TRACEBATCH:
+		if ( (unsigned int)args[4] > MAX_TRACE_BATCH ) {
+			Com_Error( ERR_DROP, "%s: bad trace count %i", __func__, (int)args[4] );
+		}
+		VM_CHECKBOUNDS( gvm, args[1], args[4] * sizeof( trace_t ) );
+		VM_CHECKBOUNDS2( gvm, args[2], args[3], args[4] * sizeof( vec3_t ) );
+		SV_TraceBatch( VMA(1), VMA(2), VMA(3), args[4], VMA(5), VMA(6), args[7], args[8], args[9] );
+		return 0;
+
 	case G_TRAP_GETVALUE:
 		VM_CHECKBOUNDS( gvm, args[1], args[2] );
 		return SV_GetValue( VMA(1), args[2], VMA(3) );
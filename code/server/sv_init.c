@@ -368,6 +368,13 @@ static void SV_ChangeMaxClients( void ) {
 		}
 	}
 
+	// connected clients moved their references to the copies
+	for ( i = 0; i < sv.maxclients; i++ ) {
+		if ( svs.clients[i].state < CS_CONNECTED ) {
+			SV_ClearReliableCommands( &svs.clients[i] );
+		}
+	}
+
 	// free old clients arrays
 	Z_Free( svs.clients );
 
@@ -410,6 +417,57 @@ static void SV_ClearServer( void ) {
 }
 
 
+/*
+================
+SV_ForkInstances
+
+Called once the first map is loaded, so the pak directories, clip map,
+AAS and VMs loaded for it are shared by all sv_instances until one of
+them writes to or reloads them. Only that first map is shared: after a
+map change every instance loads its own copy. Each forked instance
+moves to its own ports, reopens its logs under instanceN/ and runs its
+own instanceN.cfg.
+================
+*/
+static void SV_ForkInstances( void ) {
+	static qboolean forked = qfalse;
+	const char *cfg;
+	int instance;
+
+	if ( forked || sv_instances->integer <= 1 || !com_dedicated->integer ) {
+		return;
+	}
+	forked = qtrue;
+
+	instance = Sys_ForkInstances( sv_instances->integer );
+	if ( instance == 0 ) {
+		return;
+	}
+
+	Cvar_Set( "sv_instance", va( "%i", instance ) );
+
+	// stop appending to the first instance's qconsole.log and game logs
+	FS_SetInstanceDir( va( "instance%i", instance ) );
+	Com_ReopenLogFile();
+
+	Cvar_Set( "net_port", va( "%i", Cvar_VariableIntegerValue( "net_port" ) + instance ) );
+#ifdef USE_IPV6
+	Cvar_Set( "net_port6", va( "%i", Cvar_VariableIntegerValue( "net_port6" ) + instance ) );
+#endif
+	if ( sv_tvRelayPort->integer ) {
+		Cvar_Set( "sv_tvRelayPort", va( "%i", sv_tvRelayPort->integer + instance ) );
+	}
+
+	// drop the sockets shared with the first instance
+	NET_Restart();
+
+	cfg = va( "instance%i.cfg", instance );
+	if ( FS_ReadFile( cfg, NULL ) > 0 ) {
+		Cbuf_AddText( va( "exec %s\n", cfg ) );
+	}
+}
+
+
 /*
 ================
 SV_SpawnServer
@@ -557,6 +615,7 @@ void SV_SpawnServer( const char *mapname, qboolean killBots ) {
 	Cvar_SetIntegerValue( "sv_serverid", sv.serverId );
 
 	// clear physics interaction links
+	sv_areaTree = Cvar_Get( "sv_areaTree", "0", CVAR_ARCHIVE_ND | CVAR_LATCH );
 	SV_ClearWorld();
 
 	// media configstring setting should be done during
@@ -706,6 +765,9 @@ void SV_SpawnServer( const char *mapname, qboolean killBots ) {
 
 	Sys_SetStatus( "Running map %s", mapname );
 
+	// before anything starts threads or opens files
+	SV_ForkInstances();
+
 	// Auto-start TV recording if enabled
 	SV_TV_AutoStart();
 
@@ -733,6 +795,8 @@ void SV_Init( void )
 
 	SV_TV_Init();
 
+	SV_PerfInit();
+
 	if ( com_dedicated->integer )
 		SV_AddDedicatedCommands();
 
@@ -816,6 +880,20 @@ void SV_Init( void )
 
 	sv_padPackets = Cvar_Get( "sv_padPackets", "0", CVAR_DEVELOPER );
 	Cvar_SetDescription( sv_padPackets, "Adds padding bytes to network packets for rate debugging." );
+	sv_snapshotThreads = Cvar_Get( "sv_snapshotThreads", "0", CVAR_ARCHIVE_ND );
+	Cvar_CheckRange( sv_snapshotThreads, "0", XSTRING( MAX_SNAPSHOT_THREADS ), CV_INTEGER );
+	Cvar_SetDescription( sv_snapshotThreads, "Number of worker threads that build and encode client snapshots together with the server frame thread. 0 = build them on the frame thread only." );
+	sv_traceCache = Cvar_Get( "sv_traceCache", "0", CVAR_ARCHIVE_ND );
+	Cvar_CheckRange( sv_traceCache, "0", "1", CV_INTEGER );
+	Cvar_SetDescription( sv_traceCache, "Reuse the result of a trace repeated within a server frame until an entity is linked or unlinked. Game code that changes entity contents or owners without relinking may see stale results. tracecache shows the hit rate." );
+	sv_areaTree = Cvar_Get( "sv_areaTree", "0", CVAR_ARCHIVE_ND | CVAR_LATCH );
+	Cvar_CheckRange( sv_areaTree, "0", "1", CV_INTEGER );
+	Cvar_SetDescription( sv_areaTree, "Keep linked entities in a bounding volume tree for area queries and traces instead of the fixed world sectors. Entities are found in a different order, which can change ties between equally close hits and the subset kept when a query is truncated. Takes effect on the next map." );
+	sv_instances = Cvar_Get( "sv_instances", "1", CVAR_INIT | CVAR_PROTECTED );
+	Cvar_CheckRange( sv_instances, "1", "64", CV_INTEGER );
+	Cvar_SetDescription( sv_instances, "Number of dedicated server instances to run, forked from one process after the first map has loaded so that they share its memory. Only the first map is shared; after a map change each instance loads its own. Instance N listens on net_port + N, runs instanceN.cfg and writes its logs under instanceN/." );
+	sv_instance = Cvar_Get( "sv_instance", "0", CVAR_ROM );
+	Cvar_SetDescription( sv_instance, "Which of the sv_instances server instances this is." );
 	sv_killserver = Cvar_Get( "sv_killserver", "0", 0 );
 	Cvar_SetDescription( sv_killserver, "Internal flag to manage server state." );
 	sv_mapChecksum = Cvar_Get( "sv_mapChecksum", "", CVAR_ROM );
@@ -927,6 +1005,7 @@ void SV_Shutdown( const char *finalmsg ) {
 
 	SV_RemoveOperatorCommands();
 	SV_MasterShutdown();
+	SV_ShutdownSnapshotThreads();
 
 	// Notify game of server shutdown before normal shutdown
 	if ( gvm && sv_gameServerEvents ) {
@@ -948,8 +1027,10 @@ void SV_Shutdown( const char *finalmsg ) {
 	if ( svs.clients ) {
 		int index;
 
-		for ( index = 0; index < sv.maxclients; index++ )
+		for ( index = 0; index < sv.maxclients; index++ ) {
 			SV_FreeClient( &svs.clients[ index ] );
+			SV_ClearReliableCommands( &svs.clients[ index ] );
+		}
 
 		Z_Free( svs.clients );
 	}
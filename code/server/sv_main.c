@@ -41,6 +41,11 @@ cvar_t	*sv_hostname;
 cvar_t	*sv_master[MAX_MASTER_SERVERS];		// master server ip address
 cvar_t	*sv_reconnectlimit;		// minimum seconds between connect messages
 cvar_t	*sv_padPackets;			// add nop bytes to messages
+cvar_t	*sv_snapshotThreads;	// worker threads building client snapshots
+cvar_t	*sv_traceCache;			// remember repeated traces within a frame
+cvar_t	*sv_areaTree;			// entity bounding volume tree instead of sectors
+cvar_t	*sv_instances;			// server processes forked after the first map load
+cvar_t	*sv_instance;			// which of them this is
 cvar_t	*sv_killserver;			// menu system can set to 1 to shut server down
 cvar_t	*sv_mapname;
 cvar_t	*sv_mapChecksum;
@@ -106,17 +111,19 @@ FIXME: This is ugly
 ======================
 */
 #if 0 // unused
-static int SV_ReplacePendingServerCommands( client_t *client, const char *cmd ) {
+static int SV_ReplacePendingServerCommands( client_t *client, svCommand_t *cmd ) {
 	int i, index, csnum1, csnum2;
 
 	for ( i = client->reliableSent+1; i <= client->reliableSequence; i++ ) {
 		index = i & ( MAX_RELIABLE_COMMANDS - 1 );
 		//
-		if ( !Q_strncmp(cmd, client->reliableCommands[ index ], strlen("cs")) ) {
-			sscanf(cmd, "cs %i", &csnum1);
-			sscanf(client->reliableCommands[ index ], "cs %i", &csnum2);
+		if ( !Q_strncmp(cmd->text, SV_ReliableCommand( client, i ), strlen("cs")) ) {
+			sscanf(cmd->text, "cs %i", &csnum1);
+			sscanf(SV_ReliableCommand( client, i ), "cs %i", &csnum2);
 			if ( csnum1 == csnum2 ) {
-				Q_strncpyz( client->reliableCommands[ index ], cmd, sizeof( client->reliableCommands[ index ] ) );
+				cmd->refCount++;
+				SV_ReleaseCommand( client->reliableCommands[ index ] );
+				client->reliableCommands[ index ] = cmd;
 				/*
 				if ( client->netchan.remoteAddress.type != NA_BOT ) {
 					Com_Printf( "WARNING: client %i removed double pending config string %i: %s\n", client-svs.clients, csnum1, cmd );
@@ -133,13 +140,77 @@ static int SV_ReplacePendingServerCommands( client_t *client, const char *cmd )
 
 /*
 ======================
-SV_AddServerCommand
+SV_NewCommand
+
+Returns a command holding one reference for the caller, which
+releases it once the command has been handed out
+======================
+*/
+svCommand_t *SV_NewCommand( const char *text, int len ) {
+	svCommand_t *cmd;
+
+	cmd = Z_Malloc( sizeof( *cmd ) + len );
+	cmd->refCount = 1;
+	cmd->len = len;
+	Com_Memcpy( cmd->text, text, len );
+	cmd->text[ len ] = '\0';
+
+	return cmd;
+}
+
+
+/*
+======================
+SV_ReleaseCommand
+======================
+*/
+void SV_ReleaseCommand( svCommand_t *cmd ) {
+	if ( cmd && --cmd->refCount == 0 ) {
+		Z_Free( cmd );
+	}
+}
+
+
+/*
+======================
+SV_ReliableCommand
+
+Text of the reliable command slot for sequence, empty if it was never used
+======================
+*/
+const char *SV_ReliableCommand( const client_t *client, int sequence ) {
+	const svCommand_t *cmd = client->reliableCommands[ sequence & ( MAX_RELIABLE_COMMANDS - 1 ) ];
+
+	return cmd ? cmd->text : "";
+}
+
+
+/*
+======================
+SV_ClearReliableCommands
+
+Drop the references held by a client slot before it is reset or freed
+======================
+*/
+void SV_ClearReliableCommands( client_t *client ) {
+	int		i;
+
+	for ( i = 0; i < MAX_RELIABLE_COMMANDS; i++ ) {
+		SV_ReleaseCommand( client->reliableCommands[ i ] );
+		client->reliableCommands[ i ] = NULL;
+	}
+}
+
+
+/*
+======================
+SV_AddSharedCommand
 
 The given command will be transmitted to the client, and is guaranteed to
 not have future snapshot_t executed before it is executed
 ======================
 */
-void SV_AddServerCommand( client_t *client, const char *cmd ) {
+void SV_AddSharedCommand( client_t *client, svCommand_t *cmd ) {
 	int		index, i, n;
 
 	// this is very ugly but it's also a waste to for instance send multiple config string updates
@@ -162,14 +233,41 @@ void SV_AddServerCommand( client_t *client, const char *cmd ) {
 		n = client->reliableSequence - client->reliableAcknowledge;
 		for ( i = 0; i < n; i++ ) {
 			const int idx = client->reliableAcknowledge + 1 + i;
-			Com_Printf( "cmd %5d: %s\n", i, client->reliableCommands[ idx & ( MAX_RELIABLE_COMMANDS - 1 ) ] );
+			Com_Printf( "cmd %5d: %s\n", i, SV_ReliableCommand( client, idx ) );
 		}
-		Com_Printf( "cmd %5d: %s\n", i, cmd );
+		Com_Printf( "cmd %5d: %s\n", i, cmd->text );
 		SV_DropClient( client, "Server command overflow" );
 		return;
 	}
 	index = client->reliableSequence & ( MAX_RELIABLE_COMMANDS - 1 );
-	Q_strncpyz( client->reliableCommands[ index ], cmd, sizeof( client->reliableCommands[ index ] ) );
+	cmd->refCount++;
+	SV_ReleaseCommand( client->reliableCommands[ index ] );
+	client->reliableCommands[ index ] = cmd;
+}
+
+
+/*
+======================
+SV_AddServerCommand
+
+Same as SV_AddSharedCommand for a single client command string
+======================
+*/
+void SV_AddServerCommand( client_t *client, const char *cmd ) {
+	svCommand_t *shared;
+	int		len;
+
+	if ( client->state < CS_PRIMED )
+		return;
+
+	len = (int)strlen( cmd );
+	if ( len > MAX_STRING_CHARS - 1 ) {
+		len = MAX_STRING_CHARS - 1;
+	}
+
+	shared = SV_NewCommand( cmd, len );
+	SV_AddSharedCommand( client, shared );
+	SV_ReleaseCommand( shared );
 }
 
 
@@ -186,23 +284,41 @@ void QDECL SV_SendServerCommand( client_t *cl, const char *fmt, ... ) {
 	va_list		argptr;
 	char		message[MAX_STRING_CHARS+128]; // slightly larger than allowed, to detect overflows
 	client_t	*client;
+	svCommand_t	*cmd;
 	int			j, len;
 	
 	va_start( argptr, fmt );
 	len = Q_vsnprintf( message, sizeof( message ), fmt, argptr );
 	va_end( argptr );
 
+	if ( len < 0 ) {
+		len = 0;
+		message[0] = '\0';
+	} else if ( len >= (int)sizeof( message ) ) {
+		len = (int)strlen( message );
+	}
+
+	// stored once, the TV recorder and every client ring share it
+	cmd = SV_NewCommand( message, len );
+
 	// TV recording hook
 	if ( tv.recording ) {
-		SV_TV_CaptureServerCommand( cl ? (int)(cl - svs.clients) : -1, message );
+		SV_TV_CaptureServerCommand( cl ? (int)(cl - svs.clients) : -1, cmd );
+	}
+
+	// client rings never held more than MAX_STRING_CHARS-1 characters
+	if ( len > MAX_STRING_CHARS - 1 ) {
+		SV_ReleaseCommand( cmd );
+		cmd = SV_NewCommand( message, MAX_STRING_CHARS - 1 );
 	}
 
 	if ( cl != NULL ) {
 		// outdated clients can't properly decode 1023-chars-long strings
 		// http://aluigi.altervista.org/adv/q3msgboom-adv.txt
 		if ( len <= 1022 || cl->longstr ) {
-			SV_AddServerCommand( cl, message );
+			SV_AddSharedCommand( cl, cmd );
 		}
+		SV_ReleaseCommand( cmd );
 		return;
 	}
 
@@ -214,9 +330,11 @@ void QDECL SV_SendServerCommand( client_t *cl, const char *fmt, ... ) {
 	// send the data to all relevant clients
 	for ( j = 0, client = svs.clients; j < sv.maxclients; j++, client++ ) {
 		if ( len <= 1022 || client->longstr ) {
-			SV_AddServerCommand( client, message );
+			SV_AddSharedCommand( client, cmd );
 		}
 	}
+
+	SV_ReleaseCommand( cmd );
 }
 
 
@@ -1289,6 +1407,7 @@ happen before SV_Frame is called
 void SV_Frame( int msec ) {
 	int		frameMsec;
 	int		startTime;
+	int64_t	frameStart, start;
 	int		i;
 
 	if ( Cvar_CheckGroup( CVG_SERVER ) )
@@ -1380,10 +1499,20 @@ void SV_Frame( int msec ) {
 		startTime = 0;	// quite a compiler warning
 	}
 
+	frameStart = Sys_Microseconds();
+
 	// update ping based on the all received frames
 	SV_CalcPings();
 
-	if (com_dedicated->integer) SV_BotFrame (sv.time);
+	if ( com_dedicated->integer ) {
+		start = Sys_Microseconds();
+		SV_BotFrame( sv.time );
+		SV_PerfAdd( SVP_BOTS, Sys_Microseconds() - start );
+	}
+
+	if ( sv.timeResidual >= frameMsec ) {
+		SV_PerfTick( sv.timeResidual - sv.timeResidual % frameMsec );
+	}
 
 	// run the game simulation in chunks
 	while ( sv.timeResidual >= frameMsec ) {
@@ -1392,9 +1521,13 @@ void SV_Frame( int msec ) {
 		sv.time += frameMsec;
 
 		// let everything in the world think and move
+		start = Sys_Microseconds();
 		VM_Call( gvm, 1, GAME_RUN_FRAME, sv.time );
+		SV_PerfAdd( SVP_GAME, Sys_Microseconds() - start );
 
+		start = Sys_Microseconds();
 		SV_TV_WriteFrame();
+		SV_PerfAdd( SVP_TV, Sys_Microseconds() - start );
 	}
 
 	if ( com_speeds->integer ) {
@@ -1402,7 +1535,9 @@ void SV_Frame( int msec ) {
 	}
 
 	// check timeouts
+	start = Sys_Microseconds();
 	SV_CheckTimeouts();
+	SV_PerfAdd( SVP_TIMEOUTS, Sys_Microseconds() - start );
 
 	// reset current and build new snapshot on first query
 	SV_IssueNewSnapshot();
@@ -1412,6 +1547,9 @@ void SV_Frame( int msec ) {
 
 	// send a heartbeat to the master if needed
 	SV_MasterHeartbeat(HEARTBEAT_FOR_MASTER);
+
+	SV_PerfAdd( SVP_FRAME, Sys_Microseconds() - frameStart );
+	SV_PerfEndFrame();
 }
 
 
@@ -109,7 +109,7 @@ static void SV_Netchan_Decode( client_t *client, msg_t *msg ) {
 	msg->bit = sbit;
 	msg->readcount = srdc;
 
-	string = (byte *)client->reliableCommands[ reliableAcknowledge & (MAX_RELIABLE_COMMANDS-1) ];
+	string = (byte *)SV_ReliableCommand( client, reliableAcknowledge );
 	index = 0;
 	//
 	key = client->challenge ^ serverId ^ messageAcknowledge;
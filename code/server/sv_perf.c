@@ -0,0 +1,336 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// sv_perf.c -- server frame profiler
+//
+// The frame thread adds the microseconds spent in each section of
+// SV_Frame as it goes, and SV_PerfEndFrame keeps the per frame totals
+// of the last PERF_WINDOW frames for the percentiles. Work done on the
+// snapshot threads is summed over the clients, so it is CPU time rather
+// than wall time.
+
+#include "server.h"
+
+#define PERF_WINDOW			1024	// frames the statistics are taken over
+#define PERF_LOG_FILE		"svperf.log"
+
+typedef struct {
+	int		current;				// usec this frame so far
+	int		samples[ PERF_WINDOW ];
+} perfSection_t;
+
+typedef struct {
+	int		p50, p99, max;
+	int		avg;
+} perfStats_t;
+
+typedef struct {
+	perfSection_t	sections[ SVP_NUM_SECTIONS ];
+	int		frames;					// recorded since the last reset
+	int		lastDumpTime;			// Sys_Milliseconds of the last sv_perfDump line
+
+	int64_t	tickStart;				// Sys_Microseconds the last game frames started at
+	int		tickMsec;				// game time they advanced
+	int		tickEndTime;			// sv.time after them
+} perfState_t;
+
+static const char *perfSectionNames[ SVP_NUM_SECTIONS ] = {
+	"frame",
+	"game",
+	"tv",
+	"bots",
+	"timeouts",
+	"snapshot",
+	"encode",
+	"send",
+	"jitter"
+};
+
+static perfState_t perf;
+
+cvar_t	*sv_perfDump;
+
+
+/*
+===============
+SV_PerfInit
+===============
+*/
+void SV_PerfInit( void ) {
+	sv_perfDump = Cvar_Get( "sv_perfDump", "0", CVAR_ARCHIVE_ND );
+	Cvar_CheckRange( sv_perfDump, "0", "3600", CV_INTEGER );
+	Cvar_SetDescription( sv_perfDump, "Seconds between the frame timing lines appended to " PERF_LOG_FILE " as JSON, the same as svperf json. 0 = disabled." );
+}
+
+
+/*
+===============
+SV_PerfAdd
+
+Frame thread only.
+===============
+*/
+void SV_PerfAdd( svPerfSection_t section, int64_t usec ) {
+	perf.sections[ section ].current += (int)usec;
+}
+
+
+/*
+===============
+SV_PerfTick
+
+Called before running msec of game frames. The jitter is how much the
+time since the last call differs from the game time it advanced, which
+is skipped when sv.time was changed outside SV_Frame, as on map loads.
+===============
+*/
+void SV_PerfTick( int msec ) {
+	int64_t now, jitter;
+
+	now = Sys_Microseconds();
+
+	if ( perf.tickStart && sv.time == perf.tickEndTime ) {
+		jitter = now - perf.tickStart - perf.tickMsec * 1000;
+		perf.sections[ SVP_JITTER ].current = (int)( jitter < 0 ? -jitter : jitter );
+	}
+
+	perf.tickStart = now;
+	perf.tickMsec = msec;
+	perf.tickEndTime = sv.time + msec;
+}
+
+
+/*
+===============
+SV_PerfClientCount
+===============
+*/
+static int SV_PerfClientCount( void ) {
+	int i, count;
+
+	if ( !svs.clients ) {
+		return 0;
+	}
+
+	count = 0;
+	for ( i = 0; i < sv.maxclients; i++ ) {
+		if ( svs.clients[ i ].state >= CS_CONNECTED ) {
+			count++;
+		}
+	}
+
+	return count;
+}
+
+
+/*
+===============
+SV_PerfCompareSamples
+===============
+*/
+static int QDECL SV_PerfCompareSamples( const void *a, const void *b ) {
+	return *(const int *)a - *(const int *)b;
+}
+
+
+/*
+===============
+SV_PerfGetStats
+
+Returns the number of frames the stats are over.
+===============
+*/
+static int SV_PerfGetStats( const perfSection_t *section, perfStats_t *stats ) {
+	int sorted[ PERF_WINDOW ];
+	int64_t total;
+	int i, n;
+
+	Com_Memset( stats, 0, sizeof( *stats ) );
+
+	n = perf.frames < PERF_WINDOW ? perf.frames : PERF_WINDOW;
+	if ( n == 0 ) {
+		return 0;
+	}
+
+	Com_Memcpy( sorted, section->samples, n * sizeof( sorted[0] ) );
+	qsort( sorted, n, sizeof( sorted[0] ), SV_PerfCompareSamples );
+
+	total = 0;
+	for ( i = 0; i < n; i++ ) {
+		total += sorted[ i ];
+	}
+
+	stats->p50 = sorted[ n / 2 ];
+	stats->p99 = sorted[ ( n * 99 ) / 100 ];
+	stats->max = sorted[ n - 1 ];
+	stats->avg = (int)( total / n );
+
+	return n;
+}
+
+
+/*
+===============
+SV_PerfEscapeJSON
+
+Copy in as the contents of a JSON string: quotes and backslashes are
+escaped, control characters dropped.
+===============
+*/
+static void SV_PerfEscapeJSON( char *out, int size, const char *in ) {
+	int len;
+
+	for ( len = 0; *in && len < size - 2; in++ ) {
+		if ( *in == '"' || *in == '\\' ) {
+			out[ len++ ] = '\\';
+		} else if ( (unsigned char)*in < ' ' ) {
+			continue;
+		}
+		out[ len++ ] = *in;
+	}
+	out[ len ] = '\0';
+}
+
+
+/*
+===============
+SV_PerfFormatJSON
+===============
+*/
+static void SV_PerfFormatJSON( char *buf, int size ) {
+	perfStats_t stats;
+	char map[ MAX_QPATH * 2 ];
+	int i, n;
+
+	SV_PerfEscapeJSON( map, sizeof( map ), sv_mapname->string );
+
+	n = SV_PerfGetStats( &perf.sections[ SVP_FRAME ], &stats );
+	Com_sprintf( buf, size, "{\"time\":%i,\"map\":\"%s\",\"clients\":%i,\"frames\":%i",
+		Com_RealTime( NULL ), map, SV_PerfClientCount(), n );
+
+	for ( i = 0; i < SVP_NUM_SECTIONS; i++ ) {
+		SV_PerfGetStats( &perf.sections[ i ], &stats );
+		Q_strcat( buf, size, va( ",\"%s\":{\"p50\":%i,\"p99\":%i,\"max\":%i,\"avg\":%i}",
+			perfSectionNames[ i ], stats.p50, stats.p99, stats.max, stats.avg ) );
+	}
+
+	Q_strcat( buf, size, "}" );
+}
+
+
+/*
+===============
+SV_PerfDump
+
+Append one JSON line to the log, for monitoring to pick up.
+===============
+*/
+static void SV_PerfDump( void ) {
+	char buf[ 1024 ];
+	fileHandle_t f;
+
+	f = FS_FOpenFileAppend( FS_InstancePath( PERF_LOG_FILE ) );
+	if ( f == FS_INVALID_HANDLE ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: couldn't open %s, sv_perfDump disabled\n", PERF_LOG_FILE );
+		Cvar_Set( "sv_perfDump", "0" );
+		return;
+	}
+
+	SV_PerfFormatJSON( buf, sizeof( buf ) );
+	FS_Printf( f, "%s\n", buf );
+	FS_FCloseFile( f );
+}
+
+
+/*
+===============
+SV_PerfEndFrame
+
+Record the sections of the frame that just ended.
+===============
+*/
+void SV_PerfEndFrame( void ) {
+	perfSection_t *section;
+	int i, now;
+
+	for ( i = 0, section = perf.sections; i < SVP_NUM_SECTIONS; i++, section++ ) {
+		section->samples[ perf.frames % PERF_WINDOW ] = section->current;
+		section->current = 0;
+	}
+	perf.frames++;
+
+	if ( sv_perfDump->integer ) {
+		now = Sys_Milliseconds();
+		if ( now - perf.lastDumpTime >= sv_perfDump->integer * 1000 ) {
+			perf.lastDumpTime = now;
+			SV_PerfDump();
+		}
+	}
+}
+
+
+/*
+===============
+SV_Perf_f
+
+svperf [json|reset]
+===============
+*/
+void SV_Perf_f( void ) {
+	perfStats_t stats;
+	char buf[ 1024 ];
+	const char *arg;
+	int i, n;
+
+	arg = Cmd_Argv( 1 );
+
+	if ( !Q_stricmp( arg, "reset" ) ) {
+		Com_Memset( &perf.sections, 0, sizeof( perf.sections ) );
+		perf.frames = 0;
+		Com_Printf( "Frame timings reset.\n" );
+		return;
+	}
+
+	if ( !Q_stricmp( arg, "json" ) ) {
+		SV_PerfFormatJSON( buf, sizeof( buf ) );
+		Com_Printf( "%s\n", buf );
+		return;
+	}
+
+	if ( *arg ) {
+		Com_Printf( "usage: svperf [json|reset]\n" );
+		return;
+	}
+
+	n = SV_PerfGetStats( &perf.sections[ SVP_FRAME ], &stats );
+	if ( n == 0 ) {
+		Com_Printf( "No frames recorded.\n" );
+		return;
+	}
+
+	Com_Printf( "last %i frames, %i clients, usec per frame:\n", n, SV_PerfClientCount() );
+	Com_Printf( "section        p50      p99      max      avg\n" );
+	Com_Printf( "---------- -------- -------- -------- --------\n" );
+	for ( i = 0; i < SVP_NUM_SECTIONS; i++ ) {
+		SV_PerfGetStats( &perf.sections[ i ], &stats );
+		Com_Printf( "%-10s %8i %8i %8i %8i\n", perfSectionNames[ i ], stats.p50, stats.p99, stats.max, stats.avg );
+	}
+}
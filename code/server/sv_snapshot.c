@@ -45,6 +45,107 @@ A normal server packet will look like:
 =============================================================================
 */
 
+/*
+=============================================================================
+
+Entity delta cache
+
+Clients delta compressing from the same common frame get the same bits
+for an entity, spectators following the same player and broadcast
+entities in particular. Each thread building snapshots keeps the
+encoded deltas of the current common frame, keyed by entity number
+and the frame they are from, and splices them into later messages.
+
+=============================================================================
+*/
+
+#define DELTA_CACHE_HASH		4096
+#define DELTA_CACHE_ENTRIES		4096
+#define DELTA_CACHE_DATA		(256*1024)
+#define DELTA_CACHE_MAX_DELTA	512		// room left for one encoded entity before giving up
+
+typedef struct {
+	int		number;
+	int		fromFrame;			// frameNum of the old state, -1 for the baseline
+	int		offset;				// into data
+	int		bits;
+	int		next;				// hash chain
+} deltaCacheEntry_t;
+
+typedef struct {
+	int		buildCount;			// snapshotBuildCount the entries encode to, set once a common snapshot exists
+	int		numEntries;
+	int		used;
+	int		hash[ DELTA_CACHE_HASH ];
+	deltaCacheEntry_t entries[ DELTA_CACHE_ENTRIES ];
+	byte	data[ DELTA_CACHE_DATA ];
+} deltaCache_t;
+
+static deltaCache_t svDeltaCache;		// frame thread
+
+static int snapshotBuildCount;		// common snapshots built, never reset
+
+
+/*
+=============
+SV_WriteCachedDelta
+
+MSG_WriteDeltaEntity through the cache. fromFrame identifies the
+from state, -1 for the baseline.
+=============
+*/
+static void SV_WriteCachedDelta( deltaCache_t *cache, msg_t *msg, const entityState_t *from,
+								const entityState_t *to, int fromFrame, qboolean force ) {
+	deltaCacheEntry_t *e;
+	msg_t	tmp;
+	int		h, i;
+
+	if ( cache->buildCount != snapshotBuildCount ) {
+		cache->buildCount = snapshotBuildCount;
+		cache->numEntries = 0;
+		cache->used = 0;
+		for ( i = 0; i < DELTA_CACHE_HASH; i++ ) {
+			cache->hash[ i ] = -1;
+		}
+	}
+
+	h = ( to->number * 31 + fromFrame ) & ( DELTA_CACHE_HASH - 1 );
+	for ( i = cache->hash[ h ]; i >= 0; i = e->next ) {
+		e = &cache->entries[ i ];
+		if ( e->number == to->number && e->fromFrame == fromFrame ) {
+			MSG_WriteBitstring( msg, cache->data + e->offset, e->bits );
+			return;
+		}
+	}
+
+	if ( cache->numEntries >= DELTA_CACHE_ENTRIES || cache->used > DELTA_CACHE_DATA - DELTA_CACHE_MAX_DELTA ) {
+		MSG_WriteDeltaEntity( msg, from, to, force );
+		return;
+	}
+
+	// encode into the cache, leaving slack for the symbol
+	// that can be written past maxsize before overflowing
+	MSG_Init( &tmp, cache->data + cache->used, DELTA_CACHE_MAX_DELTA - 8 );
+	tmp.allowoverflow = qtrue;
+	MSG_WriteDeltaEntity( &tmp, from, to, force );
+	if ( tmp.overflowed ) {
+		MSG_WriteDeltaEntity( msg, from, to, force );
+		return;
+	}
+
+	e = &cache->entries[ cache->numEntries ];
+	e->number = to->number;
+	e->fromFrame = fromFrame;
+	e->offset = cache->used;
+	e->bits = tmp.bit;
+	e->next = cache->hash[ h ];
+	cache->hash[ h ] = cache->numEntries++;
+	cache->used += ( tmp.bit + 7 ) >> 3;
+
+	MSG_WriteBitstring( msg, cache->data + e->offset, e->bits );
+}
+
+
 /*
 =============
 SV_EmitPacketEntities
@@ -52,7 +153,7 @@ SV_EmitPacketEntities
 Writes a delta update of an entityState_t list to the message.
 =============
 */
-static void SV_EmitPacketEntities( const clientSnapshot_t *from, const clientSnapshot_t *to, msg_t *msg ) {
+static void SV_EmitPacketEntities( const clientSnapshot_t *from, const clientSnapshot_t *to, deltaCache_t *cache, msg_t *msg ) {
 	entityState_t	*oldent, *newent;
 	int		oldindex, newindex;
 	int		oldnum, newnum;
@@ -88,7 +189,7 @@ static void SV_EmitPacketEntities( const clientSnapshot_t *from, const clientSna
 			// delta update from old position
 			// because the force parm is qfalse, this will not result
 			// in any bytes being emitted if the entity has not changed at all
-			MSG_WriteDeltaEntity (msg, oldent, newent, qfalse );
+			SV_WriteCachedDelta( cache, msg, oldent, newent, from->frameNum, qfalse );
 			oldindex++;
 			newindex++;
 			continue;
@@ -96,7 +197,7 @@ static void SV_EmitPacketEntities( const clientSnapshot_t *from, const clientSna
 
 		if ( newnum < oldnum ) {
 			// this is a new entity, send it from the baseline
-			MSG_WriteDeltaEntity (msg, &sv.svEntities[newnum].baseline, newent, qtrue );
+			SV_WriteCachedDelta( cache, msg, &sv.svEntities[newnum].baseline, newent, -1, qtrue );
 			newindex++;
 			continue;
 		}
@@ -115,18 +216,15 @@ static void SV_EmitPacketEntities( const clientSnapshot_t *from, const clientSna
 
 /*
 ==================
-SV_WriteSnapshotToClient
+SV_SnapshotDeltaFrame
+
+Pick the previous frame to delta compress the next snapshot from,
+NULL for a full snapshot. Must be called after svs.currFrame is built.
 ==================
 */
-static void SV_WriteSnapshotToClient( const client_t *client, msg_t *msg ) {
+static const clientSnapshot_t *SV_SnapshotDeltaFrame( const client_t *client, int *lastframeOut ) {
 	const clientSnapshot_t	*oldframe;
-	const clientSnapshot_t	*frame;
 	int					lastframe;
-	int					i;
-	int					snapFlags;
-
-	// this is the snapshot we are creating
-	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
 
 	// try to use a previous frame as the source for delta compressing the snapshot
 	if ( /* client->deltaMessage <= 0 || */ client->state != CS_ACTIVE ) {
@@ -154,6 +252,25 @@ static void SV_WriteSnapshotToClient( const client_t *client, msg_t *msg ) {
 		}
 	}
 
+	*lastframeOut = lastframe;
+	return oldframe;
+}
+
+
+/*
+==================
+SV_WriteSnapshotToClient
+==================
+*/
+static void SV_WriteSnapshotToClient( const client_t *client, const clientSnapshot_t *oldframe, int lastframe,
+									deltaCache_t *cache, msg_t *msg ) {
+	const clientSnapshot_t	*frame;
+	int					i;
+	int					snapFlags;
+
+	// this is the snapshot we are creating
+	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
+
 	MSG_WriteByte( msg, svc_snapshot );
 
 	// NOTE, MRE: now sent at the start of every message from server to client
@@ -209,7 +326,7 @@ static void SV_WriteSnapshotToClient( const client_t *client, msg_t *msg ) {
 	}
 
 	// delta encode the entities
-	SV_EmitPacketEntities (oldframe, frame, msg);
+	SV_EmitPacketEntities (oldframe, frame, cache, msg);
 
 	// padding for rate debugging
 	if ( sv_padPackets->integer ) {
@@ -237,7 +354,7 @@ void SV_UpdateServerCommandsToClient( client_t *client, msg_t *msg ) {
 		const int index = client->reliableAcknowledge + 1 + i;
 		MSG_WriteByte( msg, svc_serverCommand );
 		MSG_WriteLong( msg, index );
-		MSG_WriteString( msg, client->reliableCommands[ index & (MAX_RELIABLE_COMMANDS-1) ] );
+		MSG_WriteString( msg, SV_ReliableCommand( client, index ) );
 	}
 }
 
@@ -255,8 +372,105 @@ typedef struct {
 	int		numSnapshotEntities;
 	entityNum_t	snapshotEntities[ MAX_SNAPSHOT_ENTITIES ];
 	qboolean unordered;
+	qboolean badClientMask;
+	byte	added[ MAX_GENTITIES / 8 ];	// prevents double adding from portal views
 } snapshotEntityNumbers_t;
 
+// svs.currFrame entities by the PVS clusters they touch, so clients only
+// test the entities of clusters their PVS has in it instead of all of them
+#define MAX_CLUSTER_REFS	( MAX_GENTITIES * MAX_ENT_CLUSTERS )
+
+typedef struct {
+	int			numRefs;
+	int			refs[ MAX_CLUSTER_REFS ];		// cluster << GENTITYNUM_BITS | frame index, sorted
+	int			numClusters;
+	int			clusters[ MAX_CLUSTER_REFS ];	// distinct clusters in refs
+	int			firstRef[ MAX_CLUSTER_REFS + 1 ];
+	uint32_t	always[ MAX_GENTITIES / 32 ];	// tested whatever the PVS is
+} snapshotClusters_t;
+
+static snapshotClusters_t snapClusters;		// built with svs.currFrame, read only after
+
+
+/*
+=============
+SV_CompareClusterRefs
+=============
+*/
+static int QDECL SV_CompareClusterRefs( const void *a, const void *b ) {
+	return *(const int *)a - *(const int *)b;
+}
+
+
+/*
+=============
+SV_IndexSnapshotClusters
+
+Group the entities of a new common snapshot by cluster
+=============
+*/
+static void SV_IndexSnapshotClusters( sharedEntity_t **list, int count ) {
+	const svEntity_t *svEnt;
+	int e, i, ref;
+
+	snapClusters.numRefs = 0;
+	snapClusters.numClusters = 0;
+	Com_Memset( snapClusters.always, 0, sizeof( snapClusters.always ) );
+
+	for ( e = 0; e < count; e++ ) {
+		svEnt = &sv.svEntities[ list[ e ]->s.number ];
+
+		// broadcasts, overflowed cluster lists, and client masks that
+		// have to report clientNum >= 32 whether visible or not
+		if ( list[ e ]->r.svFlags & ( SVF_BROADCAST | SVF_CLIENTMASK ) || svEnt->lastCluster ) {
+			snapClusters.always[ e >> 5 ] |= 1U << ( e & 31 );
+			continue;
+		}
+
+		for ( i = 0; i < svEnt->numClusters; i++ ) {
+			snapClusters.refs[ snapClusters.numRefs++ ] = ( svEnt->clusternums[ i ] << GENTITYNUM_BITS ) | e;
+		}
+	}
+
+	qsort( snapClusters.refs, snapClusters.numRefs, sizeof( snapClusters.refs[0] ), SV_CompareClusterRefs );
+
+	for ( i = 0; i < snapClusters.numRefs; i++ ) {
+		ref = snapClusters.refs[ i ];
+		if ( snapClusters.numClusters == 0 || snapClusters.clusters[ snapClusters.numClusters - 1 ] != ref >> GENTITYNUM_BITS ) {
+			snapClusters.clusters[ snapClusters.numClusters ] = ref >> GENTITYNUM_BITS;
+			snapClusters.firstRef[ snapClusters.numClusters ] = i;
+			snapClusters.numClusters++;
+		}
+	}
+	snapClusters.firstRef[ snapClusters.numClusters ] = snapClusters.numRefs;
+}
+
+
+/*
+=============
+SV_GetVisibleCandidates
+
+Mark the svs.currFrame entities that may be visible through pvs: the ones
+touching a cluster in it and the ones that are always tested
+=============
+*/
+static void SV_GetVisibleCandidates( const byte *pvs, uint32_t *candidates ) {
+	int c, cluster, i, e;
+
+	Com_Memcpy( candidates, snapClusters.always, sizeof( snapClusters.always ) );
+
+	for ( c = 0; c < snapClusters.numClusters; c++ ) {
+		cluster = snapClusters.clusters[ c ];
+		if ( !( pvs[ cluster >> 3 ] & ( 1 << ( cluster & 7 ) ) ) ) {
+			continue;
+		}
+		for ( i = snapClusters.firstRef[ c ]; i < snapClusters.firstRef[ c + 1 ]; i++ ) {
+			e = snapClusters.refs[ i ] & ( MAX_GENTITIES - 1 );
+			candidates[ e >> 5 ] |= 1U << ( e & 31 );
+		}
+	}
+}
+
 
 /*
 =============
@@ -293,9 +507,9 @@ static void SV_SortEntityNumbers( entityNum_t *num, const int size ) {
 SV_AddIndexToSnapshot
 ===============
 */
-static void SV_AddIndexToSnapshot( svEntity_t *svEnt, int index, snapshotEntityNumbers_t *eNums ) {
+static void SV_AddIndexToSnapshot( int num, int index, snapshotEntityNumbers_t *eNums ) {
 
-	svEnt->snapshotCounter = sv.snapshotCounter;
+	eNums->added[ num >> 3 ] |= 1 << ( num & 7 );
 
 	// if we are full, silently discard entities
 	if ( eNums->numSnapshotEntities >= MAX_SNAPSHOT_ENTITIES ) {
@@ -323,6 +537,7 @@ static void SV_AddEntitiesVisibleFromPoint( const vec3_t origin, clientSnapshot_
 	int		leafnum;
 	byte	*clientpvs;
 	byte	*bitvector;
+	uint32_t candidates[ MAX_GENTITIES / 32 ];
 
 	// during an error shutdown message we may need to transmit
 	// the shutdown message after the server has shutdown, so
@@ -340,7 +555,18 @@ static void SV_AddEntitiesVisibleFromPoint( const vec3_t origin, clientSnapshot_
 
 	clientpvs = CM_ClusterPVS (clientcluster);
 
+	SV_GetVisibleCandidates( clientpvs, candidates );
+
 	for ( e = 0 ; e < svs.currFrame->count; e++ ) {
+		// nothing in any cluster the PVS has
+		if ( !candidates[ e >> 5 ] ) {
+			e |= 31;
+			continue;
+		}
+		if ( !( candidates[ e >> 5 ] & ( 1U << ( e & 31 ) ) ) ) {
+			continue;
+		}
+
 		es = svs.currFrame->ents[ e ];
 		ent = SV_GentityNum( es->number );
 
@@ -358,22 +584,25 @@ static void SV_AddEntitiesVisibleFromPoint( const vec3_t origin, clientSnapshot_
 		}
 		// entities can be flagged to be sent to a given mask of clients
 		if ( ent->r.svFlags & SVF_CLIENTMASK ) {
-			if (frame->ps.clientNum >= 32)
-				Com_Error( ERR_DROP, "SVF_CLIENTMASK: clientNum >= 32" );
+			if ( frame->ps.clientNum >= 32 ) {
+				// reported by the caller, this may run on a worker thread
+				eNums->badClientMask = qtrue;
+				continue;
+			}
 			if (~ent->r.singleClient & (1 << frame->ps.clientNum))
 				continue;
 		}
 
-		svEnt = &sv.svEntities[ es->number ];
-
 		// don't double add an entity through portals
-		if ( svEnt->snapshotCounter == sv.snapshotCounter ) {
+		if ( eNums->added[ es->number >> 3 ] & ( 1 << ( es->number & 7 ) ) ) {
 			continue;
 		}
 
+		svEnt = &sv.svEntities[ es->number ];
+
 		// broadcast entities are always sent
 		if ( ent->r.svFlags & SVF_BROADCAST ) {
-			SV_AddIndexToSnapshot( svEnt, e, eNums );
+			SV_AddIndexToSnapshot( es->number, e, eNums );
 			continue;
 		}
 
@@ -419,7 +648,7 @@ static void SV_AddEntitiesVisibleFromPoint( const vec3_t origin, clientSnapshot_
 		}
 
 		// add it
-		SV_AddIndexToSnapshot( svEnt, e, eNums );
+		SV_AddIndexToSnapshot( es->number, e, eNums );
 
 		// if it's a portal entity, add everything visible from its camera position
 		if ( ent->r.svFlags & SVF_PORTAL && !portal ) {
@@ -524,12 +753,9 @@ static void SV_BuildCommonSnapshot( void )
 			}
 
 			list[ count++ ] = ent;
-			sv.svEntities[ num ].snapshotCounter = -1;
 		}
 	}
 
-	sv.snapshotCounter = -1;
-
 	sf = &svs.snapFrames[ svs.snapshotFrame % NUM_SNAPSHOT_FRAMES ];
 	
 	// track last valid frame
@@ -563,6 +789,7 @@ static void SV_BuildCommonSnapshot( void )
 
 	sf->frameNum = svs.snapshotFrame;
 	svs.snapshotFrame++;
+	snapshotBuildCount++;
 
 	svs.currFrame = sf; // clients can refer to this
 
@@ -573,6 +800,8 @@ static void SV_BuildCommonSnapshot( void )
 		svs.snapshotEntities[ index ] = list[ i ]->s;
 		sf->ents[ i ] = &svs.snapshotEntities[ index ];
 	}
+
+	SV_IndexSnapshotClusters( list, count );
 }
 
 
@@ -587,14 +816,16 @@ This properly handles multiple recursive portals, but the render
 currently doesn't.
 
 For viewing through other player's eyes, clent can be something other than client->gentity
+
+Returns an error message instead of calling Com_Error, as it also runs
+on the snapshot worker threads once svs.currFrame is built.
 =============
 */
-static void SV_BuildClientSnapshot( client_t *client ) {
+static const char *SV_BuildClientSnapshot( client_t *client ) {
 	vec3_t						org;
 	clientSnapshot_t			*frame;
 	snapshotEntityNumbers_t		entityNumbers;
 	int							i, cl;
-	svEntity_t					*svEnt;
 	int							clientNum;
 	playerState_t				*ps;
 
@@ -611,7 +842,7 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 	frame->frameNum = svs.currentSnapshotFrame;
 	
 	if ( client->state == CS_ZOMBIE )
-		return;
+		return NULL;
 
 	// grab the current playerState_t
 	ps = SV_GameClientNum( cl );
@@ -619,14 +850,14 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 
 	clientNum = frame->ps.clientNum;
 	if ( clientNum < 0 || clientNum >= MAX_GENTITIES ) {
-		Com_Error( ERR_DROP, "SV_SvEntityForGentity: bad gEnt" );
+		return "SV_SvEntityForGentity: bad gEnt";
 	}
 
 	// we set client->gentity only after sending gamestate
 	// so don't send any packetentities changes until CS_PRIMED
 	// because new gamestate will invalidate them anyway
 	if ( !client->gentity ) {
-		return;
+		return NULL;
 	}
 
 	if ( svs.currFrame == NULL ) {
@@ -634,18 +865,16 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 		SV_BuildCommonSnapshot();
 	}
 
-	// bump the counter used to prevent double adding
-	sv.snapshotCounter++;
-
 	// empty entities before visibility check
 	entityNumbers.numSnapshotEntities = 0;
+	entityNumbers.badClientMask = qfalse;
+	Com_Memset( entityNumbers.added, 0, sizeof( entityNumbers.added ) );
 
 	frame->frameNum = svs.currFrame->frameNum;
 
 	// never send client's own entity, because it can
 	// be regenerated from the playerstate
-	svEnt = &sv.svEntities[ clientNum ];
-	svEnt->snapshotCounter = sv.snapshotCounter;
+	entityNumbers.added[ clientNum >> 3 ] |= 1 << ( clientNum & 7 );
 
 	// find the client's viewpoint
 	VectorCopy( ps->origin, org );
@@ -655,6 +884,9 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 	// may include portal entities that merge other viewpoints
 	entityNumbers.unordered = qfalse;
 	SV_AddEntitiesVisibleFromPoint( org, frame, &entityNumbers, qfalse );
+	if ( entityNumbers.badClientMask ) {
+		return "SVF_CLIENTMASK: clientNum >= 32";
+	}
 
 	// if there were portals visible, there may be out of order entities
 	// in the list which will need to be resorted for the delta compression
@@ -676,6 +908,34 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 	for ( i = 0 ; i < entityNumbers.numSnapshotEntities ; i++ )	{
 		frame->ents[ i ] = svs.currFrame->ents[ entityNumbers.snapshotEntities[ i ] ];
 	}
+
+	return NULL;
+}
+
+
+/*
+=======================
+SV_WriteClientMessage
+
+Write a snapshot message for a client whose snapshot has been built
+into msg, which must be set up with MSG_Init. Safe to run on the
+snapshot worker threads, each with its own delta cache.
+=======================
+*/
+static void SV_WriteClientMessage( client_t *client, const clientSnapshot_t *oldframe, int lastframe,
+								deltaCache_t *cache, msg_t *msg ) {
+	msg->allowoverflow = qtrue;
+
+	// NOTE, MRE: all server->client messages now acknowledge
+	// let the client know which reliable clientCommands we have received
+	MSG_WriteLong( msg, client->lastClientCommand );
+
+	// (re)send any reliable server commands
+	SV_UpdateServerCommandsToClient( client, msg );
+
+	// send over all the relevant entityState_t
+	// and the playerState_t
+	SV_WriteSnapshotToClient( client, oldframe, lastframe, cache, msg );
 }
 
 
@@ -709,9 +969,19 @@ Also called by SV_FinalMessage
 void SV_SendClientSnapshot( client_t *client ) {
 	byte		msg_buf[ MAX_MSGLEN_BUF ];
 	msg_t		msg;
+	const clientSnapshot_t *oldframe;
+	const char	*error;
+	int			lastframe;
+	int64_t		start, built, encoded;
 
 	// build the snapshot
-	SV_BuildClientSnapshot( client );
+	start = Sys_Microseconds();
+	error = SV_BuildClientSnapshot( client );
+	if ( error ) {
+		Com_Error( ERR_DROP, "%s", error );
+	}
+	built = Sys_Microseconds();
+	SV_PerfAdd( SVP_SNAPSHOT, built - start );
 
 	// bots need to have their snapshots build, but
 	// the query them directly without needing to be sent
@@ -719,27 +989,277 @@ void SV_SendClientSnapshot( client_t *client ) {
 		return;
 	}
 
-	MSG_Init( &msg, msg_buf, MAX_MSGLEN );
-	msg.allowoverflow = qtrue;
+	oldframe = SV_SnapshotDeltaFrame( client, &lastframe );
 
-	// NOTE, MRE: all server->client messages now acknowledge
-	// let the client know which reliable clientCommands we have received
-	MSG_WriteLong( &msg, client->lastClientCommand );
-
-	// (re)send any reliable server commands
-	SV_UpdateServerCommandsToClient( client, &msg );
-
-	// send over all the relevant entityState_t
-	// and the playerState_t
-	SV_WriteSnapshotToClient( client, &msg );
+	MSG_Init( &msg, msg_buf, MAX_MSGLEN );
+	SV_WriteClientMessage( client, oldframe, lastframe, &svDeltaCache, &msg );
 
 	// check for overflow
 	if ( msg.overflowed ) {
 		Com_Printf( "WARNING: msg overflowed for %s\n", client->name );
 		MSG_Clear( &msg );
 	}
+	encoded = Sys_Microseconds();
+	SV_PerfAdd( SVP_ENCODE, encoded - built );
 
 	SV_SendMessageToClient( &msg, client );
+	SV_PerfAdd( SVP_SEND, Sys_Microseconds() - encoded );
+}
+
+
+/*
+=============================================================================
+
+Parallel snapshot building
+
+With sv_snapshotThreads set, the snapshots due this frame are built
+and encoded by the worker threads and the frame thread together.
+svs.currFrame is built first and, like the game and collision state,
+stays read-only while they run. The messages are then sent from the
+frame thread in client order, so the packets are the same as when
+building them one client at a time.
+
+=============================================================================
+*/
+
+typedef struct {
+	client_t	*client;
+	const clientSnapshot_t *oldframe;
+	int			lastframe;
+	const char	*error;
+	int			buildUsec;		// for svperf, added up on the frame thread
+	int			encodeUsec;
+	msg_t		msg;
+	byte		msgBuf[ MAX_MSGLEN_BUF ];
+} snapshotJob_t;
+
+typedef struct {
+	void		*threads[ MAX_SNAPSHOT_THREADS ];
+	int			numThreads;
+	int			requested;		// sv_snapshotThreads the pool was started for
+	void		*start;			// posted once per thread for each batch
+	void		*done;			// posted by each thread when the batch is finished
+	void		*lock;			// guards nextJob
+	qboolean	shutdown;
+	deltaCache_t	*caches;	// one per thread
+
+	snapshotJob_t	*jobs;		// MAX_CLIENTS
+	int			numJobs;
+	int			nextJob;
+} snapshotWorkers_t;
+
+static snapshotWorkers_t snapWorkers;
+
+
+/*
+=======================
+SV_RunSnapshotJobs
+
+Take jobs from the current batch until it is empty.
+=======================
+*/
+static void SV_RunSnapshotJobs( deltaCache_t *cache ) {
+	snapshotJob_t *job;
+	int64_t start, built;
+	int n;
+
+	while ( 1 ) {
+		Sys_LockMutex( snapWorkers.lock );
+		n = snapWorkers.nextJob++;
+		Sys_UnlockMutex( snapWorkers.lock );
+
+		if ( n >= snapWorkers.numJobs ) {
+			return;
+		}
+
+		job = &snapWorkers.jobs[ n ];
+		start = Sys_Microseconds();
+		job->error = SV_BuildClientSnapshot( job->client );
+		built = Sys_Microseconds();
+		job->buildUsec = (int)( built - start );
+		job->encodeUsec = 0;
+		if ( job->error || job->client->netchan.remoteAddress.type == NA_BOT ) {
+			continue;
+		}
+
+		MSG_Init( &job->msg, job->msgBuf, MAX_MSGLEN );
+		SV_WriteClientMessage( job->client, job->oldframe, job->lastframe, cache, &job->msg );
+		job->encodeUsec = (int)( Sys_Microseconds() - built );
+	}
+}
+
+
+/*
+=======================
+SV_SnapshotWorker
+=======================
+*/
+static void SV_SnapshotWorker( void *arg ) {
+	while ( 1 ) {
+		Sys_SemaphoreWait( snapWorkers.start );
+		if ( snapWorkers.shutdown ) {
+			break;
+		}
+		SV_RunSnapshotJobs( arg );
+		Sys_SemaphorePost( snapWorkers.done );
+	}
+}
+
+
+/*
+=======================
+SV_ShutdownSnapshotThreads
+=======================
+*/
+void SV_ShutdownSnapshotThreads( void ) {
+	int i;
+
+	if ( snapWorkers.numThreads ) {
+		snapWorkers.shutdown = qtrue;
+		for ( i = 0; i < snapWorkers.numThreads; i++ ) {
+			Sys_SemaphorePost( snapWorkers.start );
+		}
+		for ( i = 0; i < snapWorkers.numThreads; i++ ) {
+			Sys_JoinThread( snapWorkers.threads[ i ] );
+		}
+	}
+
+	Sys_DestroySemaphore( snapWorkers.start );
+	Sys_DestroySemaphore( snapWorkers.done );
+	Sys_DestroyMutex( snapWorkers.lock );
+	free( snapWorkers.jobs );
+	free( snapWorkers.caches );
+
+	Com_Memset( &snapWorkers, 0, sizeof( snapWorkers ) );
+}
+
+
+/*
+=======================
+SV_StartSnapshotThreads
+
+Start the workers for the current sv_snapshotThreads. If threads are
+not available, numThreads stays 0 and snapshots are built serially.
+=======================
+*/
+static void SV_StartSnapshotThreads( void ) {
+	int count;
+
+	SV_ShutdownSnapshotThreads();
+
+	count = sv_snapshotThreads->integer;
+	snapWorkers.requested = count;
+	if ( count <= 0 ) {
+		return;
+	}
+
+	snapWorkers.jobs = malloc( MAX_CLIENTS * sizeof( snapshotJob_t ) );
+	snapWorkers.caches = calloc( count, sizeof( deltaCache_t ) );
+	snapWorkers.start = Sys_CreateSemaphore( 0 );
+	snapWorkers.done = Sys_CreateSemaphore( 0 );
+	snapWorkers.lock = Sys_CreateMutex();
+	if ( !snapWorkers.jobs || !snapWorkers.caches || !snapWorkers.start || !snapWorkers.done || !snapWorkers.lock ) {
+		SV_ShutdownSnapshotThreads();
+		snapWorkers.requested = count;
+		return;
+	}
+
+	while ( snapWorkers.numThreads < count ) {
+		void *thread = Sys_CreateThread( SV_SnapshotWorker, &snapWorkers.caches[ snapWorkers.numThreads ] );
+		if ( !thread ) {
+			break;
+		}
+		snapWorkers.threads[ snapWorkers.numThreads++ ] = thread;
+	}
+
+	if ( snapWorkers.numThreads < count ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: started %i of %i snapshot threads\n", snapWorkers.numThreads, count );
+	}
+}
+
+
+/*
+=======================
+SV_SendSnapshotBatch
+
+Build and encode the queued snapshot jobs on all threads, then send
+them in client order.
+=======================
+*/
+static void SV_SendSnapshotBatch( void ) {
+	snapshotJob_t *job;
+	int64_t start;
+	int i, numJobs;
+
+	snapWorkers.nextJob = 0;
+	for ( i = 0; i < snapWorkers.numThreads; i++ ) {
+		Sys_SemaphorePost( snapWorkers.start );
+	}
+
+	SV_RunSnapshotJobs( &svDeltaCache );
+
+	for ( i = 0; i < snapWorkers.numThreads; i++ ) {
+		Sys_SemaphoreWait( snapWorkers.done );
+	}
+
+	// reset first, a failed snapshot drops the server
+	numJobs = snapWorkers.numJobs;
+	snapWorkers.numJobs = 0;
+
+	start = Sys_Microseconds();
+	for ( i = 0; i < numJobs; i++ ) {
+		job = &snapWorkers.jobs[ i ];
+
+		if ( job->error ) {
+			Com_Error( ERR_DROP, "%s", job->error );
+		}
+
+		SV_PerfAdd( SVP_SNAPSHOT, job->buildUsec );
+		SV_PerfAdd( SVP_ENCODE, job->encodeUsec );
+
+		if ( job->client->netchan.remoteAddress.type != NA_BOT ) {
+			if ( job->msg.overflowed ) {
+				Com_Printf( "WARNING: msg overflowed for %s\n", job->client->name );
+				MSG_Clear( &job->msg );
+			}
+			SV_SendMessageToClient( &job->msg, job->client );
+		}
+
+		job->client->lastSnapshotTime = svs.time;
+		job->client->rateDelayed = qfalse;
+	}
+	SV_PerfAdd( SVP_SEND, Sys_Microseconds() - start );
+}
+
+
+/*
+=======================
+SV_QueueClientSnapshot
+
+Prepare everything that must happen on the frame thread before the
+snapshot can be built on a worker, and add it to the batch.
+=======================
+*/
+static void SV_QueueClientSnapshot( client_t *client ) {
+	snapshotJob_t *job;
+	int64_t start;
+
+	// the common snapshot is built lazily by the first client that needs it
+	if ( svs.currFrame == NULL && client->state != CS_ZOMBIE && client->gentity ) {
+		start = Sys_Microseconds();
+		SV_BuildCommonSnapshot();
+		SV_PerfAdd( SVP_SNAPSHOT, Sys_Microseconds() - start );
+	}
+
+	job = &snapWorkers.jobs[ snapWorkers.numJobs++ ];
+	job->client = client;
+	job->error = NULL;
+	job->oldframe = NULL;
+	job->lastframe = 0;
+
+	if ( client->netchan.remoteAddress.type != NA_BOT ) {
+		job->oldframe = SV_SnapshotDeltaFrame( client, &job->lastframe );
+	}
 }
 
 
@@ -755,6 +1275,13 @@ void SV_SendClientMessages( void )
 
 	svs.msgTime = Sys_Milliseconds();
 
+	if ( snapWorkers.requested != sv_snapshotThreads->integer ) {
+		SV_StartSnapshotThreads();
+	}
+
+	// snapshots leave in one batch where the platform supports it
+	NET_BeginPacketBatch();
+
 	// send a message to each connected client
 	for ( i = 0; i < sv.maxclients; i++ )
 	{
@@ -791,9 +1318,20 @@ void SV_SendClientMessages( void )
 			continue;
 		}
 
+		if ( snapWorkers.numThreads ) {
+			SV_QueueClientSnapshot( c );
+			continue;
+		}
+
 		// generate and send a new message
 		SV_SendClientSnapshot( c );
 		c->lastSnapshotTime = svs.time;
 		c->rateDelayed = qfalse;
 	}
+
+	if ( snapWorkers.numJobs ) {
+		SV_SendSnapshotBatch();
+	}
+
+	NET_EndPacketBatch();
 }
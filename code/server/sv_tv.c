@@ -21,6 +21,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 
 #include "server.h"
+#include "../qcommon/tvd.h"
 
 tvState_t tv;
 cvar_t *sv_tvAuto;
@@ -28,6 +29,13 @@ cvar_t *sv_tvAutoMinPlayers;
 cvar_t *sv_tvAutoMinPlayersSecs;
 cvar_t *sv_tvpath;
 cvar_t *sv_tvDownload;
+cvar_t *sv_tvKeyframeInterval;
+cvar_t *sv_tvAsync;
+cvar_t *sv_tvRelayPort;
+cvar_t *sv_tvRelayMaxViewers;
+cvar_t *sv_tvDict;
+cvar_t *sv_tvCompressLevel;
+cvar_t *sv_tvCompressBudget;
 
 
 /*
@@ -50,6 +58,298 @@ void SV_TV_Init( void ) {
 
 	sv_tvDownload = Cvar_Get( "sv_tvDownload", "0", CVAR_ARCHIVE );
 	Cvar_SetDescription( sv_tvDownload, "Notify clients to download TV recordings via HTTP at end of match. Requires sv_dlURL." );
+
+	sv_tvKeyframeInterval = Cvar_Get( "sv_tvKeyframeInterval", "10", CVAR_ARCHIVE );
+	Cvar_CheckRange( sv_tvKeyframeInterval, "0", "300", CV_INTEGER );
+	Cvar_SetDescription( sv_tvKeyframeInterval, "Seconds between full-state TV keyframes used for seeking. 0 = no keyframes." );
+
+	sv_tvAsync = Cvar_Get( "sv_tvAsync", "1", CVAR_ARCHIVE );
+	Cvar_SetDescription( sv_tvAsync, "Compress and write TV recordings on a background thread. Takes effect on the next recording." );
+
+	sv_tvRelayPort = Cvar_Get( "sv_tvRelayPort", "0", CVAR_ARCHIVE );
+	Cvar_CheckRange( sv_tvRelayPort, "0", "65535", CV_INTEGER );
+	Cvar_SetDescription( sv_tvRelayPort, "TCP port to stream TV recordings live to viewers while recording. 0 = disabled. Takes effect on the next recording." );
+
+	sv_tvRelayMaxViewers = Cvar_Get( "sv_tvRelayMaxViewers", "64", CVAR_ARCHIVE );
+	Cvar_CheckRange( sv_tvRelayMaxViewers, "1", XSTRING( MAX_TV_RELAY_VIEWERS ), CV_INTEGER );
+	Cvar_SetDescription( sv_tvRelayMaxViewers, "Maximum number of simultaneous TV relay viewers." );
+
+	sv_tvDict = Cvar_Get( "sv_tvDict", "", CVAR_ARCHIVE );
+	Cvar_SetDescription( sv_tvDict, "zstd dictionary file to compress TV recordings with, e.g. tvdict/<id>.dict from tvtraindict. Players need it as tvdict/<crc32>.dict to play them back; one under another name is copied there. Takes effect on the next recording." );
+
+	sv_tvCompressLevel = Cvar_Get( "sv_tvCompressLevel", "1", CVAR_ARCHIVE );
+	Cvar_CheckRange( sv_tvCompressLevel, XSTRING( TV_LEVEL_MIN ), XSTRING( TV_LEVEL_MAX ), CV_INTEGER );
+	Cvar_SetDescription( sv_tvCompressLevel, "zstd level TV recordings start at, and keep if sv_tvCompressBudget is 0. Takes effect on the next recording." );
+
+	sv_tvCompressBudget = Cvar_Get( "sv_tvCompressBudget", "5", CVAR_ARCHIVE );
+	Cvar_CheckRange( sv_tvCompressBudget, "0", "100", CV_INTEGER );
+	Cvar_SetDescription( sv_tvCompressBudget, "Percent of the sv_fps frame time TV compression may use on average. The zstd level is raised or lowered to stay within it. 0 = fixed sv_tvCompressLevel. Takes effect on the next recording." );
+}
+
+
+/*
+===============
+SV_TV_RelayDrop
+===============
+*/
+static void SV_TV_RelayDrop( tvRelayViewer_t *v ) {
+	NET_StreamClose( v->stream );
+	free( v->pending );
+	Com_Memset( v, 0, sizeof( *v ) );
+	tv.relayViewerCount--;
+}
+
+
+/*
+===============
+SV_TV_RelaySend
+
+Send data to one viewer, keeping whatever the socket does not accept
+for later. Viewers that fall too far behind are dropped.
+===============
+*/
+static void SV_TV_RelaySend( tvRelayViewer_t *v, const void *data, int len ) {
+	int sent;
+
+	// Flush the backlog first to keep the byte order
+	if ( v->pendingLen > 0 ) {
+		sent = NET_StreamSend( v->stream, v->pending, v->pendingLen );
+		if ( sent < 0 ) {
+			SV_TV_RelayDrop( v );
+			return;
+		}
+		v->pendingLen -= sent;
+		memmove( v->pending, v->pending + sent, v->pendingLen );
+	}
+
+	sent = 0;
+	if ( v->pendingLen == 0 && len > 0 ) {
+		sent = NET_StreamSend( v->stream, data, len );
+		if ( sent < 0 ) {
+			SV_TV_RelayDrop( v );
+			return;
+		}
+	}
+
+	if ( sent == len ) {
+		return;
+	}
+
+	if ( len - sent > TV_RELAY_PENDING_SIZE - v->pendingLen ) {
+		tv.relayDropped++;
+		SV_TV_RelayDrop( v );
+		return;
+	}
+
+	if ( !v->pending ) {
+		v->pending = malloc( TV_RELAY_PENDING_SIZE );
+		if ( !v->pending ) {
+			SV_TV_RelayDrop( v );
+			return;
+		}
+	}
+
+	Com_Memcpy( v->pending + v->pendingLen, (const byte *)data + sent, len - sent );
+	v->pendingLen += len - sent;
+}
+
+
+/*
+===============
+SV_TV_SetRelayWantKeyframe
+
+relayWantKeyframe is set on the writer thread and taken on the frame
+thread, so it goes through queueLock while the writer runs.
+===============
+*/
+static void SV_TV_SetRelayWantKeyframe( qboolean want ) {
+	if ( tv.queueLock ) {
+		Sys_LockMutex( tv.queueLock );
+		tv.relayWantKeyframe = want;
+		Sys_UnlockMutex( tv.queueLock );
+	} else {
+		tv.relayWantKeyframe = want;
+	}
+}
+
+
+/*
+===============
+SV_TV_RelayWantKeyframe
+===============
+*/
+static qboolean SV_TV_RelayWantKeyframe( void ) {
+	qboolean want;
+
+	if ( tv.queueLock ) {
+		Sys_LockMutex( tv.queueLock );
+		want = tv.relayWantKeyframe;
+		Sys_UnlockMutex( tv.queueLock );
+	} else {
+		want = tv.relayWantKeyframe;
+	}
+
+	return want;
+}
+
+
+/*
+===============
+SV_TV_RelayPoll
+
+Accept new viewers, discard anything they send (the HTTP request),
+notice closed connections and flush backlogs.
+===============
+*/
+static void SV_TV_RelayPoll( void ) {
+	netstream_t *stream;
+	byte buf[1024];
+	qboolean waiting;
+	int i, n;
+
+	if ( !tv.relayListener ) {
+		return;
+	}
+
+	while ( ( stream = NET_StreamAccept( tv.relayListener, NULL ) ) != NULL ) {
+		if ( tv.relayViewerCount >= tv.relayMaxViewers ) {
+			NET_StreamClose( stream );
+			continue;
+		}
+		for ( i = 0; i < MAX_TV_RELAY_VIEWERS; i++ ) {
+			if ( !tv.relayViewers[i].stream ) {
+				tv.relayViewers[i].stream = stream;
+				tv.relayViewerCount++;
+				break;
+			}
+		}
+		if ( tv.relayViewerCount > tv.relayPeakViewers ) {
+			tv.relayPeakViewers = tv.relayViewerCount;
+		}
+	}
+
+	waiting = qfalse;
+	for ( i = 0; i < MAX_TV_RELAY_VIEWERS; i++ ) {
+		tvRelayViewer_t *v = &tv.relayViewers[i];
+
+		if ( !v->stream ) {
+			continue;
+		}
+
+		while ( ( n = NET_StreamRecv( v->stream, buf, sizeof( buf ) ) ) > 0 )
+			;
+		if ( n < 0 ) {
+			SV_TV_RelayDrop( v );
+			continue;
+		}
+
+		if ( v->live ) {
+			SV_TV_RelaySend( v, NULL, 0 );
+		} else {
+			waiting = qtrue;
+		}
+	}
+
+	// Late joiners can only start decoding at a keyframe
+	if ( waiting ) {
+		SV_TV_SetRelayWantKeyframe( qtrue );
+	}
+}
+
+
+/*
+===============
+SV_TV_RelayStartViewers
+
+Called right after a zstd frame ends, before a keyframe is written:
+waiting viewers get the header and receive everything from here on.
+===============
+*/
+static void SV_TV_RelayStartViewers( void ) {
+	int i;
+
+	for ( i = 0; i < MAX_TV_RELAY_VIEWERS; i++ ) {
+		tvRelayViewer_t *v = &tv.relayViewers[i];
+
+		if ( v->stream && !v->live ) {
+			v->live = qtrue;
+			SV_TV_RelaySend( v, tv.relayHeader, tv.relayHeaderLen );
+		}
+	}
+}
+
+
+/*
+===============
+SV_TV_RelayClose
+===============
+*/
+static void SV_TV_RelayClose( void ) {
+	int i;
+
+	if ( !tv.relayListener ) {
+		return;
+	}
+
+	for ( i = 0; i < MAX_TV_RELAY_VIEWERS; i++ ) {
+		if ( tv.relayViewers[i].stream ) {
+			SV_TV_RelayDrop( &tv.relayViewers[i] );
+		}
+	}
+
+	NET_StreamClose( tv.relayListener );
+	tv.relayListener = NULL;
+
+	Com_Printf( "TV: Relay closed, peak %i viewers, %i dropped for falling behind.\n",
+		tv.relayPeakViewers, tv.relayDropped );
+}
+
+
+/*
+===============
+SV_TV_RelayOpen
+
+Start listening for relay viewers. Viewers get an HTTP/1.0 response
+followed by a .tvd stream: the header without configstrings, then
+zstd frames starting at the next keyframe, which carries them.
+===============
+*/
+static void SV_TV_RelayOpen( const char *timestamp ) {
+	static const char response[] =
+		"HTTP/1.0 200 OK\r\n"
+		"Content-Type: application/octet-stream\r\n"
+		"Cache-Control: no-cache\r\n"
+		"\r\n";
+	byte *p;
+	int val;
+	unsigned short term = 0xFFFF;
+
+	tv.relayListener = NET_StreamListen( sv_tvRelayPort->integer );
+	if ( !tv.relayListener ) {
+		Com_Printf( "TV: Could not open relay port %i.\n", sv_tvRelayPort->integer );
+		return;
+	}
+
+	tv.relayMaxViewers = sv_tvRelayMaxViewers->integer;
+
+	p = tv.relayHeader;
+	Com_Memcpy( p, response, sizeof( response ) - 1 ); p += sizeof( response ) - 1;
+	Com_Memcpy( p, "TVD1", 4 ); p += 4;
+	val = TVD_PROTOCOL_VERSION;
+	Com_Memcpy( p, &val, 4 ); p += 4;
+	val = sv_fps->integer;
+	Com_Memcpy( p, &val, 4 ); p += 4;
+	val = sv.maxclients;
+	Com_Memcpy( p, &val, 4 ); p += 4;
+	Com_Memcpy( p, &tv.dictId, 4 ); p += 4;
+	val = (int)strlen( sv_mapname->string ) + 1;
+	Com_Memcpy( p, sv_mapname->string, val ); p += val;
+	val = (int)strlen( timestamp ) + 1;
+	Com_Memcpy( p, timestamp, val ); p += val;
+	Com_Memcpy( p, &term, 2 ); p += 2;
+	tv.relayHeaderLen = (int)( p - tv.relayHeader );
+
+	Com_Printf( "TV: Relay listening on port %i.\n", sv_tvRelayPort->integer );
 }
 
 
@@ -58,13 +358,23 @@ void SV_TV_Init( void ) {
 SV_TV_FileWrite
 
 Write data to TV file and track file offset.
+Frame data is also sent to live relay viewers.
 ===============
 */
 static void SV_TV_FileWrite( const void *data, int len, fileHandle_t f ) {
 	unsigned int newOffset;
+	int i;
 
 	FS_Write( data, len, f );
 
+	if ( tv.relayViewerCount > 0 ) {
+		for ( i = 0; i < MAX_TV_RELAY_VIEWERS; i++ ) {
+			if ( tv.relayViewers[i].live ) {
+				SV_TV_RelaySend( &tv.relayViewers[i], data, len );
+			}
+		}
+	}
+
 	newOffset = tv.fileOffset + (unsigned int)len;
 	if ( newOffset < tv.fileOffset ) {
 		tv.fileOffsetHi++;
@@ -82,6 +392,9 @@ Feed data into the zstd compressor and flush output to file.
 */
 static void SV_TV_CompressWrite( const void *data, int len ) {
 	ZSTD_inBuffer in = { data, (size_t)len, 0 };
+	int64_t start;
+
+	start = Sys_Microseconds();
 
 	while ( in.pos < in.size ) {
 		ZSTD_outBuffer out = { tv.zstdOutBuf, ZSTD_OUT_BUF_SIZE, 0 };
@@ -90,6 +403,318 @@ static void SV_TV_CompressWrite( const void *data, int len ) {
 			SV_TV_FileWrite( tv.zstdOutBuf, (int)out.pos, tv.file );
 		}
 	}
+
+	tv.windowUsec += Sys_Microseconds() - start;
+	tv.rawBytes += len;
+}
+
+
+/*
+===============
+SV_TV_EndCompressFrame
+
+Finish the current zstd frame and flush it to file. The next
+SV_TV_CompressWrite starts a new, independently decodable frame.
+===============
+*/
+static void SV_TV_EndCompressFrame( void ) {
+	ZSTD_inBuffer in = { NULL, 0, 0 };
+	size_t ret;
+	int64_t start;
+
+	start = Sys_Microseconds();
+
+	do {
+		ZSTD_outBuffer out = { tv.zstdOutBuf, ZSTD_OUT_BUF_SIZE, 0 };
+		ret = ZSTD_compressStream2( tv.cstream, &out, &in, ZSTD_e_end );
+		if ( out.pos > 0 ) {
+			SV_TV_FileWrite( tv.zstdOutBuf, (int)out.pos, tv.file );
+		}
+	} while ( ret != 0 && !ZSTD_isError( ret ) );
+
+	tv.windowUsec += Sys_Microseconds() - start;
+
+	// The single-threaded compressor only picks up a new level
+	// when a zstd frame starts
+	if ( tv.pendingLevel != tv.compressLevel ) {
+		ZSTD_CCtx_setParameter( tv.cstream, ZSTD_c_compressionLevel, tv.pendingLevel );
+		tv.compressLevel = tv.pendingLevel;
+		tv.levelChanges++;
+	}
+}
+
+
+/*
+===============
+SV_TV_AdaptLevel
+
+Compare the average compression time of the last TV_LEVEL_WINDOW frames
+against the budget. Well under budget raises the level at the next
+keyframe. Over budget lowers it; far over budget also ends the current
+zstd frame so the cheaper level applies right away.
+===============
+*/
+static void SV_TV_AdaptLevel( void ) {
+	int avg;
+
+	if ( ++tv.windowFrames < TV_LEVEL_WINDOW ) {
+		return;
+	}
+
+	avg = (int)( tv.windowUsec / tv.windowFrames );
+	tv.lastFrameUsec = avg;
+	tv.compressUsec += tv.windowUsec;
+	tv.windowUsec = 0;
+	tv.windowFrames = 0;
+
+	if ( !tv.frameBudgetUsec ) {
+		return;
+	}
+
+	if ( avg > tv.frameBudgetUsec ) {
+		if ( tv.pendingLevel > TV_LEVEL_MIN ) {
+			tv.pendingLevel--;
+			if ( avg > tv.frameBudgetUsec * 2 ) {
+				SV_TV_EndCompressFrame();
+			}
+		}
+	} else if ( avg < tv.frameBudgetUsec / 2 ) {
+		if ( tv.pendingLevel < TV_LEVEL_MAX && tv.pendingLevel == tv.compressLevel ) {
+			tv.pendingLevel++;
+		}
+	}
+}
+
+
+/*
+===============
+SV_TV_PublishStatus
+
+Copy the writer's counters for tvstatus on the frame thread.
+===============
+*/
+static void SV_TV_PublishStatus( void ) {
+	tvWriterStatus_t status;
+
+	status.rawBytes = tv.rawBytes;
+	status.fileOffset = tv.fileOffset;
+	status.compressLevel = tv.compressLevel;
+	status.pendingLevel = tv.pendingLevel;
+	status.lastFrameUsec = tv.lastFrameUsec;
+	status.levelChanges = tv.levelChanges;
+	status.relayViewerCount = tv.relayViewerCount;
+	status.relayPeakViewers = tv.relayPeakViewers;
+	status.relayDropped = tv.relayDropped;
+
+	if ( tv.queueLock ) {
+		Sys_LockMutex( tv.queueLock );
+		tv.status = status;
+		Sys_UnlockMutex( tv.queueLock );
+	} else {
+		tv.status = status;
+	}
+}
+
+
+/*
+===============
+SV_TV_EmitFrame
+
+Compress one serialized frame and write it to file, starting a new
+zstd frame first if it is a keyframe. Runs on the writer thread when
+one is active. The compressor, the file and the relay viewers belong
+to it then; relayWantKeyframe, shared with the frame thread, is only
+set through SV_TV_SetRelayWantKeyframe.
+===============
+*/
+static void SV_TV_EmitFrame( const byte *data, unsigned int len, int keyframe ) {
+	SV_TV_RelayPoll();
+
+	if ( keyframe != -1 ) {
+		SV_TV_EndCompressFrame();
+		if ( keyframe >= 0 ) {
+			tv.keyframes[keyframe].offset = tv.fileOffset;
+		}
+		SV_TV_RelayStartViewers();
+	}
+
+	SV_TV_CompressWrite( &len, 4 );
+	SV_TV_CompressWrite( data, (int)len );
+
+	SV_TV_AdaptLevel();
+
+	SV_TV_PublishStatus();
+}
+
+
+/*
+===============
+SV_TV_WriterThread
+===============
+*/
+static void SV_TV_WriterThread( void *arg ) {
+	tvQueuedFrame_t *frame;
+
+	while ( 1 ) {
+		Sys_SemaphoreWait( tv.frameQueued );
+
+		Sys_LockMutex( tv.queueLock );
+		if ( tv.queueDepth == 0 && tv.writerShutdown ) {
+			Sys_UnlockMutex( tv.queueLock );
+			break;
+		}
+		Sys_UnlockMutex( tv.queueLock );
+
+		frame = &tv.queue[tv.queueHead];
+		SV_TV_EmitFrame( frame->data, (unsigned int)frame->len, frame->keyframe );
+		tv.queueHead = ( tv.queueHead + 1 ) % TV_QUEUE_SLOTS;
+
+		Sys_LockMutex( tv.queueLock );
+		tv.queueDepth--;
+		Sys_UnlockMutex( tv.queueLock );
+
+		Sys_SemaphorePost( tv.slotFree );
+	}
+}
+
+
+/*
+===============
+SV_TV_StopWriter
+
+Drain queued frames and shut down the writer thread.
+===============
+*/
+static void SV_TV_StopWriter( void ) {
+	int i;
+
+	if ( tv.writerThread ) {
+		Sys_LockMutex( tv.queueLock );
+		tv.writerShutdown = qtrue;
+		Sys_UnlockMutex( tv.queueLock );
+		Sys_SemaphorePost( tv.frameQueued );
+
+		Sys_JoinThread( tv.writerThread );
+		tv.writerThread = NULL;
+	}
+
+	Sys_DestroySemaphore( tv.frameQueued );
+	Sys_DestroySemaphore( tv.slotFree );
+	Sys_DestroyMutex( tv.queueLock );
+	tv.frameQueued = NULL;
+	tv.slotFree = NULL;
+	tv.queueLock = NULL;
+
+	for ( i = 0; i < TV_QUEUE_SLOTS; i++ ) {
+		free( tv.queue[i].data );
+		tv.queue[i].data = NULL;
+	}
+}
+
+
+/*
+===============
+SV_TV_StartWriter
+
+Start the background writer. Returns qfalse if threads are not
+available, in which case frames are written on the frame thread.
+===============
+*/
+static qboolean SV_TV_StartWriter( void ) {
+	int i;
+
+	for ( i = 0; i < TV_QUEUE_SLOTS; i++ ) {
+		tv.queue[i].data = malloc( MAX_TV_MSGLEN );
+		if ( !tv.queue[i].data ) {
+			SV_TV_StopWriter();
+			return qfalse;
+		}
+	}
+
+	tv.queueLock = Sys_CreateMutex();
+	tv.slotFree = Sys_CreateSemaphore( TV_QUEUE_SLOTS );
+	tv.frameQueued = Sys_CreateSemaphore( 0 );
+	if ( !tv.queueLock || !tv.slotFree || !tv.frameQueued ) {
+		SV_TV_StopWriter();
+		return qfalse;
+	}
+
+	tv.queueHead = 0;
+	tv.queueTail = 0;
+	tv.queueDepth = 0;
+	tv.writerShutdown = qfalse;
+
+	tv.writerThread = Sys_CreateThread( SV_TV_WriterThread, NULL );
+	if ( !tv.writerThread ) {
+		SV_TV_StopWriter();
+		return qfalse;
+	}
+
+	return qtrue;
+}
+
+
+/*
+===============
+SV_TV_AcquireSlot
+
+Return the buffer to serialize the next frame into, waiting
+for the writer to free a queue slot if all of them are in use.
+===============
+*/
+static byte *SV_TV_AcquireSlot( void ) {
+	int depth;
+
+	if ( !tv.writerThread ) {
+		return tv.msgBuf;
+	}
+
+	Sys_LockMutex( tv.queueLock );
+	depth = tv.queueDepth;
+	Sys_UnlockMutex( tv.queueLock );
+
+	if ( depth >= TV_QUEUE_SLOTS ) {
+		int64_t start = Sys_Microseconds();
+		Sys_SemaphoreWait( tv.slotFree );
+		tv.queueStalls++;
+		tv.queueStallUsec += Sys_Microseconds() - start;
+	} else {
+		Sys_SemaphoreWait( tv.slotFree );
+	}
+
+	return tv.queue[tv.queueTail].data;
+}
+
+
+/*
+===============
+SV_TV_SubmitFrame
+
+Hand a frame serialized into the buffer from SV_TV_AcquireSlot
+to the writer, or write it directly if there is no writer thread.
+===============
+*/
+static void SV_TV_SubmitFrame( int len, int keyframe ) {
+	tvQueuedFrame_t *frame;
+
+	if ( !tv.writerThread ) {
+		SV_TV_EmitFrame( tv.msgBuf, (unsigned int)len, keyframe );
+		return;
+	}
+
+	frame = &tv.queue[tv.queueTail];
+	frame->len = len;
+	frame->keyframe = keyframe;
+	tv.queueTail = ( tv.queueTail + 1 ) % TV_QUEUE_SLOTS;
+
+	Sys_LockMutex( tv.queueLock );
+	tv.queueDepth++;
+	if ( tv.queueDepth > tv.queueMaxDepth ) {
+		tv.queueMaxDepth = tv.queueDepth;
+	}
+	Sys_UnlockMutex( tv.queueLock );
+
+	Sys_SemaphorePost( tv.frameQueued );
 }
 
 
@@ -98,20 +723,44 @@ static void SV_TV_CompressWrite( const void *data, int len ) {
 SV_TV_DefaultName
 
 Generate a default recording name: prefer g_matchUUID, fall back to timestamp.
+Forked sv_instances append their instance number, as they start out the same.
 ===============
 */
 static const char *SV_TV_DefaultName( char *buf, int bufSize ) {
 	const char *uuid = Cvar_VariableString( "g_matchUUID" );
 	if ( uuid[0] != '\0' ) {
-		return uuid;
+		Q_strncpyz( buf, uuid, bufSize );
+	} else {
+		time_t now = time( NULL );
+		struct tm *tm_info = localtime( &now );
+		strftime( buf, bufSize, "%Y%m%d_%H%M%S", tm_info );
+	}
+	if ( sv_instance->integer ) {
+		Q_strcat( buf, bufSize, va( "_%i", sv_instance->integer ) );
 	}
-	time_t now = time( NULL );
-	struct tm *tm_info = localtime( &now );
-	strftime( buf, bufSize, "%Y%m%d_%H%M%S", tm_info );
 	return buf;
 }
 
 
+/*
+===============
+SV_TV_ReleaseCommands
+
+Drop the server commands captured for the current frame
+===============
+*/
+static void SV_TV_ReleaseCommands( void ) {
+	int i;
+
+	for ( i = 0; i < tv.cmdCount; i++ ) {
+		SV_ReleaseCommand( tv.cmds[i].cmd );
+	}
+
+	tv.cmdCount = 0;
+	tv.cmdBytes = 0;
+}
+
+
 /*
 ===============
 SV_TV_StartRecord
@@ -124,6 +773,9 @@ static void SV_TV_StartRecord( const char *filename ) {
 	char timestamp[64];
 	time_t now;
 	struct tm *tm_info;
+	void *dict;
+	int dictLen;
+	char dictPath[MAX_QPATH];
 
 	if ( sv.state != SS_GAME ) {
 		Com_Printf( "TV: Not recording, server not running.\n" );
@@ -151,11 +803,34 @@ static void SV_TV_StartRecord( const char *filename ) {
 	tv.fileOffset = 0;
 	tv.fileOffsetHi = 0;
 
+	// Optional shared dictionary, referenced from the header by its crc32.
+	// Players look it up as tvdict/<id>.dict, so one loaded under any
+	// other name is copied there
+	dict = NULL;
+	dictLen = 0;
+	if ( sv_tvDict->string[0] ) {
+		dictLen = FS_ReadFile( sv_tvDict->string, &dict );
+		if ( !dict || dictLen <= 0 || dictLen > TV_DICT_MAX_SIZE ) {
+			Com_Printf( S_COLOR_YELLOW "TV: Dictionary %s not usable, recording without it.\n", sv_tvDict->string );
+			if ( dict ) {
+				FS_FreeFile( dict );
+				dict = NULL;
+			}
+		} else {
+			tv.dictId = crc32_buffer( dict, dictLen );
+			Com_sprintf( dictPath, sizeof( dictPath ), "tvdict/%08x.dict", tv.dictId );
+			if ( Q_stricmp( sv_tvDict->string, dictPath ) && FS_ReadFile( dictPath, NULL ) != dictLen ) {
+				FS_WriteFile( dictPath, dict, dictLen );
+				Com_Printf( "TV: Copied dictionary %s to %s.\n", sv_tvDict->string, dictPath );
+			}
+		}
+	}
+
 	// Write header: magic
 	SV_TV_FileWrite( "TVD1", 4, tv.file );
 
 	// Protocol version
-	val = 1;
+	val = TVD_PROTOCOL_VERSION;
 	SV_TV_FileWrite( &val, 4, tv.file );
 
 	// sv_fps
@@ -166,6 +841,9 @@ static void SV_TV_StartRecord( const char *filename ) {
 	val = sv.maxclients;
 	SV_TV_FileWrite( &val, 4, tv.file );
 
+	// Dictionary id
+	SV_TV_FileWrite( &tv.dictId, 4, tv.file );
+
 	// Map name (null-terminated)
 	SV_TV_FileWrite( sv_mapname->string, (int)strlen( sv_mapname->string ) + 1, tv.file );
 
@@ -198,10 +876,29 @@ static void SV_TV_StartRecord( const char *filename ) {
 		SV_TV_FileWrite( &term, 2, tv.file );
 	}
 
+	// Live relay, frames are published as they are written
+	if ( sv_tvRelayPort->integer > 0 ) {
+		SV_TV_RelayOpen( timestamp );
+	}
+
 	// Init zstd streaming compressor
 	tv.cstream = ZSTD_createCStream();
-	ZSTD_CCtx_setParameter( tv.cstream, ZSTD_c_compressionLevel, -3 );
-	ZSTD_initCStream( tv.cstream, -3 );
+	tv.compressLevel = sv_tvCompressLevel->integer;
+	tv.pendingLevel = tv.compressLevel;
+	tv.frameBudgetUsec = 1000000 / sv_fps->integer * sv_tvCompressBudget->integer / 100;
+	ZSTD_initCStream( tv.cstream, tv.compressLevel );
+	if ( dict ) {
+		ZSTD_CCtx_loadDictionary( tv.cstream, dict, dictLen );
+		FS_FreeFile( dict );
+		Com_Printf( "TV: Using dictionary %s, players need it as %s.\n", sv_tvDict->string, dictPath );
+	}
+
+	SV_TV_PublishStatus();
+
+	// Compression and file I/O on a background thread if possible
+	if ( sv_tvAsync->integer && !SV_TV_StartWriter() ) {
+		Com_Printf( "TV: Background writer unavailable, writing on the frame thread.\n" );
+	}
 
 	// Zero baselines
 	Com_Memset( tv.prevEntities, 0, sizeof( tv.prevEntities ) );
@@ -211,8 +908,9 @@ static void SV_TV_StartRecord( const char *filename ) {
 
 	// Clear per-frame state
 	Com_Memset( tv.csChanged, 0, sizeof( tv.csChanged ) );
-	tv.cmdCount = 0;
-	tv.cmdBufUsed = 0;
+	SV_TV_ReleaseCommands();
+
+	tv.keyframeCount = 0;
 
 	tv.recording = qtrue;
 	tv.frameCount = 0;
@@ -240,6 +938,34 @@ void SV_TV_StartRecord_f( void ) {
 }
 
 
+/*
+===============
+SV_TV_WriteMaskRuns
+
+Write a presence mask as alternating run lengths of unchanged and
+toggled bits relative to the previous frame's mask, starting with an
+unchanged run. Keyframes compare against a zeroed mask.
+===============
+*/
+static void SV_TV_WriteMaskRuns( msg_t *msg, const byte *mask, const byte *prevMask, int count ) {
+	int i, run;
+	int toggled, bit;
+
+	run = 0;
+	toggled = 0;
+	for ( i = 0; i < count; i++ ) {
+		bit = ( ( mask[i >> 3] ^ prevMask[i >> 3] ) >> ( i & 7 ) ) & 1;
+		if ( bit != toggled ) {
+			MSG_WriteShort( msg, run );
+			run = 0;
+			toggled = bit;
+		}
+		run++;
+	}
+	MSG_WriteShort( msg, run );
+}
+
+
 /*
 ===============
 SV_TV_WriteFrame
@@ -251,7 +977,7 @@ void SV_TV_WriteFrame( void ) {
 	byte curEntityBitmask[MAX_GENTITIES/8];
 	byte curPlayerBitmask[MAX_CLIENTS/8];
 	int csCount;
-	unsigned int frameSize;
+	int keyframe;
 
 	// Check for deferred auto-start
 	if ( tv.autoPending ) {
@@ -316,15 +1042,46 @@ void SV_TV_WriteFrame( void ) {
 	// Track server time range for duration
 	if ( tv.frameCount == 0 ) {
 		tv.firstServerTime = sv.time;
+		tv.lastKeyframeTime = sv.time;
 	}
 	tv.lastServerTime = sv.time;
 
+	// Periodic keyframe: close the current zstd frame so the keyframe
+	// starts a new one that can be decoded without any earlier data,
+	// and delta from zeroed baselines so it carries the full state
+	// (the file offset is filled in by SV_TV_EmitFrame). Relay viewers
+	// waiting to join force one at most every second. Keyframes are
+	// written even once the seek table is full, only unlisted, and
+	// forced ones leave its last entries to the periodic ones.
+	keyframe = -1;
+	if ( tv.frameCount > 0 && sv_tvKeyframeInterval->integer > 0 &&
+		 sv.time - tv.lastKeyframeTime >= sv_tvKeyframeInterval->integer * 1000 ) {
+		keyframe = tv.keyframeCount < MAX_TV_KEYFRAMES ? tv.keyframeCount : TV_KEYFRAME_UNLISTED;
+	} else if ( tv.frameCount > 0 && sv.time - tv.lastKeyframeTime >= 1000 && SV_TV_RelayWantKeyframe() ) {
+		keyframe = tv.keyframeCount < MAX_TV_KEYFRAMES - TV_RELAY_KEYFRAME_RESERVE ? tv.keyframeCount : TV_KEYFRAME_UNLISTED;
+	}
+
+	if ( keyframe != -1 ) {
+		SV_TV_SetRelayWantKeyframe( qfalse );
+		if ( keyframe >= 0 ) {
+			tv.keyframes[keyframe].serverTime = sv.time;
+			tv.keyframeCount++;
+		}
+		tv.lastKeyframeTime = sv.time;
+
+		Com_Memset( tv.prevEntities, 0, sizeof( tv.prevEntities ) );
+		Com_Memset( tv.prevEntityBitmask, 0, sizeof( tv.prevEntityBitmask ) );
+		Com_Memset( tv.prevPlayers, 0, sizeof( tv.prevPlayers ) );
+		Com_Memset( tv.prevPlayerBitmask, 0, sizeof( tv.prevPlayerBitmask ) );
+	}
+
 	// Init message buffer
-	MSG_Init( &msg, tv.msgBuf, MAX_TV_MSGLEN );
-	MSG_Bitstream( &msg );
+	MSG_Init( &msg, SV_TV_AcquireSlot(), MAX_TV_MSGLEN );
+	MSG_Rawstream( &msg );
 
-	// Write server time
+	// Write server time and frame flags
 	MSG_WriteLong( &msg, sv.time );
+	MSG_WriteByte( &msg, keyframe != -1 ? TVD_FRAME_KEYFRAME : 0 );
 
 	// --- Entity encoding ---
 	Com_Memset( curEntityBitmask, 0, sizeof( curEntityBitmask ) );
@@ -337,20 +1094,29 @@ void SV_TV_WriteFrame( void ) {
 		}
 	}
 
-	// Write entity bitmask
-	MSG_WriteData( &msg, curEntityBitmask, sizeof( curEntityBitmask ) );
+	SV_TV_WriteMaskRuns( &msg, curEntityBitmask, tv.prevEntityBitmask, MAX_GENTITIES );
 
-	// Write delta-encoded entities
+	// Write delta-encoded entities, skipping unchanged ones outright.
+	// Entities that left are zeroed so reappearing ones get a full delta.
 	for ( i = 0; i < MAX_GENTITIES; i++ ) {
 		entityState_t *es;
 
 		if ( !( curEntityBitmask[i >> 3] & ( 1 << ( i & 7 ) ) ) ) {
+			if ( tv.prevEntityBitmask[i >> 3] & ( 1 << ( i & 7 ) ) ) {
+				Com_Memset( &tv.prevEntities[i], 0, sizeof( entityState_t ) );
+			}
 			continue;
 		}
 
 		es = &SV_GentityNum( i )->s;
+		if ( !memcmp( &tv.prevEntities[i], es, sizeof( entityState_t ) ) ) {
+			continue;
+		}
+
 		MSG_WriteDeltaEntity( &msg, &tv.prevEntities[i], es, qfalse );
+		tv.prevEntities[i] = *es;
 	}
+	Com_Memcpy( tv.prevEntityBitmask, curEntityBitmask, sizeof( curEntityBitmask ) );
 
 	// Entity end marker
 	MSG_WriteBits( &msg, MAX_GENTITIES - 1, GENTITYNUM_BITS );
@@ -364,23 +1130,40 @@ void SV_TV_WriteFrame( void ) {
 		}
 	}
 
-	// Write player bitmask
-	MSG_WriteData( &msg, curPlayerBitmask, sizeof( curPlayerBitmask ) );
+	SV_TV_WriteMaskRuns( &msg, curPlayerBitmask, tv.prevPlayerBitmask, MAX_CLIENTS );
 
-	// Write delta-encoded players
-	for ( i = 0; i < sv.maxclients; i++ ) {
+	// Write delta-encoded players that changed, terminated by 255
+	for ( i = 0; i < MAX_CLIENTS; i++ ) {
 		playerState_t *ps;
 
 		if ( !( curPlayerBitmask[i >> 3] & ( 1 << ( i & 7 ) ) ) ) {
+			if ( tv.prevPlayerBitmask[i >> 3] & ( 1 << ( i & 7 ) ) ) {
+				Com_Memset( &tv.prevPlayers[i], 0, sizeof( playerState_t ) );
+			}
 			continue;
 		}
 
 		ps = SV_GameClientNum( i );
+		if ( !memcmp( &tv.prevPlayers[i], ps, sizeof( playerState_t ) ) ) {
+			continue;
+		}
+
 		MSG_WriteByte( &msg, i );
 		MSG_WriteDeltaPlayerstate( &msg, &tv.prevPlayers[i], ps );
+		tv.prevPlayers[i] = *ps;
 	}
+	Com_Memcpy( tv.prevPlayerBitmask, curPlayerBitmask, sizeof( curPlayerBitmask ) );
+
+	MSG_WriteByte( &msg, 255 );
 
 	// --- Configstring changes ---
+	// Keyframes carry every non-empty configstring instead of just the changes
+	if ( keyframe != -1 ) {
+		for ( i = 0; i < MAX_CONFIGSTRINGS; i++ ) {
+			tv.csChanged[i] = ( sv.configstrings[i] && sv.configstrings[i][0] != '\0' );
+		}
+	}
+
 	csCount = 0;
 	for ( i = 0; i < MAX_CONFIGSTRINGS; i++ ) {
 		if ( tv.csChanged[i] ) {
@@ -412,12 +1195,11 @@ void SV_TV_WriteFrame( void ) {
 
 	for ( i = 0; i < tv.cmdCount; i++ ) {
 		MSG_WriteByte( &msg, tv.cmds[i].target == -1 ? 255 : (byte)tv.cmds[i].target );
-		MSG_WriteShort( &msg, tv.cmds[i].len );
-		MSG_WriteData( &msg, tv.cmdBuf + tv.cmds[i].offset, tv.cmds[i].len );
+		MSG_WriteShort( &msg, tv.cmds[i].cmd->len );
+		MSG_WriteData( &msg, tv.cmds[i].cmd->text, tv.cmds[i].cmd->len );
 	}
 
-	tv.cmdCount = 0;
-	tv.cmdBufUsed = 0;
+	SV_TV_ReleaseCommands();
 
 	// --- Flush to file ---
 	if ( msg.overflowed ) {
@@ -426,29 +1208,7 @@ void SV_TV_WriteFrame( void ) {
 		return;
 	}
 
-	frameSize = (unsigned int)msg.cursize;
-	SV_TV_CompressWrite( &frameSize, 4 );
-	SV_TV_CompressWrite( msg.data, msg.cursize );
-
-	// Save current state as previous for next delta.
-	// Zero removed entities/players so reappearing ones get a full delta.
-	for ( i = 0; i < MAX_GENTITIES; i++ ) {
-		if ( curEntityBitmask[i >> 3] & ( 1 << ( i & 7 ) ) ) {
-			tv.prevEntities[i] = SV_GentityNum( i )->s;
-		} else {
-			Com_Memset( &tv.prevEntities[i], 0, sizeof( entityState_t ) );
-		}
-	}
-	Com_Memcpy( tv.prevEntityBitmask, curEntityBitmask, sizeof( curEntityBitmask ) );
-
-	for ( i = 0; i < sv.maxclients; i++ ) {
-		if ( curPlayerBitmask[i >> 3] & ( 1 << ( i & 7 ) ) ) {
-			tv.prevPlayers[i] = *SV_GameClientNum( i );
-		} else {
-			Com_Memset( &tv.prevPlayers[i], 0, sizeof( playerState_t ) );
-		}
-	}
-	Com_Memcpy( tv.prevPlayerBitmask, curPlayerBitmask, sizeof( curPlayerBitmask ) );
+	SV_TV_SubmitFrame( msg.cursize, keyframe );
 
 	tv.frameCount++;
 }
@@ -471,9 +1231,21 @@ void SV_TV_StopRecord( qboolean discard ) {
 		return;
 	}
 
+	SV_TV_ReleaseCommands();
+
 	Com_sprintf( tmpPath, sizeof( tmpPath ), "%s.tvd.tmp", tv.recordingPath );
 
+	// Let the writer finish queued frames before touching the stream
+	if ( tv.writerThread ) {
+		SV_TV_StopWriter();
+
+		Com_Printf( "TV: Writer queue max depth %i/%i, %i stalls (%i msec).\n",
+			tv.queueMaxDepth, TV_QUEUE_SLOTS, tv.queueStalls, (int)( tv.queueStallUsec / 1000 ) );
+	}
+
 	if ( discard ) {
+		SV_TV_RelayClose();
+
 		// Free compressor, close and delete the file without finalizing
 		if ( tv.cstream ) {
 			ZSTD_freeCStream( tv.cstream );
@@ -485,27 +1257,27 @@ void SV_TV_StopRecord( qboolean discard ) {
 	} else {
 		char finalPath[MAX_QPATH];
 		int durationMsec;
+		unsigned int compressedBytes;
+		int i;
 		int val;
-		size_t ret;
 
 		// Flush and end the zstd stream
 		if ( tv.cstream ) {
-			ZSTD_inBuffer in = { NULL, 0, 0 };
-			do {
-				ZSTD_outBuffer out = { tv.zstdOutBuf, ZSTD_OUT_BUF_SIZE, 0 };
-				ret = ZSTD_compressStream2( tv.cstream, &out, &in, ZSTD_e_end );
-				if ( out.pos > 0 ) {
-					SV_TV_FileWrite( tv.zstdOutBuf, (int)out.pos, tv.file );
-				}
-			} while ( ret != 0 );
+			SV_TV_EndCompressFrame();
 			ZSTD_freeCStream( tv.cstream );
 			tv.cstream = NULL;
 		}
 
+		// Relay viewers get the complete stream, but not the trailer
+		SV_TV_RelayClose();
+
+		compressedBytes = tv.fileOffset;
+
 		// Write uncompressed k/v trailer:
 		//   "TVDt"  magic
 		//   repeated: key\0 + valueLen:2 + valueData
 		//   \0       terminator (empty key)
+		// Keys: "dur" duration msec:4, "kf" keyframes (serverTime:4 + offset:4)[]
 		//   size:4   trailer total size (for EOF-4 seeking)
 		{
 			unsigned int trailerStart = tv.fileOffset;
@@ -520,6 +1292,16 @@ void SV_TV_StopRecord( qboolean discard ) {
 			SV_TV_FileWrite( &vlen, 2, tv.file );
 			SV_TV_FileWrite( &durationMsec, 4, tv.file );
 
+			if ( tv.keyframeCount > 0 ) {
+				SV_TV_FileWrite( "kf", 3, tv.file );
+				vlen = (unsigned short)( tv.keyframeCount * 8 );
+				SV_TV_FileWrite( &vlen, 2, tv.file );
+				for ( i = 0; i < tv.keyframeCount; i++ ) {
+					SV_TV_FileWrite( &tv.keyframes[i].serverTime, 4, tv.file );
+					SV_TV_FileWrite( &tv.keyframes[i].offset, 4, tv.file );
+				}
+			}
+
 			SV_TV_FileWrite( "", 1, tv.file );           // terminator
 
 			val = (int)( tv.fileOffset - trailerStart + 4 ); // +4 for this field itself
@@ -537,8 +1319,12 @@ void SV_TV_StopRecord( qboolean discard ) {
 
 		duration = (float)durationMsec / 1000.0f;
 
-		Com_Printf( "TV: Recording stopped. %i frames (%.1f seconds), %u bytes.\n",
-			tv.frameCount, duration, tv.fileOffset );
+		Com_Printf( "TV: Recording stopped. %i frames (%.1f seconds), %i keyframes, %u bytes.\n",
+			tv.frameCount, duration, tv.keyframeCount, tv.fileOffset );
+		Com_Printf( "TV: Compression %.2f:1 (%i KB of frames), level %i at the end, %i level changes, %i usec/frame.\n",
+			compressedBytes ? (double)tv.rawBytes / compressedBytes : 0.0, (int)( tv.rawBytes / 1024 ),
+			tv.compressLevel, tv.levelChanges,
+			tv.frameCount ? (int)( ( tv.compressUsec + tv.windowUsec ) / tv.frameCount ) : 0 );
 	}
 
 	tv.recording = qfalse;
@@ -561,6 +1347,306 @@ void SV_TV_StopRecord_f( void ) {
 }
 
 
+/*
+=============================================================================
+
+DICTIONARY TRAINING
+
+=============================================================================
+*/
+
+#define TV_DICT_MIN_SAMPLE		4096	// bytes taken from each recording at least
+#define TV_DICT_SAMPLE_STRIDE	8		// frames skipped between samples after the first
+
+typedef struct {
+	fileHandle_t	file;
+	ZSTD_DStream	*dstream;
+	byte			in[ZSTD_OUT_BUF_SIZE];
+	ZSTD_inBuffer	inBuf;
+	byte			out[ZSTD_OUT_BUF_SIZE];
+	int				outSize;
+	int				outPos;
+	qboolean		eof;
+} tvDictSource_t;
+
+
+static int SV_TV_DictHeaderRead( void *ctx, void *buf, int len ) {
+	return FS_Read( buf, len, ( (tvDictSource_t *)ctx )->file );
+}
+
+
+/*
+===============
+SV_TV_DictRead
+
+Read decompressed frame data. Stops at the first error, which includes
+running into the trailer after the last zstd frame.
+===============
+*/
+static qboolean SV_TV_DictRead( tvDictSource_t *src, void *buf, int len ) {
+	byte *dst = buf;
+
+	while ( len > 0 ) {
+		if ( src->outPos < src->outSize ) {
+			int n = src->outSize - src->outPos;
+			if ( n > len ) {
+				n = len;
+			}
+			Com_Memcpy( dst, src->out + src->outPos, n );
+			src->outPos += n;
+			dst += n;
+			len -= n;
+			continue;
+		}
+
+		if ( src->inBuf.pos >= src->inBuf.size ) {
+			int n;
+
+			if ( src->eof ) {
+				return qfalse;
+			}
+			n = FS_Read( src->in, sizeof( src->in ), src->file );
+			if ( n <= 0 ) {
+				src->eof = qtrue;
+				return qfalse;
+			}
+			src->inBuf.src = src->in;
+			src->inBuf.size = n;
+			src->inBuf.pos = 0;
+		}
+
+		{
+			ZSTD_outBuffer out = { src->out, sizeof( src->out ), 0 };
+			size_t ret = ZSTD_decompressStream( src->dstream, &out, &src->inBuf );
+			if ( ZSTD_isError( ret ) ) {
+				return qfalse;
+			}
+			src->outSize = (int)out.pos;
+			src->outPos = 0;
+		}
+	}
+
+	return qtrue;
+}
+
+
+/*
+===============
+SV_TV_SampleDemo
+
+Append frame records from one recording to the sample buffer: the first
+frame (a keyframe) whole, then every TV_DICT_SAMPLE_STRIDE-th frame until
+budget bytes are taken. Returns the number of bytes added.
+===============
+*/
+static int SV_TV_SampleDemo( const char *path, byte *out, int budget, byte *frame ) {
+	tvDictSource_t *src;
+	tvdHeader_t header;
+	void *dict;
+	unsigned int frameSize;
+	int used, frameNum;
+
+	src = calloc( 1, sizeof( *src ) );
+	if ( !src ) {
+		return 0;
+	}
+
+	if ( FS_FOpenFileRead( path, &src->file, qtrue ) <= 0 || !src->file ) {
+		free( src );
+		return 0;
+	}
+
+	used = 0;
+	if ( !TVD_ReadHeader( SV_TV_DictHeaderRead, NULL, src, &header ) ) {
+		Com_Printf( "TV: Skipping %s: %s\n", path, header.error[0] ? header.error : "truncated header" );
+		goto done;
+	}
+
+	src->dstream = ZSTD_createDStream();
+	ZSTD_initDStream( src->dstream );
+
+	// Recordings made with an earlier dictionary need it to decompress
+	if ( header.dictId ) {
+		int dictLen = FS_ReadFile( va( "tvdict/%08x.dict", header.dictId ), &dict );
+		if ( !dict ) {
+			Com_Printf( "TV: Skipping %s: needs dictionary tvdict/%08x.dict\n", path, header.dictId );
+			goto done;
+		}
+		ZSTD_DCtx_loadDictionary( src->dstream, dict, dictLen );
+		FS_FreeFile( dict );
+	}
+
+	for ( frameNum = 0; used < budget; frameNum++ ) {
+		int len;
+
+		if ( !SV_TV_DictRead( src, &frameSize, 4 ) || frameSize == 0 || frameSize > MAX_TV_MSGLEN ||
+			 !SV_TV_DictRead( src, frame, frameSize ) ) {
+			break;
+		}
+
+		if ( frameNum != 0 && frameNum % TV_DICT_SAMPLE_STRIDE ) {
+			continue;
+		}
+
+		// Keep records as they appear in the stream: size:4 + payload
+		len = 4 + (int)frameSize;
+		if ( len > budget - used ) {
+			len = budget - used;
+		}
+		Com_Memcpy( out + used, &frameSize, len < 4 ? len : 4 );
+		if ( len > 4 ) {
+			Com_Memcpy( out + used + 4, frame, len - 4 );
+		}
+		used += len;
+	}
+
+done:
+	if ( src->dstream ) {
+		ZSTD_freeDStream( src->dstream );
+	}
+	FS_FCloseFile( src->file );
+	free( src );
+
+	return used;
+}
+
+
+/*
+===============
+SV_TV_TrainDict_f
+
+tvtraindict [dir] [sizeKB]
+
+Build a zstd dictionary from frames sampled across existing recordings
+and write it as tvdict/<id>.dict, where id is its crc32. The bundled zstd
+has no dictionary trainer, so this is a raw content dictionary; files
+made with "zstd --train" can be used with sv_tvDict as well.
+===============
+*/
+void SV_TV_TrainDict_f( void ) {
+	const char *dir;
+	char **files;
+	char path[MAX_QPATH];
+	byte *samples, *frame;
+	int numFiles, dictSize, budget, used, demos;
+	unsigned int dictId;
+	int i;
+
+	dir = ( Cmd_Argc() >= 2 ) ? Cmd_Argv( 1 ) : sv_tvpath->string;
+	dictSize = ( Cmd_Argc() >= 3 ) ? atoi( Cmd_Argv( 2 ) ) * 1024 : TV_DICT_DEFAULT_SIZE;
+	if ( dictSize < 1024 || dictSize > TV_DICT_MAX_SIZE ) {
+		Com_Printf( "usage: tvtraindict [dir] [sizeKB 1-%i]\n", TV_DICT_MAX_SIZE / 1024 );
+		return;
+	}
+
+	files = FS_ListFiles( dir, ".tvd", &numFiles );
+	if ( numFiles == 0 ) {
+		Com_Printf( "TV: No .tvd files in %s.\n", dir );
+		FS_FreeFileList( files );
+		return;
+	}
+
+	samples = malloc( dictSize );
+	frame = malloc( MAX_TV_MSGLEN );
+	if ( !samples || !frame ) {
+		free( samples );
+		free( frame );
+		FS_FreeFileList( files );
+		Com_Printf( "TV: Out of memory.\n" );
+		return;
+	}
+
+	// Spread the dictionary across recordings
+	budget = dictSize / numFiles;
+	if ( budget < TV_DICT_MIN_SAMPLE ) {
+		budget = TV_DICT_MIN_SAMPLE;
+	}
+
+	used = 0;
+	demos = 0;
+	for ( i = 0; i < numFiles && used < dictSize; i++ ) {
+		int n;
+
+		Com_sprintf( path, sizeof( path ), "%s/%s", dir, files[i] );
+		n = SV_TV_SampleDemo( path, samples + used, MIN( budget, dictSize - used ), frame );
+		if ( n > 0 ) {
+			used += n;
+			demos++;
+		}
+	}
+
+	FS_FreeFileList( files );
+	free( frame );
+
+	if ( used < 1024 ) {
+		Com_Printf( "TV: Not enough frame data in %s to build a dictionary.\n", dir );
+		free( samples );
+		return;
+	}
+
+	dictId = crc32_buffer( samples, used );
+	Com_sprintf( path, sizeof( path ), "tvdict/%08x.dict", dictId );
+	FS_WriteFile( path, samples, used );
+	free( samples );
+
+	Com_Printf( "TV: Wrote %s, %i bytes from %i recordings. Set sv_tvDict to %s to use it.\n",
+		path, used, demos, path );
+}
+
+
+/*
+===============
+SV_TV_Status_f
+
+Print recording and compression statistics. Counters owned by the
+writer thread come from the copy it publishes after each frame.
+===============
+*/
+void SV_TV_Status_f( void ) {
+	tvWriterStatus_t status;
+	int budget;
+
+	if ( !tv.recording ) {
+		Com_Printf( "TV: Not recording.\n" );
+		return;
+	}
+
+	if ( tv.queueLock ) {
+		Sys_LockMutex( tv.queueLock );
+		status = tv.status;
+		Sys_UnlockMutex( tv.queueLock );
+	} else {
+		status = tv.status;
+	}
+
+	Com_Printf( "recording:   %s.tvd\n", tv.recordingPath );
+	Com_Printf( "frames:      %i (%.1f seconds), %i keyframes\n", tv.frameCount,
+		( tv.lastServerTime - tv.firstServerTime ) / 1000.0f, tv.keyframeCount );
+	Com_Printf( "size:        %i KB of frames -> %u KB, %.2f:1\n", (int)( status.rawBytes / 1024 ),
+		status.fileOffset / 1024, status.fileOffset ? (double)status.rawBytes / status.fileOffset : 0.0 );
+
+	budget = tv.frameBudgetUsec;
+	if ( budget ) {
+		Com_Printf( "level:       %i (next frame %i), %i changes\n", status.compressLevel, status.pendingLevel, status.levelChanges );
+		Com_Printf( "compression: %i usec/frame, budget %i usec (%i%% of %i fps)\n",
+			status.lastFrameUsec, budget, sv_tvCompressBudget->integer, sv_fps->integer );
+	} else {
+		Com_Printf( "level:       %i (fixed)\n", status.compressLevel );
+		Com_Printf( "compression: %i usec/frame\n", status.lastFrameUsec );
+	}
+
+	if ( tv.dictId ) {
+		Com_Printf( "dictionary:  tvdict/%08x.dict\n", tv.dictId );
+	}
+	Com_Printf( "writer:      %s, queue max depth %i/%i, %i stalls\n",
+		tv.writerThread ? "background" : "frame thread", tv.queueMaxDepth, TV_QUEUE_SLOTS, tv.queueStalls );
+	if ( tv.relayListener ) {
+		Com_Printf( "relay:       %i viewers (peak %i), %i dropped\n",
+			status.relayViewerCount, status.relayPeakViewers, status.relayDropped );
+	}
+}
+
+
 /*
 ===============
 SV_TV_ConfigstringChanged
@@ -578,23 +1664,19 @@ void SV_TV_ConfigstringChanged( int index ) {
 SV_TV_CaptureServerCommand
 ===============
 */
-void SV_TV_CaptureServerCommand( int target, const char *cmd ) {
-	int len;
-
+void SV_TV_CaptureServerCommand( int target, svCommand_t *cmd ) {
 	if ( tv.cmdCount >= MAX_TV_CMDS ) {
 		return;
 	}
 
-	len = (int)strlen( cmd );
-	if ( tv.cmdBufUsed + len > MAX_TV_CMDBUF ) {
+	if ( tv.cmdBytes + cmd->len > MAX_TV_CMDBUF ) {
 		return;
 	}
 
+	cmd->refCount++;
 	tv.cmds[tv.cmdCount].target = target;
-	tv.cmds[tv.cmdCount].offset = tv.cmdBufUsed;
-	tv.cmds[tv.cmdCount].len = len;
-	Com_Memcpy( tv.cmdBuf + tv.cmdBufUsed, cmd, len );
-	tv.cmdBufUsed += len;
+	tv.cmds[tv.cmdCount].cmd = cmd;
+	tv.cmdBytes += cmd->len;
 	tv.cmdCount++;
 }
 
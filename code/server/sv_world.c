@@ -48,6 +48,422 @@ clipHandle_t SV_ClipHandleForEntity( const sharedEntity_t *ent ) {
 
 
 
+/*
+============================================================================
+
+AREA TREE
+
+With sv_areaTree set, linked entities are kept in a dynamic bounding
+volume tree instead of the sectors: a binary tree with an entity at each
+leaf, where every node has the box around everything below it. Leaves
+are inserted next to the sibling that grows the surface area the least
+and the tree is rebalanced on the way back up, so it stays about
+log2( entities ) deep however the entities are spread over the map.
+
+A leaf keeps the entity box grown by AREA_TREE_MARGIN, and relinking an
+entity that is still inside that box doesn't touch the tree, so players
+moving a little each frame mostly cost nothing.
+============================================================================
+*/
+
+#define AREA_TREE_NODES		( MAX_GENTITIES * 2 )	// node 0 is unused
+#define AREA_TREE_MARGIN	16.0f
+
+typedef struct {
+	vec3_t	mins, maxs;		// leaves: the entity box with the margin
+	int		parent;			// next on the free list for free nodes
+	int		children[2];	// 0 for leaves
+	int		height;			// 0 for leaves
+	int		entityNum;		// leaves
+} areaNode_t;
+
+static struct {
+	areaNode_t	nodes[ AREA_TREE_NODES ];
+	int			root;
+	int			freeList;
+	int			numLeafs;
+} areaTree;
+
+static qboolean	sv_useAreaTree;		// sv_areaTree when the map was loaded
+
+
+/*
+===============
+SV_AreaTreeClear
+===============
+*/
+static void SV_AreaTreeClear( void ) {
+	int i;
+
+	Com_Memset( &areaTree, 0, sizeof( areaTree ) );
+
+	for ( i = 1; i < AREA_TREE_NODES - 1; i++ ) {
+		areaTree.nodes[i].parent = i + 1;
+	}
+	areaTree.freeList = 1;
+}
+
+
+/*
+===============
+SV_AreaTreeAllocNode
+===============
+*/
+static int SV_AreaTreeAllocNode( void ) {
+	areaNode_t *node;
+	int nodeNum;
+
+	nodeNum = areaTree.freeList;
+	if ( !nodeNum ) {
+		Com_Error( ERR_DROP, "SV_AreaTreeAllocNode: no free nodes" );
+	}
+
+	node = &areaTree.nodes[ nodeNum ];
+	areaTree.freeList = node->parent;
+	Com_Memset( node, 0, sizeof( *node ) );
+
+	return nodeNum;
+}
+
+
+/*
+===============
+SV_AreaTreeFreeNode
+===============
+*/
+static void SV_AreaTreeFreeNode( int nodeNum ) {
+	areaTree.nodes[ nodeNum ].parent = areaTree.freeList;
+	areaTree.freeList = nodeNum;
+}
+
+
+/*
+===============
+SV_AreaTreeArea
+
+Half the surface area of the box, the cost of a node being visited.
+===============
+*/
+static float SV_AreaTreeArea( const vec3_t mins, const vec3_t maxs ) {
+	float dx, dy, dz;
+
+	dx = maxs[0] - mins[0];
+	dy = maxs[1] - mins[1];
+	dz = maxs[2] - mins[2];
+
+	return dx * dy + dy * dz + dz * dx;
+}
+
+
+/*
+===============
+SV_AreaTreeUnion
+===============
+*/
+static void SV_AreaTreeUnion( const areaNode_t *a, const areaNode_t *b, vec3_t mins, vec3_t maxs ) {
+	int i;
+
+	for ( i = 0; i < 3; i++ ) {
+		mins[i] = a->mins[i] < b->mins[i] ? a->mins[i] : b->mins[i];
+		maxs[i] = a->maxs[i] > b->maxs[i] ? a->maxs[i] : b->maxs[i];
+	}
+}
+
+
+/*
+===============
+SV_AreaTreeRefit
+
+Sets the box and height of an interior node from its children.
+===============
+*/
+static void SV_AreaTreeRefit( areaNode_t *node ) {
+	const areaNode_t *a, *b;
+
+	a = &areaTree.nodes[ node->children[0] ];
+	b = &areaTree.nodes[ node->children[1] ];
+
+	SV_AreaTreeUnion( a, b, node->mins, node->maxs );
+	node->height = 1 + ( a->height > b->height ? a->height : b->height );
+}
+
+
+/*
+===============
+SV_AreaTreeReplaceChild
+===============
+*/
+static void SV_AreaTreeReplaceChild( int parent, int oldChild, int newChild ) {
+	areaNode_t *node;
+
+	if ( !parent ) {
+		areaTree.root = newChild;
+		return;
+	}
+
+	node = &areaTree.nodes[ parent ];
+	if ( node->children[0] == oldChild ) {
+		node->children[0] = newChild;
+	} else {
+		node->children[1] = newChild;
+	}
+}
+
+
+/*
+===============
+SV_AreaTreeRotate
+
+The taller child of a takes its place, with its shorter child given
+to a in exchange. Side is which child of a is raised.
+===============
+*/
+static int SV_AreaTreeRotate( int a, int side ) {
+	areaNode_t *nodeA, *nodeB, *nodeF, *nodeG;
+	int b, f, g;
+
+	nodeA = &areaTree.nodes[ a ];
+	b = nodeA->children[ side ];
+	nodeB = &areaTree.nodes[ b ];
+	f = nodeB->children[0];
+	g = nodeB->children[1];
+	nodeF = &areaTree.nodes[ f ];
+	nodeG = &areaTree.nodes[ g ];
+
+	// b goes where a was, with a as its first child
+	nodeB->children[0] = a;
+	nodeB->parent = nodeA->parent;
+	nodeA->parent = b;
+	SV_AreaTreeReplaceChild( nodeB->parent, a, b );
+
+	// b keeps the taller of its old children, a gets the other
+	if ( nodeF->height > nodeG->height ) {
+		nodeB->children[1] = f;
+		nodeA->children[ side ] = g;
+		nodeG->parent = a;
+	} else {
+		nodeB->children[1] = g;
+		nodeA->children[ side ] = f;
+		nodeF->parent = a;
+	}
+
+	SV_AreaTreeRefit( nodeA );
+	SV_AreaTreeRefit( nodeB );
+
+	return b;
+}
+
+
+/*
+===============
+SV_AreaTreeBalance
+
+Returns the node that is in place of nodeNum afterwards.
+===============
+*/
+static int SV_AreaTreeBalance( int nodeNum ) {
+	const areaNode_t *node;
+	int balance;
+
+	node = &areaTree.nodes[ nodeNum ];
+	if ( node->height < 2 ) {
+		return nodeNum;
+	}
+
+	balance = areaTree.nodes[ node->children[1] ].height - areaTree.nodes[ node->children[0] ].height;
+	if ( balance > 1 ) {
+		return SV_AreaTreeRotate( nodeNum, 1 );
+	}
+	if ( balance < -1 ) {
+		return SV_AreaTreeRotate( nodeNum, 0 );
+	}
+
+	return nodeNum;
+}
+
+
+/*
+===============
+SV_AreaTreeFixUpwards
+
+Refits and rebalances from nodeNum to the root.
+===============
+*/
+static void SV_AreaTreeFixUpwards( int nodeNum ) {
+	areaNode_t *node;
+
+	while ( nodeNum ) {
+		nodeNum = SV_AreaTreeBalance( nodeNum );
+		node = &areaTree.nodes[ nodeNum ];
+		SV_AreaTreeRefit( node );
+		nodeNum = node->parent;
+	}
+}
+
+
+/*
+===============
+SV_AreaTreeInsert
+===============
+*/
+static void SV_AreaTreeInsert( int leaf ) {
+	areaNode_t *leafNode, *node, *child, *newParent;
+	vec3_t mins, maxs;
+	float area, combinedArea, cost, inheritCost, childCost[2];
+	int nodeNum, sibling, oldParent, parent, i;
+
+	leafNode = &areaTree.nodes[ leaf ];
+
+	if ( !areaTree.root ) {
+		areaTree.root = leaf;
+		leafNode->parent = 0;
+		return;
+	}
+
+	// find the sibling that makes the tree cheapest to search
+	nodeNum = areaTree.root;
+	while ( areaTree.nodes[ nodeNum ].children[0] ) {
+		node = &areaTree.nodes[ nodeNum ];
+
+		area = SV_AreaTreeArea( node->mins, node->maxs );
+		SV_AreaTreeUnion( node, leafNode, mins, maxs );
+		combinedArea = SV_AreaTreeArea( mins, maxs );
+
+		// a new parent for this node and the leaf
+		cost = 2.0f * combinedArea;
+
+		// the minimum cost of pushing the leaf further down
+		inheritCost = 2.0f * ( combinedArea - area );
+
+		for ( i = 0; i < 2; i++ ) {
+			child = &areaTree.nodes[ node->children[i] ];
+			SV_AreaTreeUnion( child, leafNode, mins, maxs );
+			childCost[i] = SV_AreaTreeArea( mins, maxs ) + inheritCost;
+			if ( child->children[0] ) {
+				childCost[i] -= SV_AreaTreeArea( child->mins, child->maxs );
+			}
+		}
+
+		if ( cost < childCost[0] && cost < childCost[1] ) {
+			break;
+		}
+
+		nodeNum = node->children[ childCost[1] < childCost[0] ];
+	}
+	sibling = nodeNum;
+
+	// a new parent in place of the sibling
+	oldParent = areaTree.nodes[ sibling ].parent;
+	parent = SV_AreaTreeAllocNode();
+	newParent = &areaTree.nodes[ parent ];
+	newParent->parent = oldParent;
+	newParent->children[0] = sibling;
+	newParent->children[1] = leaf;
+	SV_AreaTreeReplaceChild( oldParent, sibling, parent );
+
+	areaTree.nodes[ sibling ].parent = parent;
+	leafNode->parent = parent;
+
+	SV_AreaTreeFixUpwards( parent );
+}
+
+
+/*
+===============
+SV_AreaTreeRemove
+
+Takes the leaf out of the tree, it is still allocated.
+===============
+*/
+static void SV_AreaTreeRemove( int leaf ) {
+	const areaNode_t *parentNode;
+	int parent, grandParent, sibling;
+
+	if ( leaf == areaTree.root ) {
+		areaTree.root = 0;
+		return;
+	}
+
+	parent = areaTree.nodes[ leaf ].parent;
+	parentNode = &areaTree.nodes[ parent ];
+	grandParent = parentNode->parent;
+	sibling = parentNode->children[ parentNode->children[0] == leaf ];
+
+	// the sibling takes the place of the parent
+	SV_AreaTreeReplaceChild( grandParent, parent, sibling );
+	areaTree.nodes[ sibling ].parent = grandParent;
+	SV_AreaTreeFreeNode( parent );
+
+	SV_AreaTreeFixUpwards( grandParent );
+}
+
+
+/*
+===============
+SV_AreaTreeLink
+
+Puts the entity in the tree for its new absmin / absmax, unless it is
+still inside the box its leaf already has.
+===============
+*/
+static void SV_AreaTreeLink( svEntity_t *ent, const sharedEntity_t *gEnt ) {
+	areaNode_t *node;
+	int i;
+
+	if ( ent->areaLeaf ) {
+		node = &areaTree.nodes[ ent->areaLeaf ];
+		for ( i = 0; i < 3; i++ ) {
+			if ( gEnt->r.absmin[i] < node->mins[i] || gEnt->r.absmax[i] > node->maxs[i] ) {
+				break;		// moved out
+			}
+			if ( gEnt->r.absmin[i] - node->mins[i] > 4 * AREA_TREE_MARGIN
+				|| node->maxs[i] - gEnt->r.absmax[i] > 4 * AREA_TREE_MARGIN ) {
+				break;		// shrunk, like a dead player
+			}
+		}
+		if ( i == 3 ) {
+			return;
+		}
+		SV_AreaTreeRemove( ent->areaLeaf );
+	} else {
+		ent->areaLeaf = SV_AreaTreeAllocNode();
+		node = &areaTree.nodes[ ent->areaLeaf ];
+		node->entityNum = ent - sv.svEntities;
+		areaTree.numLeafs++;
+	}
+
+	for ( i = 0; i < 3; i++ ) {
+		node->mins[i] = gEnt->r.absmin[i] - AREA_TREE_MARGIN;
+		node->maxs[i] = gEnt->r.absmax[i] + AREA_TREE_MARGIN;
+	}
+
+	SV_AreaTreeInsert( ent->areaLeaf );
+}
+
+
+/*
+===============
+SV_AreaTreeUnlink
+===============
+*/
+static void SV_AreaTreeUnlink( svEntity_t *ent ) {
+	SV_AreaTreeRemove( ent->areaLeaf );
+	SV_AreaTreeFreeNode( ent->areaLeaf );
+	ent->areaLeaf = 0;
+	areaTree.numLeafs--;
+}
+
+
+/*
+===============
+SV_AreaTreeHeight
+===============
+*/
+static int SV_AreaTreeHeight( void ) {
+	return areaTree.root ? areaTree.nodes[ areaTree.root ].height : 0;
+}
+
+
 /*
 ===============================================================================
 
@@ -58,6 +474,8 @@ the world is carved up with an evenly spaced, axially aligned bsp tree.  Entitie
 are kept in chains either at the final leafs, or at the first node that splits
 them, which prevents having to deal with multiple fragments of a single entity.
 
+The sectors are only used with sv_areaTree 0, see AREA TREE above.
+
 ===============================================================================
 */
 
@@ -85,6 +503,11 @@ void SV_SectorList_f( void ) {
 	worldSector_t	*sec;
 	svEntity_t		*ent;
 
+	if ( sv_useAreaTree ) {
+		Com_Printf( "area tree: %i entities, height %i\n", areaTree.numLeafs, SV_AreaTreeHeight() );
+		return;
+	}
+
 	for ( i = 0 ; i < AREA_NODES ; i++ ) {
 		sec = &sv_worldSectors[i];
 
@@ -138,6 +561,134 @@ static worldSector_t *SV_CreateworldSector( int depth, vec3_t mins, vec3_t maxs
 	return anode;
 }
 
+/*
+============================================================================
+
+TRACE CACHE
+
+With sv_traceCache set, SV_Trace results are kept until the next server
+frame or until any entity is linked or unlinked, and the same query
+(start, end, mins, maxs, passEntityNum, contentmask, capsule) returns the
+kept result. Game code that changes what is traced against without
+relinking, like r.contents or r.ownerNum, can get a stale result.
+============================================================================
+*/
+
+#define TRACE_CACHE_SIZE	1024	// must be a power of two
+
+typedef struct {
+	vec3_t		start, end;
+	vec3_t		mins, maxs;
+	int			passEntityNum;
+	int			contentmask;
+	int			capsule;
+} traceKey_t;
+
+typedef struct {
+	traceKey_t	key;
+	unsigned	generation;		// valid while it is traceCache.generation
+	trace_t		trace;
+} traceCacheEntry_t;
+
+static struct {
+	traceCacheEntry_t	entries[ TRACE_CACHE_SIZE ];
+	unsigned	generation;
+	int			time;			// sv.time of the current generation
+	qboolean	used;			// entries were stored in the current generation
+} traceCache;
+
+static struct {
+	uint64_t	lookups;
+	uint64_t	hits;
+	uint64_t	flushes;		// invalidations that dropped stored results
+} traceCacheStats;
+
+
+/*
+===============
+SV_TraceCacheInvalidate
+
+Drops every stored result. Called on all links and unlinks, so it only
+starts a new generation when something was stored in the current one.
+===============
+*/
+static void SV_TraceCacheInvalidate( void ) {
+	if ( !traceCache.used ) {
+		return;
+	}
+
+	traceCache.used = qfalse;
+	traceCacheStats.flushes++;
+
+	if ( ++traceCache.generation == 0 ) {
+		// wrapped, make sure no old entry matches again
+		Com_Memset( traceCache.entries, 0, sizeof( traceCache.entries ) );
+		traceCache.generation = 1;
+	}
+}
+
+
+/*
+===============
+SV_TraceCacheEntry
+
+Returns the entry for key, valid when its generation is the current one,
+otherwise reset for the caller to store the result in.
+===============
+*/
+static traceCacheEntry_t *SV_TraceCacheEntry( const traceKey_t *key ) {
+	traceCacheEntry_t *entry;
+	const byte *p;
+	unsigned hash;
+	int i;
+
+	if ( traceCache.time != sv.time ) {
+		SV_TraceCacheInvalidate();
+		traceCache.time = sv.time;
+	}
+
+	p = (const byte *)key;
+	hash = 2166136261U;
+	for ( i = 0; i < sizeof( *key ); i++ ) {
+		hash = ( hash ^ p[i] ) * 16777619U;
+	}
+
+	entry = &traceCache.entries[ ( hash ^ ( hash >> 16 ) ) & ( TRACE_CACHE_SIZE - 1 ) ];
+
+	traceCacheStats.lookups++;
+	if ( entry->generation == traceCache.generation && !memcmp( &entry->key, key, sizeof( *key ) ) ) {
+		traceCacheStats.hits++;
+		return entry;
+	}
+
+	entry->key = *key;
+	entry->generation = 0;
+
+	return entry;
+}
+
+
+/*
+===============
+SV_TraceCache_f
+
+tracecache [reset]
+===============
+*/
+void SV_TraceCache_f( void ) {
+	if ( !Q_stricmp( Cmd_Argv( 1 ), "reset" ) ) {
+		Com_Memset( &traceCacheStats, 0, sizeof( traceCacheStats ) );
+		return;
+	}
+
+	Com_Printf( "sv_traceCache %s: %llu of %llu traces cached, %.1f%%, %llu flushes\n",
+		sv_traceCache->integer ? "on" : "off",
+		(unsigned long long)traceCacheStats.hits, (unsigned long long)traceCacheStats.lookups,
+		traceCacheStats.lookups ? 100.0 * traceCacheStats.hits / traceCacheStats.lookups : 0.0,
+		(unsigned long long)traceCacheStats.flushes );
+}
+
+
 /*
 ===============
 SV_ClearWorld
@@ -155,6 +706,12 @@ void SV_ClearWorld( void ) {
 	h = CM_InlineModel( 0 );
 	CM_ModelBounds( h, mins, maxs );
 	SV_CreateworldSector( 0, mins, maxs );
+
+	SV_AreaTreeClear();
+	sv_useAreaTree = sv_areaTree->integer ? qtrue : qfalse;
+
+	Com_Memset( &traceCache, 0, sizeof( traceCache ) );
+	traceCache.generation = 1;
 }
 
 
@@ -173,6 +730,13 @@ void SV_UnlinkEntity( sharedEntity_t *gEnt ) {
 
 	gEnt->r.linked = qfalse;
 
+	SV_TraceCacheInvalidate();
+
+	if ( ent->areaLeaf ) {
+		SV_AreaTreeUnlink( ent );
+		return;
+	}
+
 	ws = ent->worldSector;
 	if ( !ws ) {
 		return;		// not linked in anywhere
@@ -215,6 +779,8 @@ void SV_LinkEntity( sharedEntity_t *gEnt ) {
 
 	ent = SV_SvEntityForGentity( gEnt );
 
+	SV_TraceCacheInvalidate();
+
 	if ( ent->worldSector ) {
 		SV_UnlinkEntity( gEnt );	// unlink from old position
 	}
@@ -291,6 +857,9 @@ void SV_LinkEntity( sharedEntity_t *gEnt ) {
 	// if none of the leafs were inside the map, the
 	// entity is outside the world and can be considered unlinked
 	if ( !num_leafs ) {
+		if ( ent->areaLeaf ) {
+			SV_UnlinkEntity( gEnt );
+		}
 		return;
 	}
 
@@ -332,6 +901,12 @@ void SV_LinkEntity( sharedEntity_t *gEnt ) {
 
 	gEnt->r.linkcount++;
 
+	if ( sv_useAreaTree ) {
+		SV_AreaTreeLink( ent, gEnt );
+		gEnt->r.linked = qtrue;
+		return;
+	}
+
 	// find the first world sector node that the ent's box crosses
 	node = sv_worldSectors;
 	while (1)
@@ -418,6 +993,55 @@ static void SV_AreaEntities_r( worldSector_t *node, areaParms_t *ap ) {
 	}
 }
 
+
+/*
+====================
+SV_AreaTreeEntities_r
+
+====================
+*/
+static void SV_AreaTreeEntities_r( int nodeNum, areaParms_t *ap ) {
+	const areaNode_t *node;
+	const sharedEntity_t *gcheck;
+
+	node = &areaTree.nodes[ nodeNum ];
+
+	if ( node->mins[0] > ap->maxs[0]
+	|| node->mins[1] > ap->maxs[1]
+	|| node->mins[2] > ap->maxs[2]
+	|| node->maxs[0] < ap->mins[0]
+	|| node->maxs[1] < ap->mins[1]
+	|| node->maxs[2] < ap->mins[2] ) {
+		return;
+	}
+
+	if ( node->children[0] ) {
+		SV_AreaTreeEntities_r( node->children[0], ap );
+		SV_AreaTreeEntities_r( node->children[1], ap );
+		return;
+	}
+
+	// the leaf box has a margin, test the entity itself
+	gcheck = SV_GentityNum( node->entityNum );
+
+	if ( gcheck->r.absmin[0] > ap->maxs[0]
+	|| gcheck->r.absmin[1] > ap->maxs[1]
+	|| gcheck->r.absmin[2] > ap->maxs[2]
+	|| gcheck->r.absmax[0] < ap->mins[0]
+	|| gcheck->r.absmax[1] < ap->mins[1]
+	|| gcheck->r.absmax[2] < ap->mins[2] ) {
+		return;
+	}
+
+	if ( ap->count == ap->maxcount ) {
+		Com_Printf ("SV_AreaEntities: MAXCOUNT\n");
+		return;
+	}
+
+	ap->list[ap->count] = node->entityNum;
+	ap->count++;
+}
+
 /*
 ================
 SV_AreaEntities
@@ -432,7 +1056,13 @@ int SV_AreaEntities( const vec3_t mins, const vec3_t maxs, int *entityList, int
 	ap.count = 0;
 	ap.maxcount = maxcount;
 
-	SV_AreaEntities_r( sv_worldSectors, &ap );
+	if ( sv_useAreaTree ) {
+		if ( areaTree.root ) {
+			SV_AreaTreeEntities_r( areaTree.root, &ap );
+		}
+	} else {
+		SV_AreaEntities_r( sv_worldSectors, &ap );
+	}
 
 	return ap.count;
 }
@@ -500,13 +1130,12 @@ void SV_ClipToEntity( trace_t *trace, const vec3_t start, const vec3_t mins, con
 
 /*
 ====================
-SV_ClipMoveToEntities
+SV_ClipMoveToEntityList
 
 ====================
 */
-static void SV_ClipMoveToEntities( moveclip_t *clip ) {
-	int			i, num;
-	int			touchlist[MAX_GENTITIES];
+static void SV_ClipMoveToEntityList( moveclip_t *clip, const int *touchlist, int num ) {
+	int			i;
 	sharedEntity_t *touch;
 	int			passOwnerNum;
 	trace_t		trace;
@@ -514,8 +1143,6 @@ static void SV_ClipMoveToEntities( moveclip_t *clip ) {
 	float		*origin;
 	const float *angles;
 
-	num = SV_AreaEntities( clip->boxmins, clip->boxmaxs, touchlist, MAX_GENTITIES);
-
 	if ( clip->passEntityNum != ENTITYNUM_NONE ) {
 		passOwnerNum = ( SV_GentityNum( clip->passEntityNum ) )->r.ownerNum;
 		if ( passOwnerNum == ENTITYNUM_NONE ) {
@@ -587,6 +1214,97 @@ static void SV_ClipMoveToEntities( moveclip_t *clip ) {
 }
 
 
+/*
+====================
+SV_ClipMoveToEntities
+
+====================
+*/
+static void SV_ClipMoveToEntities( moveclip_t *clip ) {
+	int			touchlist[MAX_GENTITIES];
+	int			num;
+
+	num = SV_AreaEntities( clip->boxmins, clip->boxmaxs, touchlist, MAX_GENTITIES);
+
+	SV_ClipMoveToEntityList( clip, touchlist, num );
+}
+
+
+/*
+==================
+SV_WorldTrace
+
+Clips the move to the world, returns qfalse if it is blocked immediately.
+==================
+*/
+static qboolean SV_WorldTrace( trace_t *trace, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int contentmask, qboolean capsule ) {
+	CM_BoxTrace( trace, start, end, mins, maxs, 0, contentmask, capsule );
+	trace->entityNum = trace->fraction != 1.0 ? ENTITYNUM_WORLD : ENTITYNUM_NONE;
+
+	return trace->fraction != 0;
+}
+
+
+/*
+==================
+SV_InitMoveClip
+
+Set up the rest of the clip after the world trace
+==================
+*/
+static void SV_InitMoveClip( moveclip_t *clip, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, qboolean capsule ) {
+	int			i;
+
+	clip->contentmask = contentmask;
+	clip->start = start;
+//	VectorCopy( clip->trace.endpos, clip->end );
+	VectorCopy( end, clip->end );
+	clip->mins = mins;
+	clip->maxs = maxs;
+	clip->passEntityNum = passEntityNum;
+	clip->capsule = capsule;
+
+	// create the bounding box of the entire move
+	// we can limit it to the part of the move not
+	// already clipped off by the world, which can be
+	// a significant savings for line of sight and shot traces
+	for ( i=0 ; i<3 ; i++ ) {
+		if ( end[i] > start[i] ) {
+			clip->boxmins[i] = clip->start[i] + clip->mins[i] - 1;
+			clip->boxmaxs[i] = clip->end[i] + clip->maxs[i] + 1;
+		} else {
+			clip->boxmins[i] = clip->end[i] + clip->mins[i] - 1;
+			clip->boxmaxs[i] = clip->start[i] + clip->maxs[i] + 1;
+		}
+	}
+}
+
+
+/*
+==================
+SV_TraceMove
+==================
+*/
+static void SV_TraceMove( trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, qboolean capsule ) {
+	moveclip_t	clip;
+
+	Com_Memset ( &clip, 0, sizeof ( clip ) );
+
+	// clip to world
+	if ( !SV_WorldTrace( &clip.trace, start, mins, maxs, end, contentmask, capsule ) ) {
+		*results = clip.trace;
+		return;		// blocked immediately by the world
+	}
+
+	SV_InitMoveClip( &clip, start, mins, maxs, end, passEntityNum, contentmask, capsule );
+
+	// clip to other solid entities
+	SV_ClipMoveToEntities ( &clip );
+
+	*results = clip.trace;
+}
+
+
 /*
 ==================
 SV_Trace
@@ -596,8 +1314,8 @@ passEntityNum and entities owned by passEntityNum are explicitly not checked.
 ==================
 */
 void SV_Trace( trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, qboolean capsule ) {
-	moveclip_t	clip;
-	int			i;
+	traceCacheEntry_t *entry;
+	traceKey_t	key;
 
 	if ( !mins ) {
 		mins = vec3_origin;
@@ -606,43 +1324,105 @@ void SV_Trace( trace_t *results, const vec3_t start, const vec3_t mins, const ve
 		maxs = vec3_origin;
 	}
 
-	Com_Memset ( &clip, 0, sizeof ( clip ) );
+	if ( !sv_traceCache->integer ) {
+		SV_TraceMove( results, start, mins, maxs, end, passEntityNum, contentmask, capsule );
+		return;
+	}
 
-	// clip to world
-	CM_BoxTrace( &clip.trace, start, end, mins, maxs, 0, contentmask, capsule );
-	clip.trace.entityNum = clip.trace.fraction != 1.0 ? ENTITYNUM_WORLD : ENTITYNUM_NONE;
-	if ( clip.trace.fraction == 0 ) {
-		*results = clip.trace;
-		return;		// blocked immediately by the world
+	VectorCopy( start, key.start );
+	VectorCopy( end, key.end );
+	VectorCopy( mins, key.mins );
+	VectorCopy( maxs, key.maxs );
+	key.passEntityNum = passEntityNum;
+	key.contentmask = contentmask;
+	key.capsule = capsule;
+
+	entry = SV_TraceCacheEntry( &key );
+	if ( entry->generation != traceCache.generation ) {
+		SV_TraceMove( &entry->trace, start, mins, maxs, end, passEntityNum, contentmask, capsule );
+		entry->generation = traceCache.generation;
+		traceCache.used = qtrue;
 	}
 
-	clip.contentmask = contentmask;
-	clip.start = start;
-//	VectorCopy( clip.trace.endpos, clip.end );
-	VectorCopy( end, clip.end );
-	clip.mins = mins;
-	clip.maxs = maxs;
-	clip.passEntityNum = passEntityNum;
-	clip.capsule = capsule;
+	*results = entry->trace;
+}
 
-	// create the bounding box of the entire move
-	// we can limit it to the part of the move not
-	// already clipped off by the world, which can be
-	// a significant savings for line of sight and shot traces
-	for ( i=0 ; i<3 ; i++ ) {
-		if ( end[i] > start[i] ) {
-			clip.boxmins[i] = clip.start[i] + clip.mins[i] - 1;
-			clip.boxmaxs[i] = clip.end[i] + clip.maxs[i] + 1;
-		} else {
-			clip.boxmins[i] = clip.end[i] + clip.mins[i] - 1;
-			clip.boxmaxs[i] = clip.start[i] + clip.maxs[i] + 1;
+
+/*
+==================
+SV_TraceBatch
+
+Does count SV_Traces of the same volume, pass entity and contentmask,
+as for shotgun pellets or visibility checks. The entities near any of
+the moves are looked up once, and each move is clipped against the ones
+SV_AreaEntities would have returned for it, in the same order, so the
+results are the same as from separate SV_Trace calls.
+==================
+*/
+void SV_TraceBatch( trace_t *results, const vec3_t *starts, const vec3_t *ends, int count, const vec3_t mins, const vec3_t maxs, int passEntityNum, int contentmask, qboolean capsule ) {
+	int			touchlist[MAX_GENTITIES];
+	int			cliplist[MAX_GENTITIES];
+	vec3_t		batchMins, batchMaxs;
+	moveclip_t	clip;
+	const sharedEntity_t *touch;
+	int			i, j, num, numClip;
+	qboolean	clipEntities;
+
+	if ( !mins ) {
+		mins = vec3_origin;
+	}
+	if ( !maxs ) {
+		maxs = vec3_origin;
+	}
+
+	// clip to world, and find the bounds of the moves that aren't blocked
+	clipEntities = qfalse;
+	ClearBounds( batchMins, batchMaxs );
+	for ( i = 0; i < count; i++ ) {
+		if ( !SV_WorldTrace( &results[i], starts[i], mins, maxs, ends[i], contentmask, capsule ) ) {
+			continue;
 		}
+		SV_InitMoveClip( &clip, starts[i], mins, maxs, ends[i], passEntityNum, contentmask, capsule );
+		AddPointToBounds( clip.boxmins, batchMins, batchMaxs );
+		AddPointToBounds( clip.boxmaxs, batchMins, batchMaxs );
+		clipEntities = qtrue;
 	}
 
+	if ( !clipEntities ) {
+		return;
+	}
+
+	num = SV_AreaEntities( batchMins, batchMaxs, touchlist, MAX_GENTITIES );
+
 	// clip to other solid entities
-	SV_ClipMoveToEntities ( &clip );
+	for ( i = 0; i < count; i++ ) {
+		if ( results[i].fraction == 0 ) {
+			continue;
+		}
 
-	*results = clip.trace;
+		Com_Memset( &clip, 0, sizeof( clip ) );
+		clip.trace = results[i];
+		SV_InitMoveClip( &clip, starts[i], mins, maxs, ends[i], passEntityNum, contentmask, capsule );
+
+		// the SV_AreaEntities test
+		numClip = 0;
+		for ( j = 0; j < num; j++ ) {
+			touch = SV_GentityNum( touchlist[j] );
+			if ( touch->r.absmin[0] > clip.boxmaxs[0]
+			|| touch->r.absmin[1] > clip.boxmaxs[1]
+			|| touch->r.absmin[2] > clip.boxmaxs[2]
+			|| touch->r.absmax[0] < clip.boxmins[0]
+			|| touch->r.absmax[1] < clip.boxmins[1]
+			|| touch->r.absmax[2] < clip.boxmins[2] ) {
+				continue;
+			}
+			cliplist[numClip++] = touchlist[j];
+		}
+
+		SV_ClipMoveToEntityList( &clip, cliplist, numClip );
+
+		results[i] = clip.trace;
+	}
 }
 
 
@@ -0,0 +1,862 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// cmbench.c -- collision trace benchmark
+//
+// Loads a .bsp with the engine's collision code and times the traces
+// game code issues most: hitscan lines, player sized boxes through the
+// world, and boxes against a temporary box model as for entities. The
+// traces are random but seeded, and the crc32 of their results is
+// printed so builds can be checked for identical collision.
+//
+// With -e, it also links that many entities through the server's
+// sv_world.c, moving around as on a busy team map, and times linking,
+// area queries and traces against them with the world sectors and with
+// the area tree. Both must print the same crc32.
+
+#include "../qcommon/q_shared.h"
+#include "../qcommon/qcommon.h"
+#include "../qcommon/cm_public.h"
+#include "../server/server.h"
+
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CMB_MAX_TRACE_LEN	2048	// longest random trace
+
+#define CMB_WORLD_FRAMES	500		// server frames the entities move for
+#define CMB_HOTSPOTS		4		// places the players fight around
+#define CMB_MAX_TOUCH		128		// SV_AreaEntities results kept per player
+
+// as in bg_public.h
+#define CMB_MASK_SHOT			( CONTENTS_SOLID | CONTENTS_BODY | CONTENTS_CORPSE )
+#define CMB_MASK_PLAYERSOLID	( CONTENTS_SOLID | CONTENTS_PLAYERCLIP | CONTENTS_BODY )
+
+typedef struct {
+	vec3_t			start;
+	vec3_t			end;
+} cmbTrace_t;
+
+typedef struct {
+	float			fraction;
+	vec3_t			endpos;
+	vec3_t			normal;
+	int				contents;
+	int				solid;			// startsolid | allsolid << 1
+} cmbResult_t;
+
+typedef enum {
+	CMB_POINT,			// hitscan lines
+	CMB_BOX,			// player boxes through the world
+	CMB_ENTITY,			// player boxes against a box model
+	CMB_NUM_MODES
+} cmbMode_t;
+
+static const char *cmb_modeNames[ CMB_NUM_MODES ] = {
+	"point",
+	"box",
+	"entity"
+};
+
+static const vec3_t cmb_playerMins = { -15, -15, -24 };
+static const vec3_t cmb_playerMaxs = { 15, 15, 32 };
+static const vec3_t cmb_itemMins = { -15, -15, -15 };
+static const vec3_t cmb_itemMaxs = { 15, 15, 15 };
+
+typedef enum {
+	CMB_ENT_PLAYER,
+	CMB_ENT_MISSILE,
+	CMB_ENT_ITEM,		// and triggers, they don't move
+	CMB_ENT_ITEM2
+} cmbEntityType_t;		// by entity number modulo 4
+
+typedef struct {
+	int				area;			// SV_AreaEntities results, sorted
+	int				touch[ CMB_MAX_TOUCH ];
+	cmbResult_t		move;			// the player's move this frame
+	int				moveEntity;
+	cmbResult_t		shot;			// a hitscan shot from the player
+	int				shotEntity;
+} cmbWorldResult_t;
+
+typedef struct {
+	double			link;
+	double			area;
+	double			trace;
+} cmbWorldTimes_t;
+
+static sharedEntity_t	cmb_entities[ MAX_GENTITIES ];
+
+// command line options
+static int			cmb_traces = 100000;
+static int			cmb_iterations = 10;
+static unsigned int	cmb_seed = 1;
+static const char	*cmb_loadThreads = "3";
+static const char	*cmb_patchCache = "1";
+static int			cmb_numEntities = 0;
+
+
+/*
+===============
+Engine functions used by the collision code
+===============
+*/
+void QDECL Com_Error( errorParm_t code, const char *fmt, ... ) {
+	va_list argptr;
+
+	va_start( argptr, fmt );
+	vfprintf( stderr, fmt, argptr );
+	va_end( argptr );
+	fputc( '\n', stderr );
+
+	exit( 1 );
+}
+
+
+void QDECL Com_Printf( const char *fmt, ... ) {
+	va_list argptr;
+
+	va_start( argptr, fmt );
+	vprintf( fmt, argptr );
+	va_end( argptr );
+}
+
+
+// the collision map load times are developer prints
+void QDECL Com_DPrintf( const char *fmt, ... ) {
+	va_list argptr;
+
+	va_start( argptr, fmt );
+	vprintf( fmt, argptr );
+	va_end( argptr );
+}
+
+
+cvar_t *Cvar_Get( const char *var_name, const char *value, int flags ) {
+	cvar_t *var;
+
+	var = calloc( 1, sizeof( *var ) );
+	if ( !var ) {
+		Com_Error( ERR_FATAL, "out of memory" );
+	}
+	if ( !strcmp( var_name, "cm_loadThreads" ) ) {
+		value = cmb_loadThreads;
+	} else if ( !strcmp( var_name, "cm_patchCache" ) ) {
+		value = cmb_patchCache;
+	}
+	var->name = (char *)var_name;
+	var->string = (char *)value;
+	var->value = atof( value );
+	var->integer = atoi( value );
+
+	return var;
+}
+
+
+void Cvar_SetDescription( cvar_t *var, const char *var_description ) {
+}
+
+
+void Cvar_CheckRange( cvar_t *var, const char *mins, const char *maxs, cvarValidator_t type ) {
+}
+
+
+void *Hunk_Alloc( int size, ha_pref preference ) {
+	void *buf;
+
+	buf = calloc( 1, size );
+	if ( !buf ) {
+		Com_Error( ERR_FATAL, "out of memory" );
+	}
+
+	return buf;
+}
+
+
+#ifdef ZONE_DEBUG
+void *Z_MallocDebug( int size, char *label, char *file, int line ) {
+#else
+void *Z_Malloc( int size ) {
+#endif
+	return Hunk_Alloc( size, h_low );
+}
+
+
+void Z_Free( void *ptr ) {
+	free( ptr );
+}
+
+
+int FS_ReadFile( const char *qpath, void **buffer ) {
+	FILE *f;
+	long len;
+	byte *buf;
+
+	*buffer = NULL;
+
+	f = fopen( qpath, "rb" );
+	if ( !f ) {
+		return -1;
+	}
+
+	fseek( f, 0, SEEK_END );
+	len = ftell( f );
+	fseek( f, 0, SEEK_SET );
+
+	buf = malloc( len + 1 );
+	if ( !buf || fread( buf, 1, len, f ) != len ) {
+		free( buf );
+		fclose( f );
+		return -1;
+	}
+	buf[ len ] = '\0';
+	fclose( f );
+
+	*buffer = buf;
+	return (int)len;
+}
+
+
+// there is no separate home path, the cache sits next to the map
+int FS_HomeReadFile( const char *qpath, void **buffer ) {
+	return FS_ReadFile( qpath, buffer );
+}
+
+
+void FS_FreeFile( void *buffer ) {
+	free( buffer );
+}
+
+
+// one file open for writing at a time is all the collision code needs
+static FILE *cmb_writeFile;
+
+fileHandle_t FS_FOpenFileWrite( const char *qpath ) {
+	if ( cmb_writeFile ) {
+		return FS_INVALID_HANDLE;
+	}
+
+	cmb_writeFile = fopen( qpath, "wb" );
+	if ( !cmb_writeFile ) {
+		return FS_INVALID_HANDLE;
+	}
+
+	return 1;
+}
+
+
+int FS_Write( const void *buffer, int len, fileHandle_t f ) {
+	return (int)fwrite( buffer, 1, len, cmb_writeFile );
+}
+
+
+void FS_FCloseFile( fileHandle_t f ) {
+	fclose( cmb_writeFile );
+	cmb_writeFile = NULL;
+}
+
+
+void BotDrawDebugPolygons( void (*drawPoly)(int color, int numPoints, float *points), int value ) {
+}
+
+
+const char *Cmd_Argv( int arg ) {
+	return "";
+}
+
+
+/*
+===============
+Server functions used by sv_world.c
+===============
+*/
+server_t	sv;
+cvar_t		*sv_traceCache;
+cvar_t		*sv_areaTree;
+
+
+sharedEntity_t *SV_GentityNum( int num ) {
+	return &cmb_entities[ num ];
+}
+
+
+svEntity_t *SV_SvEntityForGentity( sharedEntity_t *gEnt ) {
+	return &sv.svEntities[ gEnt->s.number ];
+}
+
+
+sharedEntity_t *SV_GEntityForSvEntity( svEntity_t *svEnt ) {
+	return &cmb_entities[ svEnt - sv.svEntities ];
+}
+
+
+int64_t Sys_Microseconds( void ) {
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+typedef struct {
+	sysThreadFunc_t	func;
+	void			*arg;
+} cmbThreadStart_t;
+
+static void *CMB_ThreadStart( void *arg ) {
+	cmbThreadStart_t start = *(cmbThreadStart_t *)arg;
+
+	free( arg );
+	start.func( start.arg );
+
+	return NULL;
+}
+
+
+void *Sys_CreateThread( sysThreadFunc_t func, void *arg ) {
+	pthread_t *thread;
+	cmbThreadStart_t *start;
+
+	thread = malloc( sizeof( *thread ) );
+	start = malloc( sizeof( *start ) );
+	if ( !thread || !start ) {
+		free( thread );
+		free( start );
+		return NULL;
+	}
+
+	start->func = func;
+	start->arg = arg;
+
+	if ( pthread_create( thread, NULL, CMB_ThreadStart, start ) != 0 ) {
+		free( thread );
+		free( start );
+		return NULL;
+	}
+
+	return thread;
+}
+
+
+void Sys_JoinThread( void *thread ) {
+	if ( thread ) {
+		pthread_join( *(pthread_t *)thread, NULL );
+		free( thread );
+	}
+}
+
+
+void *Sys_CreateMutex( void ) {
+	pthread_mutex_t *mutex;
+
+	mutex = malloc( sizeof( *mutex ) );
+	if ( mutex && pthread_mutex_init( mutex, NULL ) != 0 ) {
+		free( mutex );
+		mutex = NULL;
+	}
+
+	return mutex;
+}
+
+
+void Sys_DestroyMutex( void *mutex ) {
+	if ( mutex ) {
+		pthread_mutex_destroy( mutex );
+		free( mutex );
+	}
+}
+
+
+void Sys_LockMutex( void *mutex ) {
+	pthread_mutex_lock( mutex );
+}
+
+
+void Sys_UnlockMutex( void *mutex ) {
+	pthread_mutex_unlock( mutex );
+}
+
+
+/*
+===============
+CMB_Seconds
+===============
+*/
+static double CMB_Seconds( void ) {
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+/*
+===============
+CMB_Random
+
+Uniform in [0,1), the same sequence for the same seed on every platform.
+===============
+*/
+static float CMB_Random( unsigned int *state ) {
+	*state = *state * 1664525 + 1013904223;
+
+	return ( *state >> 8 ) * ( 1.0f / 16777216.0f );
+}
+
+
+/*
+===============
+CMB_MakeTraces
+
+Random starts in empty space, going a random distance in a random
+direction.
+===============
+*/
+static void CMB_MakeTraces( cmbTrace_t *traces, int count, const vec3_t mins, const vec3_t maxs ) {
+	unsigned int state = cmb_seed;
+	vec3_t dir;
+	float len;
+	int i, j;
+
+	for ( i = 0; i < count; i++ ) {
+		do {
+			for ( j = 0; j < 3; j++ ) {
+				traces[i].start[j] = mins[j] + CMB_Random( &state ) * ( maxs[j] - mins[j] );
+			}
+		} while ( CM_PointContents( traces[i].start, 0 ) & CONTENTS_SOLID );
+
+		do {
+			for ( j = 0; j < 3; j++ ) {
+				dir[j] = CMB_Random( &state ) * 2.0f - 1.0f;
+			}
+		} while ( VectorNormalize( dir ) < 0.1f );
+
+		len = 16.0f + CMB_Random( &state ) * ( CMB_MAX_TRACE_LEN - 16 );
+		VectorMA( traces[i].start, len, dir, traces[i].end );
+	}
+}
+
+
+/*
+===============
+CMB_Run
+
+Returns the crc32 of the results.
+===============
+*/
+static unsigned int CMB_Run( cmbMode_t mode, const cmbTrace_t *traces, int count, double *seconds ) {
+	trace_t *results;
+	cmbResult_t *packed;
+	clipHandle_t model;
+	vec3_t origin;
+	double t;
+	unsigned int crc;
+	int i;
+
+	results = calloc( count, sizeof( *results ) );
+	packed = calloc( count, sizeof( *packed ) );
+	if ( !results || !packed ) {
+		Com_Error( ERR_FATAL, "out of memory" );
+	}
+
+	t = CMB_Seconds();
+
+	switch ( mode ) {
+	case CMB_POINT:
+		for ( i = 0; i < count; i++ ) {
+			CM_BoxTrace( &results[i], traces[i].start, traces[i].end, NULL, NULL, 0, CMB_MASK_SHOT, qfalse );
+		}
+		break;
+	case CMB_BOX:
+		for ( i = 0; i < count; i++ ) {
+			CM_BoxTrace( &results[i], traces[i].start, traces[i].end, cmb_playerMins, cmb_playerMaxs, 0, CMB_MASK_PLAYERSOLID, qfalse );
+		}
+		break;
+	default:
+		// a player standing halfway along each trace
+		for ( i = 0; i < count; i++ ) {
+			model = CM_TempBoxModel( cmb_playerMins, cmb_playerMaxs, qfalse );
+			VectorAdd( traces[i].start, traces[i].end, origin );
+			VectorScale( origin, 0.5f, origin );
+			CM_TransformedBoxTrace( &results[i], traces[i].start, traces[i].end, cmb_playerMins, cmb_playerMaxs,
+				model, CMB_MASK_PLAYERSOLID, origin, vec3_origin, qfalse );
+		}
+		break;
+	}
+
+	*seconds += CMB_Seconds() - t;
+
+	// pack the results so padding and the unused fields don't count
+	for ( i = 0; i < count; i++ ) {
+		packed[i].fraction = results[i].fraction;
+		VectorCopy( results[i].endpos, packed[i].endpos );
+		VectorCopy( results[i].plane.normal, packed[i].normal );
+		packed[i].contents = results[i].contents;
+		packed[i].solid = results[i].startsolid | ( results[i].allsolid << 1 );
+	}
+	crc = crc32_buffer( (const byte *)packed, count * sizeof( *packed ) );
+
+	free( results );
+	free( packed );
+
+	return crc;
+}
+
+
+/*
+===============
+CMB_PackResult
+===============
+*/
+static void CMB_PackResult( cmbResult_t *packed, int *entityNum, const trace_t *trace ) {
+	Com_Memset( packed, 0, sizeof( *packed ) );
+	packed->fraction = trace->fraction;
+	VectorCopy( trace->endpos, packed->endpos );
+	*entityNum = -1;
+
+	// when several entities stop a trace right at its start, which of
+	// them it reports depends on the order they are found in, and that
+	// is different for the sectors and the tree
+	if ( trace->fraction == 0 ) {
+		return;
+	}
+
+	VectorCopy( trace->plane.normal, packed->normal );
+	packed->contents = trace->contents;
+	packed->solid = trace->startsolid | ( trace->allsolid << 1 );
+	*entityNum = trace->entityNum;
+}
+
+
+/*
+===============
+CMB_CompareInts
+===============
+*/
+static int CMB_CompareInts( const void *a, const void *b ) {
+	return *(const int *)a - *(const int *)b;
+}
+
+
+/*
+===============
+CMB_SpawnEntities
+
+Players start around a few hotspots in empty space, missiles at the
+players, and items are spread over the whole map.
+===============
+*/
+static void CMB_SpawnEntities( unsigned int *state, vec3_t *hotspots, vec3_t *velocities, const vec3_t mins, const vec3_t maxs ) {
+	sharedEntity_t *ent;
+	int i, j;
+
+	Com_Memset( cmb_entities, 0, sizeof( cmb_entities ) );
+	Com_Memset( sv.svEntities, 0, sizeof( sv.svEntities ) );
+
+	for ( i = 0; i < CMB_HOTSPOTS; i++ ) {
+		do {
+			for ( j = 0; j < 3; j++ ) {
+				hotspots[i][j] = mins[j] + CMB_Random( state ) * ( maxs[j] - mins[j] );
+			}
+		} while ( CM_PointContents( hotspots[i], 0 ) & CONTENTS_SOLID );
+	}
+
+	for ( i = 0; i < cmb_numEntities; i++ ) {
+		ent = &cmb_entities[i];
+		ent->s.number = i;
+		ent->r.ownerNum = ENTITYNUM_NONE;
+
+		switch ( i & 3 ) {
+		case CMB_ENT_PLAYER:
+			VectorCopy( cmb_playerMins, ent->r.mins );
+			VectorCopy( cmb_playerMaxs, ent->r.maxs );
+			ent->r.contents = CONTENTS_BODY;
+			for ( j = 0; j < 3; j++ ) {
+				ent->r.currentOrigin[j] = hotspots[ i % CMB_HOTSPOTS ][j] + ( CMB_Random( state ) * 2.0f - 1.0f ) * 384.0f;
+			}
+			break;
+		case CMB_ENT_MISSILE:
+			ent->r.contents = 0;
+			ent->r.ownerNum = i - 1;
+			VectorClear( ent->r.currentOrigin );
+			break;
+		default:
+			VectorCopy( cmb_itemMins, ent->r.mins );
+			VectorCopy( cmb_itemMaxs, ent->r.maxs );
+			ent->r.contents = CONTENTS_TRIGGER;
+			for ( j = 0; j < 3; j++ ) {
+				ent->r.currentOrigin[j] = mins[j] + CMB_Random( state ) * ( maxs[j] - mins[j] );
+			}
+			break;
+		}
+
+		VectorClear( velocities[i] );
+	}
+}
+
+
+/*
+===============
+CMB_MoveEntities
+
+One server frame of movement. Players wander around their hotspot,
+missiles fly straight and are fired again from their owner after a
+second.
+===============
+*/
+static void CMB_MoveEntities( unsigned int *state, const vec3_t *hotspots, vec3_t *velocities, int frame ) {
+	sharedEntity_t *ent, *owner;
+	int i, j;
+
+	for ( i = 0; i < cmb_numEntities; i++ ) {
+		ent = &cmb_entities[i];
+
+		switch ( i & 3 ) {
+		case CMB_ENT_PLAYER:
+			for ( j = 0; j < 2; j++ ) {
+				velocities[i][j] = velocities[i][j] * 0.9f + ( CMB_Random( state ) * 2.0f - 1.0f ) * 4.0f
+					+ ( hotspots[ i % CMB_HOTSPOTS ][j] - ent->r.currentOrigin[j] ) * 0.002f;
+			}
+			VectorAdd( ent->r.currentOrigin, velocities[i], ent->r.currentOrigin );
+			break;
+		case CMB_ENT_MISSILE:
+			if ( ( frame + i ) % 20 == 0 ) {
+				owner = &cmb_entities[ ent->r.ownerNum ];
+				VectorCopy( owner->r.currentOrigin, ent->r.currentOrigin );
+				for ( j = 0; j < 3; j++ ) {
+					velocities[i][j] = CMB_Random( state ) * 2.0f - 1.0f;
+				}
+				VectorNormalize( velocities[i] );
+				VectorScale( velocities[i], 45.0f, velocities[i] );	// 900 ups at sv_fps 20
+			}
+			VectorAdd( ent->r.currentOrigin, velocities[i], ent->r.currentOrigin );
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+
+/*
+===============
+CMB_RunWorld
+
+Runs CMB_WORLD_FRAMES server frames with the entities in the sectors or
+the area tree. Each frame the moving entities are relinked, and each
+player touches what its box is in, moves and fires a shot. Returns the
+crc32 of the results.
+===============
+*/
+static unsigned int CMB_RunWorld( qboolean areaTree, const vec3_t mins, const vec3_t maxs, cmbWorldTimes_t *times ) {
+	vec3_t hotspots[ CMB_HOTSPOTS ];
+	vec3_t *velocities;
+	cmbWorldResult_t *results, *result;
+	unsigned int *frameCrcs;
+	unsigned int state, crc;
+	sharedEntity_t *ent;
+	trace_t trace;
+	vec3_t oldOrigin, dir, end;
+	double t;
+	int frame, i, j, numPlayers;
+
+	velocities = calloc( cmb_numEntities, sizeof( *velocities ) );
+	results = calloc( cmb_numEntities, sizeof( *results ) );
+	frameCrcs = calloc( CMB_WORLD_FRAMES, sizeof( *frameCrcs ) );
+	if ( !velocities || !results || !frameCrcs ) {
+		Com_Error( ERR_FATAL, "out of memory" );
+	}
+
+	state = cmb_seed;
+	CMB_SpawnEntities( &state, hotspots, velocities, mins, maxs );
+
+	sv_areaTree->integer = areaTree;
+	SV_ClearWorld();
+
+	t = CMB_Seconds();
+	for ( i = 0; i < cmb_numEntities; i++ ) {
+		if ( ( i & 3 ) != CMB_ENT_MISSILE ) {
+			SV_LinkEntity( &cmb_entities[i] );
+		}
+	}
+	times->link += CMB_Seconds() - t;
+
+	for ( frame = 0; frame < CMB_WORLD_FRAMES; frame++ ) {
+		sv.time = frame * 50;
+
+		CMB_MoveEntities( &state, hotspots, velocities, frame );
+
+		t = CMB_Seconds();
+		for ( i = 0; i < cmb_numEntities; i++ ) {
+			if ( ( i & 3 ) == CMB_ENT_PLAYER || ( i & 3 ) == CMB_ENT_MISSILE ) {
+				SV_LinkEntity( &cmb_entities[i] );
+			}
+		}
+		times->link += CMB_Seconds() - t;
+
+		// what the players touch, like G_TouchTriggers
+		t = CMB_Seconds();
+		for ( i = 0, numPlayers = 0; i < cmb_numEntities; i += 4, numPlayers++ ) {
+			ent = &cmb_entities[i];
+			result = &results[ numPlayers ];
+			result->area = SV_AreaEntities( ent->r.absmin, ent->r.absmax, result->touch, CMB_MAX_TOUCH );
+		}
+		times->area += CMB_Seconds() - t;
+
+		// their moves and shots
+		t = CMB_Seconds();
+		for ( i = 0, numPlayers = 0; i < cmb_numEntities; i += 4, numPlayers++ ) {
+			ent = &cmb_entities[i];
+			result = &results[ numPlayers ];
+
+			VectorSubtract( ent->r.currentOrigin, velocities[i], oldOrigin );
+			SV_Trace( &trace, oldOrigin, ent->r.mins, ent->r.maxs, ent->r.currentOrigin, i, MASK_PLAYERSOLID, qfalse );
+			CMB_PackResult( &result->move, &result->moveEntity, &trace );
+
+			for ( j = 0; j < 3; j++ ) {
+				dir[j] = CMB_Random( &state ) * 2.0f - 1.0f;
+			}
+			VectorNormalize( dir );
+			VectorMA( ent->r.currentOrigin, CMB_MAX_TRACE_LEN, dir, end );
+			SV_Trace( &trace, ent->r.currentOrigin, NULL, NULL, end, i, MASK_SHOT, qfalse );
+			CMB_PackResult( &result->shot, &result->shotEntity, &trace );
+		}
+		times->trace += CMB_Seconds() - t;
+
+		for ( i = 0; i < numPlayers; i++ ) {
+			qsort( results[i].touch, results[i].area, sizeof( results[i].touch[0] ), CMB_CompareInts );
+		}
+		frameCrcs[ frame ] = crc32_buffer( (const byte *)results, numPlayers * sizeof( *results ) );
+	}
+
+	crc = crc32_buffer( (const byte *)frameCrcs, CMB_WORLD_FRAMES * sizeof( *frameCrcs ) );
+
+	free( velocities );
+	free( results );
+	free( frameCrcs );
+
+	return crc;
+}
+
+
+static void CMB_Usage( void ) {
+	fprintf( stderr,
+		"usage: cmbench [options] map.bsp ...\n"
+		"  -n count       traces per mode (default 100000)\n"
+		"  -i count       passes over the traces (default 10)\n"
+		"  -s seed        random seed (default 1)\n"
+		"  -j threads     cm_loadThreads (default 3)\n"
+		"  -C             cm_patchCache 0, always generate curve collision\n"
+		"  -e count       also move count entities around, with sectors and the area tree\n" );
+	exit( 2 );
+}
+
+
+/*
+===============
+main
+===============
+*/
+int main( int argc, char **argv ) {
+	cmbTrace_t *traces;
+	cmbWorldTimes_t times;
+	vec3_t mins, maxs;
+	double seconds;
+	unsigned int crc;
+	int checksum;
+	int opt, i, mode;
+
+	while ( ( opt = getopt( argc, argv, "n:i:s:j:Ce:h" ) ) != -1 ) {
+		switch ( opt ) {
+		case 'n':
+			cmb_traces = atoi( optarg );
+			break;
+		case 'i':
+			cmb_iterations = atoi( optarg );
+			break;
+		case 's':
+			cmb_seed = strtoul( optarg, NULL, 10 );
+			break;
+		case 'j':
+			cmb_loadThreads = optarg;
+			break;
+		case 'C':
+			cmb_patchCache = "0";
+			break;
+		case 'e':
+			cmb_numEntities = atoi( optarg );
+			break;
+		default:
+			CMB_Usage();
+		}
+	}
+
+	if ( argc - optind < 1 || cmb_traces < 1 || cmb_iterations < 1
+		|| cmb_numEntities < 0 || cmb_numEntities > ENTITYNUM_MAX_NORMAL ) {
+		CMB_Usage();
+	}
+
+	sv_traceCache = Cvar_Get( "sv_traceCache", "0", 0 );
+	sv_areaTree = Cvar_Get( "sv_areaTree", "1", 0 );
+
+	traces = malloc( cmb_traces * sizeof( *traces ) );
+	if ( !traces ) {
+		Com_Error( ERR_FATAL, "out of memory" );
+	}
+
+	for ( ; optind < argc; optind++ ) {
+		seconds = CMB_Seconds();
+		CM_LoadMap( argv[optind], qfalse, &checksum );
+		seconds = CMB_Seconds() - seconds;
+		CM_ModelBounds( 0, mins, maxs );
+		CMB_MakeTraces( traces, cmb_traces, mins, maxs );
+
+		printf( "%s: loaded in %.3f s\n", argv[optind], seconds );
+		for ( mode = 0; mode < CMB_NUM_MODES; mode++ ) {
+			seconds = 0.0;
+			crc = 0;
+			for ( i = 0; i < cmb_iterations; i++ ) {
+				crc = CMB_Run( mode, traces, cmb_traces, &seconds );
+			}
+			printf( "%-7s %.3f s, %.0f traces/s, crc32 %08x\n", cmb_modeNames[ mode ],
+				seconds, (double)cmb_traces * cmb_iterations / seconds, crc );
+		}
+
+		for ( mode = 0; mode < 2 && cmb_numEntities; mode++ ) {
+			Com_Memset( &times, 0, sizeof( times ) );
+			crc = 0;
+			for ( i = 0; i < cmb_iterations; i++ ) {
+				crc = CMB_RunWorld( mode, mins, maxs, &times );
+			}
+			printf( "%-7s link %.3f s, area %.3f s, trace %.3f s, crc32 %08x\n", mode ? "tree" : "sectors",
+				times.link, times.area, times.trace, crc );
+		}
+
+		CM_ClearMap();
+	}
+
+	free( traces );
+
+	return 0;
+}
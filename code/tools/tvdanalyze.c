@@ -0,0 +1,657 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// tvdanalyze.c -- headless .tvd statistics extractor
+//
+// Decodes .tvd files with the shared reader (qcommon/tvd.c) and writes
+// one event per line as JSON or CSV: kills, player positions,
+// configstring changes and server commands. Files are processed in
+// parallel, one per worker thread.
+
+#include "tvdtool.h"
+#include "../game/bg_public.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+#define TVA_EV_KILL		1
+#define TVA_EV_POS		2
+#define TVA_EV_CS		4
+#define TVA_EV_CMD		8
+#define TVA_EV_ALL		( TVA_EV_KILL | TVA_EV_POS | TVA_EV_CS | TVA_EV_CMD )
+
+typedef enum {
+	TVA_JSON,
+	TVA_CSV
+} tvaFormat_t;
+
+// command line options
+static tvaFormat_t	tva_format = TVA_JSON;
+static int			tva_events = TVA_EV_ALL;
+static int			tva_posInterval;	// msec between position samples, 0 = every frame
+static const char	*tva_outDir;
+static int			tva_threads;
+static const char	*tva_dictDir = "tvdict";
+
+// work queue
+static char			**tva_files;
+static int			tva_numFiles;
+static int			tva_nextFile;
+static int			tva_failed;
+static pthread_mutex_t	tva_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/*
+=============================================================================
+
+OUTPUT
+
+=============================================================================
+*/
+
+typedef struct {
+	FILE			*f;
+	const char		*demo;			// file name without directory
+} tvaOutput_t;
+
+
+/*
+===============
+TVA_PutString
+
+Write a quoted JSON or CSV string.
+===============
+*/
+static void TVA_PutString( tvaOutput_t *out, const char *s ) {
+	fputc( '"', out->f );
+
+	for ( ; *s; s++ ) {
+		unsigned char c = *s;
+
+		if ( tva_format == TVA_CSV ) {
+			if ( c == '"' ) {
+				fputc( '"', out->f );
+			}
+			fputc( c, out->f );
+		} else if ( c == '"' || c == '\\' ) {
+			fputc( '\\', out->f );
+			fputc( c, out->f );
+		} else if ( c < 0x20 ) {
+			fprintf( out->f, "\\u%04x", c );
+		} else {
+			fputc( c, out->f );
+		}
+	}
+
+	fputc( '"', out->f );
+}
+
+
+/*
+===============
+TVA_BeginEvent
+===============
+*/
+static void TVA_BeginEvent( tvaOutput_t *out, int t, const char *type ) {
+	if ( tva_format == TVA_CSV ) {
+		TVA_PutString( out, out->demo );
+		fprintf( out->f, ",%i,%s", t, type );
+	} else {
+		fprintf( out->f, "{\"demo\":" );
+		TVA_PutString( out, out->demo );
+		fprintf( out->f, ",\"t\":%i,\"type\":\"%s\"", t, type );
+	}
+}
+
+
+/*
+===============
+TVA_Event
+
+CSV columns after demo,t,type: client,other,value,x,y,z,pitch,yaw,text.
+JSON only gets the fields named in the format string, which pairs each
+CSV column with a key ("client", "other", "value", "origin", "angles",
+"text"); unnamed columns are left out.
+===============
+*/
+typedef struct {
+	const char	*client;		// JSON keys, NULL to omit
+	const char	*other;
+	const char	*value;
+	const char	*text;
+	qboolean	hasOrigin;
+} tvaFields_t;
+
+static void TVA_Event( tvaOutput_t *out, int t, const char *type, const tvaFields_t *fields,
+	int client, int other, int value, const vec3_t origin, const vec3_t angles, const char *text ) {
+	TVA_BeginEvent( out, t, type );
+
+	if ( tva_format == TVA_CSV ) {
+		if ( fields->client ) fprintf( out->f, ",%i", client ); else fprintf( out->f, "," );
+		if ( fields->other ) fprintf( out->f, ",%i", other ); else fprintf( out->f, "," );
+		if ( fields->value ) fprintf( out->f, ",%i", value ); else fprintf( out->f, "," );
+		if ( fields->hasOrigin ) {
+			fprintf( out->f, ",%.1f,%.1f,%.1f,%.1f,%.1f", origin[0], origin[1], origin[2], angles[PITCH], angles[YAW] );
+		} else {
+			fprintf( out->f, ",,,,," );
+		}
+		fputc( ',', out->f );
+		if ( fields->text ) {
+			TVA_PutString( out, text );
+		}
+		fputc( '\n', out->f );
+		return;
+	}
+
+	if ( fields->client ) {
+		fprintf( out->f, ",\"%s\":%i", fields->client, client );
+	}
+	if ( fields->other ) {
+		fprintf( out->f, ",\"%s\":%i", fields->other, other );
+	}
+	if ( fields->value ) {
+		fprintf( out->f, ",\"%s\":%i", fields->value, value );
+	}
+	if ( fields->hasOrigin ) {
+		fprintf( out->f, ",\"origin\":[%.1f,%.1f,%.1f],\"angles\":[%.1f,%.1f]",
+			origin[0], origin[1], origin[2], angles[PITCH], angles[YAW] );
+	}
+	if ( fields->text ) {
+		fprintf( out->f, ",\"%s\":", fields->text );
+		TVA_PutString( out, text );
+	}
+	fprintf( out->f, "}\n" );
+}
+
+
+/*
+=============================================================================
+
+ANALYSIS
+
+=============================================================================
+*/
+
+typedef struct {
+	tvtInput_t		input;
+	tvaOutput_t		out;
+	tvdDecoder_t	dec;
+	tvdFrame_t		frame;
+
+	char			*cs[MAX_CONFIGSTRINGS];		// current configstrings
+	byte			seenEntity[MAX_GENTITIES/8];	// presence in the previous frame
+	int				seenEType[MAX_GENTITIES];
+	int				firstServerTime;
+	int				nextPosTime;
+	int				frames;
+} tvaDemo_t;
+
+
+/*
+===============
+TVA_SetConfigstring
+
+Returns qtrue if the value changed.
+===============
+*/
+static qboolean TVA_SetConfigstring( tvaDemo_t *d, int index, const char *s ) {
+	if ( (unsigned)index >= MAX_CONFIGSTRINGS ) {
+		return qfalse;
+	}
+
+	if ( d->cs[index] ? !strcmp( d->cs[index], s ) : !s[0] ) {
+		return qfalse;
+	}
+
+	free( d->cs[index] );
+	d->cs[index] = s[0] ? strdup( s ) : NULL;
+
+	return qtrue;
+}
+
+
+static qboolean TVA_HeaderConfigstring( void *ctx, int index, const char *s, int len ) {
+	tvaDemo_t *d = ctx;
+
+	TVA_SetConfigstring( d, index, s );
+
+	return qtrue;
+}
+
+
+/*
+===============
+TVA_PlayerName
+===============
+*/
+static const char *TVA_PlayerName( tvaDemo_t *d, int clientNum ) {
+	if ( clientNum < 0 || clientNum >= MAX_CLIENTS || !d->cs[CS_PLAYERS + clientNum] ) {
+		return "";
+	}
+
+	return Info_ValueForKey( d->cs[CS_PLAYERS + clientNum], "n" );
+}
+
+
+/*
+===============
+TVA_AnalyzeFrame
+===============
+*/
+static void TVA_AnalyzeFrame( tvaDemo_t *d ) {
+	static const vec3_t zero = { 0, 0, 0 };
+	const tvdFrame_t *f = &d->frame;
+	int t = f->serverTime - d->firstServerTime;
+	const byte *p;
+	const char *data;
+	int index, len;
+	int i;
+
+	// Configstrings first so kills in this frame see new names
+	p = f->strings;
+	for ( i = 0; i < f->csCount; i++ ) {
+		p = TVD_FrameNextString( p, &index, &data, &len );
+		if ( TVA_SetConfigstring( d, index, data ) && ( tva_events & TVA_EV_CS ) ) {
+			static const tvaFields_t fields = { NULL, NULL, "index", "value", qfalse };
+			TVA_Event( &d->out, t, "cs", &fields, 0, 0, index, zero, zero, data );
+		}
+	}
+
+	// Keyframes restate every configstring; anything not restated is gone
+	if ( f->flags & TVD_FRAME_KEYFRAME ) {
+		byte restated[MAX_CONFIGSTRINGS/8];
+
+		Com_Memset( restated, 0, sizeof( restated ) );
+		p = f->strings;
+		for ( i = 0; i < f->csCount; i++ ) {
+			p = TVD_FrameNextString( p, &index, &data, &len );
+			if ( (unsigned)index < MAX_CONFIGSTRINGS ) {
+				restated[index >> 3] |= 1 << ( index & 7 );
+			}
+		}
+		for ( i = 0; i < MAX_CONFIGSTRINGS; i++ ) {
+			if ( !( restated[i >> 3] & ( 1 << ( i & 7 ) ) ) &&
+				 TVA_SetConfigstring( d, i, "" ) && ( tva_events & TVA_EV_CS ) ) {
+				static const tvaFields_t fields = { NULL, NULL, "index", "value", qfalse };
+				TVA_Event( &d->out, t, "cs", &fields, 0, 0, i, zero, zero, "" );
+			}
+		}
+	}
+
+	// Kills: obituary event entities that just appeared
+	for ( i = 0; i < f->numEntities; i++ ) {
+		const entityState_t *es = &f->entities[i].es;
+		int num = f->entities[i].num;
+
+		if ( es->number == MAX_GENTITIES - 1 || es->eType != ET_EVENTS + EV_OBITUARY ) {
+			continue;
+		}
+		if ( ( d->seenEntity[num >> 3] & ( 1 << ( num & 7 ) ) ) && d->seenEType[num] == es->eType ) {
+			continue;
+		}
+		if ( tva_events & TVA_EV_KILL ) {
+			static const tvaFields_t fields = { "target", "attacker", "mod", "text", qfalse };
+			char names[MAX_STRING_CHARS];
+
+			Com_sprintf( names, sizeof( names ), "%s\\%s",
+				TVA_PlayerName( d, es->otherEntityNum2 ), TVA_PlayerName( d, es->otherEntityNum ) );
+			TVA_Event( &d->out, t, "kill", &fields, es->otherEntityNum, es->otherEntityNum2,
+				es->eventParm, zero, zero, names );
+		}
+	}
+
+	Com_Memcpy( d->seenEntity, f->entityBitmask, sizeof( d->seenEntity ) );
+	for ( i = 0; i < f->numEntities; i++ ) {
+		d->seenEType[f->entities[i].num] = f->entities[i].es.eType;
+	}
+
+	// Positions
+	if ( ( tva_events & TVA_EV_POS ) && f->serverTime - d->nextPosTime >= 0 ) {
+		static const tvaFields_t fields = { "client", NULL, NULL, NULL, qtrue };
+
+		for ( i = 0; i < MAX_CLIENTS; i++ ) {
+			if ( f->playerBitmask[i >> 3] & ( 1 << ( i & 7 ) ) ) {
+				const playerState_t *ps = &d->dec.players[i];
+				TVA_Event( &d->out, t, "pos", &fields, i, 0, 0, ps->origin, ps->viewangles, NULL );
+			}
+		}
+		d->nextPosTime = f->serverTime + tva_posInterval;
+	}
+
+	// Server commands
+	for ( i = 0; i < f->cmdCount; i++ ) {
+		p = TVD_FrameNextString( p, &index, &data, &len );
+		if ( tva_events & TVA_EV_CMD ) {
+			static const tvaFields_t fields = { "target", NULL, NULL, "text", qfalse };
+			TVA_Event( &d->out, t, "cmd", &fields, index, 0, 0, zero, zero, data );
+		}
+	}
+}
+
+
+/*
+===============
+TVA_AnalyzeDemo
+
+Decode one file into d->out. Returns NULL or an error message.
+===============
+*/
+static const char *TVA_AnalyzeDemo( tvaDemo_t *d, const char *path ) {
+	static const vec3_t zero = { 0, 0, 0 };
+	const tvdHeader_t *header = &d->input.header;
+	const char *error;
+	jmp_buf abortJmp;
+
+	error = TVT_Open( &d->input, path, tva_dictDir, TVA_HeaderConfigstring, d );
+	if ( error ) {
+		return error;
+	}
+
+	if ( tva_format == TVA_JSON ) {
+		fprintf( d->out.f, "{\"demo\":" );
+		TVA_PutString( &d->out, d->out.demo );
+		fprintf( d->out.f, ",\"type\":\"header\",\"map\":" );
+		TVA_PutString( &d->out, header->mapname );
+		fprintf( d->out.f, ",\"timestamp\":" );
+		TVA_PutString( &d->out, header->timestamp );
+		fprintf( d->out.f, ",\"protocol\":%i,\"fps\":%i,\"maxclients\":%i,\"duration\":%i}\n",
+			header->protocol, header->svFps, header->maxclients, d->input.duration );
+	} else {
+		static const tvaFields_t fields = { NULL, NULL, "value", "text", qfalse };
+		TVA_Event( &d->out, 0, "header", &fields, 0, 0, d->input.duration, zero, zero, header->mapname );
+	}
+
+	TVD_ResetDecoder( &d->dec, header->protocol );
+
+	tvt_abort = &abortJmp;
+	if ( setjmp( abortJmp ) ) {
+		tvt_abort = NULL;
+		return tvt_abortMsg;
+	}
+
+	while ( TVT_ReadFrame( &d->input ) ) {
+		TVD_ParseFrame( &d->dec, d->input.payload, d->input.frameSize, &d->frame );
+		if ( d->frame.end ) {
+			break;
+		}
+
+		if ( d->frames++ == 0 ) {
+			d->firstServerTime = d->frame.serverTime;
+			d->nextPosTime = d->frame.serverTime;
+		}
+
+		TVA_AnalyzeFrame( d );
+	}
+
+	tvt_abort = NULL;
+
+	if ( tva_format == TVA_JSON ) {
+		fprintf( d->out.f, "{\"demo\":" );
+		TVA_PutString( &d->out, d->out.demo );
+		fprintf( d->out.f, ",\"type\":\"end\",\"frames\":%i", d->frames );
+		if ( d->frame.error[0] ) {
+			fprintf( d->out.f, ",\"error\":" );
+			TVA_PutString( &d->out, d->frame.error );
+		}
+		fprintf( d->out.f, "}\n" );
+	} else {
+		static const tvaFields_t fields = { NULL, NULL, "value", "text", qfalse };
+		TVA_Event( &d->out, d->frames ? d->frame.serverTime - d->firstServerTime : 0, "end",
+			&fields, 0, 0, d->frames, zero, zero, d->frame.error );
+	}
+
+	return d->frame.error[0] ? d->frame.error : NULL;
+}
+
+
+/*
+===============
+TVA_ProcessFile
+===============
+*/
+static void TVA_ProcessFile( const char *path ) {
+	char outPath[MAX_OSPATH];
+	char errorMsg[256];
+	const char *error;
+	const char *base;
+	tvaDemo_t *d;
+	qboolean toStdout;
+	int i;
+
+	base = strrchr( path, '/' );
+	base = base ? base + 1 : path;
+
+	d = calloc( 1, sizeof( *d ) );
+	if ( !d ) {
+		fprintf( stderr, "%s: out of memory\n", path );
+		return;
+	}
+	d->out.demo = base;
+
+	// stdout output is staged in a temp file so demos don't interleave
+	toStdout = ( tva_outDir == NULL );
+	if ( toStdout ) {
+		d->out.f = tmpfile();
+	} else {
+		Com_sprintf( outPath, sizeof( outPath ), "%s/%s.%s", tva_outDir, base,
+			tva_format == TVA_CSV ? "csv" : "json" );
+		d->out.f = fopen( outPath, "w" );
+	}
+
+	if ( !d->out.f ) {
+		fprintf( stderr, "%s: can't open output\n", path );
+		free( d );
+		return;
+	}
+
+	if ( tva_format == TVA_CSV && !toStdout ) {
+		fprintf( d->out.f, "demo,t,type,client,other,value,x,y,z,pitch,yaw,text\n" );
+	}
+
+	error = TVA_AnalyzeDemo( d, path );
+	if ( error ) {
+		Q_strncpyz( errorMsg, error, sizeof( errorMsg ) );
+	}
+
+	TVT_Close( &d->input );
+	TVD_FreeFrame( &d->frame );
+	for ( i = 0; i < MAX_CONFIGSTRINGS; i++ ) {
+		free( d->cs[i] );
+	}
+
+	pthread_mutex_lock( &tva_lock );
+	if ( error ) {
+		fprintf( stderr, "%s: %s\n", path, errorMsg );
+		tva_failed++;
+	}
+	if ( toStdout ) {
+		char buf[16384];
+		size_t n;
+
+		rewind( d->out.f );
+		while ( ( n = fread( buf, 1, sizeof( buf ), d->out.f ) ) > 0 ) {
+			fwrite( buf, 1, n, stdout );
+		}
+	}
+	pthread_mutex_unlock( &tva_lock );
+
+	fclose( d->out.f );
+	free( d );
+}
+
+
+/*
+===============
+TVA_Worker
+===============
+*/
+static void *TVA_Worker( void *arg ) {
+	while ( 1 ) {
+		int index;
+
+		pthread_mutex_lock( &tva_lock );
+		index = tva_nextFile++;
+		pthread_mutex_unlock( &tva_lock );
+
+		if ( index >= tva_numFiles ) {
+			break;
+		}
+
+		TVA_ProcessFile( tva_files[index] );
+	}
+
+	return NULL;
+}
+
+
+/*
+===============
+TVA_ParseEvents
+===============
+*/
+static int TVA_ParseEvents( const char *list ) {
+	int events = 0;
+	char token[16];
+	const char *p = list;
+
+	while ( *p ) {
+		int len = 0;
+
+		while ( *p && *p != ',' ) {
+			if ( len < (int)sizeof( token ) - 1 ) {
+				token[len++] = *p;
+			}
+			p++;
+		}
+		token[len] = '\0';
+		if ( *p == ',' ) {
+			p++;
+		}
+
+		if ( !Q_stricmp( token, "kill" ) ) {
+			events |= TVA_EV_KILL;
+		} else if ( !Q_stricmp( token, "pos" ) ) {
+			events |= TVA_EV_POS;
+		} else if ( !Q_stricmp( token, "cs" ) ) {
+			events |= TVA_EV_CS;
+		} else if ( !Q_stricmp( token, "cmd" ) ) {
+			events |= TVA_EV_CMD;
+		} else if ( !Q_stricmp( token, "all" ) ) {
+			events |= TVA_EV_ALL;
+		} else {
+			return -1;
+		}
+	}
+
+	return events;
+}
+
+
+static void TVA_Usage( void ) {
+	fprintf( stderr,
+		"usage: tvdanalyze [options] file.tvd ...\n"
+		"  -f json|csv    output format (default json, one object per line)\n"
+		"  -e list        events: kill,pos,cs,cmd,all (default all)\n"
+		"  -i msec        position sample interval (default 0 = every frame)\n"
+		"  -o dir         write <dir>/<demo>.<format> instead of stdout\n"
+		"  -j threads     parallel decoders (default: number of CPUs)\n"
+		"  -d dir         zstd dictionaries, <dir>/<id>.dict (default tvdict)\n" );
+	exit( 2 );
+}
+
+
+/*
+===============
+main
+===============
+*/
+int main( int argc, char **argv ) {
+	pthread_t *threads;
+	int opt, i;
+
+	while ( ( opt = getopt( argc, argv, "f:e:i:o:j:d:h" ) ) != -1 ) {
+		switch ( opt ) {
+		case 'f':
+			if ( !Q_stricmp( optarg, "json" ) ) {
+				tva_format = TVA_JSON;
+			} else if ( !Q_stricmp( optarg, "csv" ) ) {
+				tva_format = TVA_CSV;
+			} else {
+				TVA_Usage();
+			}
+			break;
+		case 'e':
+			tva_events = TVA_ParseEvents( optarg );
+			if ( tva_events < 0 ) {
+				TVA_Usage();
+			}
+			break;
+		case 'i':
+			tva_posInterval = atoi( optarg );
+			break;
+		case 'o':
+			tva_outDir = optarg;
+			break;
+		case 'j':
+			tva_threads = atoi( optarg );
+			break;
+		case 'd':
+			tva_dictDir = optarg;
+			break;
+		default:
+			TVA_Usage();
+		}
+	}
+
+	tva_files = argv + optind;
+	tva_numFiles = argc - optind;
+	if ( tva_numFiles <= 0 ) {
+		TVA_Usage();
+	}
+
+	if ( tva_threads <= 0 ) {
+		tva_threads = (int)sysconf( _SC_NPROCESSORS_ONLN );
+	}
+	if ( tva_threads > tva_numFiles ) {
+		tva_threads = tva_numFiles;
+	}
+	if ( tva_threads <= 0 ) {
+		tva_threads = 1;
+	}
+
+	if ( tva_format == TVA_CSV && !tva_outDir ) {
+		printf( "demo,t,type,client,other,value,x,y,z,pitch,yaw,text\n" );
+	}
+
+	threads = calloc( tva_threads, sizeof( *threads ) );
+	for ( i = 0; i < tva_threads; i++ ) {
+		if ( pthread_create( &threads[i], NULL, TVA_Worker, NULL ) != 0 ) {
+			fprintf( stderr, "can't create thread\n" );
+			return 1;
+		}
+	}
+	for ( i = 0; i < tva_threads; i++ ) {
+		pthread_join( threads[i], NULL );
+	}
+	free( threads );
+
+	return tva_failed ? 1 : 0;
+}
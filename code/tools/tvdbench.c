@@ -0,0 +1,302 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// tvdbench.c -- huffman message coding benchmark
+//
+// Re-encodes the frames of a .tvd as huffman bitstreams, as protocol 4
+// recordings and network snapshots are written, then times encoding and
+// decoding them with the MSG bit functions. The crc32 of the encoded
+// stream is printed so builds can be checked for bit-identical output.
+
+#include "tvdtool.h"
+
+#include <time.h>
+#include <unistd.h>
+
+#define TVB_PROTOCOL	4	// last huffman coded .tvd protocol
+
+typedef struct {
+	byte			*data;			// frames as length:4 payload
+	int				size;
+	int				maxSize;
+	int				frames;
+} tvbStream_t;
+
+// command line options
+static int			tvb_iterations = 20;
+static const char	*tvb_dictDir = "tvdict";
+
+
+/*
+===============
+TVB_Seconds
+===============
+*/
+static double TVB_Seconds( void ) {
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+/*
+===============
+TVB_Append
+===============
+*/
+static qboolean TVB_Append( tvbStream_t *s, const byte *data, int len ) {
+	if ( s->size + 4 + len > s->maxSize ) {
+		int newSize = s->maxSize ? s->maxSize * 2 : 1024*1024;
+		byte *p;
+
+		while ( s->size + 4 + len > newSize ) {
+			newSize *= 2;
+		}
+		p = realloc( s->data, newSize );
+		if ( !p ) {
+			return qfalse;
+		}
+		s->data = p;
+		s->maxSize = newSize;
+	}
+
+	Com_Memcpy( s->data + s->size, &len, 4 );
+	Com_Memcpy( s->data + s->size + 4, data, len );
+	s->size += 4 + len;
+	s->frames++;
+
+	return qtrue;
+}
+
+
+/*
+===============
+TVB_Encode
+
+Write every frame of the input as a huffman coded frame.
+Returns NULL or an error message.
+===============
+*/
+static const char *TVB_Encode( tvtInput_t *input, tvbStream_t *s, byte *msgBuf ) {
+	tvdDecoder_t *dec;
+	tvdEncoder_t *enc;
+	tvdFrame_t *frame;
+	const char *error = NULL;
+	msg_t msg;
+
+	dec = malloc( sizeof( *dec ) );
+	enc = malloc( sizeof( *enc ) );
+	frame = calloc( 1, sizeof( *frame ) );
+	if ( !dec || !enc || !frame ) {
+		error = "out of memory";
+		goto done;
+	}
+
+	TVD_ResetDecoder( dec, input->header.protocol );
+	TVD_ResetEncoder( enc );
+
+	while ( TVT_ReadFrame( input ) ) {
+		TVD_ParseFrame( dec, input->payload, input->frameSize, frame );
+		if ( frame->end ) {
+			break;
+		}
+
+		MSG_Init( &msg, msgBuf, TVD_MAX_FRAME_SIZE );
+		if ( !TVD_WriteFrame( enc, &msg, dec, frame, ( frame->flags & TVD_FRAME_KEYFRAME ) != 0 ) ) {
+			error = "frame too large";
+			break;
+		}
+		if ( !TVB_Append( s, msg.data, msg.cursize ) ) {
+			error = "out of memory";
+			break;
+		}
+	}
+
+	if ( !error && frame->error[0] ) {
+		fprintf( stderr, "%s, benchmarking the frames before it\n", frame->error );
+	}
+
+done:
+	free( dec );
+	free( enc );
+	if ( frame ) {
+		TVD_FreeFrame( frame );
+		free( frame );
+	}
+
+	return error;
+}
+
+
+/*
+===============
+TVB_Run
+
+Decode every frame and encode it again from the decoded state, which
+has to give the same bytes back. Frames are copied out first as
+TVD_ParseFrame reads in place.
+===============
+*/
+static qboolean TVB_Run( const tvbStream_t *s, byte *frameBuf, byte *msgBuf,
+	double *decodeTime, double *encodeTime ) {
+	tvdDecoder_t *dec;
+	tvdEncoder_t *enc;
+	tvdFrame_t *frame;
+	qboolean ok = qtrue;
+	msg_t msg;
+	double t;
+	int pos, len;
+
+	dec = malloc( sizeof( *dec ) );
+	enc = malloc( sizeof( *enc ) );
+	frame = calloc( 1, sizeof( *frame ) );
+	if ( !dec || !enc || !frame ) {
+		free( dec );
+		free( enc );
+		free( frame );
+		return qfalse;
+	}
+
+	TVD_ResetDecoder( dec, TVB_PROTOCOL );
+	TVD_ResetEncoder( enc );
+
+	for ( pos = 0; pos < s->size; pos += 4 + len ) {
+		Com_Memcpy( &len, s->data + pos, 4 );
+		Com_Memcpy( frameBuf, s->data + pos + 4, len );
+
+		t = TVB_Seconds();
+		TVD_ParseFrame( dec, frameBuf, len, frame );
+		*decodeTime += TVB_Seconds() - t;
+
+		if ( frame->end ) {
+			ok = qfalse;
+			break;
+		}
+
+		MSG_Init( &msg, msgBuf, TVD_MAX_FRAME_SIZE );
+
+		t = TVB_Seconds();
+		TVD_WriteFrame( enc, &msg, dec, frame, ( frame->flags & TVD_FRAME_KEYFRAME ) != 0 );
+		*encodeTime += TVB_Seconds() - t;
+
+		if ( msg.cursize != len || memcmp( msg.data, s->data + pos + 4, len ) ) {
+			ok = qfalse;
+			break;
+		}
+	}
+
+	free( dec );
+	free( enc );
+	TVD_FreeFrame( frame );
+	free( frame );
+
+	return ok;
+}
+
+
+static void TVB_Usage( void ) {
+	fprintf( stderr,
+		"usage: tvdbench [options] file.tvd\n"
+		"  -n count       passes over the demo (default 20)\n"
+		"  -d dir         dictionaries, <dir>/<id>.dict (default tvdict)\n" );
+	exit( 2 );
+}
+
+
+/*
+===============
+main
+===============
+*/
+int main( int argc, char **argv ) {
+	tvtInput_t *input;
+	tvbStream_t stream;
+	byte *frameBuf, *msgBuf;
+	double decodeTime = 0.0, encodeTime = 0.0;
+	double mb;
+	const char *error;
+	int opt, i;
+
+	while ( ( opt = getopt( argc, argv, "n:d:h" ) ) != -1 ) {
+		switch ( opt ) {
+		case 'n':
+			tvb_iterations = atoi( optarg );
+			break;
+		case 'd':
+			tvb_dictDir = optarg;
+			break;
+		default:
+			TVB_Usage();
+		}
+	}
+
+	if ( argc - optind != 1 || tvb_iterations < 1 ) {
+		TVB_Usage();
+	}
+
+	Com_Memset( &stream, 0, sizeof( stream ) );
+	input = calloc( 1, sizeof( *input ) );
+	frameBuf = malloc( TVD_MAX_FRAME_SIZE );
+	msgBuf = malloc( TVD_MAX_FRAME_SIZE );
+	if ( !input || !frameBuf || !msgBuf ) {
+		fprintf( stderr, "out of memory\n" );
+		return 1;
+	}
+
+	error = TVT_Open( input, argv[optind], tvb_dictDir, NULL, NULL );
+	if ( !error ) {
+		error = TVB_Encode( input, &stream, msgBuf );
+	}
+	if ( !error && stream.frames == 0 ) {
+		error = "no frames";
+	}
+	TVT_Close( input );
+	free( input );
+
+	if ( error ) {
+		fprintf( stderr, "%s: %s\n", argv[optind], error );
+		return 1;
+	}
+
+	for ( i = 0; i < tvb_iterations; i++ ) {
+		if ( !TVB_Run( &stream, frameBuf, msgBuf, &decodeTime, &encodeTime ) ) {
+			fprintf( stderr, "%s: huffman frames did not round trip\n", argv[optind] );
+			return 1;
+		}
+	}
+
+	mb = (double)( stream.size - 4 * stream.frames ) * tvb_iterations / ( 1024.0 * 1024.0 );
+
+	printf( "%s: %i frames, %i huffman bytes, crc32 %08x\n",
+		argv[optind], stream.frames, stream.size - 4 * stream.frames, crc32_buffer( stream.data, stream.size ) );
+	printf( "decode: %.3f s, %.1f MB/s, %.0f frames/s\n",
+		decodeTime, mb / decodeTime, stream.frames * tvb_iterations / decodeTime );
+	printf( "encode: %.3f s, %.1f MB/s, %.0f frames/s\n",
+		encodeTime, mb / encodeTime, stream.frames * tvb_iterations / encodeTime );
+
+	free( stream.data );
+	free( frameBuf );
+	free( msgBuf );
+
+	return 0;
+}
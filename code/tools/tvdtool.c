@@ -0,0 +1,320 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// tvdtool.c -- in-memory .tvd input and engine stubs for the offline tools
+
+#include "tvdtool.h"
+
+// msg.c checks this for debug output
+cvar_t *cl_shownet;
+
+__thread jmp_buf	*tvt_abort;
+__thread char		tvt_abortMsg[256];
+
+
+/*
+===============
+Com_Error
+===============
+*/
+void QDECL Com_Error( errorParm_t code, const char *fmt, ... ) {
+	va_list argptr;
+
+	va_start( argptr, fmt );
+	Q_vsnprintf( tvt_abortMsg, sizeof( tvt_abortMsg ), fmt, argptr );
+	va_end( argptr );
+
+	if ( tvt_abort ) {
+		longjmp( *tvt_abort, 1 );
+	}
+
+	fprintf( stderr, "ERROR: %s\n", tvt_abortMsg );
+	exit( 1 );
+}
+
+
+/*
+===============
+Com_Printf
+===============
+*/
+void QDECL Com_Printf( const char *fmt, ... ) {
+	va_list argptr;
+
+	va_start( argptr, fmt );
+	vfprintf( stderr, fmt, argptr );
+	va_end( argptr );
+}
+
+
+/*
+===============
+TVT_LoadFile
+===============
+*/
+qboolean TVT_LoadFile( const char *path, byte **data, int *size ) {
+	FILE *f;
+	long len;
+
+	*data = NULL;
+	*size = 0;
+
+	f = fopen( path, "rb" );
+	if ( !f ) {
+		return qfalse;
+	}
+
+	fseek( f, 0, SEEK_END );
+	len = ftell( f );
+	fseek( f, 0, SEEK_SET );
+
+	if ( len <= 0 || len > 0x7fffffff ) {
+		fclose( f );
+		return qfalse;
+	}
+
+	*data = malloc( len );
+	if ( !*data || fread( *data, 1, len, f ) != (size_t)len ) {
+		free( *data );
+		*data = NULL;
+		fclose( f );
+		return qfalse;
+	}
+
+	fclose( f );
+	*size = (int)len;
+
+	return qtrue;
+}
+
+
+/*
+===============
+TVT_ReadTrailer
+
+Find where the compressed data ends and pick up the duration.
+===============
+*/
+static void TVT_ReadTrailer( tvtInput_t *input ) {
+	int trailerSize, pos, end;
+
+	input->dataEnd = input->size;
+	input->duration = 0;
+
+	if ( input->size < 9 ) {
+		return;
+	}
+
+	Com_Memcpy( &trailerSize, input->data + input->size - 4, 4 );
+	if ( trailerSize < 9 || trailerSize > input->size ||
+		 memcmp( input->data + input->size - trailerSize, "TVDt", 4 ) ) {
+		return;
+	}
+
+	input->dataEnd = input->size - trailerSize;
+	pos = input->dataEnd + 4;
+	end = input->size - 4;
+
+	while ( pos < end && input->data[pos] ) {
+		const char *key = (const char *)input->data + pos;
+		unsigned short vlen;
+
+		pos += (int)strnlen( key, end - pos ) + 1;
+		if ( pos + 2 > end ) {
+			break;
+		}
+		Com_Memcpy( &vlen, input->data + pos, 2 );
+		pos += 2;
+		if ( pos + vlen > end ) {
+			break;
+		}
+		if ( !strcmp( key, "dur" ) && vlen == 4 ) {
+			Com_Memcpy( &input->duration, input->data + pos, 4 );
+		}
+		pos += vlen;
+	}
+}
+
+
+static int TVT_HeaderRead( void *ctx, void *buf, int len ) {
+	tvtInput_t *input = ctx;
+
+	if ( len > input->dataEnd - input->pos ) {
+		len = input->dataEnd - input->pos;
+	}
+	Com_Memcpy( buf, input->data + input->pos, len );
+	input->pos += len;
+
+	return len;
+}
+
+
+static qboolean TVT_HeaderConfigstring( void *ctx, int index, const char *s, int len ) {
+	tvtInput_t *input = ctx;
+
+	return input->csFunc ? input->csFunc( input->csCtx, index, s, len ) : qtrue;
+}
+
+
+/*
+===============
+TVT_LoadDictionary
+
+Dictionaries are looked up by id as <dictDir>/<id>.dict.
+===============
+*/
+static qboolean TVT_LoadDictionary( tvtInput_t *input, const char *dictDir ) {
+	char path[MAX_OSPATH];
+	byte *dict;
+	int size;
+	qboolean ok;
+
+	Com_sprintf( path, sizeof( path ), "%s/%08x.dict", dictDir, input->header.dictId );
+	if ( !TVT_LoadFile( path, &dict, &size ) ) {
+		return qfalse;
+	}
+
+	ok = ( crc32_buffer( dict, size ) == input->header.dictId &&
+		!ZSTD_isError( ZSTD_DCtx_loadDictionary( input->dstream, dict, size ) ) );
+	free( dict );
+
+	return ok;
+}
+
+
+/*
+===============
+TVT_Open
+
+Load a .tvd file, read its trailer and header and prepare the
+decompressor. Header configstrings are passed to csFunc. Returns
+NULL or an error message.
+===============
+*/
+const char *TVT_Open( tvtInput_t *input, const char *path, const char *dictDir,
+	tvdConfigstringFunc_t csFunc, void *csCtx ) {
+	input->csFunc = csFunc;
+	input->csCtx = csCtx;
+
+	if ( !TVT_LoadFile( path, &input->data, &input->size ) ) {
+		return "can't read file";
+	}
+
+	TVT_ReadTrailer( input );
+
+	if ( !TVD_ReadHeader( TVT_HeaderRead, TVT_HeaderConfigstring, input, &input->header ) ) {
+		return input->header.error[0] ? input->header.error : "truncated header";
+	}
+
+	input->dstream = ZSTD_createDStream();
+	input->payload = malloc( TVD_MAX_FRAME_SIZE );
+	if ( !input->dstream || !input->payload ) {
+		return "out of memory";
+	}
+
+	ZSTD_initDStream( input->dstream );
+	if ( input->header.dictId && !TVT_LoadDictionary( input, dictDir ) ) {
+		return "missing or mismatched dictionary";
+	}
+
+	input->in.src = input->data;
+	input->in.size = input->dataEnd;
+	input->in.pos = input->pos;
+
+	return NULL;
+}
+
+
+/*
+===============
+TVT_DecompressRead
+===============
+*/
+static int TVT_DecompressRead( tvtInput_t *input, void *buf, int len ) {
+	byte *dst = buf;
+	int total = 0;
+
+	while ( total < len ) {
+		ZSTD_outBuffer out;
+		size_t ret;
+
+		if ( input->outPos < input->outSize ) {
+			size_t copy = input->outSize - input->outPos;
+			if ( copy > (size_t)( len - total ) ) {
+				copy = (size_t)( len - total );
+			}
+			Com_Memcpy( dst + total, input->out + input->outPos, copy );
+			input->outPos += copy;
+			total += (int)copy;
+			continue;
+		}
+
+		if ( input->in.pos >= input->in.size ) {
+			break;
+		}
+
+		out.dst = input->out;
+		out.size = sizeof( input->out );
+		out.pos = 0;
+		ret = ZSTD_decompressStream( input->dstream, &out, &input->in );
+		if ( ZSTD_isError( ret ) ) {
+			break;
+		}
+		input->outSize = out.pos;
+		input->outPos = 0;
+	}
+
+	return total;
+}
+
+
+/*
+===============
+TVT_ReadFrame
+
+Read the next frame payload into input->payload. Returns qfalse at the
+end of the data or on a truncated frame.
+===============
+*/
+qboolean TVT_ReadFrame( tvtInput_t *input ) {
+	if ( TVT_DecompressRead( input, &input->frameSize, 4 ) != 4 ||
+		 input->frameSize == 0 || input->frameSize > TVD_MAX_FRAME_SIZE ||
+		 TVT_DecompressRead( input, input->payload, input->frameSize ) != (int)input->frameSize ) {
+		return qfalse;
+	}
+
+	return qtrue;
+}
+
+
+/*
+===============
+TVT_Close
+===============
+*/
+void TVT_Close( tvtInput_t *input ) {
+	if ( input->dstream ) {
+		ZSTD_freeDStream( input->dstream );
+	}
+	free( input->payload );
+	free( input->data );
+	Com_Memset( input, 0, sizeof( *input ) );
+}
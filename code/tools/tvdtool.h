@@ -0,0 +1,68 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// tvdtool.h -- in-memory .tvd input shared by the offline tools
+
+#ifndef TVDTOOL_H
+#define TVDTOOL_H
+
+#include "../qcommon/q_shared.h"
+#include "../qcommon/qcommon.h"
+#include "../qcommon/tvd.h"
+#include "zstd.h"
+
+#include <setjmp.h>
+
+#define TVT_ZSTD_OUT_SIZE	(128*1024)
+
+typedef struct {
+	byte			*data;			// whole file
+	int				size;
+	int				pos;			// header read position
+	int				dataEnd;		// start of trailer
+	int				duration;		// "dur" trailer key, 0 if missing
+
+	tvdHeader_t		header;
+	unsigned int	frameSize;		// size of payload from the last TVT_ReadFrame
+	byte			*payload;		// TVD_MAX_FRAME_SIZE
+
+	tvdConfigstringFunc_t csFunc;
+	void			*csCtx;
+
+	ZSTD_DStream	*dstream;
+	ZSTD_inBuffer	in;
+	byte			out[TVT_ZSTD_OUT_SIZE];
+	size_t			outSize;
+	size_t			outPos;
+} tvtInput_t;
+
+// Com_Error from msg.c/q_shared.c longjmps here if set, abandoning
+// only the current file; the message is left in tvt_abortMsg
+extern __thread jmp_buf	*tvt_abort;
+extern __thread char	tvt_abortMsg[256];
+
+qboolean	TVT_LoadFile( const char *path, byte **data, int *size );
+const char	*TVT_Open( tvtInput_t *input, const char *path, const char *dictDir,
+				tvdConfigstringFunc_t csFunc, void *csCtx );
+qboolean	TVT_ReadFrame( tvtInput_t *input );
+void		TVT_Close( tvtInput_t *input );
+
+#endif // TVDTOOL_H
@@ -0,0 +1,581 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+// tvdtranscode.c -- offline .tvd recompressor and clipper
+//
+// Decodes a .tvd with the shared reader and writes it again at the
+// current protocol with a strong zstd level and long-distance matching.
+// An optional time range cuts a standalone clip: the header carries the
+// configstrings at the clip start and the first frame is a full delta.
+// Source keyframes are kept and the trailer seek table is rebuilt.
+
+#include "tvdtool.h"
+
+#include <unistd.h>
+
+#define TVX_MAX_KEYFRAMES	4096	// as MAX_TV_KEYFRAMES on the server
+
+typedef struct {
+	int				serverTime;
+	unsigned int	offset;
+} tvxKeyframe_t;
+
+typedef struct {
+	FILE			*f;
+	unsigned int	offset;
+	ZSTD_CCtx		*cctx;
+	byte			zstdOut[TVT_ZSTD_OUT_SIZE];
+
+	tvdEncoder_t	enc;
+	byte			*msgBuf;		// TVD_MAX_FRAME_SIZE
+	tvdFrame_t		frame;			// rebuilt first frame
+
+	tvxKeyframe_t	keyframes[TVX_MAX_KEYFRAMES];
+	int				keyframeCount;
+	int				frames;
+	int				firstServerTime;
+	int				lastServerTime;
+} tvxOutput_t;
+
+// command line options
+static int			tvx_level = 19;
+static int			tvx_windowLog = 24;
+static int			tvx_start = -1;		// msec from the first frame, -1 = open
+static int			tvx_end = -1;
+static const char	*tvx_dictDir = "tvdict";
+static const char	*tvx_outDict;		// NULL = keep the input's, "none" = drop
+
+static char			*tvx_cs[MAX_CONFIGSTRINGS];
+
+
+/*
+===============
+TVX_SetConfigstring
+===============
+*/
+static void TVX_SetConfigstring( int index, const char *s ) {
+	if ( (unsigned)index >= MAX_CONFIGSTRINGS ) {
+		return;
+	}
+
+	free( tvx_cs[index] );
+	tvx_cs[index] = s[0] ? strdup( s ) : NULL;
+}
+
+
+static qboolean TVX_HeaderConfigstring( void *ctx, int index, const char *s, int len ) {
+	TVX_SetConfigstring( index, s );
+
+	return qtrue;
+}
+
+
+/*
+===============
+TVX_ApplyConfigstrings
+
+Track configstrings through the source. Keyframes restate all of them,
+anything not restated is gone.
+===============
+*/
+static void TVX_ApplyConfigstrings( const tvdFrame_t *f ) {
+	const byte *p;
+	const char *data;
+	int index, len;
+	int i;
+
+	if ( f->flags & TVD_FRAME_KEYFRAME ) {
+		for ( i = 0; i < MAX_CONFIGSTRINGS; i++ ) {
+			free( tvx_cs[i] );
+			tvx_cs[i] = NULL;
+		}
+	}
+
+	p = f->strings;
+	for ( i = 0; i < f->csCount; i++ ) {
+		p = TVD_FrameNextString( p, &index, &data, &len );
+		TVX_SetConfigstring( index, data );
+	}
+}
+
+
+/*
+===============
+TVX_Write
+===============
+*/
+static void TVX_Write( tvxOutput_t *out, const void *data, int len ) {
+	fwrite( data, 1, len, out->f );
+	out->offset += len;
+}
+
+
+/*
+===============
+TVX_Compress
+===============
+*/
+static qboolean TVX_Compress( tvxOutput_t *out, const void *data, int len, ZSTD_EndDirective mode ) {
+	ZSTD_inBuffer in = { data, (size_t)len, 0 };
+	size_t ret;
+
+	do {
+		ZSTD_outBuffer zout = { out->zstdOut, sizeof( out->zstdOut ), 0 };
+		ret = ZSTD_compressStream2( out->cctx, &zout, &in, mode );
+		if ( ZSTD_isError( ret ) ) {
+			return qfalse;
+		}
+		TVX_Write( out, out->zstdOut, (int)zout.pos );
+	} while ( in.pos < in.size || ( mode == ZSTD_e_end && ret != 0 ) );
+
+	return qtrue;
+}
+
+
+/*
+===============
+TVX_WriteHeader
+
+Same layout as SV_TV_StartRecord, with the configstrings at the clip start.
+===============
+*/
+static void TVX_WriteHeader( tvxOutput_t *out, const tvdHeader_t *header, unsigned int dictId ) {
+	unsigned short idx, slen;
+	int val;
+	int i;
+
+	TVX_Write( out, "TVD1", 4 );
+	val = TVD_PROTOCOL_VERSION;
+	TVX_Write( out, &val, 4 );
+	TVX_Write( out, &header->svFps, 4 );
+	TVX_Write( out, &header->maxclients, 4 );
+	TVX_Write( out, &dictId, 4 );
+	TVX_Write( out, header->mapname, (int)strlen( header->mapname ) + 1 );
+	TVX_Write( out, header->timestamp, (int)strlen( header->timestamp ) + 1 );
+
+	for ( i = 0; i < MAX_CONFIGSTRINGS; i++ ) {
+		if ( !tvx_cs[i] ) {
+			continue;
+		}
+		idx = (unsigned short)i;
+		slen = (unsigned short)strlen( tvx_cs[i] );
+		TVX_Write( out, &idx, 2 );
+		TVX_Write( out, &slen, 2 );
+		TVX_Write( out, tvx_cs[i], slen );
+	}
+
+	idx = 0xFFFF;
+	TVX_Write( out, &idx, 2 );
+}
+
+
+/*
+===============
+TVX_WriteTrailer
+
+Same layout as SV_TV_StopRecord.
+===============
+*/
+static void TVX_WriteTrailer( tvxOutput_t *out ) {
+	unsigned int trailerStart = out->offset;
+	unsigned short vlen;
+	int val;
+	int i;
+
+	TVX_Write( out, "TVDt", 4 );
+
+	TVX_Write( out, "dur", 4 );
+	vlen = 4;
+	TVX_Write( out, &vlen, 2 );
+	val = out->frames ? out->lastServerTime - out->firstServerTime : 0;
+	TVX_Write( out, &val, 4 );
+
+	if ( out->keyframeCount > 0 ) {
+		TVX_Write( out, "kf", 3 );
+		vlen = (unsigned short)( out->keyframeCount * 8 );
+		TVX_Write( out, &vlen, 2 );
+		for ( i = 0; i < out->keyframeCount; i++ ) {
+			TVX_Write( out, &out->keyframes[i].serverTime, 4 );
+			TVX_Write( out, &out->keyframes[i].offset, 4 );
+		}
+	}
+
+	TVX_Write( out, "", 1 );
+
+	val = (int)( out->offset - trailerStart + 4 );
+	TVX_Write( out, &val, 4 );
+}
+
+
+/*
+===============
+TVX_WriteFrame
+===============
+*/
+static qboolean TVX_WriteFrame( tvxOutput_t *out, const tvdDecoder_t *state, const tvdFrame_t *f, qboolean keyframe ) {
+	msg_t msg;
+	unsigned int len;
+
+	MSG_Init( &msg, out->msgBuf, TVD_MAX_FRAME_SIZE );
+	MSG_Rawstream( &msg );
+	if ( !TVD_WriteFrame( &out->enc, &msg, state, f, keyframe ) ) {
+		return qfalse;
+	}
+
+	// Keyframes start a new zstd frame so seeking can decode from there
+	if ( keyframe && out->keyframeCount < TVX_MAX_KEYFRAMES ) {
+		if ( !TVX_Compress( out, NULL, 0, ZSTD_e_end ) ) {
+			return qfalse;
+		}
+		out->keyframes[out->keyframeCount].serverTime = f->serverTime;
+		out->keyframes[out->keyframeCount].offset = out->offset;
+		out->keyframeCount++;
+	}
+
+	len = (unsigned int)msg.cursize;
+	if ( !TVX_Compress( out, &len, 4, ZSTD_e_continue ) ||
+		 !TVX_Compress( out, msg.data, msg.cursize, ZSTD_e_continue ) ) {
+		return qfalse;
+	}
+
+	if ( out->frames++ == 0 ) {
+		out->firstServerTime = f->serverTime;
+	}
+	out->lastServerTime = f->serverTime;
+
+	return qtrue;
+}
+
+
+/*
+===============
+TVX_FirstFrame
+
+The first written frame starts from zeroed baselines like the first
+frame of a recording. Its configstrings are already in the header,
+so only the commands are kept.
+===============
+*/
+static const tvdFrame_t *TVX_FirstFrame( tvxOutput_t *out, const tvdFrame_t *f ) {
+	tvdFrame_t *first = &out->frame;
+	const byte *p;
+	const char *data;
+	int index, len;
+	int i;
+
+	first->serverTime = f->serverTime;
+	first->csCount = 0;
+	first->cmdCount = 0;
+	first->stringsSize = 0;
+
+	p = f->strings;
+	for ( i = 0; i < f->csCount + f->cmdCount; i++ ) {
+		p = TVD_FrameNextString( p, &index, &data, &len );
+		if ( i >= f->csCount ) {
+			if ( !TVD_FrameAddString( first, index, data, len ) ) {
+				return NULL;
+			}
+			first->cmdCount++;
+		}
+	}
+
+	return first;
+}
+
+
+/*
+===============
+TVX_LoadOutputDictionary
+===============
+*/
+static qboolean TVX_LoadOutputDictionary( tvxOutput_t *out, const tvtInput_t *input, unsigned int *dictId ) {
+	char path[MAX_OSPATH];
+	byte *dict;
+	int size;
+
+	*dictId = 0;
+
+	if ( tvx_outDict && !Q_stricmp( tvx_outDict, "none" ) ) {
+		return qtrue;
+	}
+
+	if ( tvx_outDict ) {
+		Q_strncpyz( path, tvx_outDict, sizeof( path ) );
+	} else if ( input->header.dictId ) {
+		Com_sprintf( path, sizeof( path ), "%s/%08x.dict", tvx_dictDir, input->header.dictId );
+	} else {
+		return qtrue;
+	}
+
+	if ( !TVT_LoadFile( path, &dict, &size ) ) {
+		return qfalse;
+	}
+
+	*dictId = crc32_buffer( dict, size );
+	ZSTD_CCtx_loadDictionary( out->cctx, dict, size );
+	free( dict );
+
+	return qtrue;
+}
+
+
+/*
+===============
+TVX_Transcode
+
+Returns NULL or an error message.
+===============
+*/
+static const char *TVX_Transcode( tvtInput_t *input, tvxOutput_t *out, const char *inPath ) {
+	tvdDecoder_t *dec;
+	tvdFrame_t *frame;
+	unsigned int dictId;
+	const char *error;
+	jmp_buf abortJmp;
+	int firstServerTime = 0;
+	int sourceFrames = 0;
+
+	error = TVT_Open( input, inPath, tvx_dictDir, TVX_HeaderConfigstring, NULL );
+	if ( error ) {
+		return error;
+	}
+
+	out->cctx = ZSTD_createCCtx();
+	if ( !out->cctx ) {
+		return "out of memory";
+	}
+	ZSTD_CCtx_setParameter( out->cctx, ZSTD_c_compressionLevel, tvx_level );
+	if ( tvx_windowLog > 0 ) {
+		ZSTD_CCtx_setParameter( out->cctx, ZSTD_c_enableLongDistanceMatching, 1 );
+		ZSTD_CCtx_setParameter( out->cctx, ZSTD_c_windowLog, tvx_windowLog );
+	}
+	if ( !TVX_LoadOutputDictionary( out, input, &dictId ) ) {
+		return "can't load output dictionary";
+	}
+
+	// Heap allocated, setjmp would not preserve locals changed after it
+	dec = malloc( sizeof( *dec ) );
+	frame = calloc( 1, sizeof( *frame ) );
+	if ( !dec || !frame ) {
+		free( dec );
+		free( frame );
+		return "out of memory";
+	}
+	TVD_ResetDecoder( dec, input->header.protocol );
+
+	tvt_abort = &abortJmp;
+	if ( setjmp( abortJmp ) ) {
+		tvt_abort = NULL;
+		free( dec );
+		TVD_FreeFrame( frame );
+		free( frame );
+		return tvt_abortMsg;
+	}
+
+	while ( TVT_ReadFrame( input ) ) {
+		int t;
+
+		TVD_ParseFrame( dec, input->payload, input->frameSize, frame );
+		if ( frame->end ) {
+			break;
+		}
+
+		if ( sourceFrames++ == 0 ) {
+			firstServerTime = frame->serverTime;
+		}
+		t = frame->serverTime - firstServerTime;
+
+		TVX_ApplyConfigstrings( frame );
+
+		if ( tvx_start >= 0 && t < tvx_start ) {
+			continue;
+		}
+		if ( tvx_end >= 0 && t > tvx_end ) {
+			break;
+		}
+
+		if ( out->frames == 0 ) {
+			const tvdFrame_t *first;
+
+			TVX_WriteHeader( out, &input->header, dictId );
+			first = TVX_FirstFrame( out, frame );
+			if ( !first || !TVX_WriteFrame( out, dec, first, qfalse ) ) {
+				error = "frame too large";
+				break;
+			}
+		} else if ( !TVX_WriteFrame( out, dec, frame, ( frame->flags & TVD_FRAME_KEYFRAME ) != 0 ) ) {
+			error = "frame too large";
+			break;
+		}
+	}
+
+	tvt_abort = NULL;
+
+	if ( !error && frame->error[0] ) {
+		fprintf( stderr, "%s: %s, output ends there\n", inPath, frame->error );
+	}
+
+	free( dec );
+	TVD_FreeFrame( frame );
+	free( frame );
+
+	if ( error ) {
+		return error;
+	}
+	if ( out->frames == 0 ) {
+		return "no frames in range";
+	}
+
+	if ( !TVX_Compress( out, NULL, 0, ZSTD_e_end ) ) {
+		return "compression failed";
+	}
+	TVX_WriteTrailer( out );
+
+	return NULL;
+}
+
+
+/*
+===============
+TVX_ParseTime
+
+Seconds, optionally as minutes:seconds.
+===============
+*/
+static int TVX_ParseTime( const char *s ) {
+	const char *colon = strchr( s, ':' );
+
+	if ( colon ) {
+		return atoi( s ) * 60000 + (int)( atof( colon + 1 ) * 1000 );
+	}
+
+	return (int)( atof( s ) * 1000 );
+}
+
+
+static void TVX_Usage( void ) {
+	fprintf( stderr,
+		"usage: tvdtranscode [options] in.tvd out.tvd\n"
+		"  -l level       zstd level (default 19)\n"
+		"  -w windowlog   long-distance matching window, 0 = off (default 24)\n"
+		"  -s time        clip start, [min:]sec from the first frame\n"
+		"  -e time        clip end, [min:]sec from the first frame\n"
+		"  -d dir         dictionaries for reading, <dir>/<id>.dict (default tvdict)\n"
+		"  -D file        compress with this dictionary, \"none\" to drop the input's\n" );
+	exit( 2 );
+}
+
+
+/*
+===============
+main
+===============
+*/
+int main( int argc, char **argv ) {
+	char tmpPath[MAX_OSPATH];
+	tvtInput_t *input;
+	tvxOutput_t *out;
+	const char *error;
+	const char *outPath;
+	int opt, i;
+
+	while ( ( opt = getopt( argc, argv, "l:w:s:e:d:D:h" ) ) != -1 ) {
+		switch ( opt ) {
+		case 'l':
+			tvx_level = atoi( optarg );
+			break;
+		case 'w':
+			tvx_windowLog = atoi( optarg );
+			break;
+		case 's':
+			tvx_start = TVX_ParseTime( optarg );
+			break;
+		case 'e':
+			tvx_end = TVX_ParseTime( optarg );
+			break;
+		case 'd':
+			tvx_dictDir = optarg;
+			break;
+		case 'D':
+			tvx_outDict = optarg;
+			break;
+		default:
+			TVX_Usage();
+		}
+	}
+
+	if ( argc - optind != 2 ) {
+		TVX_Usage();
+	}
+	outPath = argv[optind + 1];
+
+	input = calloc( 1, sizeof( *input ) );
+	out = calloc( 1, sizeof( *out ) );
+	if ( !input || !out || !( out->msgBuf = malloc( TVD_MAX_FRAME_SIZE ) ) ) {
+		fprintf( stderr, "out of memory\n" );
+		return 1;
+	}
+
+	// The input is read whole first, so out.tvd may replace in.tvd
+	Com_sprintf( tmpPath, sizeof( tmpPath ), "%s.tmp", outPath );
+	out->f = fopen( tmpPath, "wb" );
+	if ( !out->f ) {
+		fprintf( stderr, "%s: can't open for writing\n", tmpPath );
+		return 1;
+	}
+
+	error = TVX_Transcode( input, out, argv[optind] );
+
+	if ( fclose( out->f ) != 0 && !error ) {
+		error = "write failed";
+	}
+
+	if ( error ) {
+		fprintf( stderr, "%s: %s\n", argv[optind], error );
+		remove( tmpPath );
+	} else if ( rename( tmpPath, outPath ) != 0 ) {
+		remove( outPath );
+		if ( rename( tmpPath, outPath ) != 0 ) {
+			error = "can't rename output";
+			fprintf( stderr, "%s: %s\n", tmpPath, error );
+		}
+	}
+
+	if ( !error ) {
+		printf( "%s: %i -> %u bytes (%.1f%%), %i frames, %i keyframes, %.1f seconds\n",
+			outPath, input->size, out->offset, input->size ? 100.0 * out->offset / input->size : 0.0,
+			out->frames, out->keyframeCount, ( out->lastServerTime - out->firstServerTime ) / 1000.0 );
+	}
+
+	TVT_Close( input );
+	if ( out->cctx ) {
+		ZSTD_freeCCtx( out->cctx );
+	}
+	TVD_FreeFrame( &out->frame );
+	free( out->msgBuf );
+	free( out );
+	free( input );
+	for ( i = 0; i < MAX_CONFIGSTRINGS; i++ ) {
+		free( tvx_cs[i] );
+	}
+
+	return error ? 1 : 0;
+}
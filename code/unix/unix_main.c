@@ -52,6 +52,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #endif
 
 #ifdef __linux__
+#include <sys/prctl.h>
 #ifdef __GLIBC__
   #include <fpu_control.h> // bk001213 - force dumps on divide by zero
 #endif
@@ -697,6 +698,92 @@ void Sys_Sleep( int msec ) {
 }
 
 
+/*
+==================
+Sys_SleepUntil
+
+Sleep until Sys_Milliseconds() reaches msec, busy waiting for the
+last spinUsec microseconds. Sys_Milliseconds counts gettimeofday time
+from sys_timeBase, so the deadline is absolute on the same clock and
+wakeup latency does not add up from frame to frame.
+==================
+*/
+void Sys_SleepUntil( int msec, int spinUsec ) {
+	extern unsigned long sys_timeBase;
+	struct timespec req;
+	int64_t target, wake;
+
+	target = ( (int64_t)sys_timeBase * 1000 + msec ) * 1000;
+	wake = target - spinUsec;
+
+	if ( wake > Sys_Microseconds() ) {
+#ifdef __linux__
+		req.tv_sec = wake / 1000000;
+		req.tv_nsec = ( wake % 1000000 ) * 1000;
+		while ( clock_nanosleep( CLOCK_REALTIME, TIMER_ABSTIME, &req, NULL ) == EINTR )
+			;
+#else
+		wake -= Sys_Microseconds();
+		req.tv_sec = wake / 1000000;
+		req.tv_nsec = ( wake % 1000000 ) * 1000;
+		nanosleep( &req, NULL );
+#endif
+	}
+
+	while ( Sys_Microseconds() < target )
+		;
+}
+
+
+/*
+==================
+Sys_ForkInstances
+
+Fork count-1 copies of this process and return the instance number,
+0 in the original one. Memory loaded so far stays shared copy-on-write
+until an instance writes to it. The copies do not read the console and,
+on Linux, get SIGTERM when the original process exits.
+==================
+*/
+int Sys_ForkInstances( int count ) {
+#ifdef __EMSCRIPTEN__
+	return 0;
+#else
+	pid_t parent, pid;
+	int i;
+
+	parent = getpid();
+
+	// don't write out buffered output once per instance
+	fflush( NULL );
+
+	// reap the copies as they exit
+	signal( SIGCHLD, SIG_IGN );
+
+	for ( i = 1; i < count; i++ ) {
+		pid = fork();
+		if ( pid == -1 ) {
+			Com_Printf( S_COLOR_YELLOW "WARNING: fork() failed: %s, started %i of %i instances\n", strerror( errno ), i, count );
+			break;
+		}
+		if ( pid == 0 ) {
+#ifdef __linux__
+			prctl( PR_SET_PDEATHSIG, SIGTERM );
+			if ( getppid() != parent ) {
+				_exit( 0 );
+			}
+#endif
+			stdin_active = qfalse;
+			ttycon_on = qfalse;
+			return i;
+		}
+	}
+
+	return 0;
+#endif
+}
+
+
 static const struct Q3ToAnsiColorTable_s
 {
 	const char Q3color;
@@ -38,6 +38,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include <dlfcn.h>
 #endif
 #include <libgen.h>
+#include <pthread.h>
 
 #include "../qcommon/q_shared.h"
 #include "../qcommon/qcommon.h"
@@ -312,6 +313,50 @@ qboolean Sys_GetFileStats( const char *filename, fileOffset_t *size, fileTime_t
 }
 
 
+/*
+=================
+Sys_MapFile
+
+Map an open file read-only. Returns NULL if the file can't be mapped,
+callers should fall back to regular reads.
+=================
+*/
+const void *Sys_MapFile( FILE *f, int *length )
+{
+#ifdef __EMSCRIPTEN__
+	*length = 0;
+	return NULL;
+#else
+	struct stat s;
+	void *base;
+
+	*length = 0;
+
+	if ( fstat( fileno( f ), &s ) != 0 || s.st_size <= 0 || s.st_size > 0x7FFFFFFF ) {
+		return NULL;
+	}
+
+	base = mmap( NULL, (size_t)s.st_size, PROT_READ, MAP_SHARED, fileno( f ), 0 );
+	if ( base == MAP_FAILED ) {
+		return NULL;
+	}
+
+	*length = (int)s.st_size;
+	return base;
+#endif
+}
+
+
+void Sys_UnmapFile( const void *base, int length )
+{
+#ifndef __EMSCRIPTEN__
+	if ( base ) {
+		munmap( (void *)base, (size_t)length );
+	}
+#endif
+}
+
+
 /*
 =================
 Sys_Mkdir
@@ -620,3 +665,184 @@ qboolean Sys_SetAffinityMask( const uint64_t mask )
 	}
 }
 #endif // USE_AFFINITY_MASK
+
+
+/*
+=================
+Sys_CreateThread
+=================
+*/
+typedef struct {
+	sysThreadFunc_t	func;
+	void			*arg;
+} sysThreadStart_t;
+
+static void *Sys_ThreadStart( void *arg )
+{
+	sysThreadStart_t start = *(sysThreadStart_t *)arg;
+
+	free( arg );
+	start.func( start.arg );
+
+	return NULL;
+}
+
+
+void *Sys_CreateThread( sysThreadFunc_t func, void *arg )
+{
+#if defined (__EMSCRIPTEN__) && !defined (__EMSCRIPTEN_PTHREADS__)
+	return NULL;
+#else
+	pthread_t *thread;
+	sysThreadStart_t *start;
+
+	thread = malloc( sizeof( *thread ) );
+	start = malloc( sizeof( *start ) );
+	if ( !thread || !start ) {
+		free( thread );
+		free( start );
+		return NULL;
+	}
+
+	start->func = func;
+	start->arg = arg;
+
+	if ( pthread_create( thread, NULL, Sys_ThreadStart, start ) != 0 ) {
+		free( thread );
+		free( start );
+		return NULL;
+	}
+
+	return thread;
+#endif
+}
+
+
+/*
+=================
+Sys_JoinThread
+=================
+*/
+void Sys_JoinThread( void *thread )
+{
+	if ( thread ) {
+		pthread_join( *(pthread_t *)thread, NULL );
+		free( thread );
+	}
+}
+
+
+/*
+=================
+Sys_CreateMutex
+=================
+*/
+void *Sys_CreateMutex( void )
+{
+	pthread_mutex_t *mutex;
+
+	mutex = malloc( sizeof( *mutex ) );
+	if ( mutex && pthread_mutex_init( mutex, NULL ) != 0 ) {
+		free( mutex );
+		mutex = NULL;
+	}
+
+	return mutex;
+}
+
+
+void Sys_DestroyMutex( void *mutex )
+{
+	if ( mutex ) {
+		pthread_mutex_destroy( mutex );
+		free( mutex );
+	}
+}
+
+
+void Sys_LockMutex( void *mutex )
+{
+	pthread_mutex_lock( mutex );
+}
+
+
+void Sys_UnlockMutex( void *mutex )
+{
+	pthread_mutex_unlock( mutex );
+}
+
+
+/*
+=================
+Sys_CreateSemaphore
+
+Counting semaphore built on a mutex and condition variable,
+unnamed POSIX semaphores are not available on macOS
+=================
+*/
+typedef struct {
+	pthread_mutex_t	mutex;
+	pthread_cond_t	cond;
+	int				count;
+} sysSemaphore_t;
+
+void *Sys_CreateSemaphore( int count )
+{
+	sysSemaphore_t *sem;
+
+	sem = malloc( sizeof( *sem ) );
+	if ( !sem ) {
+		return NULL;
+	}
+
+	if ( pthread_mutex_init( &sem->mutex, NULL ) != 0 ) {
+		free( sem );
+		return NULL;
+	}
+
+	if ( pthread_cond_init( &sem->cond, NULL ) != 0 ) {
+		pthread_mutex_destroy( &sem->mutex );
+		free( sem );
+		return NULL;
+	}
+
+	sem->count = count;
+
+	return sem;
+}
+
+
+void Sys_DestroySemaphore( void *sem )
+{
+	sysSemaphore_t *s = sem;
+
+	if ( s ) {
+		pthread_cond_destroy( &s->cond );
+		pthread_mutex_destroy( &s->mutex );
+		free( s );
+	}
+}
+
+
+void Sys_SemaphoreWait( void *sem )
+{
+	sysSemaphore_t *s = sem;
+
+	pthread_mutex_lock( &s->mutex );
+	while ( s->count <= 0 ) {
+		pthread_cond_wait( &s->cond, &s->mutex );
+	}
+	s->count--;
+	pthread_mutex_unlock( &s->mutex );
+}
+
+
+void Sys_SemaphorePost( void *sem )
+{
+	sysSemaphore_t *s = sem;
+
+	pthread_mutex_lock( &s->mutex );
+	s->count++;
+	pthread_cond_signal( &s->cond );
+	pthread_mutex_unlock( &s->mutex );
+}
@@ -176,6 +176,39 @@ void Sys_Sleep( int msec ) {
 }
 
 
+/*
+==================
+Sys_SleepUntil
+
+Sleep until Sys_Milliseconds() reaches msec, busy waiting for the
+last spinUsec microseconds. Sleep() runs on the timer resolution
+raised in WinMain, so this is as close as it gets without spinning.
+==================
+*/
+void Sys_SleepUntil( int msec, int spinUsec ) {
+	int remaining;
+
+	while ( ( remaining = msec - Sys_Milliseconds() ) > 0 ) {
+		if ( remaining * 1000 > spinUsec ) {
+			Sleep( 1 );
+		}
+	}
+}
+
+
+/*
+==================
+Sys_ForkInstances
+
+Not available without fork(), the process stays a single instance.
+==================
+*/
+int Sys_ForkInstances( int count ) {
+	Com_Printf( S_COLOR_YELLOW "WARNING: multiple server instances are not supported on this platform\n" );
+	return 0;
+}
+
+
 /*
 ==============
 Sys_Mkdir
@@ -476,6 +509,51 @@ qboolean Sys_GetFileStats( const char *filename, fileOffset_t *size, fileTime_t
 }
 
 
+/*
+=============
+Sys_MapFile
+
+Map an open file read-only. Returns NULL if the file can't be mapped,
+callers should fall back to regular reads.
+=============
+*/
+const void *Sys_MapFile( FILE *f, int *length ) {
+	HANDLE hFile, hMap;
+	LARGE_INTEGER size;
+	void *base;
+
+	*length = 0;
+
+	hFile = (HANDLE)_get_osfhandle( _fileno( f ) );
+	if ( hFile == INVALID_HANDLE_VALUE || !GetFileSizeEx( hFile, &size ) ||
+		size.QuadPart <= 0 || size.QuadPart > 0x7FFFFFFF ) {
+		return NULL;
+	}
+
+	hMap = CreateFileMapping( hFile, NULL, PAGE_READONLY, 0, 0, NULL );
+	if ( !hMap ) {
+		return NULL;
+	}
+
+	// the view keeps the mapping object alive
+	base = MapViewOfFile( hMap, FILE_MAP_READ, 0, 0, 0 );
+	CloseHandle( hMap );
+	if ( !base ) {
+		return NULL;
+	}
+
+	*length = (int)size.QuadPart;
+	return base;
+}
+
+
+void Sys_UnmapFile( const void *base, int length ) {
+	if ( base ) {
+		UnmapViewOfFile( base );
+	}
+}
+
+
 //========================================================
 
 /*
@@ -247,3 +247,131 @@ qboolean Sys_SetAffinityMask( const uint64_t mask )
 	return qfalse;
 }
 #endif // USE_AFFINITY_MASK
+
+
+/*
+=================
+Sys_CreateThread
+=================
+*/
+typedef struct {
+	sysThreadFunc_t	func;
+	void			*arg;
+} sysThreadStart_t;
+
+static DWORD WINAPI Sys_ThreadStart( LPVOID arg )
+{
+	sysThreadStart_t start = *(sysThreadStart_t *)arg;
+
+	free( arg );
+	start.func( start.arg );
+
+	return 0;
+}
+
+
+void *Sys_CreateThread( sysThreadFunc_t func, void *arg )
+{
+	sysThreadStart_t *start;
+	HANDLE thread;
+
+	start = malloc( sizeof( *start ) );
+	if ( !start ) {
+		return NULL;
+	}
+
+	start->func = func;
+	start->arg = arg;
+
+	thread = CreateThread( NULL, 0, Sys_ThreadStart, start, 0, NULL );
+	if ( thread == NULL ) {
+		free( start );
+		return NULL;
+	}
+
+	return thread;
+}
+
+
+/*
+=================
+Sys_JoinThread
+=================
+*/
+void Sys_JoinThread( void *thread )
+{
+	if ( thread ) {
+		WaitForSingleObject( (HANDLE)thread, INFINITE );
+		CloseHandle( (HANDLE)thread );
+	}
+}
+
+
+/*
+=================
+Sys_CreateMutex
+=================
+*/
+void *Sys_CreateMutex( void )
+{
+	CRITICAL_SECTION *mutex;
+
+	mutex = malloc( sizeof( *mutex ) );
+	if ( mutex ) {
+		InitializeCriticalSection( mutex );
+	}
+
+	return mutex;
+}
+
+
+void Sys_DestroyMutex( void *mutex )
+{
+	if ( mutex ) {
+		DeleteCriticalSection( mutex );
+		free( mutex );
+	}
+}
+
+
+void Sys_LockMutex( void *mutex )
+{
+	EnterCriticalSection( mutex );
+}
+
+
+void Sys_UnlockMutex( void *mutex )
+{
+	LeaveCriticalSection( mutex );
+}
+
+
+/*
+=================
+Sys_CreateSemaphore
+=================
+*/
+void *Sys_CreateSemaphore( int count )
+{
+	return CreateSemaphore( NULL, count, 0x7FFFFFFF, NULL );
+}
+
+
+void Sys_DestroySemaphore( void *sem )
+{
+	if ( sem ) {
+		CloseHandle( (HANDLE)sem );
+	}
+}
+
+
+void Sys_SemaphoreWait( void *sem )
+{
+	WaitForSingleObject( (HANDLE)sem, INFINITE );
+}
+
+
+void Sys_SemaphorePost( void *sem )
+{
+	ReleaseSemaphore( (HANDLE)sem, 1, NULL );
+}